@@ -0,0 +1,211 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "Atom.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <stdint.h>
+#include <wchar.h>
+
+namespace v2x {
+
+	namespace {
+
+		const Atom::Entry EMPTY_ATOM = { 0, 0, L"" };
+
+		/// The storage of the atoms. Memory is allocated in large blocks and
+		/// never returned.
+		class AtomArena {
+		public:
+			static const size_t BLOCK_SIZE = 64 * 1024;
+
+			AtomArena() : m_current(nullptr), m_left(0) {}
+
+			/// Copy a string into the arena and create its entry
+			const Atom::Entry * create(const Char * s, size_t length, size_t hash) {
+				const size_t align = sizeof(void *) * 2;
+				const size_t header = (sizeof(Atom::Entry) + align - 1) / align * align;
+				const size_t size = (header + (length + 1) * sizeof(Char) + align - 1) / align * align;
+
+				if (size > m_left) {
+					const size_t blockSize = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+					m_blocks.push_back(std::unique_ptr<char[]>(new char[blockSize]));
+					m_current = m_blocks.back().get();
+					m_left = blockSize;
+				}
+
+				char * memory = m_current;
+				m_current += size;
+				m_left -= size;
+
+				Char * data = reinterpret_cast<Char *>(memory + header);
+				wmemcpy(data, s, length);
+				data[length] = 0;
+
+				Atom::Entry * entry = new (memory) Atom::Entry();
+				entry->Hash = hash;
+				entry->Length = length;
+				entry->Data = data;
+				return entry;
+			}
+
+		private:
+			std::vector<std::unique_ptr<char[]>> m_blocks;
+			char * m_current;
+			size_t m_left;
+		};
+
+		/// An open addressing hash table of atoms with a capacity of a power
+		/// of 2
+		class AtomSlots {
+		public:
+			explicit AtomSlots(size_t capacity) :
+				Capacity(capacity), Slots(new std::atomic<const Atom::Entry *>[capacity]) {
+				for (size_t i = 0; i < capacity; ++i)
+					Slots[i].store(nullptr, std::memory_order_relaxed);
+			}
+
+			const size_t Capacity;
+			std::unique_ptr<std::atomic<const Atom::Entry *>[]> Slots;
+
+			const Atom::Entry * find(const Char * s, size_t length, size_t hash) const {
+				for (size_t i = hash & (Capacity - 1);; i = (i + 1) & (Capacity - 1)) {
+					const Atom::Entry * entry = Slots[i].load(std::memory_order_acquire);
+					if (!entry)
+						return nullptr;
+					if (entry->Hash == hash && entry->Length == length && wmemcmp(entry->Data, s, length) == 0)
+						return entry;
+				}
+			}
+
+			void insert(const Atom::Entry * entry) {
+				size_t i = entry->Hash & (Capacity - 1);
+				while (Slots[i].load(std::memory_order_relaxed))
+					i = (i + 1) & (Capacity - 1);
+				Slots[i].store(entry, std::memory_order_release);
+			}
+		};
+
+		/// The global table of atoms.
+		///
+		/// Readers probe the current slots without lock. Entries are published
+		/// with release stores after they are complete. When the slots are half
+		/// full, a larger copy replaces them; the old slots are kept, so that
+		/// concurrent readers never access freed memory. A reader which misses
+		/// an atom created meanwhile checks again under the lock.
+		class AtomTable {
+		public:
+			static const size_t INITIAL_CAPACITY = 1024;
+
+			static AtomTable & get() {
+				static AtomTable table;
+				return table;
+			}
+
+			AtomTable() : m_count(0) {
+				m_tables.push_back(std::unique_ptr<AtomSlots>(new AtomSlots(INITIAL_CAPACITY)));
+				m_slots.store(m_tables.back().get(), std::memory_order_release);
+			}
+
+			const Atom::Entry * find(const Char * s, size_t length, size_t hash) const {
+				return m_slots.load(std::memory_order_acquire)->find(s, length, hash);
+			}
+
+			const Atom::Entry * intern(const Char * s, size_t length, size_t hash) {
+				const Atom::Entry * result = find(s, length, hash);
+				if (result)
+					return result;
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				AtomSlots * slots = m_slots.load(std::memory_order_relaxed);
+				result = slots->find(s, length, hash);
+				if (result)
+					return result;
+
+				if ((m_count + 1) * 2 > slots->Capacity)
+					slots = grow(slots);
+
+				result = m_arena.create(s, length, hash);
+				slots->insert(result);
+				++m_count;
+				return result;
+			}
+
+			size_t getCount() const {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				return m_count;
+			}
+
+		private:
+			mutable std::mutex m_mutex;
+			std::atomic<AtomSlots *> m_slots;
+			/// All slots ever created including the current ones
+			std::vector<std::unique_ptr<AtomSlots>> m_tables;
+			AtomArena m_arena;
+			size_t m_count;
+
+			AtomSlots * grow(AtomSlots * slots) {
+				std::unique_ptr<AtomSlots> larger(new AtomSlots(slots->Capacity * 2));
+				for (size_t i = 0; i < slots->Capacity; ++i) {
+					const Atom::Entry * entry = slots->Slots[i].load(std::memory_order_relaxed);
+					if (entry)
+						larger->insert(entry);
+				}
+
+				AtomSlots * result = larger.get();
+				m_tables.push_back(std::move(larger));
+				m_slots.store(result, std::memory_order_release);
+				return result;
+			}
+		};
+
+		const Atom::Entry * intern(const Char * s, size_t length) {
+			if (length == 0)
+				return &EMPTY_ATOM;
+			return AtomTable::get().intern(s, length, Atom::hashString(s, length));
+		}
+	}
+
+	//////////
+	// Atom //
+	//////////
+
+	Atom::Atom() : m_entry(&EMPTY_ATOM) {}
+	Atom::Atom(const Char * s) : m_entry(s ? intern(s, wcslen(s)) : &EMPTY_ATOM) {}
+	Atom::Atom(const String & s) : m_entry(intern(s.data(), s.size())) {}
+	Atom::Atom(StringView s) : m_entry(intern(s.data(), s.size())) {}
+
+	bool Atom::find(StringView s, Atom & result) {
+		if (s.empty()) {
+			result = Atom();
+			return true;
+		}
+
+		const Atom::Entry * entry = AtomTable::get().find(s.data(), s.size(), hashString(s.data(), s.size()));
+		if (!entry)
+			return false;
+		result = Atom(entry);
+		return true;
+	}
+
+	size_t Atom::getCount() {
+		return AtomTable::get().getCount();
+	}
+
+	size_t Atom::hashString(const Char * s, size_t length) {
+		if (length == 0)
+			return 0;
+
+		// FNV-1a
+		uint64_t result = 14695981039346656037ull;
+		for (size_t i = 0; i < length; ++i) {
+			result ^= (uint64_t)s[i];
+			result *= 1099511628211ull;
+		}
+		return (size_t)(result ^ (result >> 32));
+	}
+}
@@ -0,0 +1,95 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "String.h"
+#include "StringView.h"
+
+#include <functional>
+#include <stddef.h>
+
+namespace v2x {
+
+	/// An interned, immutable string.
+	///
+	/// All atoms of equal strings refer to the same characters, so comparing
+	/// atoms is a pointer compare and their hash is precomputed. Names, font
+	/// families and keys which are compared often should be atoms.
+	///
+	/// The atoms are stored in a global table for the lifetime of the
+	/// process. Interning is thread-safe: looking up an existing atom takes no
+	/// lock, creating a new one locks the table.
+	///
+	class Atom {
+	public:
+		/// The stored form of an atom. The characters are zero-terminated.
+		class Entry {
+		public:
+			size_t Hash;
+			size_t Length;
+			const Char * Data;
+		};
+
+		/// The empty string
+		Atom();
+		Atom(const Char * s);
+		Atom(const String & s);
+		/// Explicit, so that comparing views to strings stays unambiguous
+		explicit Atom(StringView s);
+
+		const Char * c_str() const { return m_entry->Data; }
+		const Char * data() const { return m_entry->Data; }
+		size_t size() const { return m_entry->Length; }
+		bool empty() const { return m_entry->Length == 0; }
+		/// The hash of the characters
+		size_t hash() const { return m_entry->Hash; }
+
+		StringView getView() const { return StringView(m_entry->Data, m_entry->Length); }
+		String toString() const { return String(m_entry->Data, m_entry->Length); }
+		operator String() const { return toString(); }
+
+		bool operator == (const Atom & atom) const { return m_entry == atom.m_entry; }
+		bool operator != (const Atom & atom) const { return m_entry != atom.m_entry; }
+
+		/// Find the atom of a string without creating it. Returns false if
+		/// the string has never been interned.
+		static bool find(StringView s, Atom & result);
+
+		/// Returns the number of atoms created so far
+		static size_t getCount();
+
+		/// Returns the hash of a string, which is the same as that of its atom
+		static size_t hashString(const Char * s, size_t length);
+
+	private:
+		const Entry * m_entry;
+
+		explicit Atom(const Entry * entry) : m_entry(entry) {}
+	};
+
+	// Comparing to strings compares the characters and interns nothing
+	inline bool operator == (const Atom & a, const Char * b) { return a.getView() == StringView(b); }
+	inline bool operator == (const Char * a, const Atom & b) { return b == a; }
+	inline bool operator == (const Atom & a, const String & b) { return a.getView() == StringView(b); }
+	inline bool operator == (const String & a, const Atom & b) { return b == a; }
+	inline bool operator != (const Atom & a, const Char * b) { return !(a == b); }
+	inline bool operator != (const Char * a, const Atom & b) { return !(b == a); }
+	inline bool operator != (const Atom & a, const String & b) { return !(a == b); }
+	inline bool operator != (const String & a, const Atom & b) { return !(b == a); }
+
+	template <>
+	class FormatTraits<Atom> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const Atom & value) {
+			Formatter::writeString(buffer, spec, value.data(), value.size());
+		}
+	};
+}
+
+namespace std {
+
+	template <>
+	struct hash<v2x::Atom> {
+		size_t operator () (const v2x::Atom & atom) const { return atom.hash(); }
+	};
+}
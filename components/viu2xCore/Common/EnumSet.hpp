@@ -2,47 +2,94 @@
 
 #pragma once
 
+#include "EnumString.hpp"
+
+#include <functional>
+#include <type_traits>
+#include <stdint.h>
+
 namespace v2x {
 
-	// A light-weight collection class supporting up to 32 elements.
-	// NOTICE: The maximum value of the enum type MUST be smaller than 32.
+	/// The smallest bit storage for a number of enum values. Without a known
+	/// count (0) it supports 32 values.
+	template <size_t count>
+	class EnumSetBits {
+	public:
+		static_assert(count <= 64, "EnumSet: Too many enum values!");
+		typedef typename std::conditional<count == 0, uint32_t,
+			typename std::conditional<count <= 8, uint8_t,
+			typename std::conditional<count <= 16, uint16_t,
+			typename std::conditional<count <= 32, uint32_t, uint64_t>::type>::type>::type>::type Type;
+	};
+
+	// A light-weight collection class. The storage is sized by the count of
+	// enum values declared by DEFINE_ENUM_STRINGS, up to 64. Otherwise it
+	// supports up to 32 elements.
+	// NOTICE: The maximum value of the enum type MUST be smaller than 32 if
+	// it has no declared strings.
 	template <typename t>
 	class EnumSet {
 	public:
+		typedef typename EnumSetBits<EnumInfo<t>::Count>::Type Bits;
+
 		EnumSet() : m_bits(0) { }
-		explicit EnumSet(const t & value) : m_bits(1 << static_cast <unsigned int> (value)) { }
+		explicit EnumSet(const t & value) : m_bits(bit(value)) { }
 		EnumSet(const EnumSet<t> & set) { m_bits = set.m_bits; }
 
-		void include(t value) { m_bits |= (1 << static_cast <unsigned int> (value)); }
+		/// Create a set from raw bits. Bit i represents the enum value i.
+		static EnumSet<t> fromBits(Bits bits) { EnumSet<t> result; result.m_bits = bits; return result; }
+
+		void include(t value) { m_bits |= bit(value); }
 		void include(const EnumSet<t> & set) { m_bits |= set.m_bits; }
 		EnumSet<t> operator + (t value) const { EnumSet<t> result(*this); result.include(value); return result; }
 		EnumSet<t> operator + (const EnumSet<t> & set) const { EnumSet<t> result(*this); result.include(set); return result; }
 		EnumSet<t> & operator += (t value) { include(value); return *this; }
 		EnumSet<t> & operator += (const EnumSet<t> & set) { include(set); return *this; }
 
-		void exclude(t value) { m_bits &= ~(1 << static_cast <unsigned int> (value)); }
-		void exclude(const EnumSet<t> & set) { m_bits &= ~set.m_bits; }
+		void exclude(t value) { m_bits &= (Bits)~bit(value); }
+		void exclude(const EnumSet<t> & set) { m_bits &= (Bits)~set.m_bits; }
 		EnumSet<t> operator - (t value) const { EnumSet<t> result(*this); result.exclude(value); return result; }
 		EnumSet<t> operator - (const EnumSet<t> & set) const { EnumSet<t> result(*this); result.exclude(set); return result; }
 		EnumSet<t> & operator -= (t value) { exclude(value); return *this; }
 		EnumSet<t> & operator -= (const EnumSet<t> & set) { exclude(set); return *this; }
 
-		EnumSet<t> getComplement() const { EnumSet<t> result; result.m_bits = ~m_bits; return result; }
+		EnumSet<t> getComplement() const { EnumSet<t> result; result.m_bits = (Bits)~m_bits & getMask(); return result; }
 
 		bool intersect(const EnumSet<t> & set) { m_bits &= set.m_bits; return m_bits != 0; }
 		EnumSet<t> operator * (const EnumSet<t> & set) const { EnumSet<t> result(*this); result.intersect(set); return result; }
 
 		bool operator == (const EnumSet<t> & set) const { return m_bits == set.m_bits; }
-		bool operator == (const t & value) const { return m_bits == (1 << static_cast <unsigned int> (value)); }
+		bool operator == (const t & value) const { return m_bits == bit(value); }
 		bool operator != (const EnumSet<t> & set) const { return m_bits != set.m_bits; }
 
 		bool isEmpty() const { return m_bits == 0; }
-		bool contains(t value) const { return (m_bits & (1 << (unsigned int)value)) != 0; }
+		bool contains(t value) const { return (m_bits & bit(value)) != 0; }
 		bool contains(const EnumSet<t> & set) const { return (set.m_bits & ~m_bits) == 0; }
 		void clear() { m_bits = 0; }
 
+		/// Returns the raw bits. Bit i represents the enum value i.
+		Bits getBits() const { return m_bits; }
+
+		/// Returns the bits of all enum values
+		static Bits getMask() {
+			const size_t size = sizeof(Bits) * 8;
+			return (Bits)((Bits)~(Bits)0 >> ((size - EnumInfo<t>::Count) % size));
+		}
+
 	private:
-		unsigned int m_bits;
+		Bits m_bits;
+
+		static Bits bit(t value) { return (Bits)((Bits)1 << static_cast<unsigned int>(value)); }
 	};
 
+}
+
+namespace std {
+
+	template <typename t>
+	struct hash<v2x::EnumSet<t>> {
+		size_t operator () (const v2x::EnumSet<t> & set) const {
+			return hash<uint64_t>()(set.getBits());
+		}
+	};
 }
\ No newline at end of file
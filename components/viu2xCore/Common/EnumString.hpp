@@ -5,48 +5,175 @@
 #include "String.h"
 #include "Exceptions.h"
 
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+
 namespace v2x {
 
-	// IMPORTANT: This class requires that the enum member starts at 0 and has 
-	// no value gap between each other.
+	/// A compile-time view of the name of an enum value
+	class EnumName {
+	public:
+		constexpr EnumName() : Data(nullptr), Length(0) {}
+		template <size_t N>
+		constexpr EnumName(const Char(&name)[N]) : Data(name), Length(N - 1) {}
+
+		const Char * Data;
+		size_t Length;
+
+		bool equals(const Char * s, size_t length) const {
+			if (length != Length)
+				return false;
+			for (size_t i = 0; i < length; ++i)
+				if (s[i] != Data[i])
+					return false;
+			return true;
+		}
+	};
+
+	/// The seeded FNV-1a hash of an enum name
+	constexpr uint32_t hashEnumName(const Char * s, size_t length, uint32_t seed) {
+		uint32_t result = 2166136261u ^ seed;
+		for (size_t i = 0; i < length; ++i) {
+			result ^= (uint32_t)s[i];
+			result *= 16777619u;
+		}
+		return result;
+	}
+
+	/// A perfect hash table over the names of an enum, built at compile time.
+	///
+	/// It searches a seed for which the names hash to distinct slots of a
+	/// table at least twice as large as the number of names. Each slot holds
+	/// the value + 1 or 0 if it is empty.
+	template <size_t N>
+	class EnumHashTable {
+	public:
+		static constexpr size_t SlotCount = N < 4 ? 8 : (N < 32 ? 64 : (N < 128 ? 256 : 1024));
+		static_assert(N <= SlotCount / 2, "EnumHashTable: Too many enum values!");
+
+		constexpr EnumHashTable(const EnumName(&names)[N]) : Seed(0), Slots() {
+			while (!tryBuild(names))
+				++Seed;
+		}
+
+		uint32_t Seed;
+		uint16_t Slots[SlotCount];
+
+		/// Returns the slot of a name
+		size_t getSlot(const Char * s, size_t length) const {
+			return hashEnumName(s, length, Seed) & (SlotCount - 1);
+		}
+
+	private:
+		constexpr bool tryBuild(const EnumName(&names)[N]) {
+			for (size_t i = 0; i < SlotCount; ++i)
+				Slots[i] = 0;
+
+			for (size_t i = 0; i < N; ++i) {
+				const size_t slot = hashEnumName(names[i].Data, names[i].Length, Seed) & (SlotCount - 1);
+				if (Slots[slot] != 0)
+					return false;
+				Slots[slot] = (uint16_t)(i + 1);
+			}
+			return true;
+		}
+	};
+
+	template <size_t N>
+	constexpr size_t EnumHashTable<N>::SlotCount;
+
+	/// The compile-time reflection of an enum. It is declared for an enum by
+	/// DEFINE_ENUM_STRINGS. Enums without declaration have a Count of 0.
+	///
+	/// The second parameter is never used. It makes the static members
+	/// templates, so that they can be defined in headers.
+	template <typename E, typename Tag = void>
+	class EnumInfo {
+	public:
+		static constexpr size_t Count = 0;
+	};
+
+	template <typename E, typename Tag>
+	constexpr size_t EnumInfo<E, Tag>::Count;
+
+	/// Declare the strings of an enum, one for each value in order. It must be
+	/// used in the namespace v2x.
+	///
+	/// IMPORTANT: The enum values must start at 0 and have no gap between each
+	/// other.
+#define DEFINE_ENUM_STRINGS(Enum, ...) \
+	template <typename Tag> \
+	class EnumInfo<Enum, Tag> { \
+	public: \
+		static constexpr EnumName Names[] = { __VA_ARGS__ }; \
+		static constexpr size_t Count = sizeof(Names) / sizeof(EnumName); \
+		static constexpr EnumHashTable<Count> Table = EnumHashTable<Count>(Names); \
+	}; \
+	template <typename Tag> constexpr EnumName EnumInfo<Enum, Tag>::Names[]; \
+	template <typename Tag> constexpr size_t EnumInfo<Enum, Tag>::Count; \
+	template <typename Tag> constexpr EnumHashTable<EnumInfo<Enum, Tag>::Count> EnumInfo<Enum, Tag>::Table
+
+	/// The conversion between enum values and their strings declared by
+	/// DEFINE_ENUM_STRINGS. Parsing takes constant time.
 	template <typename t>
 	class EnumString {
 	public:
-		static String toString(t value) {
+		typedef EnumInfo<t> Info;
 
-			int count = (int)m_strings.size();
-			int i = static_cast<int>(value);
+		/// Returns the number of enum values
+		static constexpr size_t getCount() { return Info::Count; }
 
-			if (i >= count)
-				throw Exception(L"EnumString::toString(): String for the input value (%d) is not found!", i);
+		/// Returns the name of a value without copying
+		static EnumName getName(t value) {
+			const size_t i = static_cast<size_t>(value);
+			if (i >= Info::Count)
+				throw Exception(CHECKED_FORMAT(L"EnumString::getName(): String for the input value (%d) is not found!", (int)i));
+			return Info::Names[i];
+		}
 
-			return m_strings[static_cast<int>(value)];
+		static String toString(t value) {
+			const EnumName name = getName(value);
+			return String(name.Data, name.Length);
 		}
 
 		static t fromString(const String & s) {
+			t result;
+			if (tryParse(s.c_str(), s.size(), result))
+				return result;
 
-			int count = (int)m_strings.size();
-			for (int i = 0; i < count; ++i)
-				if (m_strings[i] == s)
-					return static_cast<T>(i);
-
-			throw Exception(L"EnumString::fromString(): \"%s\" is not a valid enum value!", s.c_str());
+			throw Exception(CHECKED_FORMAT(L"EnumString::fromString(): \"%s\" is not a valid enum value!", s.c_str()));
 		}
 
 		static bool tryParse(const String & s, t & result) {
+			return tryParse(s.c_str(), s.size(), result);
+		}
 
-			int count = (int)m_strings.size();
-			for (int i = 0; i < count; ++i)
-				if (m_strings[i] == s) {
-					result = static_cast<T>(i);
-					return true;
-				}
+		/// Parse a string which is not terminated, e.g. a part of a document
+		static bool tryParse(const Char * s, size_t length, t & result) {
+			const uint16_t slot = Info::Table.Slots[Info::Table.getSlot(s, length)];
+			if (slot == 0 || !Info::Names[slot - 1].equals(s, length))
+				return false;
 
-			return false;
+			result = static_cast<t>(slot - 1);
+			return true;
 		}
+	};
 
-	private:
-		static std::vector<const Char *> m_strings;
+	/// Enums print their declared strings, or their value with integer
+	/// conversions or if they have no strings.
+	template <typename T>
+	class FormatTraits<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const T & value) {
+			typedef typename std::underlying_type<T>::type Underlying;
+
+			const size_t i = static_cast<size_t>(value);
+			if (spec.isInteger() || i >= EnumInfo<T>::Count)
+				FormatTraits<Underlying>::format(buffer, spec, static_cast<Underlying>(value));
+			else
+				Formatter::writeString(buffer, spec, EnumInfo<T>::Names[i].Data, EnumInfo<T>::Names[i].Length);
+		}
 	};
 
-}
\ No newline at end of file
+}
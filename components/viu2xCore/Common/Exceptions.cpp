@@ -38,55 +38,37 @@ namespace v2x {
 	//	initialize(StrUtils::format(message, params), internalException);
 	//}
 
-	Exception::Exception(const Char * message, ...) {
-
-		va_list params;
-		va_start(params, message);
-		initialize(StrUtils::format(message, params));
-		va_end(params);
-	}
-
-	Exception::Exception(const Char * message, va_list params) {
-
-		initialize(StrUtils::format(message, params));
-	}
-
-	Exception::Exception(const Exception & internalException, const Char * message, ...) {
-
-		va_list params;
-		va_start(params, message);
-		initialize(StrUtils::format(message, params), internalException);
-		va_end(params);
-	}
-
-	Exception::Exception(const Exception & internalException, const Char * message, va_list params) {
-
-		initialize(StrUtils::format(message, params), internalException);
-	}
-
 	Exception::~Exception() {
 	}
 
-	void Exception::initialize(const String & message) {
+	void Exception::initialize(const Exception & internalException) {
 
-		// Copy all previous exception messages
-		m_messages.push_front(message);
-	}
-
-	void Exception::initialize(const String & message, const Exception & internalException) {
-
-		// Copy all previous exception messages
-		m_messages.assign(internalException.getMessages().begin(), internalException.getMessages().end());
-
-		m_messages.push_front(message);
+		// Keep all previous exception messages unformatted
+		m_internalMessages.reserve(internalException.m_internalMessages.size() + 1);
+		m_internalMessages.push_back(internalException.m_message);
+		m_internalMessages.insert(m_internalMessages.end(),
+			internalException.m_internalMessages.begin(), internalException.m_internalMessages.end());
 	}
 
 	const String & Exception::getMessage() const {
-		return m_messages.front();
+		return getMessages().front();
 	}
 
 	const std::deque<String> & Exception::getMessages() const {
-		return m_messages;
+		if (!m_messages) {
+			std::shared_ptr<std::deque<String>> messages = std::make_shared<std::deque<String>>();
+			messages->push_back(m_message.format());
+			for (auto i = m_internalMessages.begin(); i != m_internalMessages.end(); ++i)
+				messages->push_back(i->format());
+			m_messages = messages;
+		}
+		return *m_messages;
+	}
+
+	String Exception::Message::format() const {
+		if (Arguments)
+			return Arguments->format(Format);
+		return Formatter::format(Format);
 	}
 
 	/////////////////
@@ -102,11 +84,11 @@ namespace v2x {
 	//}
 
 	OsException::OsException(const Char * caller) :
-		Exception(StrUtils::format(L"%s: %s", caller, getLastErrorMessage().c_str()).c_str()) {
+		Exception(CHECKED_FORMAT(L"%s: %s", caller, getLastErrorMessage())) {
 	}
 
 	OsException::OsException(const Exception & internalException, const Char * caller) :
-		Exception(internalException, L"%s: %s", caller, getLastErrorMessage().c_str()) {
+		Exception(internalException, CHECKED_FORMAT(L"%s: %s", caller, getLastErrorMessage())) {
 	}
 
 	OsException::~OsException() {
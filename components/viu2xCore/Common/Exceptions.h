@@ -5,12 +5,82 @@
 #include "String.h"
 
 #include <deque>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace v2x {
 
+	/// The arguments of an exception message, captured by value so that the
+	/// message can be formatted when it is read.
+	class MessageArguments {
+	public:
+		virtual ~MessageArguments() {}
+		virtual String format(const Char * format) const = 0;
+	};
+
+	/// How an argument is captured. Values are copied, strings given as
+	/// pointers are copied into strings because they may not outlive the
+	/// exception.
+	template <typename T>
+	class MessageArgument {
+	public:
+		typedef T Type;
+		static const T & capture(const T & value) { return value; }
+	};
+
+	template <>
+	class MessageArgument<const Char *> {
+	public:
+		typedef String Type;
+		static String capture(const Char * value) { return value ? String(value) : String(L"(null)"); }
+	};
+
+	template <>
+	class MessageArgument<Char *> : public MessageArgument<const Char *> {};
+
+	template <>
+	class MessageArgument<const char *> {
+	public:
+		typedef std::string Type;
+		static std::string capture(const char * value) { return value ? std::string(value) : std::string("(null)"); }
+	};
+
+	template <>
+	class MessageArgument<char *> : public MessageArgument<const char *> {};
+
+	template <typename... Args>
+	class MessageArgumentPack : public MessageArguments {
+	public:
+		explicit MessageArgumentPack(const Args & ... args) : m_values(args...) {}
+
+		String format(const Char * format) const override {
+			return formatValues(format, std::index_sequence_for<Args...>());
+		}
+
+	private:
+		std::tuple<Args...> m_values;
+
+		template <size_t... I>
+		String formatValues(const Char * format, std::index_sequence<I...>) const {
+			return Formatter::format(format, std::get<I>(m_values)...);
+		}
+	};
+
 	/**
 	 * The common base of all viu2x exceptions.
 	 *
+	 * Constructing an exception formats nothing. It keeps the format string
+	 * and a copy of the arguments, and the message is formatted on the first
+	 * call of getMessage(). Exceptions which are caught and discarded cost
+	 * at most one allocation for their arguments. The format string must
+	 * therefore have static storage duration, e.g. be a literal.
+	 *
+	 * Pass literals with arguments through CHECKED_FORMAT, so that a format
+	 * string which does not match the arguments fails to compile.
+	 *
 	 * @test Types/Exceptions
 	 *
 	 * @author  Qin
@@ -20,22 +90,54 @@ namespace v2x {
 	public:
 		//Exception(const String & message, ...);
 		//Exception(const String & message, va_list params);
-		explicit Exception(const Char * message, ...);
-		Exception(const Char * message, va_list params);
+		/// The message is formatted by Formatter, printf-style but type-safe.
+		template <typename... Args>
+		explicit Exception(const Char * message, const Args & ... args) :
+			m_message(message, capture(args...)) {}
 		//Exception(const Exception & internalException, const String & message, ...);
 		//Exception(const Exception & internalException, const String & message, va_list params);
-		Exception(const Exception & internalException, const Char * message, ...);
-		Exception(const Exception & internalException, const Char * message, va_list params);
+		template <typename... Args>
+		Exception(const Exception & internalException, const Char * message, const Args & ... args) :
+			m_message(message, capture(args...)) {
+			initialize(internalException);
+		}
 		virtual ~Exception();
 
+		/// Returns the message. It is formatted on the first call.
 		const String & getMessage() const;
+		/// Returns the messages of this exception and of all internal ones
 		const std::deque<String> & getMessages() const;
 
 	protected:
-		std::deque<String> m_messages;
+		/// A message which has not been formatted yet
+		class Message {
+		public:
+			Message(const Char * format, const std::shared_ptr<const MessageArguments> & arguments) :
+				Format(format), Arguments(arguments) {}
+
+			const Char * Format;
+			std::shared_ptr<const MessageArguments> Arguments;
+
+			String format() const;
+		};
+
+		Message m_message;
+		/// The messages of the internal exceptions, the innermost last
+		std::vector<Message> m_internalMessages;
+
+		void initialize(const Exception & internalException);
+
+	private:
+		/// The formatted messages, created on demand
+		mutable std::shared_ptr<std::deque<String>> m_messages;
+
+		static std::shared_ptr<const MessageArguments> capture() { return nullptr; }
 
-		void initialize(const String & message);
-		void initialize(const String & message, const Exception & internalException);
+		template <typename... Args>
+		static std::shared_ptr<const MessageArguments> capture(const Args & ... args) {
+			return std::make_shared<MessageArgumentPack<typename MessageArgument<typename std::decay<Args>::type>::Type...>>(
+				MessageArgument<typename std::decay<Args>::type>::capture(args)...);
+		}
 	};
 
 	/**
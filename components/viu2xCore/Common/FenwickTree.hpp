@@ -0,0 +1,123 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "Exceptions.h"
+
+#include <vector>
+#include <stddef.h>
+
+namespace v2x {
+
+	/// A sequence of values with prefix sums in O(log n), also known as
+	/// binary indexed tree.
+	///
+	/// Changing a value and summing the values before an index take
+	/// O(log n). Building the tree from n values takes O(n). Lookups by sum
+	/// require non-negative values, e.g. the sizes of the items of a list:
+	///
+	///     FenwickTree<double> heights(count, estimatedHeight);
+	///     heights.set(index, measuredHeight);
+	///     double top = heights.getPrefixSum(index);
+	///     size_t first = heights.findIndex(scrollOffset);
+	///
+	template <typename T>
+	class FenwickTree {
+	public:
+		FenwickTree() : m_tree(1, T()), m_total() {}
+		explicit FenwickTree(size_t count, const T & value = T()) {
+			assign(count, value);
+		}
+
+		size_t size() const { return m_values.size(); }
+		bool empty() const { return m_values.empty(); }
+
+		void assign(size_t count, const T & value) {
+			assign(count, [&value](size_t) { return value; });
+		}
+
+		/// Build the tree from the values of a function of the index
+		template <typename F>
+		void assign(size_t count, const F & valueOf) {
+			m_values.resize(count);
+			m_tree.assign(count + 1, T());
+			m_total = T();
+
+			for (size_t i = 0; i < count; ++i) {
+				m_values[i] = valueOf(i);
+				m_total += m_values[i];
+
+				// Each node passes its sum on to its parent
+				const size_t node = i + 1;
+				m_tree[node] += m_values[i];
+				const size_t parent = node + (node & (0 - node));
+				if (parent <= count)
+					m_tree[parent] += m_tree[node];
+			}
+		}
+
+		void clear() { assign(0, T()); }
+
+		const T & get(size_t index) const {
+			checkIndex(L"FenwickTree::get()", index);
+			return m_values[index];
+		}
+
+		void set(size_t index, const T & value) {
+			checkIndex(L"FenwickTree::set()", index);
+			const T delta = value - m_values[index];
+			m_values[index] = value;
+			m_total += delta;
+
+			for (size_t node = index + 1; node < m_tree.size(); node += node & (0 - node))
+				m_tree[node] += delta;
+		}
+
+		/// Returns the sum of the values before an index
+		T getPrefixSum(size_t index) const {
+			if (index > m_values.size())
+				throw Exception(CHECKED_FORMAT(L"FenwickTree::getPrefixSum(): Index %d is out of range!", (int)index));
+
+			T result = T();
+			for (size_t node = index; node > 0; node -= node & (0 - node))
+				result += m_tree[node];
+			return result;
+		}
+
+		/// Returns the sum of all values in O(1)
+		const T & getTotal() const { return m_total; }
+
+		/// Returns the index of the value covering a position, i.e. the
+		/// number of values whose sum does not exceed it. Returns size() if
+		/// the position is beyond the total.
+		size_t findIndex(const T & position) const {
+			size_t node = 0;
+			T sum = T();
+
+			size_t step = 1;
+			while (step * 2 < m_tree.size())
+				step *= 2;
+
+			// Descend from the largest power of two within the tree
+			for (; step > 0; step /= 2) {
+				const size_t next = node + step;
+				if (next < m_tree.size() && !(position < sum + m_tree[next])) {
+					node = next;
+					sum += m_tree[next];
+				}
+			}
+			return node;
+		}
+
+	private:
+		std::vector<T> m_values;
+		/// One-based, each node holds the sum of a range ending at it
+		std::vector<T> m_tree;
+		T m_total;
+
+		void checkIndex(const Char * caller, size_t index) const {
+			if (index >= m_values.size())
+				throw Exception(CHECKED_FORMAT(L"%s: Index %d is out of range!", caller, (int)index));
+		}
+	};
+}
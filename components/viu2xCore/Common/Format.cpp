@@ -0,0 +1,245 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "Format.hpp"
+
+#include <algorithm>
+#include <string.h>
+#include <wchar.h>
+
+namespace v2x {
+
+	//////////////////
+	// FormatBuffer //
+	//////////////////
+
+	FormatBuffer::FormatBuffer() : m_data(m_inline), m_size(0), m_capacity(INLINE_SIZE) {}
+
+	FormatBuffer::~FormatBuffer() {
+		if (m_data != m_inline)
+			delete[] m_data;
+	}
+
+	void FormatBuffer::append(const Char * s, size_t length) {
+		if (m_size + length > m_capacity)
+			grow(m_size + length);
+		memcpy(m_data + m_size, s, length * sizeof(Char));
+		m_size += length;
+	}
+
+	void FormatBuffer::append(const char * s, size_t length) {
+		if (m_size + length > m_capacity)
+			grow(m_size + length);
+		for (size_t i = 0; i < length; ++i)
+			m_data[m_size + i] = (Char)(unsigned char)s[i];
+		m_size += length;
+	}
+
+	void FormatBuffer::insert(size_t position, Char c, size_t count) {
+		if (m_size + count > m_capacity)
+			grow(m_size + count);
+		memmove(m_data + position + count, m_data + position, (m_size - position) * sizeof(Char));
+		std::fill(m_data + position, m_data + position + count, c);
+		m_size += count;
+	}
+
+	void FormatBuffer::grow(size_t size) {
+		const size_t capacity = std::max(size, m_capacity * 2);
+		Char * data = new Char[capacity];
+		memcpy(data, m_data, m_size * sizeof(Char));
+		if (m_data != m_inline)
+			delete[] m_data;
+		m_data = data;
+		m_capacity = capacity;
+	}
+
+	///////////////
+	// Formatter //
+	///////////////
+
+	void Formatter::formatArguments(FormatBuffer & buffer, const Char * format,
+		const Argument * arguments, size_t count) {
+
+		size_t next = 0;
+		const Char * p = format;
+
+		while (*p) {
+
+			const Char * literal = p;
+			while (*p && *p != L'%')
+				++p;
+			if (p > literal)
+				buffer.append(literal, p - literal);
+			if (!*p)
+				break;
+
+			if (p[1] == L'%') {
+				buffer.append(L'%');
+				p += 2;
+				continue;
+			}
+
+			FormatSpec spec;
+			const Char * end = parseSpec(p + 1, spec);
+			if (!end) {
+				buffer.append(p, wcslen(p));
+				break;
+			}
+
+			// Keep the specifiers without argument visible
+			if (next >= count) {
+				buffer.append(p, end - p);
+				p = end;
+				continue;
+			}
+
+			const size_t start = buffer.getSize();
+			arguments[next].Write(buffer, spec, arguments[next].Value);
+			++next;
+
+			// Pad to the width
+			const size_t length = buffer.getSize() - start;
+			if (spec.Width > length) {
+				const size_t padding = spec.Width - length;
+				const bool numeric = spec.isFloat() || (spec.isInteger() && spec.Precision < 0);
+
+				if (spec.LeftAlign)
+					buffer.insert(buffer.getSize(), L' ', padding);
+				else if (spec.ZeroPad && numeric) {
+					const Char * data = buffer.getData();
+					size_t position = start;
+					if (data[position] == L'-' || data[position] == L'+' || data[position] == L' ')
+						++position;
+					if (position + 1 < buffer.getSize() && data[position] == L'0' &&
+						(data[position + 1] == L'x' || data[position + 1] == L'X'))
+						position += 2;
+					buffer.insert(position, L'0', padding);
+				}
+				else
+					buffer.insert(start, L' ', padding);
+			}
+
+			p = end;
+		}
+	}
+
+	const Char * Formatter::parseSpec(const Char * format, FormatSpec & spec) {
+
+		for (;; ++format) {
+			if (*format == L'-') spec.LeftAlign = true;
+			else if (*format == L'+') spec.ShowSign = true;
+			else if (*format == L' ') spec.SpaceSign = true;
+			else if (*format == L'0') spec.ZeroPad = true;
+			else if (*format == L'#') spec.Alternate = true;
+			else break;
+		}
+
+		for (; *format >= L'0' && *format <= L'9'; ++format)
+			spec.Width = spec.Width * 10 + (*format - L'0');
+
+		if (*format == L'.') {
+			spec.Precision = 0;
+			for (++format; *format >= L'0' && *format <= L'9'; ++format)
+				spec.Precision = spec.Precision * 10 + (*format - L'0');
+		}
+
+		// Length modifiers
+		while (*format == L'h' || *format == L'l' || *format == L'L' || *format == L'q' ||
+			*format == L'j' || *format == L'z' || *format == L't' || *format == L'w')
+			++format;
+		if (*format == L'I')
+			for (++format; *format >= L'0' && *format <= L'9'; ++format);
+
+		if (!*format)
+			return nullptr;
+
+		spec.Conversion = *format;
+		return format + 1;
+	}
+
+	void Formatter::writeInteger(FormatBuffer & buffer, const FormatSpec & spec, uint64_t magnitude, bool negative) {
+
+		const uint32_t base = spec.Conversion == L'x' || spec.Conversion == L'X' ? 16 : (spec.Conversion == L'o' ? 8 : 10);
+		const Char * symbols = spec.Conversion == L'X' ? L"0123456789ABCDEF" : L"0123456789abcdef";
+		const bool isZero = magnitude == 0;
+
+		// The digits in reverse order
+		Char digits[96];
+		size_t count = 0;
+		if (!(isZero && spec.Precision == 0))
+			do {
+				digits[count++] = symbols[magnitude % base];
+				magnitude /= base;
+			} while (magnitude);
+
+		const size_t precision = (size_t)std::min(std::max(spec.Precision, 0), 64);
+		while (count < precision)
+			digits[count++] = L'0';
+		if (spec.Alternate && base == 8 && (count == 0 || digits[count - 1] != L'0'))
+			digits[count++] = L'0';
+
+		if (negative)
+			buffer.append(L'-');
+		else if (spec.ShowSign && spec.Conversion != L'u' && base == 10)
+			buffer.append(L'+');
+		else if (spec.SpaceSign && spec.Conversion != L'u' && base == 10)
+			buffer.append(L' ');
+
+		if (spec.Alternate && base == 16 && !isZero) {
+			buffer.append(L'0');
+			buffer.append(spec.Conversion == L'X' ? L'X' : L'x');
+		}
+
+		while (count > 0)
+			buffer.append(digits[--count]);
+	}
+
+	void Formatter::writeFloat(FormatBuffer & buffer, const FormatSpec & spec, double value) {
+
+		// The width is applied by formatArguments()
+		Char format[16];
+		size_t i = 0;
+		format[i++] = L'%';
+		if (spec.ShowSign) format[i++] = L'+';
+		if (spec.SpaceSign) format[i++] = L' ';
+		if (spec.Alternate) format[i++] = L'#';
+		format[i++] = L'.';
+		format[i++] = L'*';
+		format[i++] = spec.isFloat() ? spec.Conversion : L'g';
+		format[i] = 0;
+
+		// The largest double has 309 digits before the decimal point
+		Char result[512];
+		const int precision = spec.Precision < 0 ? 6 : std::min(spec.Precision, 100);
+		const int length = swprintf(result, sizeof(result) / sizeof(Char), format, precision, value);
+		if (length > 0)
+			buffer.append(result, (size_t)length);
+	}
+
+	void Formatter::writeString(FormatBuffer & buffer, const FormatSpec & spec, const Char * s, size_t length) {
+		if (spec.Precision >= 0)
+			length = std::min(length, (size_t)spec.Precision);
+		buffer.append(s, length);
+	}
+
+	void Formatter::writeString(FormatBuffer & buffer, const FormatSpec & spec, const char * s, size_t length) {
+		if (spec.Precision >= 0)
+			length = std::min(length, (size_t)spec.Precision);
+		buffer.append(s, length);
+	}
+
+	void Formatter::writeWideString(FormatBuffer & buffer, const FormatSpec & spec, const void * value) {
+		const Char * s = static_cast<const Char *>(value);
+		if (s)
+			writeString(buffer, spec, s, wcslen(s));
+		else
+			writeString(buffer, spec, L"(null)", 6);
+	}
+
+	void Formatter::writeNarrowString(FormatBuffer & buffer, const FormatSpec & spec, const void * value) {
+		const char * s = static_cast<const char *>(value);
+		if (s)
+			writeString(buffer, spec, s, strlen(s));
+		else
+			writeString(buffer, spec, L"(null)", 6);
+	}
+}
@@ -0,0 +1,318 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "String.h"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace v2x {
+
+	/// The output buffer of the formatter. Short results stay in the inline
+	/// storage and need no allocation.
+	class FormatBuffer {
+	public:
+		static const size_t INLINE_SIZE = 256;
+
+		FormatBuffer();
+		~FormatBuffer();
+
+		void append(Char c) {
+			if (m_size == m_capacity)
+				grow(m_size + 1);
+			m_data[m_size++] = c;
+		}
+		void append(const Char * s, size_t length);
+		void append(const char * s, size_t length);
+		/// Insert count copies of a character at a position
+		void insert(size_t position, Char c, size_t count);
+
+		const Char * getData() const { return m_data; }
+		size_t getSize() const { return m_size; }
+		String toString() const { return String(m_data, m_size); }
+
+	private:
+		Char m_inline[INLINE_SIZE];
+		Char * m_data;
+		size_t m_size;
+		size_t m_capacity;
+
+		void grow(size_t size);
+
+		FormatBuffer(const FormatBuffer &);
+		FormatBuffer & operator = (const FormatBuffer &);
+	};
+
+	/// A parsed printf-style conversion specification:
+	/// %[flags][width][.precision][length]conversion
+	///
+	/// The length modifiers (h, l, ll, I64, z...) are accepted and ignored,
+	/// because the size is taken from the argument type.
+	class FormatSpec {
+	public:
+		FormatSpec() : LeftAlign(false), ShowSign(false), SpaceSign(false), ZeroPad(false),
+			Alternate(false), Width(0), Precision(-1), Conversion(L's') {}
+
+		bool LeftAlign;
+		bool ShowSign;
+		bool SpaceSign;
+		bool ZeroPad;
+		bool Alternate;
+		uint32_t Width;
+		/// -1 if not specified
+		int32_t Precision;
+		Char Conversion;
+
+		bool isSignedInteger() const { return Conversion == L'd' || Conversion == L'i'; }
+		bool isUnsignedInteger() const {
+			return Conversion == L'u' || Conversion == L'x' || Conversion == L'X' || Conversion == L'o';
+		}
+		bool isInteger() const { return isSignedInteger() || isUnsignedInteger(); }
+		bool isFloat() const {
+			return Conversion == L'f' || Conversion == L'F' || Conversion == L'e' || Conversion == L'E' ||
+				Conversion == L'g' || Conversion == L'G' || Conversion == L'a' || Conversion == L'A';
+		}
+	};
+
+	/// The conversion of a type to text. Specialize it to make a type
+	/// formattable. There are specializations for numbers, characters,
+	/// strings and pointers here, for enums in EnumString.hpp and for
+	/// matrices and rectangles in their headers.
+	template <typename T, typename Enable = void>
+	class FormatTraits {
+	public:
+		static_assert(sizeof(T) == 0, "FormatTraits: The type is not formattable!");
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const T & value);
+	};
+
+	/// A type-safe formatter for printf-style format strings.
+	///
+	/// The conversion of an argument is chosen by its type, so a wrong
+	/// specifier can not read garbage: %d prints an unsigned value as signed
+	/// of the same size, %s prints any type in its default form. Missing
+	/// arguments leave their specifiers in the output, surplus arguments are
+	/// ignored. Formatting never throws except on allocation failure, so
+	/// that exceptions can use it safely.
+	///
+	/// Results up to FormatBuffer::INLINE_SIZE characters are composed
+	/// without heap allocation.
+	///
+	class Formatter {
+	public:
+
+		/// A type-erased reference to an argument
+		class Argument {
+		public:
+			typedef void(*Writer)(FormatBuffer & buffer, const FormatSpec & spec, const void * value);
+
+			const void * Value;
+			Writer Write;
+		};
+
+		template <typename... Args>
+		static String format(const Char * format, const Args & ... args) {
+			FormatBuffer buffer;
+			formatTo(buffer, format, args...);
+			return buffer.toString();
+		}
+
+		template <typename... Args>
+		static void formatTo(FormatBuffer & buffer, const Char * format, const Args & ... args) {
+			const Argument arguments[] = { makeArgument(args)..., Argument() };
+			formatArguments(buffer, format, arguments, sizeof...(Args));
+		}
+
+		/// Returns the number of arguments a format string consumes. It can
+		/// be evaluated at compile time, see CHECKED_FORMAT.
+		static constexpr size_t countArguments(const Char * format) {
+			size_t result = 0;
+			for (; *format; ++format)
+				if (*format == L'%') {
+					if (format[1] == L'%')
+						++format;
+					else if (format[1])
+						++result;
+				}
+			return result;
+		}
+
+		/// Returns the format string. It fails to compile if the numbers of
+		/// the expected and the given arguments differ, see CHECKED_FORMAT.
+		template <size_t EXPECTED, size_t GIVEN>
+		static constexpr const Char * checkArguments(const Char * format) {
+			static_assert(EXPECTED == GIVEN, "The format string does not match the number of arguments!");
+			return format;
+		}
+
+		/// Format the arguments into a buffer
+		static void formatArguments(FormatBuffer & buffer, const Char * format,
+			const Argument * arguments, size_t count);
+
+		/// Parse a conversion specification after a '%'. Returns a pointer
+		/// behind it or nullptr if it is incomplete.
+		static const Char * parseSpec(const Char * format, FormatSpec & spec);
+
+		/// Write an integer with sign, base and precision
+		static void writeInteger(FormatBuffer & buffer, const FormatSpec & spec, uint64_t magnitude, bool negative);
+		/// Write a floating point number. The conversion defaults to %g.
+		static void writeFloat(FormatBuffer & buffer, const FormatSpec & spec, double value);
+		/// Write a string, truncated to the precision
+		static void writeString(FormatBuffer & buffer, const FormatSpec & spec, const Char * s, size_t length);
+		static void writeString(FormatBuffer & buffer, const FormatSpec & spec, const char * s, size_t length);
+
+	private:
+		template <typename T>
+		static void write(FormatBuffer & buffer, const FormatSpec & spec, const void * value) {
+			FormatTraits<T>::format(buffer, spec, *static_cast<const T *>(value));
+		}
+
+		static void writeWideString(FormatBuffer & buffer, const FormatSpec & spec, const void * value);
+		static void writeNarrowString(FormatBuffer & buffer, const FormatSpec & spec, const void * value);
+
+		template <typename T>
+		static Argument makeArgument(const T & value) {
+			Argument result = { &value, &write<T> };
+			return result;
+		}
+
+		// Strings are referenced directly, so that literals need no traits
+		// for each array size.
+		static Argument makeArgument(const Char * value) {
+			Argument result = { value, &writeWideString };
+			return result;
+		}
+		static Argument makeArgument(Char * value) {
+			return makeArgument(static_cast<const Char *>(value));
+		}
+		static Argument makeArgument(const char * value) {
+			Argument result = { value, &writeNarrowString };
+			return result;
+		}
+		static Argument makeArgument(char * value) {
+			return makeArgument(static_cast<const char *>(value));
+		}
+	};
+
+	/// Pass a format string literal and its arguments to a formatting call,
+	/// e.g. of an exception, and check at compile time that the format
+	/// string consumes as many arguments as are given:
+	///
+	///     throw Exception(CHECKED_FORMAT(L"Index %d of %d is out of range!", index, count));
+	///
+	#define CHECKED_FORMAT(format, ...) \
+		::v2x::Formatter::checkArguments<v2x::Formatter::countArguments(format), \
+			std::tuple_size<decltype(std::forward_as_tuple(__VA_ARGS__))>::value>(format), __VA_ARGS__
+
+	/// Integers. The conversions d and i print them signed, u, x, X and o
+	/// unsigned and all others as they are.
+	template <typename T>
+	class FormatTraits<T, typename std::enable_if<std::is_integral<T>::value &&
+		!std::is_same<T, bool>::value && !std::is_same<T, Char>::value && !std::is_same<T, char>::value>::type> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const T & value) {
+			typedef typename std::make_signed<T>::type Signed;
+			typedef typename std::make_unsigned<T>::type Unsigned;
+
+			if (spec.isFloat())
+				Formatter::writeFloat(buffer, spec, (double)value);
+			else if (spec.isUnsignedInteger() || (!spec.isSignedInteger() && std::is_unsigned<T>::value))
+				Formatter::writeInteger(buffer, spec, static_cast<Unsigned>(value), false);
+			else {
+				const Signed s = static_cast<Signed>(value);
+				const uint64_t magnitude = s < 0 ? (uint64_t)0 - (uint64_t)(int64_t)s : (uint64_t)s;
+				Formatter::writeInteger(buffer, spec, magnitude, s < 0);
+			}
+		}
+	};
+
+	/// Floating point numbers. Integer conversions print them rounded.
+	template <typename T>
+	class FormatTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const T & value) {
+			if (spec.isInteger()) {
+				const int64_t i = (int64_t)(value < 0 ? value - 0.5 : value + 0.5);
+				FormatTraits<int64_t>::format(buffer, spec, i);
+			}
+			else
+				Formatter::writeFloat(buffer, spec, (double)value);
+		}
+	};
+
+	/// Booleans print true or false, or 1 and 0 with integer conversions
+	template <>
+	class FormatTraits<bool> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const bool & value) {
+			if (spec.isInteger())
+				Formatter::writeInteger(buffer, spec, value ? 1 : 0, false);
+			else if (value)
+				Formatter::writeString(buffer, spec, L"true", 4);
+			else
+				Formatter::writeString(buffer, spec, L"false", 5);
+		}
+	};
+
+	/// Characters print themselves, or their code with integer conversions
+	template <typename T>
+	class FormatTraits<T, typename std::enable_if<std::is_same<T, Char>::value || std::is_same<T, char>::value>::type> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const T & value) {
+			if (spec.isInteger())
+				Formatter::writeInteger(buffer, spec, (uint64_t)value, false);
+			else {
+				const Char c = (Char)value;
+				Formatter::writeString(buffer, spec, &c, 1);
+			}
+		}
+	};
+
+	template <>
+	class FormatTraits<String> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const String & value) {
+			Formatter::writeString(buffer, spec, value.c_str(), value.size());
+		}
+	};
+
+	template <>
+	class FormatTraits<std::string> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const std::string & value) {
+			Formatter::writeString(buffer, spec, value.c_str(), value.size());
+		}
+	};
+
+	/// Pointers print their address in hex
+	template <typename T>
+	class FormatTraits<T *> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, T * const & value) {
+			FormatSpec hex(spec);
+			hex.Conversion = L'x';
+			hex.Alternate = true;
+			Formatter::writeInteger(buffer, hex, (uint64_t)(uintptr_t)value, false);
+		}
+	};
+
+	template <>
+	class FormatTraits<std::nullptr_t> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const std::nullptr_t &) {
+			Formatter::writeString(buffer, spec, L"nullptr", 7);
+		}
+	};
+
+	//////////////
+	// StrUtils //
+	//////////////
+
+	template <typename... Args>
+	String StrUtils::format(const Char * format, const Args & ... args) {
+		return Formatter::format(format, args...);
+	}
+}
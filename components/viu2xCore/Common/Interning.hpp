@@ -0,0 +1,130 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+
+namespace v2x {
+
+	/// Mix a hash value into a seed (the well known boost recipe).
+	inline size_t hashCombine(size_t seed, size_t value) {
+		return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+	}
+
+	/// The hashing used by InternPool. By default the method hash() of the
+	/// type is used.
+	template <typename T>
+	class InternTraits {
+	public:
+		static size_t hash(const T & value) { return value.hash(); }
+	};
+
+	/// A pool of immutable shared instances (flyweights).
+	///
+	/// Interning a value returns the pooled instance equal to it, so equal
+	/// values share one copy in memory and can be compared by pointer. The
+	/// pool does not own the instances: an instance is released as soon as
+	/// the last reference to it is gone.
+	///
+	/// The pool is not thread-safe. It is meant to be used by the GUI thread.
+	///
+	template <typename T>
+	class InternPool {
+	public:
+		typedef std::shared_ptr<const T> Instance;
+
+		InternPool() : m_internCount(0) {}
+		~InternPool() {}
+
+		/// Returns the global pool of the type.
+		static InternPool<T> & getDefault() {
+			static InternPool<T> pool;
+			return pool;
+		}
+
+		/// Returns the shared instance equal to the value. A new instance
+		/// is created if there is no such instance yet.
+		Instance intern(const T & value) {
+
+			const size_t hash = InternTraits<T>::hash(value);
+			auto & bucket = m_buckets[hash];
+
+			Instance result;
+			for (auto i = bucket.begin(); i != bucket.end();) {
+				Instance instance = i->lock();
+				if (!instance) {
+					i = bucket.erase(i);
+					continue;
+				}
+				if (!result && *instance == value)
+					result = instance;
+				++i;
+			}
+
+			if (!result) {
+				result = std::make_shared<const T>(value);
+				bucket.push_back(result);
+			}
+
+			// Drop the buckets of released instances from time to time.
+			if (++m_internCount >= 2 * m_buckets.size() + 64)
+				purge();
+
+			return result;
+		}
+
+		/// Returns the instance of the default constructed value. It is kept
+		/// alive by the pool.
+		const Instance & getEmpty() {
+			if (!m_empty)
+				m_empty = intern(T());
+			return m_empty;
+		}
+
+		/// Remove all released instances from the pool.
+		void purge() {
+			for (auto i = m_buckets.begin(); i != m_buckets.end();) {
+				auto & bucket = i->second;
+				bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+					[](const std::weak_ptr<const T> & instance) { return instance.expired(); }),
+					bucket.end());
+				if (bucket.empty())
+					i = m_buckets.erase(i);
+				else
+					++i;
+			}
+			m_internCount = 0;
+		}
+
+		/// Returns the number of distinct instances alive.
+		size_t getUniqueCount() const {
+			size_t result = 0;
+			for (auto i = m_buckets.begin(); i != m_buckets.end(); ++i)
+				for (auto j = i->second.begin(); j != i->second.end(); ++j)
+					if (!j->expired())
+						++result;
+			return result;
+		}
+
+		/// Returns the number of references to all instances, i.e. the number
+		/// of values which would exist without interning. The reference kept
+		/// by getEmpty() is not counted.
+		size_t getTotalCount() const {
+			size_t result = 0;
+			for (auto i = m_buckets.begin(); i != m_buckets.end(); ++i)
+				for (auto j = i->second.begin(); j != i->second.end(); ++j)
+					result += j->use_count();
+			return m_empty ? result - 1 : result;
+		}
+
+	private:
+		std::unordered_map<size_t, std::vector<std::weak_ptr<const T>>> m_buckets;
+		size_t m_internCount;
+		Instance m_empty;
+	};
+}
@@ -536,13 +536,33 @@ namespace v2x {
 				fromRow < 0 || toRow < fromRow || toRow >= ROWS)
 				throw Exception(L"Matrix_T::eliminate: Column or row index out of range!");
 
+			// Check if the zone is a square matrix
+			if (toCol - fromCol != toRow - fromRow)
+				throw Exception(L"Matrix_T::eliminate: Only square sub-matrix can be eliminated!");
+
+			if (!tryEliminate(fromCol, fromRow, toCol, toRow))
+				throw Exception(L"Matrix_T::eliminate: The specified zone cannot be eliminated!");
+		}
+
+		/// The same as eliminate() without exceptions, e.g. to probe whether a
+		/// matrix is invertible.
+		///
+		/// @return false if the sub-matrix cannot be eliminated, is not square
+		/// 		or out of range. The matrix may have been changed partly then.
+		bool tryEliminate(int fromCol, int fromRow, int toCol, int toRow) noexcept {
+
+			// Check if the input column-/row-indices is in a valid range.
+			if (fromCol < 0 || toCol < fromCol || toCol >= COLS || //
+				fromRow < 0 || toRow < fromRow || toRow >= ROWS)
+				return false;
+
 			// Calculate the size of the zone.
 			int dCol = toCol - fromCol + 1;
 			int dRow = toRow - fromRow + 1;
 
 			// Check if the zone is a square matrix
 			if (dCol != dRow)
-				throw Exception(L"Matrix_T::eliminate: Only square sub-matrix can be eliminated!");
+				return false;
 
 			// Check if the zone has at more than one column/row.
 			if (dCol > 1) {
@@ -574,7 +594,7 @@ namespace v2x {
 							// Check if the row is found.
 							if (nz < 0)
 								// If not found, it means the matrix cannot be eliminated.
-								throw Exception(L"Matrix_T::eliminate: The specified zone cannot be eliminated!");
+								return false;
 
 							// Adapt the current row.
 							// After this operation, the current diagonal element should be 1 and all elements (in the sub-matrix and
@@ -613,7 +633,7 @@ namespace v2x {
 					// be true. Just left here for higher security)
 					if (m_elements[current_row][current_col] == 0)
 						// If true, this matrix cannot be eliminated.
-						throw Exception(L"Matrix_T::eliminate: The specified zone cannot be eliminated!");
+						return false;
 
 					// Do it for all rows (in the same column) above the diagonal element.
 					for (int r = current_row - 1; r >= fromRow; r--) {
@@ -632,7 +652,7 @@ namespace v2x {
 				// Check if the element is zero.
 				if (m_elements[fromRow][fromCol] == 0)
 					// if true, the matrix cannot be eliminated.
-					throw Exception(L"Matrix_T::eliminate: The specified zone cannot be eliminated!");
+					return false;
 
 				// To avoid divisions, just compute a scale factor first, then only multiplications are used later.
 				T factor = 1 / m_elements[fromRow][fromCol];
@@ -641,6 +661,8 @@ namespace v2x {
 				for (int i = 0; i < COLS; i++)
 					m_elements[fromRow][i] *= factor;
 			}
+
+			return true;
 		}
 
 		/// Returns a transposed version of the current matrix. The current matrix is not changed.
@@ -728,23 +750,7 @@ namespace v2x {
 
 		/// Returns a string representation of the matrix in C++ syntax.
 		String toString() const {
-			std::wostringstream ss;
-			ss.precision(32);
-			ss << "{";
-			for (int i = 0; i < ROWS; i++) {
-				ss << "{";
-				for (int j = 0; j < COLS; j++) {
-					ss << m_elements[i][j];
-					if (j < COLS - 1)
-						ss << ", ";
-				}
-				ss << "}";
-				if (j < ROWS - 1)
-					ss << ", ";
-			}
-			ss << "}";
-
-			return ss.str();
+			return Formatter::format(L"%.17g", *this);
 		}
 
 		/// Return true if all elements are normal numbers.
@@ -842,6 +848,31 @@ namespace v2x {
 		T2 & height() { return m_elements[1][0]; }
 	};
 
+	/// Matrices print in C++ syntax, e.g. {{1, 2}, {3, 4}}. The conversion
+	/// specification applies to each element.
+	template <typename T, size_t ROWS, size_t COLS>
+	class FormatTraits<Matrix_T<T, ROWS, COLS>> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const Matrix_T<T, ROWS, COLS> & value) {
+			FormatSpec element(spec);
+			element.Width = 0;
+
+			buffer.append(L'{');
+			for (int i = 0; i < (int)ROWS; i++) {
+				if (i > 0)
+					buffer.append(L", ", 2);
+				buffer.append(L'{');
+				for (int j = 0; j < (int)COLS; j++) {
+					if (j > 0)
+						buffer.append(L", ", 2);
+					FormatTraits<T>::format(buffer, element, value[i][j]);
+				}
+				buffer.append(L'}');
+			}
+			buffer.append(L'}');
+		}
+	};
+
 	template<typename T>
 	using Vector2D_T = Matrix_T<T, 2, 1>;
 	using Vector2D32I = Vector2D_T<int32_t>;
@@ -4,16 +4,32 @@
 
 namespace v2x {
 
-	Message::Message() : m_id(UNSPECIFIED_MESSAGE_ID) {
+	Message::Message() : m_id(UNSPECIFIED_MESSAGE_ID), m_payloadType(nullptr) {
 	}
 
-	Message::Message(Id id, const Object::Shared & data) : m_id(id), m_data(data) {
+	Message::Message(Id id) : m_id(id), m_payloadType(nullptr) {
+	}
+
+	Message::Message(Id id, const Object::Shared & data) : m_id(id), m_data(data), m_payloadType(nullptr) {
+	}
+
+	Message::Message(const Message & message) :
+		Object(), m_id(message.m_id), m_data(message.m_data), m_payloadType(message.m_payloadType) {
+		memcpy(m_payload, message.m_payload, PAYLOAD_CAPACITY);
 	}
 
 	/// We always need a virtual destructor.
 	Message::~Message() {
 	}
 
+	Message & Message::operator = (const Message & message) {
+		m_id = message.m_id;
+		m_data = message.m_data;
+		m_payloadType = message.m_payloadType;
+		memcpy(m_payload, message.m_payload, PAYLOAD_CAPACITY);
+		return *this;
+	}
+
 	Message::Id Message::getId() const {
 		return m_id;
 	}
@@ -22,6 +38,23 @@ namespace v2x {
 		return m_data;
 	}
 
+	TypeId Message::getPayloadType() const {
+		return m_payloadType;
+	}
+
+	const void * Message::getRawPayload() const {
+		return m_payload;
+	}
+
+	void Message::setRawPayload(TypeId type, const void * data, size_t size) {
+
+		if (size > PAYLOAD_CAPACITY)
+			throw Exception(CHECKED_FORMAT(L"Message::setRawPayload(): The payload size (%u) exceeds the capacity!", (unsigned int)size));
+
+		memcpy(m_payload, data, size);
+		m_payloadType = type;
+	}
+
 	MessageHandler::MessageHandler() {}
 
 	MessageHandler::~MessageHandler() {}
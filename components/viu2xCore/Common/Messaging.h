@@ -3,6 +3,12 @@
 #pragma once
 
 #include "Object.h"
+#include "TypeId.hpp"
+#include "Exceptions.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
 
 namespace v2x {
 
@@ -14,6 +20,12 @@ namespace v2x {
 	// contrary side, Event will be used for communication between the GUI 
 	/// framework and the user logic.
 	///
+	/// A message can carry its data in two ways:
+	/// - A small trivially copyable payload stored inline in the message. It
+	///   is type-checked by a compile-time type ID and needs no allocation,
+	///   so messages can be created on the stack and passed by value.
+	/// - A shared pointer to an Object for large data.
+	///
 	class Message : public Object {
 	public:
 		DEFINE_POINTERS(Message);
@@ -24,16 +36,34 @@ namespace v2x {
 		/// The unspecified message ID
 		static const Id UNSPECIFIED_MESSAGE_ID = 0;
 
+		/// The maximum size of the inline payload in bytes
+		static const size_t PAYLOAD_CAPACITY = 32;
+
 		/// The default constructor
 		Message();
 
-		/// The constructor refers to an external data. It is also the only way 
-		/// to set the message ID.
+		/// The constructor for a message without any data.
+		explicit Message(Id id);
+
+		/// The constructor refers to an external data.
 		Message(Id id, const Object::Shared & data);
 
+		/// The constructor copies the input value into the inline payload.
+		template <typename T, typename TEST = typename std::enable_if<
+			!std::is_convertible<T, Object::Shared>::value>::type>
+		Message(Id id, const T & payload) : m_id(id), m_payloadType(nullptr) {
+			setPayload(payload);
+		}
+
+		/// The copy constructor
+		Message(const Message & message);
+
 		/// We always need a virtual destructor.
 		virtual ~Message();
 
+		/// The assignment copies the ID, the payload and the data reference.
+		Message & operator = (const Message & message);
+
 		/// This function returns the message ID i.e. the purpose or cause of 
 		/// this message.
 		Id getId() const;
@@ -49,9 +79,66 @@ namespace v2x {
 			return std::dynamic_pointer_cast<T>(m_data);
 		}
 
+		/// This function copies the input value into the inline payload.
+		template <typename T>
+		void setPayload(const T & payload) {
+			static_assert(std::is_trivially_copyable<T>::value,
+				"Type of inline message payload must be trivially copyable");
+			static_assert(sizeof(T) <= PAYLOAD_CAPACITY,
+				"Type of inline message payload is too large, use shared data instead");
+			static_assert(alignof(T) <= alignof(double),
+				"Type of inline message payload is over-aligned");
+
+			memcpy(m_payload, &payload, sizeof(T));
+			m_payloadType = typeIdOf<T>();
+		}
+
+		/// Return true if the message carries an inline payload of type T.
+		template <typename T>
+		bool hasPayload() const { return m_payloadType == typeIdOf<T>(); }
+
+		/// Return true if the message carries any inline payload.
+		bool hasPayload() const { return m_payloadType != nullptr; }
+
+		/// This function returns the inline payload.
+		///
+		/// @throw Exception if the message does not carry a payload of type T.
+		template <typename T>
+		const T & getPayload() const {
+			if (!hasPayload<T>())
+				throw Exception(L"Message::getPayload(): The actual payload type is unexpected!");
+			return *reinterpret_cast<const T *>(m_payload);
+		}
+
+		/// This function returns nullptr instead of throwing if the message
+		/// does not carry a payload of type T.
+		template <typename T>
+		const T * tryGetPayload() const {
+			return hasPayload<T>() ? reinterpret_cast<const T *>(m_payload) : nullptr;
+		}
+
+		/// This function returns the type of the inline payload or nullptr if 
+		/// there is no payload.
+		TypeId getPayloadType() const;
+
+		/// This function returns the raw bytes of the inline payload.
+		const void * getRawPayload() const;
+
+		/// This function sets the inline payload from raw bytes. It is meant 
+		/// for deserialization where the payload type is known at runtime only.
+		///
+		/// @throw Exception if the size exceeds PAYLOAD_CAPACITY.
+		void setRawPayload(TypeId type, const void * data, size_t size);
+
 	protected:
-		const Id m_id;
+		Id m_id;
 		Object::Shared m_data;
+
+		TypeId m_payloadType;
+		union {
+			double m_payloadAlignment;
+			uint8_t m_payload[PAYLOAD_CAPACITY];
+		};
 	};
 
 #define MESSAGE(id, sharedDataPointer) Message::Shared(new Message((id), sharedDataPointer))
@@ -0,0 +1,285 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "Exceptions.h"
+#include "EnumString.hpp"
+#include "Ownership.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+namespace v2x {
+
+	/// The kinds of changes of an ObservableVector
+	enum class CollectionAction : uint8_t {
+		/// Count elements have been inserted at Index
+		Insert,
+		/// OldItems have been removed from Index
+		Remove,
+		/// Count elements have been moved from Index to NewIndex
+		Move,
+		/// OldItems at Index have been replaced by Count elements
+		Replace,
+		/// The whole content has been replaced by Count elements
+		Reset
+	};
+	/// The strings for CollectionAction
+	DEFINE_ENUM_STRINGS(CollectionAction,
+		L"Insert",
+		L"Remove",
+		L"Move",
+		L"Replace",
+		L"Reset"
+	);
+
+	/// The data of the change notification of an ObservableVector. Each
+	/// operation on a range is reported by a single notification.
+	template <typename T>
+	class CollectionChange {
+	public:
+		CollectionChange(CollectionAction action, size_t index, size_t count) :
+			Action(action), Index(index), NewIndex(index), Count(count) {}
+
+		CollectionAction Action;
+		/// The first affected position before the change
+		size_t Index;
+		/// The position of the moved elements after the change
+		size_t NewIndex;
+		/// The number of inserted, replacing or moved elements
+		size_t Count;
+		/// The removed or replaced elements
+		std::vector<T> OldItems;
+	};
+
+	/// A vector which notifies its listener about changes of its content.
+	///
+	/// The elements are unique. An index from element to position makes
+	/// indexOf() and contains() O(1). Operations on ranges update the index
+	/// only from the first affected position on, so appending is O(1) per
+	/// element and bulk operations cost one pass instead of one per element.
+	///
+	/// The listener is called after each operation with the vector as sender
+	/// and a CollectionChange<T> as data.
+	///
+	template <typename T, typename Hash = std::hash<T>>
+	class ObservableVector {
+	public:
+		typedef T ValueType;
+		typedef CollectionChange<T> Change;
+		typedef typename std::vector<T>::const_iterator ConstIterator;
+
+		static const size_t NotFound = (size_t)-1;
+
+		ObservableVector(const Listener & listener = nullptr) : m_listener(listener) {}
+		~ObservableVector() {}
+
+		void setListener(const Listener & listener) { m_listener = listener; }
+
+		size_t size() const { return m_items.size(); }
+		bool empty() const { return m_items.empty(); }
+
+		const T & operator [] (size_t index) const { return m_items[index]; }
+		const T & at(size_t index) const {
+			if (index >= m_items.size())
+				throw Exception(CHECKED_FORMAT(L"ObservableVector::at(): Index %d is out of range!", (int)index));
+			return m_items[index];
+		}
+
+		ConstIterator begin() const { return m_items.begin(); }
+		ConstIterator end() const { return m_items.end(); }
+
+		/// Returns the position of an element or NotFound
+		size_t indexOf(const T & value) const {
+			auto i = m_index.find(value);
+			return i == m_index.end() ? NotFound : i->second;
+		}
+		bool contains(const T & value) const {
+			return m_index.find(value) != m_index.end();
+		}
+
+		void push_back(const T & value) {
+			insert(m_items.size(), &value, &value + 1);
+		}
+
+		void insert(size_t index, const T & value) {
+			insert(index, &value, &value + 1);
+		}
+
+		/// Insert a range of elements at a position
+		///
+		/// @throw Exception if the index is out of range or an element is
+		///        already contained.
+		template <typename I>
+		void insert(size_t index, I first, I last) {
+			if (index > m_items.size())
+				throw Exception(CHECKED_FORMAT(L"ObservableVector::insert(): Index %d is out of range!", (int)index));
+
+			const size_t count = (size_t)std::distance(first, last);
+			if (count == 0)
+				return;
+
+			checkUnique(first, last);
+			m_items.insert(m_items.begin() + index, first, last);
+			reindex(index, m_items.size());
+
+			Change change(CollectionAction::Insert, index, count);
+			notify(change);
+		}
+
+		template <typename I>
+		void append(I first, I last) {
+			insert(m_items.size(), first, last);
+		}
+
+		/// Remove a range of elements
+		///
+		/// @throw Exception if the range is out of range.
+		void remove(size_t index, size_t count = 1) {
+			checkRange(L"ObservableVector::remove()", index, count);
+			if (count == 0)
+				return;
+
+			Change change(CollectionAction::Remove, index, 0);
+			takeItems(index, count, change.OldItems);
+			m_items.erase(m_items.begin() + index, m_items.begin() + index + count);
+			reindex(index, m_items.size());
+
+			notify(change);
+		}
+
+		/// Remove an element. Returns false if it is not contained.
+		bool removeValue(const T & value) {
+			const size_t index = indexOf(value);
+			if (index == NotFound)
+				return false;
+			remove(index, 1);
+			return true;
+		}
+
+		/// Move a range of elements so that it starts at newIndex afterwards
+		///
+		/// @throw Exception if one of the ranges is out of range.
+		void move(size_t index, size_t count, size_t newIndex) {
+			checkRange(L"ObservableVector::move()", index, count);
+			checkRange(L"ObservableVector::move()", newIndex, count);
+			if (count == 0 || index == newIndex)
+				return;
+
+			auto begin = m_items.begin();
+			if (newIndex < index)
+				std::rotate(begin + newIndex, begin + index, begin + index + count);
+			else
+				std::rotate(begin + index, begin + index + count, begin + newIndex + count);
+			reindex(std::min(index, newIndex), std::max(index, newIndex) + count);
+
+			Change change(CollectionAction::Move, index, count);
+			change.NewIndex = newIndex;
+			notify(change);
+		}
+
+		/// Replace a range of elements by another one
+		///
+		/// @throw Exception if the range is out of range or a new element is
+		///        contained outside of the replaced range.
+		template <typename I>
+		void replace(size_t index, size_t count, I first, I last) {
+			checkRange(L"ObservableVector::replace()", index, count);
+
+			Change change(CollectionAction::Replace, index, (size_t)std::distance(first, last));
+			takeItems(index, count, change.OldItems);
+
+			// The replaced elements may be inserted again
+			try {
+				checkUnique(first, last);
+			}
+			catch (...) {
+				reindex(index, index + count);
+				throw;
+			}
+
+			m_items.erase(m_items.begin() + index, m_items.begin() + index + count);
+			m_items.insert(m_items.begin() + index, first, last);
+			reindex(index, m_items.size());
+
+			notify(change);
+		}
+
+		/// Replace the whole content
+		template <typename I>
+		void assign(I first, I last) {
+			std::vector<T> items(first, last);
+			std::unordered_map<T, size_t, Hash> index;
+			for (size_t i = 0; i < items.size(); ++i)
+				if (!index.insert(std::make_pair(items[i], i)).second)
+					throw Exception(CHECKED_FORMAT(L"ObservableVector::assign(): Element %d is contained twice!", (int)i));
+
+			Change change(CollectionAction::Reset, 0, items.size());
+			change.OldItems.swap(m_items);
+			m_items.swap(items);
+			m_index.swap(index);
+
+			notify(change);
+		}
+
+		void clear() {
+			if (m_items.empty())
+				return;
+			const T * none = nullptr;
+			assign(none, none);
+		}
+
+	private:
+		std::vector<T> m_items;
+		std::unordered_map<T, size_t, Hash> m_index;
+		Listener m_listener;
+
+		void reindex(size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				m_index[m_items[i]] = i;
+		}
+
+		void takeItems(size_t index, size_t count, std::vector<T> & items) {
+			items.assign(m_items.begin() + index, m_items.begin() + index + count);
+			for (auto i = items.begin(); i != items.end(); ++i)
+				m_index.erase(*i);
+		}
+
+		template <typename I>
+		void checkUnique(I first, I last) const {
+			for (I i = first; i != last; ++i)
+				if (m_index.find(*i) != m_index.end())
+					throw Exception(CHECKED_FORMAT(L"ObservableVector::insert(): Element %d is already contained!",
+						(int)std::distance(first, i)));
+
+			// Duplicates within the range itself
+			if (std::distance(first, last) > 1) {
+				std::unordered_map<T, size_t, Hash> added;
+				for (I i = first; i != last; ++i)
+					if (!added.insert(std::make_pair(*i, 0)).second)
+						throw Exception(CHECKED_FORMAT(L"ObservableVector::insert(): Element %d is contained twice!",
+							(int)std::distance(first, i)));
+			}
+		}
+
+		void checkRange(const Char * caller, size_t index, size_t count) const {
+			if (index > m_items.size() || count > m_items.size() - index)
+				throw Exception(CHECKED_FORMAT(L"%s: Range %d+%d is out of range!", caller, (int)index, (int)count));
+		}
+
+		void notify(const Change & change) {
+			if (m_listener)
+				m_listener(this, &change);
+		}
+
+		ObservableVector(const ObservableVector &);
+		ObservableVector & operator = (const ObservableVector &);
+	};
+
+	template <typename T, typename Hash>
+	const size_t ObservableVector<T, Hash>::NotFound;
+}
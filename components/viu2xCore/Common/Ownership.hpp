@@ -2,7 +2,20 @@
 
 #pragma once
 
+#include "String.h"
+#include "Atom.h"
+#include "EnumSet.hpp"
+#include "Interning.hpp"
+#include "Transaction.h"
+#include "Reactive.h"
+
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <stdint.h>
 
 namespace v2x {
 
@@ -10,87 +23,407 @@ namespace v2x {
 
 #define LISTENER(owner_ptr, method_ptr) std::bind(&method_ptr, owner_ptr, std::placeholders::_1, std::placeholders::_2)
 
-	template <typename T>
-	class Notifier {
+	class Specification;
+	class FieldTrackingSpec;
+	class CompositeSpec;
+
+	/// The data passed to the listener of a specification with fields, i.e.
+	/// a composite specification or a SharedSpec.
+	///
+	/// All changes batched by beginUpdate()/endUpdate() or an UpdateTransaction
+	/// are merged into one SpecChange.
+	class SpecChange {
+	public:
+		SpecChange(const Specification * spec, uint32_t changedFields) : Spec(spec), ChangedFields(changedFields) {}
+
+		/// The specification which has been changed
+		const Specification * Spec;
+
+		/// Bit i is set if the field i has been changed
+		uint32_t ChangedFields;
+
+		/// Returns the changed fields as a set of the Field enum of the
+		/// specification, e.g. getFields<LayoutSpec::Field>().
+		template <typename F>
+		EnumSet<F> getFields() const { return EnumSet<F>::fromBits(ChangedFields); }
+
+		template <typename F>
+		bool contains(F field) const { return (ChangedFields & (1u << static_cast<uint32_t>(field))) != 0; }
+	};
+
+	/// This class describes who gets notified when a specification changes.
+	///
+	/// A specification is either a member of a composite specification (e.g.
+	/// ScalarSpec::Size) or a top level specification owned by some other
+	/// object (e.g. Control::Layout). Only top level specifications keep a
+	/// type-erased Listener; members notify their parent directly.
+	///
+	/// SpecOwner is implicitly constructible from anything a Listener can be
+	/// constructed from, so the constructors of specifications accept
+	/// LISTENER(...), Listener objects and nullptr as before.
+	class SpecOwner {
 	public:
-		Notifier(const Listener & listener) : //
-			m_memberChangeListener(std::bind(&Notifier<T>::doOnMemberChange, this, std::placeholders::_1, std::placeholders::_2)), //
-			m_beginUpdateCount(0), m_isChanged(false), m_listener(listener) {}
-		virtual ~Notifier() {}
+		/// No owner at all
+		SpecOwner() : m_parent(nullptr), m_field(0) {}
+
+		/// A member of a composite specification
+		SpecOwner(CompositeSpec * parent, uint8_t field) : m_parent(parent), m_field(field) {}
+
+		/// A top level specification notifying a listener
+		template <typename F, typename TEST = typename std::enable_if<
+			std::is_constructible<Listener, F>::value &&
+			!std::is_same<typename std::decay<F>::type, SpecOwner>::value>::type>
+		SpecOwner(F && listener) : m_parent(nullptr), m_field(0), m_listener(std::forward<F>(listener)) {}
+
+		CompositeSpec * getParent() const { return m_parent; }
+		uint8_t getField() const { return m_field; }
+		const Listener & getListener() const { return m_listener; }
+
+	private:
+		CompositeSpec * m_parent;
+		uint8_t m_field;
+		Listener m_listener;
+	};
+
+	/// The common base of all specifications.
+	///
+	/// A specification holds a value which may be unset, i.e. inherited from
+	/// some default. It notifies its owner about every change. Changes can be
+	/// batched by beginUpdate()/endUpdate(), or across many specifications by
+	/// an UpdateTransaction.
+	///
+	/// To keep specifications small, the set-flags of the members of a
+	/// composite specification are packed into one mask in the parent and
+	/// the notification to the parent is a plain (non-virtual) call. The
+	/// only std::function is the one of a top level specification.
+	///
+	/// Listeners of specifications with fields receive a SpecChange as data.
+	///
+	/// Specifications are not polymorphic and should be used as value-types.
+	class Specification {
+		friend class FieldTrackingSpec;
+		friend class CompositeSpec;
+		friend class UpdateTransaction;
+	public:
+		Specification() : m_parent(nullptr), m_beginUpdateCount(0), m_field(0), m_flags(0) {}
+		Specification(bool isSet) : m_parent(nullptr), m_beginUpdateCount(0), m_field(0), m_flags(0) {
+			setIsSet(isSet);
+		}
+		Specification(const SpecOwner & owner, bool isSet) : m_parent(nullptr), m_beginUpdateCount(0), m_field(0), m_flags(0) {
+			attach(owner);
+			setIsSet(isSet);
+		}
+		/// Copying a specification does NOT copy its owner.
+		Specification(const Specification & spec) : m_parent(nullptr), m_beginUpdateCount(0), m_field(0), m_flags(0) {
+			setIsSet(spec.isSet());
+		}
+		~Specification() {
+			if (m_flags & FLAG_IS_DEFERRED)
+				UpdateTransaction::cancelNotification(this);
+			if (m_flags & FLAG_HAS_LISTENER)
+				delete m_listener;
+		}
+
+		bool isSet() const;
 
 		void beginUpdate() { ++m_beginUpdateCount; }
 		void endUpdate() {
 			if (m_beginUpdateCount > 0) {
 				--m_beginUpdateCount;
-				if (m_beginUpdateCount == 0 && m_isChanged)
+				if (m_beginUpdateCount == 0 && isChanged())
 					notifyChange(this, this);
 			}
 		}
 		bool isChanged() const {
-			return m_isChanged;
+			return (m_flags & FLAG_IS_CHANGED) != 0;
 		}
 
 	protected:
+		/// Set or clear the set-flag. It is stored in the parent if there is
+		/// one, otherwise in the specification itself.
+		void setIsSet(bool isSet);
+
+		/// A function for members to notify changes to owner.
+		void notifyChange(const void * sender, const void * data);
+
+		/// Set-flag of a top level specification
+		static const uint8_t FLAG_IS_SET = 0x01;
+		/// The specification has been changed during an update
+		static const uint8_t FLAG_IS_CHANGED = 0x02;
+		/// m_parent is valid
+		static const uint8_t FLAG_HAS_PARENT = 0x04;
+		/// m_listener is valid
+		static const uint8_t FLAG_HAS_LISTENER = 0x08;
+		/// The notification is deferred by an UpdateTransaction
+		static const uint8_t FLAG_IS_DEFERRED = 0x10;
+		/// The specification is a FieldTrackingSpec
+		static const uint8_t FLAG_TRACKS_FIELDS = 0x20;
 
-		// A bounded functor to doOnMemberChange.
-		Listener m_memberChangeListener;
+	private:
+		union {
+			CompositeSpec * m_parent;
+			Listener * m_listener;
+		};
+		uint16_t m_beginUpdateCount;
+		uint8_t m_field;
+		uint8_t m_flags;
+
+		/// Called by UpdateTransaction on commit.
+		void notifyDeferredChange() {
+			m_flags &= ~FLAG_IS_DEFERRED;
+			callListener(this, this);
+		}
 
-		// A function for members to notify changes to owner.
-		virtual void notifyChange(const void * sender, const void * data) {
+		void callListener(const void * sender, const void * data);
 
-			if (m_beginUpdateCount == 0) {
-				if (m_listener != nullptr)
-					m_listener(sender, data);
-				m_isChanged = false;
+		void attach(const SpecOwner & owner) {
+			if (owner.getParent() != nullptr) {
+				m_parent = owner.getParent();
+				m_field = owner.getField();
+				m_flags |= FLAG_HAS_PARENT;
+			}
+			else if (owner.getListener() != nullptr) {
+				m_listener = new Listener(owner.getListener());
+				m_flags |= FLAG_HAS_LISTENER;
 			}
-			else m_isChanged = true;
 		}
 
-		// A function called when some member notifies that it has been changed.
-		virtual void doOnMemberChange(const void * sender, const void * data) {
+		// Specifications must be copied by value only through the assignment
+		// operators of the derived classes.
+		Specification & operator = (const Specification &);
+	};
 
-			// Forward the notification to owner.
-			notifyChange(this, sender);
+	/// The common base of specifications which record the fields changed
+	/// since their last notification. It supports up to 32 fields.
+	///
+	/// These specifications also carry a version and a cached hash, so that
+	/// they can serve as cache keys. The version is a stamp from one global
+	/// monotonic counter which is renewed on every change of the value, so a
+	/// cache can be validated by a single integer compare. A change of a
+	/// member renews the versions and drops the cached hashes of all its
+	/// parents immediately, even while their notifications are batched.
+	/// The hash is computed lazily, reusing the cached hashes of unchanged
+	/// members.
+	class FieldTrackingSpec : public Specification {
+		friend class Specification;
+	public:
+		FieldTrackingSpec() : m_version(newVersion()), m_hash(0), m_changedFields(0) {
+			m_flags |= FLAG_TRACKS_FIELDS;
+		}
+		FieldTrackingSpec(const SpecOwner & owner, bool isSet) :
+			Specification(owner, isSet), m_version(newVersion()), m_hash(0), m_changedFields(0) {
+			m_flags |= FLAG_TRACKS_FIELDS;
+		}
+		/// The cached hash is copied with the value.
+		FieldTrackingSpec(const FieldTrackingSpec & spec) :
+			Specification(spec), m_version(newVersion()), m_hash(spec.m_hash), m_changedFields(0) {
+			m_flags |= FLAG_TRACKS_FIELDS;
+		}
+
+		/// Returns the fields changed since the last notification. Bit i
+		/// belongs to field i.
+		uint32_t getChangedFields() const { return m_changedFields; }
+
+		/// Returns the version of the current value.
+		uint64_t getVersion() const { return m_version; }
+
+		/// Returns a new stamp from the global version counter. It is greater
+		/// than all versions issued before.
+		static uint64_t newVersion() {
+			static std::atomic<uint64_t> counter(0);
+			return ++counter;
+		}
+
+	protected:
+		/// Returns the bit of a field in the masks.
+		template <typename F>
+		static uint32_t fieldBit(F field) { return 1u << static_cast<uint32_t>(field); }
+
+		/// Record changed fields and notify the owner.
+		void notifyFieldChange(uint32_t fields) {
+			m_changedFields |= fields;
+			touch();
+			notifyChange(this, this);
+		}
+
+		/// Returns true and the hash if it is cached.
+		bool getCachedHash(size_t & hash) const {
+			hash = m_hash;
+			return m_hash != 0;
+		}
+		/// Cache a computed hash and return it. Zero is reserved for "not
+		/// computed" and replaced.
+		size_t setCachedHash(size_t hash) const {
+			m_hash = hash != 0 ? hash : 1;
+			return m_hash;
+		}
+		/// Take over the cached hash of an equal specification.
+		void copyCachedHash(const FieldTrackingSpec & spec) {
+			m_hash = spec.m_hash;
 		}
 
 	private:
-		int m_beginUpdateCount;
-		bool m_isChanged;
+		uint64_t m_version;
+		mutable size_t m_hash;
+		uint32_t m_changedFields;
 
-		Listener m_listener;
+		/// Renew the version and drop the cached hash of this specification
+		/// and all its parents.
+		void touch();
+
+		FieldTrackingSpec & operator = (const FieldTrackingSpec &);
 	};
 
-	class Specification {
+	/// The common base of specifications consisting of member specifications.
+	///
+	/// It supports up to 32 members. Each member is identified by a field
+	/// index which is also its bit in the set-mask and the change-mask.
+	class CompositeSpec : public FieldTrackingSpec {
+		friend class Specification;
 	public:
-		Specification() : m_isSet(false) {}
-		Specification(const Specification & spec) : m_isSet(spec.isSet()) {}
-		Specification(bool isSet) : m_isSet(isSet) {}
-		virtual ~Specification() {}
+		CompositeSpec() : m_setMask(0) {}
+		CompositeSpec(const SpecOwner & owner) : FieldTrackingSpec(owner, false), m_setMask(0) {}
+		CompositeSpec(const CompositeSpec & spec) : FieldTrackingSpec(), m_setMask(0) {
+			copyCachedHash(spec);
+		}
+		/// Used by the copy constructors of derived classes, which copy the
+		/// members themselves.
+		CompositeSpec(const CompositeSpec & spec, const SpecOwner & owner) : FieldTrackingSpec(owner, false), m_setMask(0) {
+			copyCachedHash(spec);
+		}
 
-		virtual bool isSet() const { return m_isSet; }
-		virtual void unset() { m_isSet = false; }
+		/// Returns the set-flags of all members. Bit i belongs to field i.
+		uint32_t getSetMask() const { return m_setMask; }
 
 	protected:
-		bool m_isSet;
+		/// Create the owner descriptor for a member.
+		template <typename F>
+		SpecOwner member(F field) { return SpecOwner(this, static_cast<uint8_t>(field)); }
+
+		/// Called by members after they have been changed.
+		void doOnMemberChange(const Specification * member) {
+			// Forward the notification to owner.
+			notifyFieldChange(1u << member->m_field);
+		}
+
+	private:
+		uint32_t m_setMask;
+
+		bool isMemberSet(uint8_t field) const { return (m_setMask & (1u << field)) != 0; }
+
+		void setMemberSet(uint8_t field, bool isSet) {
+			const bool wasSet = m_setMask != 0;
+			if (isSet) m_setMask |= (1u << field);
+			else m_setMask &= ~(1u << field);
+			if (wasSet != (m_setMask != 0))
+				setIsSet(m_setMask != 0);
+		}
+
+		CompositeSpec & operator = (const CompositeSpec &);
+	};
+
+	inline bool Specification::isSet() const {
+		if (m_flags & FLAG_HAS_PARENT)
+			return m_parent->isMemberSet(m_field);
+		return (m_flags & FLAG_IS_SET) != 0;
+	}
+
+	inline void Specification::setIsSet(bool isSet) {
+		if (m_flags & FLAG_HAS_PARENT)
+			m_parent->setMemberSet(m_field, isSet);
+		else if (isSet) m_flags |= FLAG_IS_SET;
+		else m_flags &= ~FLAG_IS_SET;
+	}
+
+	inline void Specification::notifyChange(const void * sender, const void * data) {
+
+		if (m_beginUpdateCount > 0) {
+			m_flags |= FLAG_IS_CHANGED;
+			return;
+		}
+
+		m_flags &= ~FLAG_IS_CHANGED;
+
+		if (m_flags & FLAG_HAS_LISTENER) {
+			// Within a transaction the listener is notified once on commit.
+			if (m_flags & FLAG_IS_DEFERRED)
+				return;
+			if (UpdateTransaction::deferNotification(this)) {
+				m_flags |= FLAG_IS_DEFERRED;
+				return;
+			}
+			callListener(sender, data);
+			return;
+		}
+
+		// The parent records the field of this specification, so the own
+		// changed fields are consumed here.
+		if (m_flags & FLAG_TRACKS_FIELDS)
+			static_cast<FieldTrackingSpec *>(this)->m_changedFields = 0;
+
+		if (m_flags & FLAG_HAS_PARENT)
+			m_parent->doOnMemberChange(this);
+	}
+
+	inline void FieldTrackingSpec::touch() {
+		const uint64_t version = newVersion();
+		FieldTrackingSpec * spec = this;
+		while (spec) {
+			spec->m_version = version;
+			spec->m_hash = 0;
+			spec = (spec->m_flags & FLAG_HAS_PARENT) ? spec->m_parent : nullptr;
+		}
+	}
+
+	inline void Specification::callListener(const void * sender, const void * data) {
+		if (m_flags & FLAG_TRACKS_FIELDS) {
+			FieldTrackingSpec * spec = static_cast<FieldTrackingSpec *>(this);
+			SpecChange change(this, spec->m_changedFields);
+			spec->m_changedFields = 0;
+			(*m_listener)(this, &change);
+		}
+		else
+			(*m_listener)(sender, data);
+	}
+
+	/// The comparison and hashing used by SimpleSpec. NAN values are
+	/// considered equal to each other.
+	template <typename T>
+	class SpecValueTraits {
+	public:
+		static bool equals(const T & a, const T & b) { return a == b; }
+		static size_t hash(const T & value) { return std::hash<T>()(value); }
+	};
+
+	template <>
+	class SpecValueTraits<double> {
+	public:
+		static bool equals(const double & a, const double & b) {
+			if (std::isnan(a))
+				return std::isnan(b);
+			return a == b;
+		}
+		static size_t hash(const double & value) {
+			return std::isnan(value) ? 0 : std::hash<double>()(value);
+		}
 	};
 
+	/// A specification holding a single value.
 	template <typename T>
-	class SimpleSpec : public Specification, public Notifier < SimpleSpec <T> > {
+	class SimpleSpec : public Specification {
 
 	public:
 
 		typedef T ValueType;
 
-		SimpleSpec(const Listener & listener = nullptr) : //
-			Specification(false),
-			Notifier < SimpleSpec <T> >(listener) {
-			memset(&m_value, 0, sizeof(m_value));
-		}
-		SimpleSpec(const T & value, const Listener & listener = nullptr) :
-			Specification(true),
-			Notifier < SimpleSpec <T> >(listener), m_value(value) {
-		}
-		virtual ~SimpleSpec() {}
+		SimpleSpec(const SpecOwner & owner = SpecOwner()) :
+			Specification(owner, false), m_value() {}
+		SimpleSpec(const T & value, const SpecOwner & owner = SpecOwner()) :
+			Specification(owner, true), m_value(value) {}
+		SimpleSpec(const SimpleSpec <T> & spec) :
+			Specification(spec), m_value(spec.m_value) {}
+		SimpleSpec(const SimpleSpec <T> & spec, const SpecOwner & owner) :
+			Specification(owner, spec.isSet()), m_value(spec.m_value) {}
 
 		// Implicit conversion
 		operator T() const { return m_value; }
@@ -98,52 +431,68 @@ namespace v2x {
 		// A getter
 		const T & get() const { return m_value; }
 
-		// A setter
+		// A setter. Setting an equal value is not a change.
 		void set(const T & value) {
+			if (isSet() && SpecValueTraits<T>::equals(m_value, value))
+				return;
 			m_value = value;
-			m_isSet = true;
+			setIsSet(true);
 			notifyChange(this, &m_value);
 		}
 
 		// Assignment
 		SimpleSpec <T> & operator = (const T & value) {
-			m_value = value;
-			m_isSet = true;
-			notifyChange(this, &m_value);
+			set(value);
 			return *this;
 		}
 
 		// Assignment
 		SimpleSpec <T> & operator = (const SimpleSpec<T> & value) {
+			if (*this == value)
+				return *this;
 			m_value = value.get();
-			m_isSet = value.isSet();
+			setIsSet(value.isSet());
 			notifyChange(this, this);
 			return *this;
 		}
 
 		void unset() {
-			if (!m_isSet)
+			if (!isSet())
 				return;
-			Specification::unset();
+			setIsSet(false);
 			notifyChange(this, this);
 		}
 
 		bool operator == (const SimpleSpec <T> & value) const {
 
-			if (m_isSet != value.isSet())
+			if (isSet() != value.isSet())
 				return false;
 
-			if (!m_isSet)
+			if (!isSet())
 				return true;
 
-			return m_value == value.get();
+			return SpecValueTraits<T>::equals(m_value, value.get());
 		}
 		bool operator != (const SimpleSpec <T> & value) const {
+			return !(*this == value);
+		}
 
-			if (isSet() != value.isSet())
-				return true;
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const {
+			return isSet() ? SpecValueTraits<T>::hash(m_value) : 0;
+		}
 
-			return m_value != value.get();
+		/// Keep the value equal to a reactive value, e.g. a Signal<T> or a
+		/// Computed<T>. The spec is set whenever the source changes and is
+		/// bound as long as the returned effect exists. The source must outlive
+		/// the effect.
+		template <typename S>
+		std::unique_ptr<Effect> bind(S & source) {
+			return std::unique_ptr<Effect>(new Effect([this, &source]() {
+				const T value = source.get();
+				// Listeners of the spec must not become dependencies
+				ReactiveNode::untracked([this, &value]() { set(value); });
+			}));
 		}
 
 	private:
@@ -155,157 +504,98 @@ namespace v2x {
 	typedef SimpleSpec<int64_t> Int64Spec;
 	typedef SimpleSpec<uint64_t> UInt64Spec;
 
-	// Specialization for decimal
-	template <>
-	class SimpleSpec<double> : public Specification, public Notifier < SimpleSpec <double> > {
+	typedef SimpleSpec<double> NumberSpec;
+
+	typedef SimpleSpec<String> StringSpec;
+	/// A string compared by pointer, e.g. a name. See Atom.
+	typedef SimpleSpec<Atom> AtomSpec;
+
+	/// A specification referring to an interned, immutable instance of a
+	/// composite specification.
+	///
+	/// Equal values share one instance from InternPool<T>::getDefault(), so
+	/// thousands of controls with the same layout cost one pointer each and
+	/// comparing them is a pointer compare. Writes are copy-on-write: the
+	/// value is copied, modified and interned again.
+	///
+	/// The fields of T are tracked like those of a composite specification.
+	///
+	/// T must provide a copy constructor, operator ==, hash() and diff().
+	template <typename T>
+	class SharedSpec : public FieldTrackingSpec {
 
 	public:
-		SimpleSpec(const Listener & listener = nullptr) : //
-			Specification(false),
-			Notifier < SimpleSpec <double> >(listener), m_value(0) {
-		}
-		SimpleSpec(const double & value, const Listener & listener = nullptr) :
-			Specification(true),
-			Notifier < SimpleSpec <double> >(listener), m_value(value) {
-		}
-		virtual ~SimpleSpec() {}
 
-		// Implicit conversion
-		operator double() const { return m_value; }
+		typedef T ValueType;
+		typedef typename InternPool<T>::Instance Instance;
+
+		SharedSpec(const SpecOwner & owner = SpecOwner()) :
+			FieldTrackingSpec(owner, false), m_instance(InternPool<T>::getDefault().getEmpty()) {}
+		SharedSpec(const T & value, const SpecOwner & owner = SpecOwner()) :
+			FieldTrackingSpec(owner, value.isSet()), m_instance(InternPool<T>::getDefault().intern(value)) {}
+		SharedSpec(const SharedSpec <T> & spec) :
+			FieldTrackingSpec(spec), m_instance(spec.m_instance) {}
+
+		operator const T & () const { return *m_instance; }
+		const T * operator -> () const { return m_instance.get(); }
 
 		// A getter
-		const double & get() const { return m_value; }
+		const T & get() const { return *m_instance; }
+
+		/// Returns the shared instance.
+		const Instance & getInstance() const { return m_instance; }
 
 		// A setter
-		void set(const double & value) {
-			m_value = value;
-			m_isSet = true;
-			notifyChange(this, &m_value);
+		void set(const T & value) {
+			setInstance(InternPool<T>::getDefault().intern(value));
 		}
 
-		void unset() {
-			if (!m_isSet)
-				return;
-			Specification::unset();
-			notifyChange(this, this);
+		/// Modify a copy of the current value and apply it. The modifier is
+		/// called with a T & argument.
+		template <typename F>
+		void edit(F modifier) {
+			T value(*m_instance);
+			modifier(value);
+			set(value);
 		}
 
 		// Assignment
-		SimpleSpec <double> & operator = (const double & value) {
-			m_value = value;
-			m_isSet = true;
-			notifyChange(this, &m_value);
+		SharedSpec <T> & operator = (const T & value) {
+			set(value);
 			return *this;
 		}
 
 		// Assignment
-		SimpleSpec <double> & operator = (const SimpleSpec<double> & value) {
-			m_value = value.get();
-			m_isSet = value.isSet();
-			notifyChange(this, this);
+		SharedSpec <T> & operator = (const SharedSpec <T> & value) {
+			setInstance(value.m_instance);
 			return *this;
 		}
 
-		bool operator == (const SimpleSpec <double> & value) const {
-
-			if (isSet() != value.isSet())
-				return false;
-
-			if (!isSet())
-				return true;
-
-			if (std::isnan(m_value))
-				return std::isnan(value.get());
-
-			return m_value == value.get();
-		}
-		bool operator != (const SimpleSpec <double> & value) const {
-
-			if (isSet() != value.isSet())
-				return true;
-
-			if (std::isnan(m_value))
-				return !std::isnan(value.get());
-
-			return m_value != value.get();
-		}
-
-	private:
-		double m_value;
-	};
-
-	typedef SimpleSpec<double> NumberSpec;
-
-	// Specialization for string
-	template <>
-	class SimpleSpec<String> : public Specification, public Notifier < SimpleSpec <String> > {
-
-	public:
-		SimpleSpec(const Listener & listener = nullptr) : //
-			Specification(false),
-			Notifier < SimpleSpec <String> >(listener), m_value(L"") {}
-		SimpleSpec(const String & value, const Listener & listener = nullptr) : //
-			Specification(false),
-			Notifier < SimpleSpec <String> >(listener), m_value(value) {}
-		virtual ~SimpleSpec() {}
-
-		// Implicit conversion
-		operator String() const { return m_value; }
-
-		// A getter
-		const String & get() const { return m_value; }
-
-		// A setter
-		void set(const String & value) {
-			m_value = value;
-			m_isSet = true;
-			notifyChange(this, &m_value);
-		}
-
 		void unset() {
-			if (!m_isSet)
-				return;
-			Specification::unset();
-			notifyChange(this, this);
+			setInstance(InternPool<T>::getDefault().getEmpty());
 		}
 
-		// Assignment
-		SimpleSpec <String> & operator = (const String & value) {
-			m_value = value;
-			m_isSet = true;
-			notifyChange(this, &m_value);
-			return *this;
+		bool operator == (const SharedSpec <T> & value) const {
+			return m_instance == value.m_instance;
 		}
-
-		// Assignment
-		SimpleSpec <String> & operator = (const SimpleSpec<String> & value) {
-			m_value = value.get();
-			m_isSet = value.isSet();
-			notifyChange(this, this);
-			return *this;
+		bool operator != (const SharedSpec <T> & value) const {
+			return m_instance != value.m_instance;
 		}
 
-		bool operator == (const SimpleSpec <String> & value) const {
-
-			if (isSet() != value.isSet())
-				return false;
-
-			if (!isSet())
-				return true;
-
-			return m_value == value.get();
+		size_t hash() const {
+			return m_instance->hash();
 		}
-		bool operator != (const SimpleSpec <String> & value) const {
 
-			if (isSet() != value.isSet())
-				return true;
+	private:
+		Instance m_instance;
 
-			return m_value != value.get();
+		void setInstance(const Instance & instance) {
+			if (instance == m_instance)
+				return;
+			const uint32_t fields = m_instance->diff(*instance);
+			m_instance = instance;
+			setIsSet(m_instance->isSet());
+			notifyFieldChange(fields);
 		}
-
-	private:
-		String m_value;
 	};
-
-	typedef SimpleSpec<String> StringSpec;
-}
\ No newline at end of file
+}
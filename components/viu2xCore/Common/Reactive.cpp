@@ -0,0 +1,178 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "Reactive.h"
+#include "Transaction.h"
+
+#include <algorithm>
+
+namespace v2x {
+
+	namespace {
+
+		class EffectQueue {
+		public:
+			EffectQueue() : IsFlushing(false) {}
+
+			std::vector<ReactiveNode *> Effects;
+			bool IsFlushing;
+		};
+
+		EffectQueue & getEffectQueue() {
+			static EffectQueue queue;
+			return queue;
+		}
+	}
+
+	//////////////////
+	// ReactiveNode //
+	//////////////////
+
+	ReactiveNode::ReactiveNode() : m_state(State::Clean) {}
+
+	ReactiveNode::~ReactiveNode() {
+		unlinkSources();
+		for (auto i = m_observers.begin(); i != m_observers.end(); ++i) {
+			auto & sources = (*i)->m_sources;
+			sources.erase(std::remove(sources.begin(), sources.end(), this), sources.end());
+		}
+	}
+
+	void ReactiveNode::track() {
+		ReactiveNode * current = currentNode();
+		if (!current || current == this)
+			return;
+
+		if (std::find(current->m_sources.begin(), current->m_sources.end(), this) != current->m_sources.end())
+			return;
+
+		current->m_sources.push_back(this);
+		m_observers.push_back(current);
+	}
+
+	void ReactiveNode::updateIfNecessary() {
+
+		// Pull the sources first. They may turn this node dirty.
+		if (m_state == State::Check) {
+			std::vector<ReactiveNode *> sources(m_sources);
+			for (auto i = sources.begin(); i != sources.end(); ++i) {
+				(*i)->updateIfNecessary();
+				if (m_state == State::Dirty)
+					break;
+			}
+		}
+
+		if (m_state == State::Dirty && recompute()) {
+			for (auto i = m_observers.begin(); i != m_observers.end(); ++i)
+				if ((*i)->m_state == State::Check)
+					(*i)->m_state = State::Dirty;
+		}
+
+		m_state = State::Clean;
+	}
+
+	void ReactiveNode::notifyObservers() {
+		std::vector<ReactiveNode *> observers(m_observers);
+		for (auto i = observers.begin(); i != observers.end(); ++i)
+			(*i)->mark(State::Dirty);
+	}
+
+	bool ReactiveNode::recompute() {
+		return false;
+	}
+
+	void ReactiveNode::doOnStale() {}
+
+	void ReactiveNode::mark(State state) {
+		if (m_state >= state)
+			return;
+
+		const bool wasClean = m_state == State::Clean;
+		m_state = state;
+
+		if (wasClean) {
+			doOnStale();
+			for (auto i = m_observers.begin(); i != m_observers.end(); ++i)
+				(*i)->mark(State::Check);
+		}
+	}
+
+	void ReactiveNode::unlinkSources() {
+		for (auto i = m_sources.begin(); i != m_sources.end(); ++i) {
+			auto & observers = (*i)->m_observers;
+			observers.erase(std::remove(observers.begin(), observers.end(), this), observers.end());
+		}
+		m_sources.clear();
+	}
+
+	ReactiveNode *& ReactiveNode::currentNode() {
+		static ReactiveNode * current = nullptr;
+		return current;
+	}
+
+	void ReactiveNode::scheduleFlush() {
+		EffectQueue & queue = getEffectQueue();
+		if (queue.Effects.empty() || queue.IsFlushing)
+			return;
+
+		if (UpdateTransaction::isActive())
+			UpdateTransaction::addCommitHandler(&queue, &ReactiveNode::flushEffects);
+		else
+			flushEffects();
+	}
+
+	void ReactiveNode::enqueueEffect(ReactiveNode * effect) {
+		getEffectQueue().Effects.push_back(effect);
+	}
+
+	void ReactiveNode::dequeueEffect(ReactiveNode * effect) {
+		auto & effects = getEffectQueue().Effects;
+		std::replace(effects.begin(), effects.end(), effect, (ReactiveNode *)nullptr);
+	}
+
+	void ReactiveNode::flushEffects() {
+		EffectQueue & queue = getEffectQueue();
+		queue.IsFlushing = true;
+
+		// Effects may change signals and enqueue further effects.
+		try {
+			for (size_t i = 0; i < queue.Effects.size(); ++i) {
+				ReactiveNode * effect = queue.Effects[i];
+				if (effect) {
+					queue.Effects[i] = nullptr;
+					effect->updateIfNecessary();
+				}
+			}
+		}
+		catch (...) {
+			queue.Effects.clear();
+			queue.IsFlushing = false;
+			throw;
+		}
+
+		queue.Effects.clear();
+		queue.IsFlushing = false;
+	}
+
+	////////////
+	// Effect //
+	////////////
+
+	Effect::Effect(const Function & function) : m_function(function) {
+		m_state = State::Dirty;
+		updateIfNecessary();
+	}
+
+	Effect::~Effect() {
+		if (m_state != State::Clean)
+			dequeueEffect(this);
+	}
+
+	bool Effect::recompute() {
+		evaluate(m_function);
+		return false;
+	}
+
+	void Effect::doOnStale() {
+		enqueueEffect(this);
+	}
+}
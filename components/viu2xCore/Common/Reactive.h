@@ -0,0 +1,203 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+namespace v2x {
+
+	/// The common base of the reactive values Signal<T>, Computed<T> and of
+	/// Effect.
+	///
+	/// Dependencies are tracked automatically: every reactive value read while
+	/// a Computed or an Effect is evaluated becomes a source of it. A change of
+	/// a signal only marks its observers: the direct ones as dirty and the
+	/// indirect ones as to be checked. Nothing is recomputed until a value is
+	/// read (pull). Effects are flushed after all marks are set, and each of
+	/// them first brings its sources up to date in dependency order. So no
+	/// effect sees a mix of old and new values (glitch-free), and a computed
+	/// value is evaluated at most once per change. A computed value which
+	/// stays equal stops the propagation.
+	///
+	/// Within an UpdateTransaction the effects are flushed on commit.
+	///
+	/// Reactive nodes are not thread-safe. They are meant to be used by the
+	/// GUI thread.
+	///
+	class ReactiveNode {
+	public:
+		ReactiveNode();
+		virtual ~ReactiveNode();
+
+		/// Run a function without tracking what it reads as dependencies of
+		/// the currently evaluated node.
+		template <typename F>
+		static void untracked(F function) {
+			ReactiveNode * saved = currentNode();
+			currentNode() = nullptr;
+			try {
+				function();
+			}
+			catch (...) {
+				currentNode() = saved;
+				throw;
+			}
+			currentNode() = saved;
+		}
+
+	protected:
+		enum class State : uint8_t {
+			/// The value is up to date
+			Clean,
+			/// A source of a source has been changed
+			Check,
+			/// A source has been changed
+			Dirty
+		};
+
+		State m_state;
+
+		/// Register this node as a source of the currently evaluated node.
+		void track();
+
+		/// Bring the value up to date.
+		void updateIfNecessary();
+
+		/// Mark the observers after the value of this node has been changed.
+		void notifyObservers();
+
+		/// Recompute the value. Returns true if it has been changed.
+		virtual bool recompute();
+
+		/// Called when the node is no longer clean
+		virtual void doOnStale();
+
+		/// Evaluate a function and track its dependencies as the sources of
+		/// this node.
+		template <typename F>
+		void evaluate(F function) {
+			unlinkSources();
+			ReactiveNode * saved = currentNode();
+			currentNode() = this;
+			try {
+				function();
+			}
+			catch (...) {
+				currentNode() = saved;
+				throw;
+			}
+			currentNode() = saved;
+		}
+
+		/// Flush the pending effects, or schedule the flush on commit if an
+		/// UpdateTransaction is open.
+		static void scheduleFlush();
+
+		static void enqueueEffect(ReactiveNode * effect);
+		static void dequeueEffect(ReactiveNode * effect);
+
+	private:
+		std::vector<ReactiveNode *> m_sources;
+		std::vector<ReactiveNode *> m_observers;
+
+		void mark(State state);
+		void unlinkSources();
+
+		static ReactiveNode *& currentNode();
+		static void flushEffects();
+
+		ReactiveNode(const ReactiveNode &);
+		ReactiveNode & operator = (const ReactiveNode &);
+	};
+
+	/// A reactive variable.
+	template <typename T>
+	class Signal : public ReactiveNode {
+	public:
+		Signal() : m_value() {}
+		Signal(const T & value) : m_value(value) {}
+		~Signal() {}
+
+		/// Returns the value and tracks it as dependency.
+		const T & get() {
+			track();
+			return m_value;
+		}
+		operator const T & () { return get(); }
+
+		/// Returns the value without tracking it.
+		const T & peek() const { return m_value; }
+
+		/// Change the value. Setting an equal value is not a change.
+		void set(const T & value) {
+			if (m_value == value)
+				return;
+			m_value = value;
+			notifyObservers();
+			scheduleFlush();
+		}
+		Signal<T> & operator = (const T & value) {
+			set(value);
+			return *this;
+		}
+
+	private:
+		T m_value;
+	};
+
+	/// A reactive value derived from other reactive values. It is computed
+	/// lazily on read and cached until one of its sources changes.
+	template <typename T>
+	class Computed : public ReactiveNode {
+	public:
+		typedef std::function<T()> Function;
+
+		Computed(const Function & function) : m_function(function), m_value(), m_hasValue(false) {
+			m_state = State::Dirty;
+		}
+		~Computed() {}
+
+		/// Returns the value and tracks it as dependency.
+		const T & get() {
+			track();
+			updateIfNecessary();
+			return m_value;
+		}
+		operator const T & () { return get(); }
+
+	protected:
+		bool recompute() override {
+			T value = T();
+			evaluate([this, &value]() { value = m_function(); });
+			if (m_hasValue && value == m_value)
+				return false;
+			m_value = value;
+			m_hasValue = true;
+			return true;
+		}
+
+	private:
+		Function m_function;
+		T m_value;
+		bool m_hasValue;
+	};
+
+	/// A function which is run once on construction and again after any of
+	/// the reactive values it has read changed. It is stopped on destruction.
+	class Effect : public ReactiveNode {
+	public:
+		typedef std::function<void()> Function;
+
+		Effect(const Function & function);
+		~Effect();
+
+	protected:
+		bool recompute() override;
+		void doOnStale() override;
+
+	private:
+		Function m_function;
+	};
+}
@@ -344,11 +344,30 @@ namespace v2x {
 
 	template <typename S>
 	std::wostream& operator<< (std::wostream& out, const Rect_T <S>& rect)  {
-		out << "Rect_T (" << rect.position.x << ", " << rect.position.y << ", "
-			<< rect.size.width() << ", " << rect.size.height() << ")";
+		out << Formatter::format(L"%s", rect);
 		return out;
 	}
 
+	/// Rectangles print like their stream output, e.g. Rect_T (0, 0, 10, 20).
+	/// The conversion specification applies to each value.
+	template <typename T>
+	class FormatTraits<Rect_T<T>> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const Rect_T<T> & rect) {
+			FormatSpec element(spec);
+			element.Width = 0;
+
+			const T values[] = { rect.position.x(), rect.position.y(), rect.size.width(), rect.size.height() };
+			buffer.append(L"Rect_T (", 8);
+			for (int i = 0; i < 4; i++) {
+				if (i > 0)
+					buffer.append(L", ", 2);
+				FormatTraits<T>::format(buffer, element, values[i]);
+			}
+			buffer.append(L')');
+		}
+	};
+
 	typedef Rect_T <int32_t> Rect32I;
 	typedef Rect_T <int64_t> Rect64I;
 
@@ -4,10 +4,15 @@
 
 #include "String.h"
 #include "Exceptions.h"
+#include "StringView.h"
+#include "Unicode.h"
 
 #include <inttypes.h>
+#include <limits.h>
+#include <string.h>
 #include <exception>
 #include <stdarg.h>
+#include <wchar.h>
 #include <Windows.h>
 
 namespace v2x {
@@ -20,14 +25,6 @@ namespace v2x {
 	//	return result;
 	//}
 
-	String StrUtils::format(const Char * format, ...) {
-		va_list params;
-		va_start(params, format);
-		String result = vformat(format, params);
-		va_end(params);
-		return result;
-	}
-
 	//String StrUtils::vformat(const String & format, va_list params) {
 	//	String result = vformat(format.c_str(), params);
 	//	return result;
@@ -38,23 +35,21 @@ namespace v2x {
 		const size_t maxSize = 0x7FFFFFFF;
 		const size_t initialSize = 256;
 
-		size_t bufferSize = initialSize;
+		std::vector<Char> buffer(initialSize);
 
-		while (bufferSize < maxSize) {
+		while (buffer.size() < maxSize) {
 
-			Char * buf = new Char[bufferSize];
-			size_t actualSize = _vsnwprintf_s(buf, bufferSize, bufferSize - 1, format, params) + 1; // reserve place for '\0'
+			// A va_list can be consumed only once
+			va_list copy;
+			va_copy(copy, params);
+			const int length = vswprintf(buffer.data(), buffer.size(), format, copy);
+			va_end(copy);
 
 			// Check if it succeeded.
-			if (actualSize > 0 && actualSize < bufferSize) {
-				String result(buf);
-				delete[] buf;
-				return result;
-			}
-			else {
-				delete[] buf;
-				bufferSize *= 2;
-			}
+			if (length >= 0 && (size_t)length < buffer.size())
+				return String(buffer.data(), (size_t)length);
+
+			buffer.resize(buffer.size() * 2);
 		}
 
 		throw Exception(L"StrUtils::format(): Failed to format string! String length out of range!");
@@ -74,49 +69,25 @@ namespace v2x {
 	}
 
 	String StrUtils::trim(const String & s) {
+		return trimView(s).toString();
+	}
 
-		if (s.empty())
-			return String();
-
-		size_t left = 0;
-		for (; left < s.size(); ++left)
-			if (!isspace(s[left]))
-				break;
-
-		size_t right = s.size() - 1;
-		for (;; --right) {
-			if (!isspace(s[right]))
-				break;
-			if (right == 0)
-				break;
-		}
-
-		if (right > left) {
-			return s.substr(left, right - left + 1);
-		}
-		else return String();
+	StringView StrUtils::trimView(StringView s) {
+		return s.trim();
 	}
 
 	void StrUtils::split(const String & s, const String & splitters, std::vector<String> & tokens) {
+		for (StringView token : tokenize(s, splitters))
+			tokens.push_back(token.toString());
+	}
 
-		int tokenStart = 0;
-		int i = 0;
-
-		for (; i < (int)s.length(); ++i) {
-
-			// Check if it is splitter
-			if (splitters.find(s[i]) != String::npos) {
-
-				// Check if it is not right after another splitter
-				if (i > tokenStart)
-					tokens.push_back(s.substr(tokenStart, i - tokenStart));
-				tokenStart = i + 1;
-			}
-		}
+	void StrUtils::split(StringView s, StringView splitters, std::vector<StringView> & tokens) {
+		for (StringView token : tokenize(s, splitters))
+			tokens.push_back(token);
+	}
 
-		// Process the last token
-		if (i > tokenStart)
-			tokens.push_back(s.substr(tokenStart, i - tokenStart));
+	Tokenizer StrUtils::tokenize(StringView s, StringView splitters) {
+		return Tokenizer(s, splitters);
 	}
 
 	//! Convert a multibyte string to unicode and assign to the current
@@ -127,42 +98,43 @@ namespace v2x {
 	//! @return         None
 	void StrUtils::multibyteToUnicode(String & unicodeString, const char * multibyteString) {
 
-#ifdef V2X_WINDOWS
-
 		if (multibyteString == NULL)
 			throw Exception(L"StrUtils::multibyteToUnicode(): The input string is NULL!");
 
+		const size_t length = strlen(multibyteString);
+
+		// ASCII is identical in all code pages and needs no system call
+		if (Unicode::getAsciiLength(multibyteString, length) == length) {
+			unicodeString = Unicode::toWide(multibyteString, length);
+			return;
+		}
+
+#ifdef V2X_WINDOWS
+
+		if (length > (size_t)INT_MAX)
+			throw Exception(L"StrUtils::multibyteToUnicode(): The input string is too long!");
+
 		// Get the required buffer size
-		int requiredLength = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, multibyteString, -1, NULL, 0);
+		int requiredLength = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, multibyteString, (int)length, NULL, 0);
 		if (requiredLength <= 0)
 			OsException::throwLatest(L"StrUtils::multibyteToUnicode()");
 
-		// Allocate the buffer
-		Char * dst = new Char[requiredLength + 1];
-		if (dst == NULL)
-			throw Exception(L"StrUtils::multibyteToUnicode(): Failed to allocate temporary buffer!");
+		// Convert directly into the result
+		String result((size_t)requiredLength, 0);
+		int writtenLength = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, multibyteString, (int)length, &result[0], requiredLength);
 
-		try {
-			// Convert to unicode
-			int writtenLength = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, multibyteString, -1, dst, requiredLength + 1);
+		// Check if conversion was successful
+		if (writtenLength == 0)
+			OsException::throwLatest(L"StrUtils::multibyteToUnicode()");
 
-			// Check if conversion was successful
-			if (writtenLength == 0)
-				OsException::throwLatest(L"StrUtils::multibyteToUnicode()");
+		// Check if the string length before/after conversion are identical.
+		if (writtenLength != requiredLength)
+			throw Exception(L"StrUtils::multibyteToUnicode(): The length of the converted string is not expected!");
 
-			// Check if the string length before/after conversion are identical.
-			if (writtenLength != requiredLength)
-				throw Exception(L"StrUtils::multibyteToUnicode(): The length of the converted string is not expected!");
-		}
-		catch (...) {
-			delete[] dst;
-			throw;
-		}
-
-		unicodeString.assign(dst);
-		delete[] dst;
+		unicodeString.swap(result);
 #else
-#error Not implemented!
+		// Multibyte strings are UTF-8 on the other platforms
+		unicodeString = Unicode::toWide(multibyteString, length);
 #endif
-		}
+	}
 	}
\ No newline at end of file
@@ -11,12 +11,17 @@ namespace v2x {
 	typedef std::wstring String;
 	typedef wchar_t Char;
 
+	class StringView;
+	class Tokenizer;
+
 	class StrUtils
 	{
 	public:
 
 		//static String format(const String & format, ...);
-		static String format(const Char * format, ...);
+		/// Format printf-style but type-safe. See Formatter.
+		template <typename... Args>
+		static String format(const Char * format, const Args & ... args);
 
 		//static String vformat(const String & format, va_list params);
 		static String vformat(const Char * format, va_list params);
@@ -25,8 +30,14 @@ namespace v2x {
 		static String toStr(const char * & s);
 
 		static String trim(const String & s);
+		/// Trim white spaces without copying
+		static StringView trimView(StringView s);
 
 		static void split(const String & s, const String & splitters, std::vector<String> & tokens);
+		/// Split into views of the source. Empty tokens are skipped.
+		static void split(StringView s, StringView splitters, std::vector<StringView> & tokens);
+		/// Iterate the tokens of a string without copying. See Tokenizer.
+		static Tokenizer tokenize(StringView s, StringView splitters);
 
 	private:
 		static void multibyteToUnicode(String & unicodeString, const char * multibyteString);
@@ -34,3 +45,5 @@ namespace v2x {
 	};
 }
 
+// The formatter defines StrUtils::format()
+#include "Format.hpp"
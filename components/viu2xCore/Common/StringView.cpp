@@ -0,0 +1,144 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "StringView.h"
+
+#include <wctype.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define V2X_STRINGVIEW_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace v2x {
+
+	namespace {
+
+		/// The largest set scanned with SSE2
+		const size_t MAX_VECTOR_SET = 4;
+
+		bool contains(StringView set, Char c) {
+			for (size_t i = 0; i < set.size(); ++i)
+				if (set[i] == c)
+					return true;
+			return false;
+		}
+
+#ifdef V2X_STRINGVIEW_SSE2
+		__m128i broadcast(Char c, char(&)[2]) { return _mm_set1_epi16((short)c); }
+		__m128i broadcast(Char c, char(&)[4]) { return _mm_set1_epi32((int)c); }
+		__m128i equal(__m128i a, __m128i b, char(&)[2]) { return _mm_cmpeq_epi16(a, b); }
+		__m128i equal(__m128i a, __m128i b, char(&)[4]) { return _mm_cmpeq_epi32(a, b); }
+
+		/// Scan 16 bytes at a time for any of up to four characters. Returns
+		/// the position of the first match, or the position from which the
+		/// rest must be scanned one by one.
+		size_t findFirstOfVector(const Char * s, size_t size, StringView set, size_t position, bool & found) {
+			const size_t LANES = 16 / sizeof(Char);
+			char width[sizeof(Char)];
+
+			__m128i needles[MAX_VECTOR_SET];
+			for (size_t i = 0; i < MAX_VECTOR_SET; ++i)
+				needles[i] = broadcast(set[i < set.size() ? i : 0], width);
+
+			found = false;
+			for (; position + LANES <= size; position += LANES) {
+				const __m128i chars = _mm_loadu_si128((const __m128i *)(s + position));
+				__m128i matches = equal(chars, needles[0], width);
+				for (size_t i = 1; i < set.size(); ++i)
+					matches = _mm_or_si128(matches, equal(chars, needles[i], width));
+
+				unsigned int mask = (unsigned int)_mm_movemask_epi8(matches);
+				if (mask != 0) {
+					size_t offset = 0;
+					for (; !(mask & 1); mask >>= 1)
+						++offset;
+					found = true;
+					return position + offset / sizeof(Char);
+				}
+			}
+			return position;
+		}
+#endif
+	}
+
+	////////////////
+	// StringView //
+	////////////////
+
+	const size_t StringView::npos;
+
+	size_t StringView::find(Char c, size_t position) const {
+		if (position >= m_size)
+			return npos;
+		const Char * result = wmemchr(m_data + position, c, m_size - position);
+		return result ? (size_t)(result - m_data) : npos;
+	}
+
+	size_t StringView::findFirstOf(StringView set, size_t position) const {
+		if (set.empty() || position >= m_size)
+			return npos;
+		if (set.size() == 1)
+			return find(set[0], position);
+
+#ifdef V2X_STRINGVIEW_SSE2
+		if (set.size() <= MAX_VECTOR_SET) {
+			bool found;
+			position = findFirstOfVector(m_data, m_size, set, position, found);
+			if (found)
+				return position;
+		}
+#endif
+
+		for (; position < m_size; ++position)
+			if (contains(set, m_data[position]))
+				return position;
+		return npos;
+	}
+
+	StringView StringView::trim() const {
+		size_t left = 0;
+		while (left < m_size && iswspace(m_data[left]))
+			++left;
+
+		size_t right = m_size;
+		while (right > left && iswspace(m_data[right - 1]))
+			--right;
+
+		return StringView(m_data + left, right - left);
+	}
+
+	int StringView::compare(StringView other) const {
+		const size_t size = m_size < other.m_size ? m_size : other.m_size;
+		const int result = size > 0 ? wmemcmp(m_data, other.m_data, size) : 0;
+		if (result != 0)
+			return result;
+		return m_size < other.m_size ? -1 : (m_size > other.m_size ? 1 : 0);
+	}
+
+	///////////////
+	// Tokenizer //
+	///////////////
+
+	Tokenizer::Iterator::Iterator(StringView source, StringView delimiters) :
+		m_source(source), m_delimiters(delimiters) {
+		next(0);
+	}
+
+	void Tokenizer::Iterator::next(size_t position) {
+
+		// Skip the delimiters before the token
+		const size_t size = m_source.size();
+		while (position < size && contains(m_delimiters, m_source[position]))
+			++position;
+
+		if (position >= size) {
+			m_token = StringView();
+			return;
+		}
+
+		size_t end = m_source.findFirstOf(m_delimiters, position);
+		if (end == StringView::npos)
+			end = size;
+		m_token = StringView(m_source.data() + position, end - position);
+	}
+}
@@ -0,0 +1,143 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "String.h"
+#include "Format.hpp"
+
+#include <iterator>
+#include <stddef.h>
+#include <wchar.h>
+
+namespace v2x {
+
+	/// A non-owning reference to a range of characters, e.g. a part of a
+	/// String. The referenced characters must outlive the view and are not
+	/// necessarily zero-terminated.
+	class StringView {
+	public:
+		static const size_t npos = (size_t)-1;
+
+		typedef const Char * const_iterator;
+
+		StringView() : m_data(nullptr), m_size(0) {}
+		StringView(const Char * s) : m_data(s), m_size(s ? wcslen(s) : 0) {}
+		StringView(const Char * s, size_t size) : m_data(s), m_size(size) {}
+		StringView(const String & s) : m_data(s.data()), m_size(s.size()) {}
+
+		const Char * data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+
+		const_iterator begin() const { return m_data; }
+		const_iterator end() const { return m_data + m_size; }
+
+		Char operator [] (size_t i) const { return m_data[i]; }
+
+		/// Returns a part of the view. The range is clamped to the view.
+		StringView substr(size_t position, size_t count = npos) const {
+			if (position > m_size)
+				position = m_size;
+			if (count > m_size - position)
+				count = m_size - position;
+			return StringView(m_data + position, count);
+		}
+
+		/// Returns the position of a character or npos
+		size_t find(Char c, size_t position = 0) const;
+
+		/// Returns the position of the first character in a set or npos. Sets
+		/// of up to four characters are scanned with SSE2 where available.
+		size_t findFirstOf(StringView set, size_t position = 0) const;
+
+		/// Returns the view without leading and trailing white spaces
+		StringView trim() const;
+
+		bool startsWith(StringView prefix) const {
+			return prefix.m_size <= m_size && wmemcmp(m_data, prefix.m_data, prefix.m_size) == 0;
+		}
+
+		int compare(StringView other) const;
+
+		String toString() const { return String(m_data, m_size); }
+
+		bool operator == (StringView other) const {
+			return m_size == other.m_size && (m_size == 0 || wmemcmp(m_data, other.m_data, m_size) == 0);
+		}
+		bool operator != (StringView other) const { return !(*this == other); }
+		bool operator < (StringView other) const { return compare(other) < 0; }
+
+	private:
+		const Char * m_data;
+		size_t m_size;
+	};
+
+	template <>
+	class FormatTraits<StringView> {
+	public:
+		static void format(FormatBuffer & buffer, const FormatSpec & spec, const StringView & value) {
+			Formatter::writeString(buffer, spec, value.data(), value.size());
+		}
+	};
+
+	/// The lazy sequence of the tokens of a string, separated by any of a set
+	/// of delimiters. Empty tokens are skipped. The tokens are views into the
+	/// source, so iterating allocates nothing.
+	///
+	///     for (StringView token : StrUtils::tokenize(path, L"\\/"))
+	///         ...
+	///
+	class Tokenizer {
+	public:
+
+		class Iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef StringView value_type;
+			typedef ptrdiff_t difference_type;
+			typedef const StringView * pointer;
+			typedef const StringView & reference;
+
+			/// The end of any sequence
+			Iterator() {}
+			Iterator(StringView source, StringView delimiters);
+
+			reference operator * () const { return m_token; }
+			pointer operator -> () const { return &m_token; }
+
+			Iterator & operator ++ () {
+				next(m_token.data() - m_source.data() + m_token.size());
+				return *this;
+			}
+			Iterator operator ++ (int) {
+				Iterator result(*this);
+				++*this;
+				return result;
+			}
+
+			bool operator == (const Iterator & other) const { return m_token.data() == other.m_token.data(); }
+			bool operator != (const Iterator & other) const { return !(*this == other); }
+
+		private:
+			StringView m_source;
+			StringView m_delimiters;
+			/// The current token. Its data is nullptr at the end.
+			StringView m_token;
+
+			/// Find the token at or after a position
+			void next(size_t position);
+		};
+
+		typedef Iterator const_iterator;
+
+		Tokenizer(StringView source, StringView delimiters) :
+			m_source(source), m_delimiters(delimiters) {}
+
+		Iterator begin() const { return Iterator(m_source, m_delimiters); }
+		Iterator end() const { return Iterator(); }
+
+	private:
+		StringView m_source;
+		StringView m_delimiters;
+	};
+}
@@ -0,0 +1,185 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "TaskPool.h"
+
+#include <deque>
+
+namespace v2x {
+
+	namespace {
+
+		/// The pool and index of the worker running on the current thread
+		thread_local const TaskPool * t_pool = nullptr;
+		thread_local size_t t_worker = 0;
+
+		const size_t NO_WORKER = (size_t)-1;
+	}
+
+	/// The queue of a worker. Its owner takes tasks from the back, thieves
+	/// from the front.
+	class TaskPool::Worker {
+	public:
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	//////////////
+	// TaskPool //
+	//////////////
+
+	TaskPool::TaskPool(size_t threadCount) :
+		m_queued(0), m_nextWorker(0), m_stopping(false) {
+
+		// Without threads the tasks are run by the waiting threads
+		const size_t queueCount = threadCount > 0 ? threadCount : 1;
+		for (size_t i = 0; i < queueCount; ++i)
+			m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+		for (size_t i = 0; i < threadCount; ++i)
+			m_threads.push_back(std::thread(&TaskPool::run, this, i));
+	}
+
+	TaskPool::~TaskPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_wakeup.notify_all();
+
+		for (auto i = m_threads.begin(); i != m_threads.end(); ++i)
+			i->join();
+	}
+
+	size_t TaskPool::getThreadCount() const { return m_threads.size(); }
+
+	void TaskPool::submit(const Task & task) {
+
+		// Workers fork onto their own queue
+		const size_t worker = t_pool == this ? t_worker :
+			m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+		{
+			std::lock_guard<std::mutex> lock(m_workers[worker]->Mutex);
+			m_workers[worker]->Tasks.push_back(task);
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_queued;
+		}
+		m_wakeup.notify_one();
+	}
+
+	bool TaskPool::runPending() {
+		Task task;
+		if (!take(t_pool == this ? t_worker : NO_WORKER, task))
+			return false;
+		task();
+		return true;
+	}
+
+	size_t TaskPool::getDefaultThreadCount() {
+		const size_t cores = std::thread::hardware_concurrency();
+		return cores > 1 ? cores - 1 : 0;
+	}
+
+	TaskPool & TaskPool::getDefault() {
+		// Never destroyed: joining threads while the process exits may block
+		static TaskPool * pool = new TaskPool();
+		return *pool;
+	}
+
+	bool TaskPool::take(size_t worker, Task & task) {
+		if (m_queued.load(std::memory_order_acquire) == 0)
+			return false;
+
+		if (worker != NO_WORKER) {
+			Worker & own = *m_workers[worker];
+			std::lock_guard<std::mutex> lock(own.Mutex);
+			if (!own.Tasks.empty()) {
+				task = std::move(own.Tasks.back());
+				own.Tasks.pop_back();
+				--m_queued;
+				return true;
+			}
+		}
+
+		const size_t count = m_workers.size();
+		const size_t first = worker != NO_WORKER ? worker + 1 : 0;
+		for (size_t i = 0; i < count; ++i) {
+			Worker & victim = *m_workers[(first + i) % count];
+			std::lock_guard<std::mutex> lock(victim.Mutex);
+			if (!victim.Tasks.empty()) {
+				task = std::move(victim.Tasks.front());
+				victim.Tasks.pop_front();
+				--m_queued;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void TaskPool::run(size_t worker) {
+		t_pool = this;
+		t_worker = worker;
+
+		for (;;) {
+			Task task;
+			if (take(worker, task)) {
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeup.wait(lock, [this]() { return m_stopping || m_queued.load() > 0; });
+			if (m_stopping && m_queued.load() == 0)
+				return;
+		}
+	}
+
+	///////////////
+	// TaskGroup //
+	///////////////
+
+	TaskGroup::TaskGroup(TaskPool & pool) : m_pool(pool), m_pending(0) {}
+
+	TaskGroup::~TaskGroup() {
+		join();
+	}
+
+	void TaskGroup::run(const TaskPool::Task & task) {
+		m_pending.fetch_add(1, std::memory_order_relaxed);
+		m_pool.submit([this, task]() {
+			try {
+				task();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!m_exception)
+					m_exception = std::current_exception();
+			}
+
+			// The group may be gone after this
+			m_pending.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	void TaskGroup::wait() {
+		join();
+
+		std::exception_ptr exception;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::swap(exception, m_exception);
+		}
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	void TaskGroup::join() {
+
+		// Help instead of blocking. The tasks of other groups may be run
+		// meanwhile, which is fine as they are independent.
+		while (m_pending.load(std::memory_order_acquire) > 0)
+			if (!m_pool.runPending())
+				std::this_thread::yield();
+	}
+}
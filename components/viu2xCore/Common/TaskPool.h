@@ -0,0 +1,105 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+namespace v2x {
+
+	/// A pool of worker threads which steal work from each other.
+	///
+	/// Each worker has its own queue of tasks. It runs its newest task first,
+	/// so that nested forks stay on one thread, and steals the oldest tasks of
+	/// the others when its queue is empty. Tasks submitted by other threads
+	/// are distributed round-robin.
+	///
+	/// Use TaskGroup to fork and join tasks.
+	///
+	class TaskPool {
+	public:
+		typedef std::function<void()> Task;
+
+		explicit TaskPool(size_t threadCount = getDefaultThreadCount());
+		/// Runs the pending tasks and joins the threads
+		~TaskPool();
+
+		size_t getThreadCount() const;
+
+		void submit(const Task & task);
+
+		/// Run one pending task on the calling thread. Returns false if there
+		/// is none.
+		bool runPending();
+
+		/// Returns the number of cores but one, which is left to the thread
+		/// that forks the tasks and helps to run them.
+		static size_t getDefaultThreadCount();
+
+		/// Returns a pool with the default number of threads. It lives until
+		/// the process exits.
+		static TaskPool & getDefault();
+
+	private:
+		class Worker;
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wakeup;
+		/// The number of tasks in all queues
+		std::atomic<size_t> m_queued;
+		std::atomic<size_t> m_nextWorker;
+		bool m_stopping;
+
+		TaskPool(const TaskPool &);
+		TaskPool & operator = (const TaskPool &);
+
+		/// Take the newest task of a worker or steal the oldest one of another
+		bool take(size_t worker, Task & task);
+		void run(size_t worker);
+	};
+
+	/// A set of tasks forked onto a pool and joined by wait().
+	///
+	/// The waiting thread runs pending tasks of the pool meanwhile, so groups
+	/// can be nested within tasks without blocking the workers.
+	///
+	///     TaskGroup group(TaskPool::getDefault());
+	///     for (auto i = items.begin(); i != items.end(); ++i)
+	///         group.run([i]() { process(*i); });
+	///     group.wait();
+	///
+	class TaskGroup {
+	public:
+		explicit TaskGroup(TaskPool & pool);
+		/// Waits for the tasks without throwing
+		~TaskGroup();
+
+		void run(const TaskPool::Task & task);
+
+		/// Wait for all tasks to finish.
+		///
+		/// @throw The first exception thrown by a task
+		void wait();
+
+	private:
+		TaskPool & m_pool;
+		std::atomic<size_t> m_pending;
+		std::mutex m_mutex;
+		std::exception_ptr m_exception;
+
+		TaskGroup(const TaskGroup &);
+		TaskGroup & operator = (const TaskGroup &);
+
+		void join();
+	};
+}
@@ -0,0 +1,165 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "Transaction.h"
+#include "Exceptions.h"
+#include "Ownership.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace v2x {
+
+	namespace {
+
+		class TransactionState {
+		public:
+			TransactionState() : Depth(0), IsCommitting(false) {}
+
+			uint32_t Depth;
+			bool IsCommitting;
+			std::vector<Specification *> Specs;
+			/// The specifications of the running commit round
+			std::vector<Specification *> CommittingSpecs;
+			std::vector<std::pair<const void *, UpdateTransaction::CommitHandler>> Handlers;
+		};
+
+		TransactionState & getState() {
+			static TransactionState state;
+			return state;
+		}
+
+		/// Closes a transaction level when it goes out of scope
+		class TransactionClose {
+		public:
+			explicit TransactionClose(TransactionState & state) : m_state(state) {}
+			~TransactionClose() { --m_state.Depth; }
+
+		private:
+			TransactionState & m_state;
+		};
+
+		/// Marks the state as committing while it is in scope
+		class CommitScope {
+		public:
+			explicit CommitScope(TransactionState & state) : m_state(state) { m_state.IsCommitting = true; }
+			~CommitScope() {
+				m_state.CommittingSpecs.clear();
+				m_state.IsCommitting = false;
+			}
+
+		private:
+			TransactionState & m_state;
+		};
+	}
+
+	///////////////////////
+	// UpdateTransaction //
+	///////////////////////
+
+	UpdateTransaction::UpdateTransaction() {
+		++getState().Depth;
+	}
+
+	UpdateTransaction::~UpdateTransaction() {
+		TransactionState & state = getState();
+		TransactionClose close(state);
+		if (state.Depth == 1) {
+			try {
+				commitPending();
+			}
+			catch (...) {
+				// A destructor must not throw, commit() reports the errors.
+			}
+		}
+	}
+
+	void UpdateTransaction::commit() {
+		if (getState().Depth == 1)
+			commitPending();
+	}
+
+	bool UpdateTransaction::isActive() {
+		return getState().Depth > 0;
+	}
+
+	bool UpdateTransaction::deferNotification(Specification * spec) {
+		TransactionState & state = getState();
+		if (state.Depth == 0)
+			return false;
+
+		state.Specs.push_back(spec);
+		return true;
+	}
+
+	void UpdateTransaction::cancelNotification(Specification * spec) {
+		TransactionState & state = getState();
+		auto i = std::find(state.Specs.begin(), state.Specs.end(), spec);
+		if (i != state.Specs.end())
+			*i = nullptr;
+
+		i = std::find(state.CommittingSpecs.begin(), state.CommittingSpecs.end(), spec);
+		if (i != state.CommittingSpecs.end())
+			*i = nullptr;
+	}
+
+	void UpdateTransaction::addCommitHandler(const void * key, const CommitHandler & handler) {
+		TransactionState & state = getState();
+		if (state.Depth == 0)
+			throw Exception(L"UpdateTransaction::addCommitHandler(): There is no open transaction!");
+
+		for (auto i = state.Handlers.begin(); i != state.Handlers.end(); ++i)
+			if (i->first == key)
+				return;
+		state.Handlers.push_back(std::make_pair(key, handler));
+	}
+
+	void UpdateTransaction::commitPending() {
+
+		// The transaction stays open while committing, so that everything
+		// triggered by the notifications is collected and handled here.
+		TransactionState & state = getState();
+		if (state.IsCommitting)
+			return;
+		CommitScope scope(state);
+
+		// The pending work of each round is taken out first and every
+		// listener and handler is called, even if one of them throws.
+		std::exception_ptr exception;
+		while (!state.Specs.empty() || !state.Handlers.empty()) {
+
+			// Listeners may defer or cancel further notifications.
+			state.CommittingSpecs.swap(state.Specs);
+			for (size_t i = 0; i < state.CommittingSpecs.size(); ++i) {
+				Specification * spec = state.CommittingSpecs[i];
+				if (!spec)
+					continue;
+				state.CommittingSpecs[i] = nullptr;
+				try {
+					spec->notifyDeferredChange();
+				}
+				catch (...) {
+					if (!exception)
+						exception = std::current_exception();
+				}
+			}
+			state.CommittingSpecs.clear();
+
+			std::vector<std::pair<const void *, CommitHandler>> handlers;
+			handlers.swap(state.Handlers);
+			for (auto i = handlers.begin(); i != handlers.end(); ++i) {
+				try {
+					i->second();
+				}
+				catch (...) {
+					if (!exception)
+						exception = std::current_exception();
+				}
+			}
+		}
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+}
@@ -0,0 +1,71 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+
+namespace v2x {
+
+	class Specification;
+
+	/// An update transaction defers the change notifications of all top level
+	/// specifications and other registered work until it is committed.
+	///
+	/// Transactions are scoped (RAII) and can be nested. Only the outermost
+	/// transaction commits, when it is destroyed or by commit(). Committing
+	/// happens in rounds:
+	///
+	/// 1. Every specification changed within the transaction notifies its
+	///    listener once, with itself as both sender and data.
+	/// 2. Every commit handler is called once. Controls use it to hand their
+	///    consolidated invalidations to layout and paint.
+	///
+	/// Notifications and handlers triggered during commit are processed in
+	/// the following rounds of the same commit.
+	///
+	/// A throwing listener or handler does not stop the commit, the others
+	/// are still called. commit() rethrows the first exception afterwards,
+	/// the destructor drops it. Commit explicitly to receive the errors.
+	///
+	/// Transactions are not thread-safe. They are meant to be used by the GUI
+	/// thread.
+	///
+	class UpdateTransaction {
+	public:
+		typedef std::function<void()> CommitHandler;
+
+		UpdateTransaction();
+		~UpdateTransaction();
+
+		/// Commit the deferred work now. The transaction stays open, later
+		/// changes are committed by the destructor. Nested transactions
+		/// leave the work to the outermost one.
+		///
+		/// @throw The first exception thrown by a listener or handler.
+		void commit();
+
+		/// Returns true if there is an open transaction.
+		static bool isActive();
+
+		/// Defer the change notification of a specification. The caller must
+		/// avoid duplicates. Returns false if there is no open transaction.
+		static bool deferNotification(Specification * spec);
+
+		/// Drop the deferred notification of a specification, e.g. because
+		/// it is destroyed.
+		static void cancelNotification(Specification * spec);
+
+		/// Register a handler called once on commit. Handlers with the same key
+		/// are registered only once.
+		///
+		/// @throw Exception if there is no open transaction.
+		static void addCommitHandler(const void * key, const CommitHandler & handler);
+
+	private:
+		UpdateTransaction(const UpdateTransaction &);
+		UpdateTransaction & operator = (const UpdateTransaction &);
+
+		static void commitPending();
+	};
+}
@@ -0,0 +1,33 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include <type_traits>
+
+namespace v2x {
+
+	/// An identifier of a C++ type which does not rely on RTTI.
+	///
+	/// Two TypeIds are equal if and only if they are created for the same type
+	/// (ignoring const/volatile qualifiers). Comparing TypeIds is a single
+	/// pointer compare.
+	typedef const void * TypeId;
+
+	/// This class provides a unique tag for each type. The address of the tag
+	/// is a constant expression and therefore can be used as a compile-time
+	/// type identifier.
+	template <typename T>
+	class TypeTag {
+	public:
+		static const char Tag;
+	};
+
+	template <typename T>
+	const char TypeTag<T>::Tag = 0;
+
+	/// This function returns the TypeId of the specified type.
+	template <typename T>
+	constexpr TypeId typeIdOf() {
+		return &TypeTag<typename std::remove_cv<T>::type>::Tag;
+	}
+}
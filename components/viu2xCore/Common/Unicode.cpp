@@ -0,0 +1,358 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "Unicode.h"
+#include "Exceptions.h"
+
+#include <string.h>
+#include <stdint.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define V2X_UNICODE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace v2x {
+
+	namespace {
+
+		const size_t INVALID = Unicode::INVALID;
+
+		size_t countTrailingZeros(unsigned int mask) {
+			size_t result = 0;
+			for (; !(mask & 1); mask >>= 1)
+				++result;
+			return result;
+		}
+
+#ifdef V2X_UNICODE_SSE2
+		/// Store 16 ASCII bytes widened to 16 bit units
+		template <typename U>
+		void storeWidened(__m128i bytes, U * dst, char(&)[2]) {
+			const __m128i zero = _mm_setzero_si128();
+			_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(bytes, zero));
+			_mm_storeu_si128((__m128i *)(dst + 8), _mm_unpackhi_epi8(bytes, zero));
+		}
+
+		/// Store 16 ASCII bytes widened to 32 bit units
+		template <typename U>
+		void storeWidened(__m128i bytes, U * dst, char(&)[4]) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(low, zero));
+			_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(low, zero));
+			_mm_storeu_si128((__m128i *)(dst + 8), _mm_unpacklo_epi16(high, zero));
+			_mm_storeu_si128((__m128i *)(dst + 12), _mm_unpackhi_epi16(high, zero));
+		}
+#endif
+
+		/// Copy the leading ASCII bytes widened to the destination. Without
+		/// destination they are only counted. Returns their number.
+		template <typename U>
+		size_t widenAscii(const uint8_t * s, size_t length, U * dst) {
+			size_t i = 0;
+
+#ifdef V2X_UNICODE_SSE2
+			char size[sizeof(U)];
+			for (; i + 16 <= length; i += 16) {
+				const __m128i bytes = _mm_loadu_si128((const __m128i *)(s + i));
+				const int mask = _mm_movemask_epi8(bytes);
+				if (mask != 0) {
+					const size_t end = i + countTrailingZeros((unsigned int)mask);
+					if (dst)
+						for (; i < end; ++i)
+							dst[i] = (U)s[i];
+					return end;
+				}
+				if (dst)
+					storeWidened(bytes, dst + i, size);
+			}
+#else
+			for (; i + 8 <= length; i += 8) {
+				uint64_t block;
+				memcpy(&block, s + i, 8);
+				if (block & 0x8080808080808080ull)
+					break;
+				if (dst)
+					for (size_t j = i; j < i + 8; ++j)
+						dst[j] = (U)s[j];
+			}
+#endif
+
+			for (; i < length && s[i] < 0x80; ++i)
+				if (dst)
+					dst[i] = (U)s[i];
+			return i;
+		}
+
+		/// Copy the leading ASCII units narrowed to the destination. Without
+		/// destination they are only counted. Returns their number.
+		template <typename U>
+		size_t narrowAscii(const U * s, size_t length, uint8_t * dst) {
+			size_t i = 0;
+
+#ifdef V2X_UNICODE_SSE2
+			if (sizeof(U) == 2) {
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i nonAscii = _mm_set1_epi16((short)0xFF80);
+				for (; i + 16 <= length; i += 16) {
+					const __m128i low = _mm_loadu_si128((const __m128i *)(s + i));
+					const __m128i high = _mm_loadu_si128((const __m128i *)(s + i + 8));
+					const __m128i test = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+					if (_mm_movemask_epi8(_mm_cmpeq_epi16(test, zero)) != 0xFFFF)
+						break;
+					if (dst)
+						_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(low, high));
+				}
+			}
+#endif
+
+			for (; i < length && (uint32_t)s[i] < 0x80; ++i)
+				if (dst)
+					dst[i] = (uint8_t)s[i];
+			return i;
+		}
+
+		/// Decode the UTF-8 sequence at s[i] and move i behind it
+		bool decodeUtf8(const uint8_t * s, size_t length, size_t & i, uint32_t & codePoint) {
+			const uint8_t first = s[i];
+			size_t count;
+			uint32_t minimum;
+
+			if (first < 0x80) {
+				codePoint = first;
+				++i;
+				return true;
+			}
+			else if ((first & 0xE0) == 0xC0) {
+				count = 1;
+				codePoint = first & 0x1F;
+				minimum = 0x80;
+			}
+			else if ((first & 0xF0) == 0xE0) {
+				count = 2;
+				codePoint = first & 0x0F;
+				minimum = 0x800;
+			}
+			else if ((first & 0xF8) == 0xF0) {
+				count = 3;
+				codePoint = first & 0x07;
+				minimum = 0x10000;
+			}
+			else
+				return false;
+
+			if (length - i <= count)
+				return false;
+
+			for (size_t k = 1; k <= count; ++k) {
+				const uint8_t next = s[i + k];
+				if ((next & 0xC0) != 0x80)
+					return false;
+				codePoint = (codePoint << 6) | (next & 0x3F);
+			}
+
+			// Overlong sequences, surrogates and values out of range
+			if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+				return false;
+
+			i += count + 1;
+			return true;
+		}
+
+		/// Decode the code point at s[i] of UTF-16 or UTF-32 and move i behind it
+		template <typename U>
+		bool decodeWide(const U * s, size_t length, size_t & i, uint32_t & codePoint) {
+			codePoint = (uint32_t)s[i++];
+
+			if (sizeof(U) == 2) {
+				codePoint &= 0xFFFF;
+				if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+					return false;
+				if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+					if (i >= length)
+						return false;
+					const uint32_t low = (uint32_t)s[i] & 0xFFFF;
+					if (low < 0xDC00 || low > 0xDFFF)
+						return false;
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					++i;
+				}
+				return true;
+			}
+
+			return codePoint <= 0x10FFFF && (codePoint < 0xD800 || codePoint > 0xDFFF);
+		}
+
+		/// Encode a code point as UTF-16 or UTF-32. Returns the number of units.
+		template <typename U>
+		size_t encodeWide(uint32_t codePoint, U * dst) {
+			if (sizeof(U) == 2 && codePoint >= 0x10000) {
+				if (dst) {
+					codePoint -= 0x10000;
+					dst[0] = (U)(0xD800 + (codePoint >> 10));
+					dst[1] = (U)(0xDC00 + (codePoint & 0x3FF));
+				}
+				return 2;
+			}
+			if (dst)
+				dst[0] = (U)codePoint;
+			return 1;
+		}
+
+		/// Encode a code point as UTF-8. Returns the number of bytes.
+		size_t encodeUtf8(uint32_t codePoint, uint8_t * dst) {
+			if (codePoint < 0x80) {
+				if (dst)
+					dst[0] = (uint8_t)codePoint;
+				return 1;
+			}
+			if (codePoint < 0x800) {
+				if (dst) {
+					dst[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+					dst[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+				}
+				return 2;
+			}
+			if (codePoint < 0x10000) {
+				if (dst) {
+					dst[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+					dst[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+					dst[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+				}
+				return 3;
+			}
+			if (dst) {
+				dst[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+				dst[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+				dst[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+				dst[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+			}
+			return 4;
+		}
+
+		/// Convert UTF-8 to UTF-16 or UTF-32. Without destination only the
+		/// length is computed.
+		template <typename U>
+		size_t fromUtf8(const char * utf8, size_t length, U * dst) {
+			const uint8_t * s = reinterpret_cast<const uint8_t *>(utf8);
+			size_t i = 0;
+			size_t written = 0;
+
+			while (i < length) {
+				const size_t ascii = widenAscii(s + i, length - i, dst ? dst + written : nullptr);
+				i += ascii;
+				written += ascii;
+				if (i >= length)
+					break;
+
+				uint32_t codePoint;
+				if (!decodeUtf8(s, length, i, codePoint))
+					return INVALID;
+				written += encodeWide(codePoint, dst ? dst + written : nullptr);
+			}
+
+			return written;
+		}
+
+		/// Convert UTF-16 or UTF-32 to UTF-8. Without destination only the
+		/// length is computed.
+		template <typename U>
+		size_t toUtf8(const U * s, size_t length, char * utf8) {
+			uint8_t * dst = reinterpret_cast<uint8_t *>(utf8);
+			size_t i = 0;
+			size_t written = 0;
+
+			while (i < length) {
+				const size_t ascii = narrowAscii(s + i, length - i, dst ? dst + written : nullptr);
+				i += ascii;
+				written += ascii;
+				if (i >= length)
+					break;
+
+				uint32_t codePoint;
+				if (!decodeWide(s, length, i, codePoint))
+					return INVALID;
+				written += encodeUtf8(codePoint, dst ? dst + written : nullptr);
+			}
+
+			return written;
+		}
+	}
+
+	/////////////
+	// Unicode //
+	/////////////
+
+	const size_t Unicode::INVALID;
+
+	size_t Unicode::getAsciiLength(const char * utf8, size_t length) {
+		return widenAscii<char32_t>(reinterpret_cast<const uint8_t *>(utf8), length, nullptr);
+	}
+
+	bool Unicode::isValidUtf8(const char * utf8, size_t length) {
+		return fromUtf8<char32_t>(utf8, length, nullptr) != INVALID;
+	}
+
+	size_t Unicode::getUtf16Length(const char * utf8, size_t length) {
+		return fromUtf8<char16_t>(utf8, length, nullptr);
+	}
+
+	size_t Unicode::getUtf32Length(const char * utf8, size_t length) {
+		return fromUtf8<char32_t>(utf8, length, nullptr);
+	}
+
+	size_t Unicode::getUtf8Length(const char16_t * utf16, size_t length) {
+		return v2x::toUtf8<char16_t>(utf16, length, nullptr);
+	}
+
+	size_t Unicode::getUtf8Length(const char32_t * utf32, size_t length) {
+		return v2x::toUtf8<char32_t>(utf32, length, nullptr);
+	}
+
+	size_t Unicode::convert(const char * utf8, size_t length, char16_t * utf16) {
+		return fromUtf8(utf8, length, utf16);
+	}
+
+	size_t Unicode::convert(const char * utf8, size_t length, char32_t * utf32) {
+		return fromUtf8(utf8, length, utf32);
+	}
+
+	size_t Unicode::convert(const char16_t * utf16, size_t length, char * utf8) {
+		return v2x::toUtf8(utf16, length, utf8);
+	}
+
+	size_t Unicode::convert(const char32_t * utf32, size_t length, char * utf8) {
+		return v2x::toUtf8(utf32, length, utf8);
+	}
+
+	String Unicode::toWide(const char * utf8, size_t length) {
+		const size_t size = fromUtf8<Char>(utf8, length, nullptr);
+		if (size == INVALID)
+			throw Exception(L"Unicode::toWide(): The input is not valid UTF-8!");
+
+		String result(size, 0);
+		if (size > 0)
+			fromUtf8(utf8, length, &result[0]);
+		return result;
+	}
+
+	String Unicode::toWide(const std::string & utf8) {
+		return toWide(utf8.data(), utf8.size());
+	}
+
+	std::string Unicode::toUtf8(const Char * s, size_t length) {
+		const size_t size = v2x::toUtf8<Char>(s, length, nullptr);
+		if (size == INVALID)
+			throw Exception(CHECKED_FORMAT(L"Unicode::toUtf8(): The input is not valid UTF-%d!", (int)sizeof(Char) * 8));
+
+		std::string result(size, 0);
+		if (size > 0)
+			v2x::toUtf8(s, length, &result[0]);
+		return result;
+	}
+
+	std::string Unicode::toUtf8(const String & s) {
+		return toUtf8(s.data(), s.size());
+	}
+}
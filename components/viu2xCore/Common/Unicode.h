@@ -0,0 +1,63 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "String.h"
+
+#include <string>
+#include <stddef.h>
+
+namespace v2x {
+
+	/// Transcoding between UTF-8, UTF-16 and UTF-32.
+	///
+	/// The conversion works in two passes: get*Length() validates the source
+	/// and returns the exact length of the destination, so that it can be
+	/// allocated once, and convert() fills it. Both skip runs of ASCII
+	/// characters with SSE2 where available and eight bytes at a time
+	/// otherwise.
+	///
+	/// Invalid input (broken or overlong sequences, surrogates in UTF-8 or
+	/// UTF-32, unpaired surrogates in UTF-16, values above U+10FFFF) is
+	/// rejected with INVALID.
+	///
+	class Unicode {
+	public:
+		/// The result of the functions for invalid input
+		static const size_t INVALID = (size_t)-1;
+
+		/// Returns the number of leading ASCII characters
+		static size_t getAsciiLength(const char * utf8, size_t length);
+
+		static bool isValidUtf8(const char * utf8, size_t length);
+
+		/// Returns the number of UTF-16 units for a UTF-8 string or INVALID
+		static size_t getUtf16Length(const char * utf8, size_t length);
+		/// Returns the number of code points of a UTF-8 string or INVALID
+		static size_t getUtf32Length(const char * utf8, size_t length);
+		/// Returns the number of UTF-8 bytes for a UTF-16 string or INVALID
+		static size_t getUtf8Length(const char16_t * utf16, size_t length);
+		/// Returns the number of UTF-8 bytes for a UTF-32 string or INVALID
+		static size_t getUtf8Length(const char32_t * utf32, size_t length);
+
+		/// Convert a string into a destination of the length returned by the
+		/// corresponding get*Length(). Returns the number of written units or
+		/// INVALID.
+		static size_t convert(const char * utf8, size_t length, char16_t * utf16);
+		static size_t convert(const char * utf8, size_t length, char32_t * utf32);
+		static size_t convert(const char16_t * utf16, size_t length, char * utf8);
+		static size_t convert(const char32_t * utf32, size_t length, char * utf8);
+
+		/// Convert UTF-8 to a wide string (UTF-16 or UTF-32 by the size of Char)
+		///
+		/// @throw Exception if the input is not valid UTF-8.
+		static String toWide(const char * utf8, size_t length);
+		static String toWide(const std::string & utf8);
+
+		/// Convert a wide string to UTF-8
+		///
+		/// @throw Exception if the input is not valid UTF-16 or UTF-32.
+		static std::string toUtf8(const Char * s, size_t length);
+		static std::string toUtf8(const String & s);
+	};
+}
@@ -6,6 +6,7 @@
 
 #include "App.h"
 #include "WindowHostWinGdi.h"
+#include "WindowHostHeadless.h"
 
 namespace v2x {
 
@@ -40,14 +41,18 @@ namespace v2x {
 
 		switch (engine) {
 
+		case RenderingEngineType::Headless:
+			result = WindowHostHeadless::createNew();
+			break;
+
 		case RenderingEngineType::Default:
 		case RenderingEngineType::GDI:
 			result = WindowHostWinGdi::createNew();
 			break;
 
 		default:
-			throw Exception(L"App::createWindowHost(): The rendering engine type (%s) is not supported!",
-				EnumString<RenderingEngineType>::toString(m_defaultRenderingEngine).c_str());
+			throw Exception(CHECKED_FORMAT(L"App::createWindowHost(): The rendering engine type (%s) is not supported!",
+				EnumString<RenderingEngineType>::toString(m_defaultRenderingEngine).c_str()));
 		}
 
 		return result;
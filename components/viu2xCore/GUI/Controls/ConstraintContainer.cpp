@@ -0,0 +1,186 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "ConstraintContainer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace v2x {
+
+	//////////////////////////////////
+	// ConstraintContainer::Anchors //
+	//////////////////////////////////
+
+	LinearExpression ConstraintContainer::Anchors::getRight() const { return Left + Width; }
+
+	LinearExpression ConstraintContainer::Anchors::getBottom() const { return Top + Height; }
+
+	LinearExpression ConstraintContainer::Anchors::getCenterX() const { return Left + Width * 0.5; }
+
+	LinearExpression ConstraintContainer::Anchors::getCenterY() const { return Top + Height * 0.5; }
+
+	/////////////////////////
+	// ConstraintContainer //
+	/////////////////////////
+
+	ConstraintContainer::ConstraintContainer() {
+		m_content = createAnchors();
+		m_solver.addConstraint(LinearConstraint(m_content.Left, ConstraintRelation::Equal, 0));
+		m_solver.addConstraint(LinearConstraint(m_content.Top, ConstraintRelation::Equal, 0));
+		m_solver.addEditVariable(m_content.Width, ConstraintStrength::STRONG);
+		m_solver.addEditVariable(m_content.Height, ConstraintStrength::STRONG);
+	}
+
+	ConstraintContainer::~ConstraintContainer() {}
+
+	const ConstraintContainer::Anchors & ConstraintContainer::getContentAnchors() const { return m_content; }
+
+	const ConstraintContainer::Anchors & ConstraintContainer::getAnchors(const Control::Shared & child) {
+		if (!hasChild(child))
+			throw Exception(L"ConstraintContainer::getAnchors(): The control is not a child!");
+
+		auto anchors = m_anchors.find(child.get());
+		if (anchors != m_anchors.end())
+			return anchors->second.Rect;
+
+		ChildAnchors result;
+		result.Rect = createAnchors();
+		result.MinWidth = m_solver.addConstraint(LinearConstraint(result.Rect.Width, ConstraintRelation::GreaterOrEqual, 0));
+		result.MinHeight = m_solver.addConstraint(LinearConstraint(result.Rect.Height, ConstraintRelation::GreaterOrEqual, 0));
+		m_solver.addEditVariable(result.Rect.Width, ConstraintStrength::WEAK);
+		m_solver.addEditVariable(result.Rect.Height, ConstraintStrength::WEAK);
+
+		invalidateLayout();
+		return m_anchors.insert(std::make_pair(child.get(), result)).first->second.Rect;
+	}
+
+	bool ConstraintContainer::hasAnchors(const Control::Shared & child) const {
+		return m_anchors.find(child.get()) != m_anchors.end();
+	}
+
+	ConstraintVariable ConstraintContainer::createVariable() { return m_solver.createVariable(); }
+
+	ConstraintSolver::ConstraintId ConstraintContainer::addConstraint(const LinearConstraint & constraint) {
+		const ConstraintSolver::ConstraintId id = m_solver.addConstraint(constraint);
+		invalidateLayout();
+		return id;
+	}
+
+	void ConstraintContainer::removeConstraint(ConstraintSolver::ConstraintId id) {
+		m_solver.removeConstraint(id);
+		invalidateLayout();
+	}
+
+	void ConstraintContainer::addEditVariable(const ConstraintVariable & variable, double strength) {
+		m_solver.addEditVariable(variable, strength);
+		invalidateLayout();
+	}
+
+	void ConstraintContainer::removeEditVariable(const ConstraintVariable & variable) {
+		m_solver.removeEditVariable(variable);
+		invalidateLayout();
+	}
+
+	void ConstraintContainer::suggestValue(const ConstraintVariable & variable, double value) {
+		m_solver.suggestValue(variable, value);
+		invalidateLayout();
+	}
+
+	double ConstraintContainer::getValue(const ConstraintVariable & variable) const { return m_solver.getValue(variable); }
+
+	const ConstraintSolver & ConstraintContainer::getSolver() const { return m_solver; }
+
+	Size2D64F ConstraintContainer::doMeasure(const Size2D64F & availableSize) {
+		const ResolvedMargin padding = getLayoutUnits().resolve(ContentLayout->Padding, availableSize);
+		const Size2D64F content = padding.deflate(availableSize).size;
+
+		layoutChildren([&content](Control & child, size_t) { child.measure(content); });
+
+		// Without a limit the children may be placed side by side
+		double width = 0, height = 0;
+		for (auto i = m_children.begin(); i != m_children.end(); ++i) {
+			width += (*i)->getDesiredSize().width();
+			height += (*i)->getDesiredSize().height();
+		}
+		updateSolver(Size2D64F(std::isfinite(content.width()) ? content.width() : width,
+			std::isfinite(content.height()) ? content.height() : height));
+
+		// The extent of the rectangles of the children
+		double right = 0, bottom = 0;
+		const Rect64F area(0, 0, m_solver.getValue(m_content.Width), m_solver.getValue(m_content.Height));
+		for (auto i = m_children.begin(); i != m_children.end(); ++i) {
+			const Rect64F rect = getChildRect(**i, area);
+			right = std::max(right, rect.getLeft() + rect.getWidth());
+			bottom = std::max(bottom, rect.getTop() + rect.getHeight());
+		}
+
+		return Size2D64F((std::isfinite(content.width()) ? content.width() : right) + padding.Left + padding.Right,
+			(std::isfinite(content.height()) ? content.height() : bottom) + padding.Top + padding.Bottom);
+	}
+
+	void ConstraintContainer::doArrange(const Size2D64F & finalSize) {
+		const LayoutUnits & units = getLayoutUnits();
+		const Rect64F content = units.resolve(ContentLayout->Padding, finalSize).deflate(finalSize);
+
+		// The content size may have come from the cache, see ControlContainer
+		const Size2D64F & constraint = getContentConstraint();
+		const Size2D64F childConstraint = units.resolve(ContentLayout->Padding, constraint).deflate(constraint).size;
+
+		layoutChildren([&childConstraint](Control & child, size_t) { child.measure(childConstraint); });
+		updateSolver(content.size);
+
+		layoutChildren([this, &content](Control & child, size_t) { child.arrange(getChildRect(child, content)); });
+	}
+
+	void ConstraintContainer::doOnChildrenChange(const void * sender, const void * data) {
+		ControlContainer::doOnChildrenChange(sender, data);
+
+		const Children::Change & change = *static_cast<const Children::Change *>(data);
+		for (auto i = change.OldItems.begin(); i != change.OldItems.end(); ++i) {
+			auto anchors = m_anchors.find(i->get());
+			if (anchors == m_anchors.end() || m_children.contains(*i))
+				continue;
+
+			const ChildAnchors & child = anchors->second;
+			m_solver.removeEditVariable(child.Rect.Width);
+			m_solver.removeEditVariable(child.Rect.Height);
+			m_solver.removeConstraint(child.MinWidth);
+			m_solver.removeConstraint(child.MinHeight);
+			m_anchors.erase(anchors);
+		}
+	}
+
+	ConstraintContainer::Anchors ConstraintContainer::createAnchors() {
+		Anchors result;
+		result.Left = m_solver.createVariable();
+		result.Top = m_solver.createVariable();
+		result.Width = m_solver.createVariable();
+		result.Height = m_solver.createVariable();
+		return result;
+	}
+
+	void ConstraintContainer::updateSolver(const Size2D64F & content) {
+		// Unchanged values leave the solver alone
+		m_solver.suggestValue(m_content.Width, content.width());
+		m_solver.suggestValue(m_content.Height, content.height());
+
+		for (auto i = m_children.begin(); i != m_children.end(); ++i) {
+			auto anchors = m_anchors.find(i->get());
+			if (anchors == m_anchors.end())
+				continue;
+			const Size2D64F & size = (*i)->getDesiredSize();
+			m_solver.suggestValue(anchors->second.Rect.Width, size.width());
+			m_solver.suggestValue(anchors->second.Rect.Height, size.height());
+		}
+	}
+
+	Rect64F ConstraintContainer::getChildRect(const Control & child, const Rect64F & content) const {
+		auto anchors = m_anchors.find(&child);
+		if (anchors == m_anchors.end())
+			return content;
+
+		const Anchors & rect = anchors->second.Rect;
+		return Rect64F(content.getLeft() + m_solver.getValue(rect.Left), content.getTop() + m_solver.getValue(rect.Top),
+			std::max(0.0, m_solver.getValue(rect.Width)), std::max(0.0, m_solver.getValue(rect.Height)));
+	}
+}
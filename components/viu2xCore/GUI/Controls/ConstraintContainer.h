@@ -0,0 +1,118 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+#include "../Graphics/ConstraintSolver.h"
+#include "Controls.h"
+
+#include <map>
+
+namespace v2x {
+
+	/// This container places its children into rectangles given by linear
+	/// constraints, see ConstraintSolver.
+	///
+	/// The rectangle of a child is described by the variables of its anchors.
+	/// The content area has anchors as well: its left and top are 0 and its
+	/// size follows the size of the container with strong strength. The
+	/// width and height of a child prefer its desired size with weak
+	/// strength, so that the constraints decide, e.g. for two panes besides
+	/// a splitter:
+	///
+	///     auto & content = container->getContentAnchors();
+	///     auto & left = container->getAnchors(leftPane);
+	///     auto & right = container->getAnchors(rightPane);
+	///     ConstraintVariable splitter = container->createVariable();
+	///     container->addConstraint(LinearConstraint(left.Left, ConstraintRelation::Equal, content.Left));
+	///     container->addConstraint(LinearConstraint(left.Width, ConstraintRelation::Equal, splitter));
+	///     container->addConstraint(LinearConstraint(right.Left, ConstraintRelation::Equal, left.getRight() + 4));
+	///     container->addConstraint(LinearConstraint(right.getRight(), ConstraintRelation::Equal, content.getRight()));
+	///     container->addEditVariable(splitter);
+	///     container->suggestValue(splitter, 200);
+	///
+	/// The solver keeps its solution between layouts. A resize or a value
+	/// suggested for an edit variable only solves the rows of the tableau
+	/// which it affects again.
+	///
+	/// Children without anchors fill the content area. The container takes
+	/// all of the space it is given. Without a limit the content gets the
+	/// sum of the desired sizes of the children and the container takes the
+	/// extent of their rectangles.
+	///
+	class ConstraintContainer : public ControlContainer {
+
+	public:
+		DEFINE_POINTERS(ConstraintContainer);
+
+		/// The variables of a rectangle
+		class Anchors {
+		public:
+			ConstraintVariable Left;
+			ConstraintVariable Top;
+			ConstraintVariable Width;
+			ConstraintVariable Height;
+
+			LinearExpression getRight() const;
+			LinearExpression getBottom() const;
+			LinearExpression getCenterX() const;
+			LinearExpression getCenterY() const;
+		};
+
+		ConstraintContainer();
+
+		virtual ~ConstraintContainer();
+
+		const Anchors & getContentAnchors() const;
+		/// Returns the anchors of a child. They are created on the first
+		/// call and dropped when the child is removed. The constraints on
+		/// them stay until they are removed.
+		///
+		/// The width and height are edit variables for the desired size of
+		/// the child. Constrain them to a variable of your own to edit them.
+		const Anchors & getAnchors(const Control::Shared & child);
+		bool hasAnchors(const Control::Shared & child) const;
+
+		ConstraintVariable createVariable();
+		ConstraintSolver::ConstraintId addConstraint(const LinearConstraint & constraint);
+		void removeConstraint(ConstraintSolver::ConstraintId id);
+
+		void addEditVariable(const ConstraintVariable & variable, double strength = ConstraintStrength::STRONG);
+		void removeEditVariable(const ConstraintVariable & variable);
+		/// Move an edit variable, e.g. a splitter dragged by the user
+		void suggestValue(const ConstraintVariable & variable, double value);
+
+		/// Returns the value of a variable from the last layout
+		double getValue(const ConstraintVariable & variable) const;
+
+		const ConstraintSolver & getSolver() const;
+
+	protected:
+
+		Size2D64F doMeasure(const Size2D64F & availableSize) override;
+		void doArrange(const Size2D64F & finalSize) override;
+		/// Drop the anchors of the removed children
+		void doOnChildrenChange(const void * sender, const void * data) override;
+
+	private:
+		/// The anchors of a child and the constraints which keep its size
+		/// non-negative
+		class ChildAnchors {
+		public:
+			Anchors Rect;
+			ConstraintSolver::ConstraintId MinWidth;
+			ConstraintSolver::ConstraintId MinHeight;
+		};
+
+		ConstraintSolver m_solver;
+		Anchors m_content;
+		std::map<const Control *, ChildAnchors> m_anchors;
+
+		Anchors createAnchors();
+		/// Give the solver the size of the content and the desired sizes of
+		/// the children
+		void updateSolver(const Size2D64F & content);
+		/// Returns the solved rectangle of a child within the content area
+		Rect64F getChildRect(const Control & child, const Rect64F & content) const;
+	};
+}
@@ -6,8 +6,266 @@
 #include "Controls.h"
 #include "App.h"
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
 namespace v2x {
 
+	namespace {
+
+		/// The resolved sizes of a layout spec along one axis
+		class AxisLayout {
+		public:
+			/// The margin before and after the control
+			double MarginBefore;
+			double MarginAfter;
+			/// NAN if automatic
+			double Size;
+			double Min;
+			double Max;
+
+			AxisLayout(double marginBefore, double marginAfter, double size, double min, double max) :
+				MarginBefore(marginBefore), MarginAfter(marginAfter), Size(size), Min(min), Max(max) {}
+
+			double getMargin() const { return MarginBefore + MarginAfter; }
+
+			double clamp(double size) const {
+				return std::max(Min, std::min(Max, size));
+			}
+		};
+
+		AxisLayout getHorizontalLayout(const ResolvedLayout & layout) {
+			return AxisLayout(layout.Margin.Left, layout.Margin.Right,
+				layout.Width, layout.MinWidth, layout.MaxWidth);
+		}
+
+		AxisLayout getVerticalLayout(const ResolvedLayout & layout) {
+			return AxisLayout(layout.Margin.Top, layout.Margin.Bottom,
+				layout.Height, layout.MinHeight, layout.MaxHeight);
+		}
+
+		/// Returns true if the sizes are resolved without the parent
+		bool isAbsolute(const SizeSpec & size) {
+			if (!size.Size.isSet())
+				return false;
+			const ScalarUnit unit = size.Unit.isSet() ? size.Unit.get() : ScalarUnit::Pixel;
+			return unit == ScalarUnit::Pixel || unit == ScalarUnit::Dot || unit == ScalarUnit::Millimeter;
+		}
+
+		/// Returns the offset of a size within a slot
+		double align(double slot, double size, bool before, bool after) {
+			if (before)
+				return 0;
+			if (after)
+				return slot - size;
+			return (slot - size) / 2;
+		}
+
+		bool equals(const Rect64F & a, const Rect64F & b) {
+			return a.position == b.position && a.size == b.size;
+		}
+
+		/// Returns the item of a control in a flow
+		FlowItem getFlowItem(const Control & control) {
+			const LayoutSpec & layout = control.Layout.get();
+			return FlowItem(control.getDesiredSize(),
+				layout.PositionMode.isSet() ? layout.PositionMode.get() : PositionMode::Inline,
+				layout.HorizontalAlignment.isSet() ? layout.HorizontalAlignment.get() : HorizontalAlignment::Stretch);
+		}
+
+		/// The settings of the parallel layout
+		class ParallelLayout {
+		public:
+			ParallelLayout() : Pool(nullptr), Threshold(Control::DEFAULT_PARALLEL_LAYOUT_THRESHOLD) {}
+
+			/// nullptr until the parallel layout is enabled
+			TaskPool * Pool;
+			size_t Threshold;
+
+			static ParallelLayout & get() {
+				static ParallelLayout settings;
+				return settings;
+			}
+		};
+
+		/// The statistics of the parallel layout running on this thread
+		thread_local LayoutStatistics * t_statistics = nullptr;
+		/// The budget of the layout running on this thread or nullptr
+		thread_local LayoutBudget * t_budget = nullptr;
+
+		/// Sets the statistics and budget of the current thread during its
+		/// lifetime
+		class LayoutScope {
+		public:
+			LayoutScope(LayoutStatistics * statistics, LayoutBudget * budget) :
+				m_statistics(t_statistics), m_budget(t_budget) {
+				t_statistics = statistics;
+				t_budget = budget;
+			}
+			~LayoutScope() {
+				t_statistics = m_statistics;
+				t_budget = m_budget;
+			}
+
+		private:
+			LayoutStatistics * m_statistics;
+			LayoutBudget * m_budget;
+		};
+
+		bool isLayoutExpired() {
+			return t_budget && t_budget->isExpired();
+		}
+
+		bool isLayoutInterrupted() {
+			return t_budget && t_budget->isInterrupted();
+		}
+	}
+
+	//////////////
+	// DirtySet //
+	//////////////
+
+	DirtySet::DirtySet() {}
+
+	DirtySet::~DirtySet() {}
+
+	void DirtySet::add(Control * control, const Invalidations & invalidations) {
+		auto i = m_index.find(control);
+		if (i != m_index.end()) {
+			m_entries[i->second].second += invalidations;
+			return;
+		}
+		m_index[control] = m_entries.size();
+		m_entries.push_back(std::make_pair(control, invalidations));
+	}
+
+	void DirtySet::add(const DirtySet & dirtySet) {
+		for (auto i = dirtySet.m_entries.begin(); i != dirtySet.m_entries.end(); ++i)
+			add(i->first, i->second);
+	}
+
+	void DirtySet::remove(Control * control) {
+		auto i = m_index.find(control);
+		if (i == m_index.end())
+			return;
+
+		// Move the last entry into the gap
+		const size_t index = i->second;
+		m_index.erase(i);
+		if (index + 1 < m_entries.size()) {
+			m_entries[index] = m_entries.back();
+			m_index[m_entries[index].first] = index;
+		}
+		m_entries.pop_back();
+	}
+
+	void DirtySet::clear() {
+		m_entries.clear();
+		m_index.clear();
+	}
+
+	bool DirtySet::isEmpty() const { return m_entries.empty(); }
+
+	size_t DirtySet::count() const { return m_entries.size(); }
+
+	bool DirtySet::contains(const Control * control) const {
+		return m_index.find(control) != m_index.end();
+	}
+
+	Control * DirtySet::getControl(size_t index) const {
+		return m_entries[index].first;
+	}
+
+	const Invalidations & DirtySet::getInvalidations(size_t index) const {
+		return m_entries[index].second;
+	}
+
+	Invalidations DirtySet::getInvalidations(const Control * control) const {
+		auto i = m_index.find(control);
+		return i != m_index.end() ? m_entries[i->second].second : Invalidations();
+	}
+
+	//////////////////
+	// LayoutBudget //
+	//////////////////
+
+	const uint32_t LayoutBudget::CHECK_INTERVAL;
+
+	LayoutBudget::LayoutBudget() : m_unlimited(true), m_calls(0), m_interrupted(false) {}
+
+	LayoutBudget::LayoutBudget(double milliseconds) :
+		m_unlimited(false),
+		m_deadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double, std::milli>(milliseconds))),
+		m_calls(0), m_interrupted(false) {}
+
+	bool LayoutBudget::isUnlimited() const { return m_unlimited; }
+
+	bool LayoutBudget::isExpired() {
+		if (m_unlimited)
+			return false;
+		if (m_interrupted.load(std::memory_order_relaxed))
+			return true;
+		if (m_calls.fetch_add(1, std::memory_order_relaxed) % CHECK_INTERVAL != 0)
+			return false;
+
+		if (Clock::now() < m_deadline)
+			return false;
+		m_interrupted.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool LayoutBudget::isInterrupted() const {
+		return m_interrupted.load(std::memory_order_relaxed);
+	}
+
+	//////////////////
+	// MeasureCache //
+	//////////////////
+
+	const size_t MeasureCache::CAPACITY;
+
+	MeasureCache::MeasureCache() : m_count(0), m_next(0) {}
+
+	bool MeasureCache::find(const Size2D64F & constraint, uint64_t version, Size2D64F & size) const {
+		for (size_t i = 0; i < m_count; ++i)
+			if (m_entries[i].Version == version && m_entries[i].Constraint == constraint) {
+				size = m_entries[i].Size;
+				return true;
+			}
+		return false;
+	}
+
+	void MeasureCache::add(const Size2D64F & constraint, uint64_t version, const Size2D64F & size) {
+
+		// Replace an entry of the constraint or an outdated one first
+		size_t index = m_count;
+		for (size_t i = 0; i < m_count; ++i)
+			if (m_entries[i].Constraint == constraint || m_entries[i].Version != version) {
+				index = i;
+				break;
+			}
+
+		if (index == CAPACITY) {
+			index = m_next;
+			m_next = (m_next + 1) % CAPACITY;
+		}
+		else if (index == m_count)
+			++m_count;
+
+		m_entries[index].Constraint = constraint;
+		m_entries[index].Version = version;
+		m_entries[index].Size = size;
+	}
+
+	void MeasureCache::clear() {
+		m_count = 0;
+		m_next = 0;
+	}
+
+	size_t MeasureCache::count() const { return m_count; }
+
 	/////////////
 	// Control //
 	/////////////
@@ -15,9 +273,274 @@ namespace v2x {
 	Control::Control() :
 		Layout(LISTENER(this, Control::doOnLayoutChange)),
 		Font(LISTENER(this, Control::doOnFontChange)), 
-		Cursor(LISTENER(this, Control::doOnCursorChange)) {}
+		Cursor(LISTENER(this, Control::doOnCursorChange)),
+		m_parent(nullptr),
+		m_availableSize(INFINITY, INFINITY),
+		m_contentConstraint(INFINITY, INFINITY),
+		m_desiredSize(0, 0),
+		m_measureInvalid(true),
+		m_arrangeInvalid(true),
+		m_descendantInvalid(false),
+		m_resolvedLayout(),
+		m_layoutTree(nullptr),
+		m_layoutIndex(LayoutTree::NONE) {}
+
+	Control::~Control() {
+		getPendingInvalidations().remove(this);
+		if (m_layoutTree)
+			m_layoutTree->forget(m_layoutIndex);
+	}
 
-	Control::~Control() {}
+	ControlContainer * Control::getParent() const { return m_parent; }
+
+	uint64_t Control::getLayoutInputsVersion() const {
+		// All versions are stamps of one monotonic counter, so the maximum
+		// changes whenever one of them changes.
+		return std::max(Layout.getVersion(), Font.getVersion());
+	}
+
+	void Control::measure(const Size2D64F & availableSize) {
+		if (!m_measureInvalid && availableSize == m_availableSize)
+			return;
+
+		// Interrupted controls and their parents are measured again
+		if (isLayoutExpired()) {
+			m_measureInvalid = true;
+			mirrorLayoutState();
+			return;
+		}
+
+		const ResolvedLayout layout = getLayoutUnits().resolve(Layout.get(), availableSize);
+		const AxisLayout horizontal = getHorizontalLayout(layout);
+		const AxisLayout vertical = getVerticalLayout(layout);
+
+		// The content gets the explicit size or the available space
+		const Size2D64F contentConstraint(
+			std::isnan(horizontal.Size) ?
+			horizontal.clamp(std::max(0.0, availableSize.width() - horizontal.getMargin())) :
+			horizontal.clamp(horizontal.Size),
+			std::isnan(vertical.Size) ?
+			vertical.clamp(std::max(0.0, availableSize.height() - vertical.getMargin())) :
+			vertical.clamp(vertical.Size));
+
+		LayoutStatistics & statistics = getLayoutStatistics();
+		const uint64_t version = getLayoutInputsVersion();
+		Size2D64F content;
+		if (m_measureCache.find(contentConstraint, version, content))
+			++statistics.MeasureCacheHits;
+		else {
+			content = doMeasure(contentConstraint);
+			if (isLayoutInterrupted()) {
+				m_measureInvalid = true;
+				mirrorLayoutState();
+				return;
+			}
+			m_measureCache.add(contentConstraint, version, content);
+			++statistics.MeasureCacheMisses;
+		}
+
+		const Size2D64F desiredSize(
+			horizontal.clamp(std::isnan(horizontal.Size) ? content.width() : horizontal.Size) + horizontal.getMargin(),
+			vertical.clamp(std::isnan(vertical.Size) ? content.height() : vertical.Size) + vertical.getMargin());
+
+		// The children may have been measured with another constraint
+		if (desiredSize != m_desiredSize || contentConstraint != m_contentConstraint)
+			m_arrangeInvalid = true;
+
+		m_desiredSize = desiredSize;
+		m_contentConstraint = contentConstraint;
+		m_availableSize = availableSize;
+		m_measureInvalid = false;
+		mirrorLayoutState();
+		++statistics.Measures;
+	}
+
+	void Control::arrange(const Rect64F & finalRect) {
+		if (m_measureInvalid) {
+			measure(m_availableSize);
+			if (m_measureInvalid) {
+				m_arrangeInvalid = true;
+				mirrorLayoutState();
+				return;
+			}
+		}
+
+		if (!m_arrangeInvalid && equals(finalRect, m_finalRect)) {
+			if (m_descendantInvalid) {
+				doArrangeInvalidChildren();
+				m_descendantInvalid = isLayoutInterrupted();
+				mirrorLayoutState();
+			}
+			return;
+		}
+
+		if (isLayoutExpired()) {
+			m_arrangeInvalid = true;
+			mirrorLayoutState();
+			return;
+		}
+
+		const ResolvedLayout layout = getLayoutUnits().resolve(Layout.get(), finalRect.size);
+		const AxisLayout horizontal = getHorizontalLayout(layout);
+		const AxisLayout vertical = getVerticalLayout(layout);
+
+		const HorizontalAlignment horizontalAlignment = Layout->HorizontalAlignment.isSet() ?
+			Layout->HorizontalAlignment.get() : HorizontalAlignment::Stretch;
+		const VerticalAlignment verticalAlignment = Layout->VerticalAlignment.isSet() ?
+			Layout->VerticalAlignment.get() : VerticalAlignment::Stretch;
+
+		// The slot without margin
+		const double slotWidth = std::max(0.0, finalRect.getWidth() - horizontal.getMargin());
+		const double slotHeight = std::max(0.0, finalRect.getHeight() - vertical.getMargin());
+
+		// Stretched controls fill the slot, the others keep their desired size
+		double width = horizontal.Size;
+		if (std::isnan(width))
+			width = horizontalAlignment == HorizontalAlignment::Stretch ? slotWidth :
+			std::min(slotWidth, m_desiredSize.width() - horizontal.getMargin());
+		width = horizontal.clamp(width);
+
+		double height = vertical.Size;
+		if (std::isnan(height))
+			height = verticalAlignment == VerticalAlignment::Stretch ? slotHeight :
+			std::min(slotHeight, m_desiredSize.height() - vertical.getMargin());
+		height = vertical.clamp(height);
+
+		// Controls which cannot stretch are centered
+		const double left = finalRect.getLeft() + horizontal.MarginBefore + align(slotWidth, width,
+			horizontalAlignment == HorizontalAlignment::Left,
+			horizontalAlignment == HorizontalAlignment::Right);
+		const double top = finalRect.getTop() + vertical.MarginBefore + align(slotHeight, height,
+			verticalAlignment == VerticalAlignment::Top,
+			verticalAlignment == VerticalAlignment::Bottom);
+
+		m_resolvedLayout = layout;
+		m_layoutRect = Rect64F(left, top, width, height);
+		doArrange(m_layoutRect.size);
+
+		// Arranged again with the children which have not been reached
+		if (isLayoutInterrupted()) {
+			m_arrangeInvalid = true;
+			mirrorLayoutState();
+			return;
+		}
+
+		m_finalRect = finalRect;
+		m_arrangeInvalid = false;
+		m_descendantInvalid = false;
+		mirrorLayoutState();
+		++getLayoutStatistics().Arranges;
+	}
+
+	void Control::updateLayout(const Size2D64F & size) {
+		measure(size);
+		arrange(Rect64F(0, 0,
+			std::isfinite(size.width()) ? size.width() : m_desiredSize.width(),
+			std::isfinite(size.height()) ? size.height() : m_desiredSize.height()));
+	}
+
+	bool Control::updateLayout(const Size2D64F & size, LayoutBudget & budget) {
+		LayoutScope scope(t_statistics, &budget);
+		updateLayout(size);
+		return !budget.isInterrupted();
+	}
+
+	const Size2D64F & Control::getDesiredSize() const { return m_desiredSize; }
+
+	const Rect64F & Control::getLayoutRect() const { return m_layoutRect; }
+
+	bool Control::isLayoutValid() const {
+		return !m_measureInvalid && !m_arrangeInvalid && !m_descendantInvalid;
+	}
+
+	const Size2D64F & Control::getContentConstraint() const { return m_contentConstraint; }
+
+	const MeasureCache & Control::getMeasureCache() const { return m_measureCache; }
+
+	LayoutTree::Index Control::getLayoutIndex() const { return m_layoutIndex; }
+
+	const ResolvedLayout & Control::getResolvedLayout() const { return m_resolvedLayout; }
+
+	bool Control::isLayoutBoundary() const {
+		return !m_parent || (isAbsolute(Layout->Width) && isAbsolute(Layout->Height));
+	}
+
+	const LayoutUnits & Control::getLayoutUnits() const {
+		if (m_parent)
+			return m_parent->getLayoutUnits();
+
+		static const LayoutUnits defaultUnits;
+		return defaultUnits;
+	}
+
+	size_t Control::getSubtreeSize() const { return 1; }
+
+	bool Control::hasSerialLayout() const { return false; }
+
+	const size_t Control::DEFAULT_PARALLEL_LAYOUT_THRESHOLD;
+
+	void Control::setParallelLayout(TaskPool * pool, size_t threshold) {
+		ParallelLayout & settings = ParallelLayout::get();
+		settings.Pool = pool;
+		settings.Threshold = threshold;
+	}
+
+	TaskPool * Control::getParallelLayoutPool() {
+		return ParallelLayout::get().Pool;
+	}
+
+	size_t Control::getParallelLayoutThreshold() {
+		return ParallelLayout::get().Threshold;
+	}
+
+	LayoutStatistics & Control::getLayoutStatistics() {
+		if (t_statistics)
+			return *t_statistics;
+
+		static LayoutStatistics statistics;
+		return statistics;
+	}
+
+	Size2D64F Control::doMeasure(const Size2D64F & availableSize) {
+		return Size2D64F(0, 0);
+	}
+
+	void Control::doArrange(const Size2D64F & finalSize) {}
+
+	void Control::doArrangeInvalidChildren() {}
+
+	void Control::invalidateLayoutState(bool measure) {
+		m_arrangeInvalid = true;
+
+		// The parents must measure again until one does not depend on the
+		// size of its content
+		Control * control = this;
+		if (measure) {
+			m_measureInvalid = true;
+			m_measureCache.clear();
+			while (control->m_parent && !control->isLayoutBoundary()) {
+				control = control->m_parent;
+				if (control->m_measureInvalid)
+					break;
+				control->m_measureInvalid = true;
+				control->m_arrangeInvalid = true;
+				control->m_measureCache.clear();
+				control->mirrorLayoutState();
+			}
+		}
+		mirrorLayoutState();
+
+		// The parents above must only pass the arrange down
+		for (Control * parent = m_parent; parent && !parent->m_descendantInvalid; parent = parent->m_parent) {
+			parent->m_descendantInvalid = true;
+			parent->mirrorLayoutState();
+		}
+	}
+
+	void Control::mirrorLayoutState() const {
+		if (m_layoutTree)
+			m_layoutTree->store(m_layoutIndex, *this);
+	}
 
 	// Return true if the input message is expected and processed
 	// This function is only accessible within the GUI framework inside.
@@ -25,41 +548,208 @@ namespace v2x {
 		return false;
 	}
 
-	void Control::invalidateLayout() {}
+	void Control::invalidateLayout() {
+		invalidate(Invalidations(Invalidation::Measure) + Invalidation::Arrange);
+	}
+
+	void Control::invalidateCanvas() {
+		invalidate(Invalidations(Invalidation::Canvas));
+	}
 
-	void Control::invalidateCanvas() {}
+	void Control::invalidate(const Invalidations & invalidations) {
 
-	void Control::doOnLayoutChange(const void * sender, const void * data) {}
+		if (invalidations.contains(Invalidation::Measure))
+			invalidateLayoutState(true);
+		else if (invalidations.contains(Invalidation::Arrange))
+			invalidateLayoutState(false);
 
-	void Control::doOnFontChange(const void * sender, const void * data) {}
+		// Collect the invalidations until the transaction is committed
+		if (UpdateTransaction::isActive()) {
+			DirtySet & pending = getPendingInvalidations();
+			if (pending.isEmpty())
+				UpdateTransaction::addCommitHandler(&pending, &Control::flushPendingInvalidations);
+			pending.add(this, invalidations);
+			return;
+		}
+
+		DirtySet dirtySet;
+		dirtySet.add(this, invalidations);
+		dispatchInvalidations(dirtySet);
+	}
+
+	void Control::doOnInvalidated(const DirtySet & dirtySet) {}
+
+	void Control::doOnForgetInvalidations(Control * control) {}
+
+	void Control::dispatchInvalidations(const DirtySet & dirtySet) {
+
+		// Split the set by root controls
+		std::vector<std::pair<Control *, DirtySet>> roots;
+		for (size_t i = 0; i < dirtySet.count(); ++i) {
+
+			Control * root = dirtySet.getControl(i);
+			while (root->m_parent)
+				root = root->m_parent;
+
+			auto j = roots.begin();
+			while (j != roots.end() && j->first != root)
+				++j;
+			if (j == roots.end())
+				j = roots.insert(roots.end(), std::make_pair(root, DirtySet()));
+
+			j->second.add(dirtySet.getControl(i), dirtySet.getInvalidations(i));
+		}
+
+		for (auto i = roots.begin(); i != roots.end(); ++i)
+			i->first->doOnInvalidated(i->second);
+	}
+
+	void Control::flushPendingInvalidations() {
+		DirtySet dirtySet;
+		std::swap(dirtySet, getPendingInvalidations());
+		dispatchInvalidations(dirtySet);
+	}
+
+	DirtySet & Control::getPendingInvalidations() {
+		static DirtySet pending;
+		return pending;
+	}
+
+	void Control::doOnLayoutChange(const void * sender, const void * data) {
+
+		const LayoutFields fields = static_cast<const SpecChange *>(data)->getFields<LayoutSpec::Field>();
+
+		// The alignments only move the control within its parent.
+		const LayoutFields arrangeOnly =
+			LayoutFields(LayoutSpec::Field::HorizontalAlignment) + LayoutSpec::Field::VerticalAlignment;
+
+		Invalidations invalidations = Invalidations(Invalidation::Arrange) + Invalidation::Canvas;
+		if (!arrangeOnly.contains(fields)) {
+			invalidations += Invalidation::Measure;
+
+			// The spec of a control is part of the content of its parent,
+			// even if the control is a layout boundary
+			if (m_parent)
+				m_parent->invalidateLayoutState(true);
+		}
+		else if (m_parent && Layout->PositionMode.isSet() && Layout->PositionMode.get() == PositionMode::FloatSurround) {
+			// The side of a float moves the content of the parent around it
+			m_parent->invalidateLayoutState(true);
+		}
+		invalidate(invalidations);
+
+		if (m_parent)
+			m_parent->doOnChildLayoutChange(*this);
+	}
+
+	void Control::doOnFontChange(const void * sender, const void * data) {
+		// All font fields affect the text metrics.
+		invalidate(Invalidations(Invalidation::Measure) + Invalidation::Arrange + Invalidation::Canvas);
+	}
 
 	void Control::doOnCursorChange(const void * sender, const void * data) {}
 
+	void Control::doOnLayoutUnitsChange() {
+		if (!LayoutUnits::dependsOnDpi(Layout.get()))
+			return;
+
+		// As for a change of the layout spec
+		if (m_parent)
+			m_parent->invalidateLayoutState(true);
+		invalidate(Invalidations(Invalidation::Measure) + Invalidation::Arrange + Invalidation::Canvas);
+	}
+
 	//////////////////////
 	// ControlContainer //
 	//////////////////////
 
 	ControlContainer::ControlContainer() :
-		ContentLayout(LISTENER(this, ControlContainer::doOnContentLayoutChange)) {}
+		ContentLayout(LISTENER(this, ControlContainer::doOnContentLayoutChange)),
+		m_children(LISTENER(this, ControlContainer::doOnChildrenChange)),
+		m_childrenVersion(FieldTrackingSpec::newVersion()),
+		m_subtreeSize(0), m_hasSerialLayout(false), m_isChangingInLayout(false) {}
 
 	ControlContainer::~ControlContainer() {
 
-		// Destroy all subsequent controls
-		m_children.clear();
+		// Release all subsequent controls
+		m_children.setListener(nullptr);
+		for (auto i = m_children.begin(); i != m_children.end(); ++i)
+			(*i)->m_parent = nullptr;
 	}
 
 	// Add a child control
 	void ControlContainer::Add(Control::Shared control) {
-		auto i = std::find(m_children.begin(), m_children.end(), control);
-		if (i != m_children.end()) return;
+		if (m_children.contains(control)) return;
+
+		if (control->m_parent)
+			control->m_parent->Remove(control);
 
 		m_children.push_back(control);
 	}
 
+	void ControlContainer::AddRange(const SubControls & controls) {
+		SubControls added;
+		added.reserve(controls.size());
+
+		for (auto i = controls.begin(); i != controls.end(); ++i) {
+			if (m_children.contains(*i)) continue;
+
+			if ((*i)->m_parent)
+				(*i)->m_parent->Remove(*i);
+			added.push_back(*i);
+		}
+
+		// Skip controls listed twice
+		if (added.size() > 1) {
+			std::unordered_set<Control *> unique;
+			added.erase(std::remove_if(added.begin(), added.end(),
+				[&unique](const Control::Shared & control) { return !unique.insert(control.get()).second; }),
+				added.end());
+		}
+
+		m_children.append(added.begin(), added.end());
+	}
+
+	void ControlContainer::Insert(size_t index, Control::Shared control) {
+		const size_t current = m_children.indexOf(control);
+		if (current != Children::NotFound) {
+			m_children.move(current, 1, std::min(index, m_children.size() - 1));
+			return;
+		}
+
+		// Before the control leaves its current parent
+		if (index > m_children.size())
+			throw Exception(CHECKED_FORMAT(L"ControlContainer::Insert(): Index %d is out of range!", (int)index));
+
+		if (control->m_parent)
+			control->m_parent->Remove(control);
+
+		m_children.insert(index, control);
+	}
+
 	// Remove a child control
 	void ControlContainer::Remove(Control::Shared control) {
-		auto i = std::find(m_children.begin(), m_children.end(), control);
-		if (i != m_children.end()) m_children.erase(i);
+		m_children.removeValue(control);
+	}
+
+	void ControlContainer::RemoveRange(size_t index, size_t count) {
+		m_children.remove(index, count);
+	}
+
+	void ControlContainer::Move(size_t index, size_t count, size_t newIndex) {
+		m_children.move(index, count, newIndex);
+	}
+
+	void ControlContainer::Clear() {
+		m_children.clear();
+	}
+
+	const ControlContainer::Children & ControlContainer::getChildren() const {
+		return m_children;
+	}
+
+	bool ControlContainer::hasChild(const Control::Shared & control) const {
+		return m_children.contains(control);
 	}
 
 	// Return true if the input message is expected and processed
@@ -76,9 +766,295 @@ namespace v2x {
 		return Control::processMessage(message);
 	}
 
+	uint64_t ControlContainer::getLayoutInputsVersion() const {
+		return std::max(std::max(Control::getLayoutInputsVersion(), ContentLayout.getVersion()), m_childrenVersion);
+	}
+
+	Size2D64F ControlContainer::doMeasure(const Size2D64F & availableSize) {
+		const ResolvedMargin padding = getLayoutUnits().resolve(ContentLayout->Padding, availableSize);
+		const Size2D64F content = padding.deflate(availableSize).size;
+
+		layoutChildren([&content](Control & child, size_t) { child.measure(content); });
+
+		double width = 0, height = 0;
+		for (auto i = m_children.begin(); i != m_children.end(); ++i) {
+			width = std::max(width, (*i)->getDesiredSize().width());
+			height = std::max(height, (*i)->getDesiredSize().height());
+		}
+		return Size2D64F(width + padding.Left + padding.Right, height + padding.Top + padding.Bottom);
+	}
+
+	void ControlContainer::doArrange(const Size2D64F & finalSize) {
+		const LayoutUnits & units = getLayoutUnits();
+		const Rect64F content = units.resolve(ContentLayout->Padding, finalSize).deflate(finalSize);
+
+		// The content size may have come from the cache, so the children
+		// get the matching constraint before they are arranged
+		const Size2D64F & constraint = getContentConstraint();
+		const Size2D64F childConstraint = units.resolve(ContentLayout->Padding, constraint).deflate(constraint).size;
+
+		layoutChildren([&childConstraint, &content](Control & child, size_t) {
+			child.measure(childConstraint);
+			child.arrange(content);
+		});
+	}
+
+	void ControlContainer::doArrangeInvalidChildren() {
+		layoutChildren([](Control & child, size_t) {
+			if (!child.isLayoutValid())
+				child.arrange(child.m_finalRect);
+		});
+	}
+
+	size_t ControlContainer::getSubtreeSize() const {
+		if (m_subtreeSize == 0) {
+			m_subtreeSize = 1;
+			m_hasSerialLayout = false;
+			for (auto i = m_children.begin(); i != m_children.end(); ++i) {
+				m_subtreeSize += (*i)->getSubtreeSize();
+				m_hasSerialLayout = m_hasSerialLayout || (*i)->hasSerialLayout();
+			}
+		}
+		return m_subtreeSize;
+	}
+
+	bool ControlContainer::hasSerialLayout() const {
+		getSubtreeSize();
+		return m_hasSerialLayout;
+	}
+
+	void ControlContainer::layoutChildren(const std::function<void(Control &, size_t)> & step) {
+		TaskPool * pool = m_children.size() > 1 ? getParallelLayoutPool() : nullptr;
+		const size_t threshold = getParallelLayoutThreshold();
+
+		if (!pool || getSubtreeSize() < threshold) {
+			for (size_t i = 0; i < m_children.size(); ++i)
+				step(*m_children[i], i);
+			return;
+		}
+
+		// Fork chunks of about half the threshold, so that small children are
+		// not forked one by one. The children with a serial layout stay on
+		// this thread, which is the one which started the layout.
+		std::vector<std::pair<size_t, size_t>> chunks;
+		std::vector<size_t> serial;
+		size_t first = 0, size = 0;
+		for (size_t i = 0; i < m_children.size(); ++i) {
+			if (m_children[i]->hasSerialLayout())
+				serial.push_back(i);
+			else
+				size += m_children[i]->getSubtreeSize();
+			if (size * 2 >= threshold || i + 1 == m_children.size()) {
+				if (size > 0)
+					chunks.push_back(std::make_pair(first, i + 1));
+				first = i + 1;
+				size = 0;
+			}
+		}
+
+		// Each chunk counts on its own, the sums are added in order
+		std::vector<LayoutStatistics> statistics(chunks.size());
+		LayoutBudget * budget = t_budget;
+		auto runChunk = [this, &step, &chunks, &statistics, budget](size_t chunk) {
+			LayoutScope scope(&statistics[chunk], budget);
+			for (size_t i = chunks[chunk].first; i < chunks[chunk].second; ++i)
+				if (!m_children[i]->hasSerialLayout())
+					step(*m_children[i], i);
+		};
+
+		{
+			TaskGroup group(*pool);
+			for (size_t i = 1; i < chunks.size(); ++i)
+				group.run([&runChunk, i]() { runChunk(i); });
+			if (!chunks.empty())
+				runChunk(0);
+			for (auto i = serial.begin(); i != serial.end(); ++i)
+				step(*m_children[*i], *i);
+			group.wait();
+		}
+
+		LayoutStatistics & total = getLayoutStatistics();
+		for (auto i = statistics.begin(); i != statistics.end(); ++i)
+			total += *i;
+	}
+
+	void ControlContainer::changeChildrenInLayout(const std::function<void(Children &)> & change) {
+		m_isChangingInLayout = true;
+		try {
+			change(m_children);
+		}
+		catch (...) {
+			m_isChangingInLayout = false;
+			throw;
+		}
+		m_isChangingInLayout = false;
+	}
+
 	void ControlContainer::doOnContentLayoutChange(const void * sender, const void * data) {
+
+		const ContentLayoutFields fields = static_cast<const SpecChange *>(data)->getFields<ContentLayoutSpec::Field>();
+
+		// The flow alignment only moves the children within the container.
+		Invalidations invalidations = Invalidations(Invalidation::Arrange) + Invalidation::Canvas;
+		if (!ContentLayoutFields(ContentLayoutSpec::Field::FlowAlignment).contains(fields))
+			invalidations += Invalidation::Measure;
+		invalidate(invalidations);
+	}
+
+	void ControlContainer::doOnChildrenChange(const void * sender, const void * data) {
+
+		const Children::Change & change = *static_cast<const Children::Change *>(data);
+
+		// The flat tree is built again on its next use
+		if (m_layoutTree)
+			m_layoutTree->markStale();
+
+		if (!change.OldItems.empty() && !m_isChangingInLayout) {
+			Control * root = this;
+			while (root->m_parent)
+				root = root->m_parent;
+
+			// Replaced children may have been inserted again
+			for (auto i = change.OldItems.begin(); i != change.OldItems.end(); ++i)
+				if (!m_children.contains(*i)) {
+					forgetInvalidations(root, i->get());
+					(*i)->m_parent = nullptr;
+				}
+		}
+
+		if (change.Action == CollectionAction::Insert || change.Action == CollectionAction::Replace ||
+			change.Action == CollectionAction::Reset) {
+			const size_t first = change.Action == CollectionAction::Reset ? 0 : change.Index;
+			for (size_t i = first; i < first + change.Count; ++i)
+				m_children[i]->m_parent = this;
+		}
+
+		// Neither the invalidations of the root nor the containers above
+		// are touched within a layout
+		if (m_isChangingInLayout) {
+			for (auto i = change.OldItems.begin(); i != change.OldItems.end(); ++i)
+				if (!m_children.contains(*i))
+					(*i)->m_parent = nullptr;
+			m_subtreeSize = 0;
+			return;
+		}
+
+		m_childrenVersion = FieldTrackingSpec::newVersion();
+
+		// The sizes of the subtrees above are unknown as well
+		for (ControlContainer * container = this; container && container->m_subtreeSize != 0; container = container->m_parent)
+			container->m_subtreeSize = 0;
+
 		invalidateLayout();
-		invalidateCanvas();
+	}
+
+	void ControlContainer::doOnChildLayoutChange(Control & child) {}
+
+	void ControlContainer::doOnLayoutUnitsChange() {
+		Control::doOnLayoutUnitsChange();
+		if (LayoutUnits::dependsOnDpi(ContentLayout->Padding))
+			invalidate(Invalidations(Invalidation::Measure) + Invalidation::Arrange + Invalidation::Canvas);
+
+		for (auto i = m_children.begin(); i != m_children.end(); ++i)
+			(*i)->doOnLayoutUnitsChange();
+	}
+
+	void ControlContainer::forgetInvalidations(Control * root, Control * control) {
+		root->doOnForgetInvalidations(control);
+
+		auto container = dynamic_cast<ControlContainer *>(control);
+		if (container)
+			for (auto i = container->m_children.begin(); i != container->m_children.end(); ++i)
+				forgetInvalidations(root, i->get());
+	}
+
+	///////////////////
+	// FlowContainer //
+	///////////////////
+
+	FlowContainer::FlowContainer() : m_firstResized(Children::NotFound) {}
+
+	FlowContainer::~FlowContainer() {}
+
+	const FlowLayout & FlowContainer::getFlow() const { return m_flow; }
+
+	Size2D64F FlowContainer::doMeasure(const Size2D64F & availableSize) {
+		const ResolvedMargin padding = getLayoutUnits().resolve(ContentLayout->Padding, availableSize);
+		const Size2D64F content = padding.deflate(availableSize).size;
+
+		measureChildren(content);
+		updateFlow(content.width());
+
+		const Size2D64F size = m_flow.getContentSize();
+		return Size2D64F(size.width() + padding.Left + padding.Right, size.height() + padding.Top + padding.Bottom);
+	}
+
+	void FlowContainer::doArrange(const Size2D64F & finalSize) {
+		const LayoutUnits & units = getLayoutUnits();
+		const Rect64F content = units.resolve(ContentLayout->Padding, finalSize).deflate(finalSize);
+
+		// The content size may have come from the cache, see ControlContainer
+		const Size2D64F & constraint = getContentConstraint();
+		const Size2D64F childConstraint = units.resolve(ContentLayout->Padding, constraint).deflate(constraint).size;
+
+		measureChildren(childConstraint);
+		updateFlow(content.getWidth());
+
+		const FlowDirection direction = ContentLayout->FlowDirection.isSet() ?
+			ContentLayout->FlowDirection.get() : FlowDirection::TopLeftToBottomRight;
+		layoutChildren([this, &content, direction](Control & child, size_t index) {
+			const Rect64F rect = m_flow.getItemRect(index, content.size, direction);
+			child.arrange(Rect64F(content.getLeft() + rect.getLeft(), content.getTop() + rect.getTop(),
+				rect.getWidth(), rect.getHeight()));
+		});
+	}
+
+	void FlowContainer::doOnChildrenChange(const void * sender, const void * data) {
+		ControlContainer::doOnChildrenChange(sender, data);
+
+		// The items follow the children
+		const Children::Change & change = *static_cast<const Children::Change *>(data);
+		if (change.Action == CollectionAction::Move) {
+			m_flow.moveItems(change.Index, change.Count, change.NewIndex);
+			return;
+		}
+
+		// The removed or replaced children are followed by the new ones
+		const size_t first = change.Action == CollectionAction::Reset ? 0 : change.Index;
+		m_flow.removeItems(first, change.OldItems.size());
+		m_flow.insertItems(first, change.Count);
+		for (size_t i = first; i < first + change.Count; ++i)
+			m_flow.setItem(i, getFlowItem(*m_children[i]));
+	}
+
+	void FlowContainer::doOnChildLayoutChange(Control & child) {
+		const size_t index = m_children.indexOf(std::static_pointer_cast<Control>(child.shared_from_this()));
+		if (index != Children::NotFound)
+			m_flow.setItem(index, getFlowItem(child));
+	}
+
+	void FlowContainer::measureChildren(const Size2D64F & constraint) {
+		layoutChildren([this, &constraint](Control & child, size_t index) {
+			child.measure(constraint);
+			if (child.getDesiredSize() == m_flow.getItem(index).Size)
+				return;
+			size_t first = m_firstResized;
+			while (index < first && !m_firstResized.compare_exchange_weak(first, index)) {}
+		});
+
+		// The children after the first resized one are placed again anyway
+		const size_t first = m_firstResized.exchange(Children::NotFound);
+		for (size_t i = first; i < m_children.size(); ++i) {
+			FlowItem item = m_flow.getItem(i);
+			item.Size = m_children[i]->getDesiredSize();
+			m_flow.setItem(i, item);
+		}
+	}
+
+	void FlowContainer::updateFlow(double width) {
+		const FlowAlignment alignment = ContentLayout->FlowAlignment.isSet() ?
+			ContentLayout->FlowAlignment.get() : FlowAlignment::Left;
+		m_flow.update(width, alignment);
 	}
 
 	///////////////////////////
@@ -111,15 +1087,33 @@ namespace v2x {
 	// EventDataKeyboard //
 	///////////////////////
 
-	EventDataKeyboard::EventDataKeyboard(const String & key,
+	EventDataKeyboard::EventDataKeyboard(const Atom & key,
 		const EnumSet<KeyModifier> & modifiers) :
 		Key(key), Modifiers(modifiers) {}
 
 	EventDataKeyboard::EventDataKeyboard(const KeyModifier & modifier) :
-		Key('\0'), Modifiers(modifier) {}
+		Key(EnumString<KeyModifier>::getName(modifier).Data), Modifiers(modifier) {}
 
 	EventDataKeyboard::~EventDataKeyboard() {}
 
+	////////////////////
+	// EventDataTimer //
+	////////////////////
+
+	EventDataTimer::EventDataTimer(const uint32_t & timerId) :
+		TimerId(timerId) {}
+
+	EventDataTimer::~EventDataTimer() {}
+
+	////////////////////////
+	// EventDataDpiChange //
+	////////////////////////
+
+	EventDataDpiChange::EventDataDpiChange(const double & dpi) :
+		Dpi(dpi) {}
+
+	EventDataDpiChange::~EventDataDpiChange() {}
+
 	////////////////
 	// WindowHost //
 	////////////////
@@ -132,12 +1126,17 @@ namespace v2x {
 	// Window //
 	////////////
 
-	Window::Window() {
+	const double Window::DEFAULT_LAYOUT_SLICE = 8;
+
+	Window::Window() : m_layoutSlice(DEFAULT_LAYOUT_SLICE) {
 
 		// Initialize default window size as 1/3 of the screen size.
 		Displays displays;
-		Layout.Width.Size = displays.getPrimaryDisplay()->getScreenAreaInPx().getWidth() / 3;
-		Layout.Height.Size = displays.getPrimaryDisplay()->getScreenAreaInPx().getHeight() / 3;
+		m_layoutUnits = displays.getPrimaryDisplay()->getLayoutUnits();
+		Layout.edit([&displays](LayoutSpec & layout) {
+			layout.Width.Size = displays.getPrimaryDisplay()->getScreenAreaInPx().getWidth() / 3;
+			layout.Height.Size = displays.getPrimaryDisplay()->getScreenAreaInPx().getHeight() / 3;
+		});
 	}
 
 	Window::~Window() {
@@ -155,12 +1154,14 @@ namespace v2x {
 		m_host->OnShow += EVENTHANDLER_FROM_THIS(Window::doOnHostShow);
 		m_host->OnClose += EVENTHANDLER_FROM_THIS(Window::doOnHostClose);
 		m_host->OnResize += EVENTHANDLER_FROM_THIS(Window::doOnHostResize);
+		m_host->OnPaint += EVENTHANDLER_FROM_THIS(Window::doOnHostPaint);
+		m_host->OnDpiChange += EVENTHANDLER_FROM_THIS(Window::doOnHostDpiChange);
 
 		// Other initializations
-		if (Layout.Width.Size.isSet() || Layout.Height.Size.isSet()) {
+		if (Layout->Width.Size.isSet() || Layout->Height.Size.isSet()) {
 			Size2D64F defaultSize = m_host->getDefaultWindowSize();
-			double w = Layout.Width.Size.isSet() ? Layout.Width.Size.get() : defaultSize.width();
-			double h = Layout.Height.Size.isSet() ? Layout.Height.Size.get() : defaultSize.height();
+			double w = Layout->Width.Size.isSet() ? Layout->Width.Size.get() : defaultSize.width();
+			double h = Layout->Height.Size.isSet() ? Layout->Height.Size.get() : defaultSize.height();
 			m_host->setPosition(Rect64F(0, 0, w, h));
 		}
 		// ...
@@ -195,6 +1196,62 @@ namespace v2x {
 	double Window::getActualWidth() const { return m_actualPosition.getWidth(); }
 	double Window::getActualHeight() const { return m_actualPosition.getHeight(); }
 
+	WindowHost::Shared Window::getHost() const { return m_host; }
+
+	void Window::updateLayout() {
+		updateLayout(m_actualPosition.size);
+	}
+
+	bool Window::updateLayout(LayoutBudget & budget) {
+		return updateLayout(m_actualPosition.size, budget);
+	}
+
+	void Window::setLayoutSlice(double milliseconds) { m_layoutSlice = milliseconds; }
+
+	double Window::getLayoutSlice() const { return m_layoutSlice; }
+
+	const LayoutUnits & Window::getLayoutUnits() const { return m_layoutUnits; }
+
+	void Window::setLayoutUnits(const LayoutUnits & units) {
+		if (units == m_layoutUnits)
+			return;
+
+		m_layoutUnits = units;
+		doOnLayoutUnitsChange();
+	}
+
+	void Window::setDisplay(const Display & display) {
+		setLayoutUnits(display.getLayoutUnits());
+	}
+
+	const DirtySet & Window::getDirtySet() const { return m_dirtySet; }
+
+	void Window::clearDirtySet() { m_dirtySet.clear(); }
+
+	const LayoutTree & Window::getLayoutTree() {
+		if (m_tree.isStale() || m_tree.empty() || m_tree.getControl(0) != this)
+			m_tree.build(*this);
+		else if (m_tree.areBoundsStale())
+			m_tree.updateBounds();
+		return m_tree;
+	}
+
+	Control * Window::getControlAt(const Vector2D64F & position) {
+		const LayoutTree & tree = getLayoutTree();
+		const LayoutTree::Index index = tree.hitTest(position);
+		return index == LayoutTree::NONE ? nullptr : tree.getControl(index);
+	}
+
+	void Window::doOnInvalidated(const DirtySet & dirtySet) {
+		m_dirtySet.add(dirtySet);
+		if (m_host)
+			m_host->requestPaint();
+	}
+
+	void Window::doOnForgetInvalidations(Control * control) {
+		m_dirtySet.remove(control);
+	}
+
 	void Window::doOnHostShow(Event::Shared e) {
 
 		auto data = e->getDataAs<const EventDataWindowSize>();
@@ -204,6 +1261,17 @@ namespace v2x {
 	void Window::doOnHostClose(Event::Shared e) {
 	}
 
+	void Window::doOnHostPaint(Event::Shared e) {
+		LayoutBudget budget(m_layoutSlice);
+		if (!updateLayout(budget))
+			m_host->requestPaint();
+	}
+
+	void Window::doOnHostDpiChange(Event::Shared e) {
+		auto data = e->getDataAs<const EventDataDpiChange>();
+		setLayoutUnits(LayoutUnits(data->Dpi));
+	}
+
 	void Window::doOnHostResize(Event::Shared e) {
 
 		auto data = e->getDataAs<const EventDataWindowSize>();
@@ -212,7 +1280,14 @@ namespace v2x {
 		bool sizeChanged = newRect.size != m_actualPosition.size;
 		m_actualPosition = newRect;
 
+		// The window follows the size of the host, which invalidates the
+		// layout if it changes
 		if (sizeChanged)
-			invalidateLayout();
+			Layout.edit([&newRect](LayoutSpec & layout) {
+				layout.Width.Size = newRect.getWidth();
+				layout.Width.Unit = ScalarUnit::Pixel;
+				layout.Height.Size = newRect.getHeight();
+				layout.Height.Unit = ScalarUnit::Pixel;
+			});
 	}
 }
\ No newline at end of file
@@ -3,9 +3,15 @@
 #pragma once
 
 #include "../../common.h"
+#include "../Graphics/FlowLayout.h"
 #include "../Graphics/Layout.h"
+#include "LayoutTree.h"
 #include "WindowHost.h"
 
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
 namespace v2x {
 
 	/// The mouse cursor specification
@@ -15,16 +21,182 @@ namespace v2x {
 		Busy
 	};
 	/// The strings for MouseButton
-	std::vector<const Char *> EnumString<Cursor>::m_strings = {
+	DEFINE_ENUM_STRINGS(Cursor,
 		L"Arrow",
 		L"Busy"
-	};
+	);
 	typedef SimpleSpec<Cursor> CursorSpec;
 
+	/// The aspects of a control which can be invalidated
+	enum class Invalidation : uint8_t {
+		/// The size of the control must be measured again
+		Measure,
+
+		/// The control or its children must be positioned again
+		Arrange,
+
+		/// The control must be repainted
+		Canvas
+	};
+	/// The strings for Invalidation
+	DEFINE_ENUM_STRINGS(Invalidation,
+		L"Measure",
+		L"Arrange",
+		L"Canvas"
+	);
+	typedef EnumSet<Invalidation> Invalidations;
+
+	class Control;
+	class ControlContainer;
+
+	/// This class collects invalidated controls. Each control is contained
+	/// only once with all its invalidations merged.
+	///
+	/// The set does not own the controls. Destroyed controls must be removed.
+	///
+	class DirtySet {
+	public:
+		DirtySet();
+		~DirtySet();
+
+		/// Add the invalidations of a control
+		void add(Control * control, const Invalidations & invalidations);
+		/// Merge another set into this one
+		void add(const DirtySet & dirtySet);
+		void remove(Control * control);
+		void clear();
+
+		bool isEmpty() const;
+		size_t count() const;
+		bool contains(const Control * control) const;
+
+		Control * getControl(size_t index) const;
+		const Invalidations & getInvalidations(size_t index) const;
+		/// Returns the invalidations of a control or an empty set
+		Invalidations getInvalidations(const Control * control) const;
+
+	private:
+		std::vector<std::pair<Control *, Invalidations>> m_entries;
+		std::unordered_map<const Control *, size_t> m_index;
+	};
+
+	/// Counters of the work done by the layout, e.g. for benchmarks
+	class LayoutStatistics {
+	public:
+		LayoutStatistics() : Measures(0), Arranges(0), MeasureCacheHits(0), MeasureCacheMisses(0) {}
+
+		/// The number of controls measured, not counting skipped ones
+		uint64_t Measures;
+		/// The number of controls arranged, not counting skipped ones
+		uint64_t Arranges;
+		/// The number of measures which took the size of the content from
+		/// the cache and those which measured it
+		uint64_t MeasureCacheHits;
+		uint64_t MeasureCacheMisses;
+
+		void reset() { *this = LayoutStatistics(); }
+
+		LayoutStatistics & operator += (const LayoutStatistics & statistics) {
+			Measures += statistics.Measures;
+			Arranges += statistics.Arranges;
+			MeasureCacheHits += statistics.MeasureCacheHits;
+			MeasureCacheMisses += statistics.MeasureCacheMisses;
+			return *this;
+		}
+	};
+
+	/// The time limit of a layout. A layout which runs out of time stops and
+	/// is resumed by the next one, see Control::updateLayout().
+	///
+	/// The clock is read only every few controls, so the limit may be
+	/// exceeded by the time of laying out a few controls.
+	class LayoutBudget {
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		/// The number of controls laid out between two reads of the clock
+		static const uint32_t CHECK_INTERVAL = 16;
+
+		/// Unlimited
+		LayoutBudget();
+		explicit LayoutBudget(double milliseconds);
+
+		bool isUnlimited() const;
+
+		/// Called before laying out a control. Returns true if the time is up.
+		bool isExpired();
+		/// Returns true if the time has been found to be up
+		bool isInterrupted() const;
+
+	private:
+		bool m_unlimited;
+		Clock::time_point m_deadline;
+		std::atomic<uint32_t> m_calls;
+		std::atomic<bool> m_interrupted;
+
+		LayoutBudget(const LayoutBudget &);
+		LayoutBudget & operator = (const LayoutBudget &);
+	};
+
+	/// The sizes of the content of a control measured with the last few
+	/// constraints. The entries are tagged with the layout inputs version of
+	/// the control; entries of an older version are never returned and are
+	/// replaced first.
+	class MeasureCache {
+	public:
+		static const size_t CAPACITY = 4;
+
+		MeasureCache();
+
+		/// Returns false if no entry of the constraint and version exists
+		bool find(const Size2D64F & constraint, uint64_t version, Size2D64F & size) const;
+		void add(const Size2D64F & constraint, uint64_t version, const Size2D64F & size);
+		void clear();
+
+		size_t count() const;
+
+	private:
+		class Entry {
+		public:
+			Size2D64F Constraint;
+			uint64_t Version;
+			Size2D64F Size;
+		};
+
+		Entry m_entries[CAPACITY];
+		size_t m_count;
+		/// The entry to be replaced next if all are current
+		size_t m_next;
+	};
+
 	// The common class for all visual elements
 	//
+	// Changes of the specs invalidate the control. Within an UpdateTransaction
+	// the invalidations of all controls are collected and handed to their
+	// root controls once on commit.
+	//
+	// The layout runs in two passes: measure() computes the size each control
+	// wants bottom-up, arrange() assigns the final positions top-down. Both
+	// skip the controls which are neither invalidated nor given another
+	// constraint. An invalidated control marks its parents to be measured
+	// again only up to the nearest relayout boundary (see isLayoutBoundary()),
+	// so a change inside a fixed-size panel never lays out its ancestors.
+	// The content sizes are cached by constraint, so controls whose content
+	// gets a known constraint again are not measured, e.g. fixed-size panels
+	// while the window is resized.
+	//
+	// If enabled by setParallelLayout(), containers with large subtrees lay
+	// out their children in parallel on a task pool. doMeasure() and
+	// doArrange() must then only access the subtree of their control and
+	// must not edit any specs.
+	//
+	// A layout with a budget stops when its time is up. The controls which
+	// have not been laid out keep their geometry and stay invalid, so the
+	// next layout continues with them.
+	//
 	class Control : public Object, public MessageHandler {
 		friend class ControlContainer;
+		friend class LayoutTree;
 	public:
 		DEFINE_POINTERS(Control);
 
@@ -35,11 +207,82 @@ namespace v2x {
 		virtual void show() = 0;
 		virtual void close() = 0;
 
-		LayoutSpec Layout;
-		FontSpec Font;
+		/// Layout and font are shared between all controls with equal values.
+		/// Use edit() or assign a whole spec to change them.
+		SharedLayoutSpec Layout;
+		SharedFontSpec Font;
 
 		CursorSpec Cursor;
 
+		/// Returns the container of the control or nullptr
+		ControlContainer * getParent() const;
+
+		/// Returns a version which changes whenever an input of the layout of
+		/// this control changes, e.g. the layout or font specification. Caches
+		/// of measured sizes or text can be validated by comparing it.
+		virtual uint64_t getLayoutInputsVersion() const;
+
+		/// Measure the size the control wants within an available size. The
+		/// sizes include the margin, infinite ones mean no limit.
+		void measure(const Size2D64F & availableSize);
+		/// Position the control within a slot given in the coordinates of
+		/// the parent. The slot includes the margin.
+		void arrange(const Rect64F & finalRect);
+		/// Lay out the invalidated parts of the tree of a root control
+		void updateLayout(const Size2D64F & size);
+		/// Lay out as much as the budget allows. Returns true if the layout
+		/// is complete.
+		bool updateLayout(const Size2D64F & size, LayoutBudget & budget);
+
+		/// Returns the size from the last measure including the margin
+		const Size2D64F & getDesiredSize() const;
+		/// Returns the rectangle from the last arrange in the coordinates of
+		/// the parent, without margin
+		const Rect64F & getLayoutRect() const;
+		/// Returns true if the control needs no measure or arrange
+		bool isLayoutValid() const;
+		/// Returns the constraint of the content from the last measure
+		const Size2D64F & getContentConstraint() const;
+		const MeasureCache & getMeasureCache() const;
+		/// Returns the index of the control in the layout tree of its window
+		/// or LayoutTree::NONE, see Window::getLayoutTree()
+		LayoutTree::Index getLayoutIndex() const;
+		/// Returns the layout spec resolved by the last arrange
+		const ResolvedLayout & getResolvedLayout() const;
+
+		/// Returns true if no change inside the control can change its desired
+		/// size, so that the parent needs no measure. These are the roots and
+		/// the controls with a width and height in absolute units.
+		virtual bool isLayoutBoundary() const;
+		/// Returns the units to resolve the layout specs. These are the units
+		/// of the parent by default.
+		virtual const LayoutUnits & getLayoutUnits() const;
+
+		/// Returns the number of controls in the subtree of the control
+		virtual size_t getSubtreeSize() const;
+		/// Returns true if the subtree must be laid out by the thread which
+		/// started the layout, e.g. because it creates and binds controls.
+		/// The parallel layout never forks such subtrees.
+		virtual bool hasSerialLayout() const;
+
+		/// The default minimum subtree size to be laid out in parallel
+		static const size_t DEFAULT_PARALLEL_LAYOUT_THRESHOLD = 256;
+
+		/// Lay out the children of containers with at least threshold
+		/// controls on a pool, e.g. TaskPool::getDefault(). The parallel
+		/// layout is disabled by default and by a pool of nullptr.
+		///
+		/// While a pool is set, the code running inside measure and arrange
+		/// must not edit specs, e.g. by Layout.edit(), since their values are
+		/// interned in pools which are not thread-safe.
+		static void setParallelLayout(TaskPool * pool, size_t threshold = DEFAULT_PARALLEL_LAYOUT_THRESHOLD);
+		static TaskPool * getParallelLayoutPool();
+		static size_t getParallelLayoutThreshold();
+
+		/// Returns the statistics of the calling thread. Those of parallel
+		/// layouts are added to the thread which started them.
+		static LayoutStatistics & getLayoutStatistics();
+
 		// Mouse events..
 		// MouseMove
 		// MouseClick
@@ -62,12 +305,66 @@ namespace v2x {
 		// This function is only accessible within the GUI framework inside.
 		bool processMessage(const Message & message) override;
 
+		/// Invalidate measure and arrange
 		virtual void invalidateLayout();
 		virtual void invalidateCanvas();
+		void invalidate(const Invalidations & invalidations);
+
+		/// Measure the content within the available size without margin and
+		/// return its size. The default content is empty.
+		virtual Size2D64F doMeasure(const Size2D64F & availableSize);
+		/// Arrange the content within the final size without margin
+		virtual void doArrange(const Size2D64F & finalSize);
+		/// Arrange the children which need layout within their last slots
+		virtual void doArrangeInvalidChildren();
+
+		/// Called on root controls (those without parent) with the
+		/// invalidations of their subtree.
+		virtual void doOnInvalidated(const DirtySet & dirtySet);
+		/// Called on root controls when a control leaves their subtree.
+		virtual void doOnForgetInvalidations(Control * control);
 
 		virtual void doOnLayoutChange(const void * sender, const void * data);
 		virtual void doOnFontChange(const void * sender, const void * data);
 		virtual void doOnCursorChange(const void * sender, const void * data);
+		/// Called on each control of a tree whose layout units have changed,
+		/// e.g. because its window moved to another display. Only controls
+		/// with sizes depending on the resolution are invalidated.
+		virtual void doOnLayoutUnitsChange();
+
+	private:
+		ControlContainer * m_parent;
+
+		/// The constraint of the last measure
+		Size2D64F m_availableSize;
+		Size2D64F m_contentConstraint;
+		Size2D64F m_desiredSize;
+		MeasureCache m_measureCache;
+		/// The slot of the last arrange
+		Rect64F m_finalRect;
+		Rect64F m_layoutRect;
+		bool m_measureInvalid;
+		bool m_arrangeInvalid;
+		/// A descendant needs layout
+		bool m_descendantInvalid;
+		ResolvedLayout m_resolvedLayout;
+
+		/// The layout tree which mirrors the state above
+		LayoutTree * m_layoutTree;
+		LayoutTree::Index m_layoutIndex;
+
+		/// Mark the control to be laid out again. If the desired size may
+		/// change, the parents are marked up to the nearest boundary and
+		/// their measure caches are cleared.
+		void invalidateLayoutState(bool measure);
+		/// Write the layout state through to the layout tree
+		void mirrorLayoutState() const;
+
+		/// Hand the invalidations to the root controls.
+		static void dispatchInvalidations(const DirtySet & dirtySet);
+		/// Dispatch the invalidations collected by the current transaction.
+		static void flushPendingInvalidations();
+		static DirtySet & getPendingInvalidations();
 	};
 
 	/// This class is the common base for the controls with subsequent controls.
@@ -75,7 +372,7 @@ namespace v2x {
 	/// It forward the incoming messages to the children controls.
 	///
 	class ControlContainer : public Control {
-
+		friend class Control;
 	public:
 		DEFINE_POINTERS(ControlContainer);
 
@@ -83,23 +380,126 @@ namespace v2x {
 
 		virtual ~ControlContainer();
 
+		typedef std::vector<Control::Shared> SubControls;
+		typedef ObservableVector<Control::Shared> Children;
+
 		// Add a child control
 		void Add(Control::Shared control);
+		/// Add several controls at once. Controls which are already children
+		/// are skipped.
+		void AddRange(const SubControls & controls);
+		/// Insert a child control at a position. A child is moved there.
+		///
+		/// @throw Exception if the index is out of range. The control keeps
+		///        its parent then.
+		void Insert(size_t index, Control::Shared control);
 		// Remove a child control
 		void Remove(Control::Shared control);
+		/// Remove a range of child controls
+		void RemoveRange(size_t index, size_t count);
+		/// Move a range of child controls so that it starts at newIndex
+		void Move(size_t index, size_t count, size_t newIndex);
+		void Clear();
 
-		ContentLayoutSpec ContentLayout;
+		const Children & getChildren() const;
+		/// Returns true if the control is a child. It takes constant time.
+		bool hasChild(const Control::Shared & control) const;
 
-	protected:
+		SharedContentLayoutSpec ContentLayout;
 
-		typedef std::vector<Control::Shared> SubControls;
+		/// Includes the content layout and the list of children
+		uint64_t getLayoutInputsVersion() const override;
 
-		// Owned reference to child contorls
-		SubControls m_children;
+		size_t getSubtreeSize() const override;
+		bool hasSerialLayout() const override;
+
+	protected:
+
+		/// The children overlap. Each one is aligned within the content area
+		/// by its own layout spec.
+		Size2D64F doMeasure(const Size2D64F & availableSize) override;
+		void doArrange(const Size2D64F & finalSize) override;
+		void doArrangeInvalidChildren() override;
+
+		/// Run a step of the layout, e.g. measure, for each child and its
+		/// index. The steps of the children must be independent, so that
+		/// large subtrees can be laid out in parallel.
+		void layoutChildren(const std::function<void(Control &, size_t)> & step);
+
+		/// Change the children within doMeasure(), e.g. to create them on
+		/// demand. Only this container is touched: the children are adopted
+		/// and released, but nothing is invalidated as the measure in
+		/// progress covers the change. The released children must be kept
+		/// alive, e.g. for reuse.
+		void changeChildrenInLayout(const std::function<void(Children &)> & change);
+
+		// Owned reference to child contorls. Each change of the list is
+		// handled by doOnChildrenChange().
+		Children m_children;
+		// Version of the list of children
+		uint64_t m_childrenVersion;
 
 		bool processMessage(const Message & message) override;
 
 		virtual void doOnContentLayoutChange(const void * sender, const void * data);
+		/// Adopt the inserted and release the removed children
+		virtual void doOnChildrenChange(const void * sender, const void * data);
+		/// Called after the layout spec of a child has changed
+		virtual void doOnChildLayoutChange(Control & child);
+		/// Pass the change on to the children
+		void doOnLayoutUnitsChange() override;
+
+	private:
+		/// The number of controls in the subtree or 0 if unknown
+		mutable size_t m_subtreeSize;
+		/// A child has a serial layout, valid with the subtree size
+		mutable bool m_hasSerialLayout;
+		bool m_isChangingInLayout;
+
+		/// Remove a control and its children from the invalidations of a root
+		static void forgetInvalidations(Control * root, Control * control);
+	};
+
+	/// This container places its children into lines like text, see
+	/// FlowLayout. The position mode of a child decides how it takes part in
+	/// the flow, floats go to the side of their horizontal alignment. The
+	/// content layout gives the alignment and direction of the flow.
+	///
+	/// A change of the children places them again from the line of the first
+	/// changed child. The items of the flow follow the changes of the list
+	/// and the specs of the children, so a flow without changes is not
+	/// placed again.
+	///
+	class FlowContainer : public ControlContainer {
+
+	public:
+		DEFINE_POINTERS(FlowContainer);
+
+		FlowContainer();
+
+		virtual ~FlowContainer();
+
+		/// Returns the flow of the last measure or arrange
+		const FlowLayout & getFlow() const;
+
+	protected:
+
+		Size2D64F doMeasure(const Size2D64F & availableSize) override;
+		void doArrange(const Size2D64F & finalSize) override;
+
+		void doOnChildrenChange(const void * sender, const void * data) override;
+		void doOnChildLayoutChange(Control & child) override;
+
+	private:
+		FlowLayout m_flow;
+		/// The first child whose size differs from its item. The children
+		/// may be measured in parallel.
+		std::atomic<size_t> m_firstResized;
+
+		/// Measure the children and take the sizes which have changed
+		void measureChildren(const Size2D64F & constraint);
+		/// Place the measured children within a width
+		void updateFlow(double width);
 	};
 
 	/// The visual state of a window
@@ -114,11 +514,11 @@ namespace v2x {
 		Maximized
 	};
 	/// The strings for WindowState
-	std::vector<const Char *> EnumString<WindowState>::m_strings = {
+	DEFINE_ENUM_STRINGS(WindowState,
 		L"Normal",
 		L"Minimized",
 		L"Maximized"
-	};
+	);
 
 	/// This event data represents the resizing behaviour of a window.
 	///
@@ -141,11 +541,11 @@ namespace v2x {
 		Right
 	};
 	/// The strings for MouseButton
-	std::vector<const Char *> EnumString<MouseButton>::m_strings = {
+	DEFINE_ENUM_STRINGS(MouseButton,
 		L"Left",
 		L"Middle",
 		L"Right"
-	};
+	);
 
 	/// The basic key modifiers
 	enum class KeyModifier {
@@ -155,12 +555,12 @@ namespace v2x {
 		Command
 	};
 	/// The strings for KeyModifier
-	std::vector<const Char *> EnumString<KeyModifier>::m_strings = {
+	DEFINE_ENUM_STRINGS(KeyModifier,
 		L"Control",
 		L"Alt",
 		L"Shift",
 		L"Command"
-	};
+	);
 
 	/// This event data represents mouse moving and mouse button hitting events.
 	/// 
@@ -197,7 +597,8 @@ namespace v2x {
 	/// In case of special key stroke, the Key field holds the corresponding 
 	/// string of that key, which is usually longer than one character. For
 	/// example, the Key field will be set to L"F10" when the key F10 is 
-	/// pressed.
+	/// pressed. The key is an atom, so comparing it to another key compares
+	/// pointers.
 	///
 	/// The Modifiers field will always show the state related to the event.
 	///
@@ -205,15 +606,44 @@ namespace v2x {
 	public:
 		DEFINE_POINTERS(EventDataKeyboard);
 
-		EventDataKeyboard(const String & key,
+		EventDataKeyboard(const Atom & key,
 			const EnumSet<KeyModifier> & modifiers);
 		EventDataKeyboard(const KeyModifier & modifier);
 		~EventDataKeyboard();
 
-		String Key;
+		Atom Key;
 		EnumSet<KeyModifier> Modifiers;
 	};
 
+	/// This event data represents a tick of a timer.
+	///
+	/// The TimerId field identifies the timer which has been elapsed.
+	///
+	class EventDataTimer : public Object {
+	public:
+		DEFINE_POINTERS(EventDataTimer);
+
+		EventDataTimer(const uint32_t & timerId);
+		~EventDataTimer();
+
+		uint32_t TimerId;
+	};
+
+	/// This event data represents a change of the resolution of a window,
+	/// e.g. when it is moved to another display.
+	///
+	class EventDataDpiChange : public Object {
+	public:
+		DEFINE_POINTERS(EventDataDpiChange);
+
+		EventDataDpiChange(const double & dpi);
+		~EventDataDpiChange();
+
+		double Dpi;
+	};
+
+	class Display;
+
 	/// This class is a logical window
 	///
 	/// It communicate with OS through the OS-specific window host object.
@@ -239,15 +669,63 @@ namespace v2x {
 		/// Returns the actual window top position in device unit [px]
 		double getActualHeight() const;
 
+		/// Returns the OS-specific window host. It is empty until the window
+		/// is shown for the first time.
+		WindowHost::Shared getHost() const;
+
+		/// The default time of a layout slice in milliseconds
+		static const double DEFAULT_LAYOUT_SLICE;
+
+		using Control::updateLayout;
+		/// Lay out the invalidated controls within the actual window size
+		void updateLayout();
+		bool updateLayout(LayoutBudget & budget);
+
+		/// Set the time of the layout on each paint of the host. Larger
+		/// layouts continue on the following paints, so input is processed
+		/// in between.
+		void setLayoutSlice(double milliseconds);
+		double getLayoutSlice() const;
+
+		/// The units of the controls of the window. The host updates them
+		/// when the window moves to a display with another resolution.
+		const LayoutUnits & getLayoutUnits() const override;
+		void setLayoutUnits(const LayoutUnits & units);
+		/// Take the units of a display
+		void setDisplay(const Display & display);
+
+		/// Returns the controls of the window to be laid out or painted.
+		const DirtySet & getDirtySet() const;
+		void clearDirtySet();
+
+		/// Returns the flat layout tree of the window with up to date bounds.
+		/// It is built again when the children of a control have changed,
+		/// the bounds are computed again only after an arrange has moved a
+		/// control.
+		const LayoutTree & getLayoutTree();
+		/// Returns the topmost control at a position in the coordinates of
+		/// the window or nullptr
+		Control * getControlAt(const Vector2D64F & position);
+
 	protected:
+		void doOnInvalidated(const DirtySet & dirtySet) override;
+		void doOnForgetInvalidations(Control * control) override;
+
 		virtual void doOnHostShow(Event::Shared e);
 		virtual void doOnHostClose(Event::Shared e);
 		virtual void doOnHostResize(Event::Shared e);
+		/// Continue the layout within a slice
+		virtual void doOnHostPaint(Event::Shared e);
+		virtual void doOnHostDpiChange(Event::Shared e);
 
 	private:
 
 		WindowHost::Shared m_host;
 		Rect64F m_actualPosition;
+		DirtySet m_dirtySet;
+		double m_layoutSlice;
+		LayoutUnits m_layoutUnits;
+		LayoutTree m_tree;
 
 		/// This function will be called after the construction.
 		void initializeHost();
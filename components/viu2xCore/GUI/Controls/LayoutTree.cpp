@@ -0,0 +1,237 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "LayoutTree.h"
+#include "Controls.h"
+
+#include <utility>
+
+namespace v2x {
+
+	////////////////
+	// LayoutTree //
+	////////////////
+
+	const LayoutTree::Index LayoutTree::NONE;
+	const uint8_t LayoutTree::MEASURE_INVALID;
+	const uint8_t LayoutTree::ARRANGE_INVALID;
+	const uint8_t LayoutTree::DESCENDANT_INVALID;
+
+	LayoutTree::LayoutTree() : m_isStale(true), m_areBoundsStale(false) {}
+
+	LayoutTree::~LayoutTree() {
+		detach();
+	}
+
+	void LayoutTree::build(Control & root) {
+		clear();
+
+		// Depth first with an explicit stack, as trees may be deep. Each
+		// entry is a control and the index of its parent.
+		std::vector<std::pair<Control *, Index>> stack(1, std::make_pair(&root, NONE));
+		std::vector<Index> lastChildren;
+		while (!stack.empty()) {
+			Control * control = stack.back().first;
+			const Index parent = stack.back().second;
+			stack.pop_back();
+
+			if (m_controls.size() >= NONE)
+				throw Exception(L"LayoutTree::build(): Too many controls!");
+			const Index index = (Index)m_controls.size();
+			m_controls.push_back(control);
+			m_parents.push_back(parent);
+			m_firstChildren.push_back(NONE);
+			m_nextSiblings.push_back(NONE);
+			m_subtreeEnds.push_back(NONE);
+			lastChildren.push_back(NONE);
+
+			if (parent != NONE) {
+				if (lastChildren[parent] == NONE)
+					m_firstChildren[parent] = index;
+				else
+					m_nextSiblings[lastChildren[parent]] = index;
+				lastChildren[parent] = index;
+			}
+
+			// Controls of other trees are taken over
+			if (control->m_layoutTree && control->m_layoutTree != this)
+				control->m_layoutTree->forget(control->m_layoutIndex);
+			control->m_layoutTree = this;
+			control->m_layoutIndex = index;
+
+			// The first child is visited first
+			auto container = dynamic_cast<ControlContainer *>(control);
+			if (container) {
+				const ControlContainer::Children & children = container->getChildren();
+				for (size_t i = children.size(); i > 0; --i)
+					stack.push_back(std::make_pair(children[i - 1].get(), index));
+			}
+		}
+
+		// A subtree ends where the next sibling of the control or of one of
+		// its ancestors starts. The parents precede their children.
+		const Index count = (Index)m_controls.size();
+		for (Index index = 0; index < count; ++index) {
+			if (m_nextSiblings[index] != NONE)
+				m_subtreeEnds[index] = m_nextSiblings[index];
+			else if (m_parents[index] != NONE)
+				m_subtreeEnds[index] = m_subtreeEnds[m_parents[index]];
+			else
+				m_subtreeEnds[index] = count;
+		}
+
+		m_resolvedLayouts.resize(count);
+		m_desiredSizes.resize(count);
+		m_layoutRects.resize(count);
+		m_bounds.resize(count);
+		m_dirtyBits.resize(count);
+		for (Index index = 0; index < count; ++index)
+			store(index, *m_controls[index]);
+		updateBounds();
+
+		m_isStale = false;
+	}
+
+	void LayoutTree::clear() {
+		detach();
+		m_controls.clear();
+		m_parents.clear();
+		m_firstChildren.clear();
+		m_nextSiblings.clear();
+		m_subtreeEnds.clear();
+		m_resolvedLayouts.clear();
+		m_desiredSizes.clear();
+		m_layoutRects.clear();
+		m_bounds.clear();
+		m_dirtyBits.clear();
+		m_isStale = true;
+	}
+
+	bool LayoutTree::isStale() const { return m_isStale; }
+
+	size_t LayoutTree::size() const { return m_controls.size(); }
+
+	bool LayoutTree::empty() const { return m_controls.empty(); }
+
+	Control * LayoutTree::getControl(Index index) const {
+		checkIndex(L"LayoutTree::getControl()", index);
+		return m_controls[index];
+	}
+
+	LayoutTree::Index LayoutTree::getParent(Index index) const {
+		checkIndex(L"LayoutTree::getParent()", index);
+		return m_parents[index];
+	}
+
+	LayoutTree::Index LayoutTree::getFirstChild(Index index) const {
+		checkIndex(L"LayoutTree::getFirstChild()", index);
+		return m_firstChildren[index];
+	}
+
+	LayoutTree::Index LayoutTree::getNextSibling(Index index) const {
+		checkIndex(L"LayoutTree::getNextSibling()", index);
+		return m_nextSiblings[index];
+	}
+
+	LayoutTree::Index LayoutTree::getSubtreeEnd(Index index) const {
+		checkIndex(L"LayoutTree::getSubtreeEnd()", index);
+		return m_subtreeEnds[index];
+	}
+
+	const ResolvedLayout & LayoutTree::getResolvedLayout(Index index) const {
+		checkIndex(L"LayoutTree::getResolvedLayout()", index);
+		return m_resolvedLayouts[index];
+	}
+
+	const Size2D64F & LayoutTree::getDesiredSize(Index index) const {
+		checkIndex(L"LayoutTree::getDesiredSize()", index);
+		return m_desiredSizes[index];
+	}
+
+	const Rect64F & LayoutTree::getLayoutRect(Index index) const {
+		checkIndex(L"LayoutTree::getLayoutRect()", index);
+		return m_layoutRects[index];
+	}
+
+	const Rect64F & LayoutTree::getBounds(Index index) const {
+		checkIndex(L"LayoutTree::getBounds()", index);
+		return m_bounds[index];
+	}
+
+	uint8_t LayoutTree::getDirtyBits(Index index) const {
+		checkIndex(L"LayoutTree::getDirtyBits()", index);
+		return m_dirtyBits[index];
+	}
+
+	bool LayoutTree::isLayoutValid() const {
+		for (auto i = m_dirtyBits.begin(); i != m_dirtyBits.end(); ++i)
+			if (*i != 0)
+				return false;
+		return true;
+	}
+
+	bool LayoutTree::areBoundsStale() const { return m_areBoundsStale; }
+
+	void LayoutTree::updateBounds() {
+		m_areBoundsStale = false;
+
+		// The parents precede their children
+		for (size_t index = 0; index < m_controls.size(); ++index) {
+			const Rect64F & rect = m_layoutRects[index];
+			const Index parent = m_parents[index];
+			if (parent == NONE)
+				m_bounds[index] = rect;
+			else
+				m_bounds[index] = Rect64F(m_bounds[parent].getLeft() + rect.getLeft(),
+					m_bounds[parent].getTop() + rect.getTop(), rect.getWidth(), rect.getHeight());
+		}
+	}
+
+	LayoutTree::Index LayoutTree::hitTest(const Vector2D64F & position) const {
+		// The last control in tree order which contains the position is on
+		// top. Subtrees of controls which miss it are skipped.
+		Index result = NONE;
+		const Index count = (Index)m_controls.size();
+		for (Index index = 0; index < count;) {
+			if (m_controls[index] && m_bounds[index].contains(position)) {
+				result = index;
+				++index;
+			}
+			else
+				index = m_subtreeEnds[index];
+		}
+		return result;
+	}
+
+	void LayoutTree::checkIndex(const Char * caller, Index index) const {
+		if (index >= m_controls.size())
+			throw Exception(CHECKED_FORMAT(L"%s: Index %d is out of range!", caller, (int)index));
+	}
+
+	void LayoutTree::store(Index index, const Control & control) {
+		m_resolvedLayouts[index] = control.m_resolvedLayout;
+		m_desiredSizes[index] = control.m_desiredSize;
+		if (!(m_layoutRects[index] == control.m_layoutRect)) {
+			m_layoutRects[index] = control.m_layoutRect;
+			m_areBoundsStale = true;
+		}
+		m_dirtyBits[index] = (control.m_measureInvalid ? MEASURE_INVALID : 0) |
+			(control.m_arrangeInvalid ? ARRANGE_INVALID : 0) |
+			(control.m_descendantInvalid ? DESCENDANT_INVALID : 0);
+	}
+
+	void LayoutTree::markStale() { m_isStale = true; }
+
+	void LayoutTree::forget(Index index) {
+		if (index < m_controls.size())
+			m_controls[index] = nullptr;
+		m_isStale = true;
+	}
+
+	void LayoutTree::detach() {
+		for (auto i = m_controls.begin(); i != m_controls.end(); ++i)
+			if (*i && (*i)->m_layoutTree == this) {
+				(*i)->m_layoutTree = nullptr;
+				(*i)->m_layoutIndex = NONE;
+			}
+	}
+}
@@ -0,0 +1,117 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+#include "../Graphics/Layout.h"
+
+#include <atomic>
+#include <vector>
+
+namespace v2x {
+
+	class Control;
+
+	/// A flat mirror of the layout state of a tree of controls.
+	///
+	/// The controls are stored in tree order (preorder), each property in an
+	/// array of its own: the links of the tree, the resolved layout specs,
+	/// the desired sizes, the layout rectangles, the bounds and the dirty
+	/// bits. The subtree of a control is the range from its index to its
+	/// subtree end, so passes over the tree walk the arrays from the front
+	/// and skip subtrees by a jump, e.g. hitTest().
+	///
+	/// Each control knows its index (see Control::getLayoutIndex()) and
+	/// writes its state through whenever it is measured, arranged or
+	/// invalidated. Only a change of the children of a control in the tree
+	/// makes it stale, so that it has to be built again.
+	///
+	class LayoutTree {
+		friend class Control;
+		friend class ControlContainer;
+	public:
+		typedef uint32_t Index;
+
+		/// No control, e.g. the parent of the root
+		static const Index NONE = 0xFFFFFFFF;
+
+		/// The dirty bits of a control
+		static const uint8_t MEASURE_INVALID = 1;
+		static const uint8_t ARRANGE_INVALID = 2;
+		static const uint8_t DESCENDANT_INVALID = 4;
+
+		LayoutTree();
+		~LayoutTree();
+
+		/// Mirror the tree of a root control. Its controls leave the tree
+		/// they were mirrored by before.
+		void build(Control & root);
+		void clear();
+		/// Returns true if the children of a control have changed since the
+		/// tree was built
+		bool isStale() const;
+
+		size_t size() const;
+		bool empty() const;
+
+		Control * getControl(Index index) const;
+		Index getParent(Index index) const;
+		Index getFirstChild(Index index) const;
+		Index getNextSibling(Index index) const;
+		/// Returns the index after the last control of the subtree
+		Index getSubtreeEnd(Index index) const;
+
+		/// Returns the layout spec resolved by the last arrange
+		const ResolvedLayout & getResolvedLayout(Index index) const;
+		/// Returns the size from the last measure including the margin
+		const Size2D64F & getDesiredSize(Index index) const;
+		/// Returns the rectangle from the last arrange in the coordinates
+		/// of the parent
+		const Rect64F & getLayoutRect(Index index) const;
+		/// Returns the layout rectangle in the coordinates of the root as of
+		/// the last updateBounds()
+		const Rect64F & getBounds(Index index) const;
+		uint8_t getDirtyBits(Index index) const;
+
+		/// Returns true if no control needs measure or arrange
+		bool isLayoutValid() const;
+		/// Returns true if a layout rectangle has changed since the bounds
+		/// were computed
+		bool areBoundsStale() const;
+		/// Compute the bounds of all controls in one pass
+		void updateBounds();
+		/// Returns the topmost control whose bounds contain a position in
+		/// the coordinates of the root or NONE. The children are clipped by
+		/// their parents, later siblings cover earlier ones.
+		Index hitTest(const Vector2D64F & position) const;
+
+	private:
+		std::vector<Control *> m_controls;
+		std::vector<Index> m_parents;
+		std::vector<Index> m_firstChildren;
+		std::vector<Index> m_nextSiblings;
+		std::vector<Index> m_subtreeEnds;
+
+		std::vector<ResolvedLayout> m_resolvedLayouts;
+		std::vector<Size2D64F> m_desiredSizes;
+		std::vector<Rect64F> m_layoutRects;
+		std::vector<Rect64F> m_bounds;
+		std::vector<uint8_t> m_dirtyBits;
+
+		/// Set from the layouts of parallel subtrees as well
+		std::atomic<bool> m_isStale;
+		std::atomic<bool> m_areBoundsStale;
+
+		LayoutTree(const LayoutTree &) = delete;
+		LayoutTree & operator = (const LayoutTree &) = delete;
+
+		void checkIndex(const Char * caller, Index index) const;
+		/// Copy the state of a control into its slot
+		void store(Index index, const Control & control);
+		void markStale();
+		/// Drop a destroyed control
+		void forget(Index index);
+		/// Release the controls from the tree
+		void detach();
+	};
+}
@@ -0,0 +1,648 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "../../common.h"
+
+#include "SessionRecording.h"
+
+#include <thread>
+
+namespace v2x {
+
+	/// The magic number at the beginning of a saved session log: "V2XS"
+	static const uint32_t SESSION_LOG_MAGIC = 0x53583256;
+
+	/// The format version of saved session logs
+	static const uint32_t SESSION_LOG_VERSION = 1;
+
+	static const int MOUSE_BUTTON_COUNT = (int)EnumString<MouseButton>::getCount();
+	static const int KEY_MODIFIER_COUNT = (int)EnumString<KeyModifier>::getCount();
+	static_assert(EnumString<MouseButton>::getCount() <= 8 && EnumString<KeyModifier>::getCount() <= 8,
+		"Session logs store mouse buttons and key modifiers in one byte each!");
+
+	template <typename T>
+	static uint8_t packEnumSet(const EnumSet<T> & set, int count) {
+		uint8_t result = 0;
+		for (int i = 0; i < count; ++i)
+			if (set.contains(static_cast<T>(i)))
+				result |= (uint8_t)(1 << i);
+		return result;
+	}
+
+	template <typename T>
+	static EnumSet<T> unpackEnumSet(uint8_t bits, int count) {
+		EnumSet<T> result;
+		for (int i = 0; i < count; ++i)
+			if (bits & (1 << i))
+				result.include(static_cast<T>(i));
+		return result;
+	}
+
+	///////////////////
+	// SessionRecord //
+	///////////////////
+
+	SessionRecord::SessionRecord() :
+		Kind(SessionRecordKind::Paint), Timestamp(0), State(WindowState::Normal),
+		TimerId(0), MessageId(Message::UNSPECIFIED_MESSAGE_ID), PayloadIndex(-1) {
+		memset(Payload, 0, sizeof(Payload));
+	}
+
+	SessionRecord::~SessionRecord() {}
+
+	/////////////////////////
+	// SessionPayloadTypes //
+	/////////////////////////
+
+	SessionPayloadTypes::SessionPayloadTypes() {}
+
+	SessionPayloadTypes::~SessionPayloadTypes() {}
+
+	int32_t SessionPayloadTypes::indexOf(TypeId type) const {
+		for (size_t i = 0; i < m_types.size(); ++i)
+			if (m_types[i] == type)
+				return (int32_t)i;
+		return -1;
+	}
+
+	TypeId SessionPayloadTypes::getType(int32_t index) const {
+		if (index < 0 || index >= (int32_t)m_types.size())
+			throw Exception(CHECKED_FORMAT(L"SessionPayloadTypes::getType(): Index %d out of range!", index));
+		return m_types[index];
+	}
+
+	size_t SessionPayloadTypes::getSize(int32_t index) const {
+		if (index < 0 || index >= (int32_t)m_sizes.size())
+			throw Exception(CHECKED_FORMAT(L"SessionPayloadTypes::getSize(): Index %d out of range!", index));
+		return m_sizes[index];
+	}
+
+	size_t SessionPayloadTypes::count() const {
+		return m_types.size();
+	}
+
+	////////////////
+	// SessionLog //
+	////////////////
+
+	SessionLog::SessionLog() : m_recordCount(0), m_lastTimestamp(0) {}
+
+	SessionLog::~SessionLog() {}
+
+	void SessionLog::clear() {
+		m_data.clear();
+		m_recordCount = 0;
+		m_lastTimestamp = 0;
+	}
+
+	void SessionLog::append(const SessionRecord & record) {
+
+		if (record.Timestamp < m_lastTimestamp)
+			throw Exception(L"SessionLog::append(): The timestamp of the record must not decrease!");
+
+		writeByte(static_cast<uint8_t>(record.Kind));
+		writeVarUInt(record.Timestamp - m_lastTimestamp);
+
+		switch (record.Kind) {
+
+		case SessionRecordKind::Show:
+		case SessionRecordKind::Resize:
+			writeByte(static_cast<uint8_t>(record.State));
+			writeFloat((float)record.Position.x());
+			writeFloat((float)record.Position.y());
+			writeFloat((float)record.Size.width());
+			writeFloat((float)record.Size.height());
+			break;
+
+		case SessionRecordKind::MouseMove:
+		case SessionRecordKind::MouseButtonDown:
+		case SessionRecordKind::MouseButtonUp:
+			writeFloat((float)record.Position.x());
+			writeFloat((float)record.Position.y());
+			writeByte(packEnumSet(record.Buttons, MOUSE_BUTTON_COUNT));
+			writeByte(packEnumSet(record.Modifiers, KEY_MODIFIER_COUNT));
+			break;
+
+		case SessionRecordKind::KeyDown:
+		case SessionRecordKind::KeyUp:
+		case SessionRecordKind::KeyStroke:
+			writeVarUInt(record.Key.size());
+			for (size_t i = 0; i < record.Key.size(); ++i)
+				writeVarUInt((uint64_t)record.Key[i]);
+			writeByte(packEnumSet(record.Modifiers, KEY_MODIFIER_COUNT));
+			break;
+
+		case SessionRecordKind::Timer:
+			writeVarUInt(record.TimerId);
+			break;
+
+		case SessionRecordKind::Message:
+			writeVarUInt(record.MessageId);
+			// The payload index is stored with an offset of 1 so that -1 fits.
+			writeVarUInt((uint64_t)(record.PayloadIndex + 1));
+			if (record.PayloadIndex >= 0)
+				for (size_t i = 0; i < Message::PAYLOAD_CAPACITY; ++i)
+					writeByte(record.Payload[i]);
+			break;
+
+		case SessionRecordKind::Close:
+		case SessionRecordKind::Paint:
+			break;
+
+		default:
+			throw Exception(CHECKED_FORMAT(L"SessionLog::append(): Unknown record kind (%d)!", (int)record.Kind));
+		}
+
+		m_lastTimestamp = record.Timestamp;
+		++m_recordCount;
+	}
+
+	size_t SessionLog::getRecordCount() const {
+		return m_recordCount;
+	}
+
+	size_t SessionLog::getSizeInBytes() const {
+		return m_data.size();
+	}
+
+	uint64_t SessionLog::getDuration() const {
+		return m_lastTimestamp;
+	}
+
+	void SessionLog::save(std::ostream & stream) const {
+
+		const uint32_t header[] = {
+			SESSION_LOG_MAGIC,
+			SESSION_LOG_VERSION,
+			(uint32_t)m_recordCount,
+			(uint32_t)m_data.size() };
+
+		stream.write(reinterpret_cast<const char *>(header), sizeof(header));
+		if (!m_data.empty())
+			stream.write(reinterpret_cast<const char *>(&m_data[0]), m_data.size());
+
+		if (!stream.good())
+			throw Exception(L"SessionLog::save(): Failed to write to the stream!");
+	}
+
+	void SessionLog::load(std::istream & stream) {
+
+		uint32_t header[4];
+		stream.read(reinterpret_cast<char *>(header), sizeof(header));
+		if (!stream.good())
+			throw Exception(L"SessionLog::load(): Failed to read the header!");
+		if (header[0] != SESSION_LOG_MAGIC)
+			throw Exception(L"SessionLog::load(): The stream does not contain a session log!");
+		if (header[1] != SESSION_LOG_VERSION)
+			throw Exception(CHECKED_FORMAT(L"SessionLog::load(): The log version (%u) is not supported!", header[1]));
+
+		std::vector<uint8_t> data(header[3]);
+		if (!data.empty()) {
+			stream.read(reinterpret_cast<char *>(&data[0]), data.size());
+			if (stream.gcount() != (std::streamsize)data.size())
+				throw Exception(L"SessionLog::load(): Unexpected end of the stream!");
+		}
+
+		// Walk through all records to validate the data and restore the
+		// timestamp of the last record. The log keeps its data until the
+		// loaded one turned out to be valid.
+		SessionLog loaded;
+		loaded.m_data.swap(data);
+		loaded.m_recordCount = header[2];
+		Reader reader(loaded);
+		SessionRecord record;
+		size_t count = 0;
+		while (reader.next(record)) {
+			loaded.m_lastTimestamp = record.Timestamp;
+			++count;
+		}
+
+		if (count != loaded.m_recordCount)
+			throw Exception(L"SessionLog::load(): The record count does not match!");
+
+		m_data.swap(loaded.m_data);
+		m_recordCount = loaded.m_recordCount;
+		m_lastTimestamp = loaded.m_lastTimestamp;
+	}
+
+	void SessionLog::writeByte(uint8_t value) {
+		m_data.push_back(value);
+	}
+
+	void SessionLog::writeVarUInt(uint64_t value) {
+		while (value >= 0x80) {
+			m_data.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		m_data.push_back((uint8_t)value);
+	}
+
+	void SessionLog::writeFloat(float value) {
+		const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&value);
+		m_data.insert(m_data.end(), bytes, bytes + sizeof(value));
+	}
+
+	////////////////////////
+	// SessionLog::Reader //
+	////////////////////////
+
+	SessionLog::Reader::Reader(const SessionLog & log) : m_log(log), m_offset(0), m_timestamp(0) {}
+
+	SessionLog::Reader::~Reader() {}
+
+	bool SessionLog::Reader::next(SessionRecord & record) {
+
+		if (m_offset >= m_log.m_data.size())
+			return false;
+
+		record.Kind = static_cast<SessionRecordKind>(readByte());
+		m_timestamp += readVarUInt();
+		record.Timestamp = m_timestamp;
+
+		switch (record.Kind) {
+
+		case SessionRecordKind::Show:
+		case SessionRecordKind::Resize:
+		{
+			record.State = static_cast<WindowState>(readByte());
+			double x = readFloat();
+			double y = readFloat();
+			double w = readFloat();
+			double h = readFloat();
+			record.Position = Vector2D64F(x, y);
+			record.Size = Size2D64F(w, h);
+			break;
+		}
+
+		case SessionRecordKind::MouseMove:
+		case SessionRecordKind::MouseButtonDown:
+		case SessionRecordKind::MouseButtonUp:
+		{
+			double x = readFloat();
+			double y = readFloat();
+			record.Position = Vector2D64F(x, y);
+			record.Buttons = unpackEnumSet<MouseButton>(readByte(), MOUSE_BUTTON_COUNT);
+			record.Modifiers = unpackEnumSet<KeyModifier>(readByte(), KEY_MODIFIER_COUNT);
+			break;
+		}
+
+		case SessionRecordKind::KeyDown:
+		case SessionRecordKind::KeyUp:
+		case SessionRecordKind::KeyStroke:
+		{
+			size_t length = (size_t)readVarUInt();
+			record.Key.resize(length);
+			for (size_t i = 0; i < length; ++i)
+				record.Key[i] = (Char)readVarUInt();
+			record.Modifiers = unpackEnumSet<KeyModifier>(readByte(), KEY_MODIFIER_COUNT);
+			break;
+		}
+
+		case SessionRecordKind::Timer:
+			record.TimerId = (uint32_t)readVarUInt();
+			break;
+
+		case SessionRecordKind::Message:
+			record.MessageId = (Message::Id)readVarUInt();
+			record.PayloadIndex = (int32_t)readVarUInt() - 1;
+			if (record.PayloadIndex >= 0)
+				for (size_t i = 0; i < Message::PAYLOAD_CAPACITY; ++i)
+					record.Payload[i] = readByte();
+			break;
+
+		case SessionRecordKind::Close:
+		case SessionRecordKind::Paint:
+			break;
+
+		default:
+			throw Exception(CHECKED_FORMAT(L"SessionLog::Reader::next(): Unknown record kind (%d)!", (int)record.Kind));
+		}
+
+		return true;
+	}
+
+	uint8_t SessionLog::Reader::readByte() {
+		if (m_offset >= m_log.m_data.size())
+			throw Exception(L"SessionLog::Reader: Unexpected end of the log!");
+		return m_log.m_data[m_offset++];
+	}
+
+	uint64_t SessionLog::Reader::readVarUInt() {
+		uint64_t result = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t b = readByte();
+			result |= (uint64_t)(b & 0x7F) << shift;
+			if ((b & 0x80) == 0)
+				return result;
+		}
+		throw Exception(L"SessionLog::Reader: Invalid variable-length integer!");
+	}
+
+	float SessionLog::Reader::readFloat() {
+		float result;
+		uint8_t * bytes = reinterpret_cast<uint8_t *>(&result);
+		for (size_t i = 0; i < sizeof(result); ++i)
+			bytes[i] = readByte();
+		return result;
+	}
+
+	/////////////////////
+	// SessionRecorder //
+	/////////////////////
+
+	/// This function lists the event slots of the host which will be recorded.
+	static std::vector<std::pair<EventSlot *, SessionRecordKind>> getRecordedSlots(WindowHost & host) {
+		std::vector<std::pair<EventSlot *, SessionRecordKind>> result = {
+			{ &host.OnShow, SessionRecordKind::Show },
+			{ &host.OnClose, SessionRecordKind::Close },
+			{ &host.OnResize, SessionRecordKind::Resize },
+			{ &host.OnMouseMove, SessionRecordKind::MouseMove },
+			{ &host.OnMouseButtonDown, SessionRecordKind::MouseButtonDown },
+			{ &host.OnMouseButtonUp, SessionRecordKind::MouseButtonUp },
+			{ &host.OnKeyDown, SessionRecordKind::KeyDown },
+			{ &host.OnKeyUp, SessionRecordKind::KeyUp },
+			{ &host.OnKeyStroke, SessionRecordKind::KeyStroke },
+			{ &host.OnPaint, SessionRecordKind::Paint },
+			{ &host.OnTimer, SessionRecordKind::Timer } };
+		return result;
+	}
+
+	SessionRecorder::SessionRecorder() : m_log(new SessionLog()), m_isStarted(false) {}
+
+	SessionRecorder::SessionRecorder(const SessionPayloadTypes & payloadTypes) :
+		m_payloadTypes(payloadTypes), m_log(new SessionLog()), m_isStarted(false) {}
+
+	SessionRecorder::~SessionRecorder() {}
+
+	void SessionRecorder::attach(WindowHost::Shared host) {
+
+		if (!host)
+			throw Exception(L"SessionRecorder::attach(): The host is NULL!");
+
+		detach();
+
+		auto slots = getRecordedSlots(*host);
+		for (auto i = slots.begin(); i != slots.end(); ++i)
+			*(i->first) += EventHandler(shared_from_this(),
+				std::bind(&SessionRecorder::doOnHostEvent, this, i->second, std::placeholders::_1));
+
+		m_host = host;
+
+		if (!m_isStarted) {
+			m_startTime = std::chrono::steady_clock::now();
+			m_isStarted = true;
+		}
+	}
+
+	void SessionRecorder::detach() {
+
+		WindowHost::Shared host = m_host.lock();
+		if (!host)
+			return;
+
+		auto slots = getRecordedSlots(*host);
+		for (auto i = slots.begin(); i != slots.end(); ++i)
+			*(i->first) -= EventHandler(shared_from_this(), EventCallback());
+
+		m_host.reset();
+	}
+
+	void SessionRecorder::recordMessage(const Message & message) {
+
+		SessionRecord record;
+		record.Kind = SessionRecordKind::Message;
+		record.Timestamp = getTimestamp();
+		record.MessageId = message.getId();
+		record.PayloadIndex = message.hasPayload() ? m_payloadTypes.indexOf(message.getPayloadType()) : -1;
+		if (record.PayloadIndex >= 0)
+			memcpy(record.Payload, message.getRawPayload(), Message::PAYLOAD_CAPACITY);
+
+		m_log->append(record);
+	}
+
+	void SessionRecorder::recordTimerTick(uint32_t timerId) {
+
+		SessionRecord record;
+		record.Kind = SessionRecordKind::Timer;
+		record.Timestamp = getTimestamp();
+		record.TimerId = timerId;
+
+		m_log->append(record);
+	}
+
+	SessionLog::Shared SessionRecorder::getLog() const {
+		return m_log;
+	}
+
+	void SessionRecorder::doOnHostEvent(SessionRecordKind kind, Event::Shared e) {
+
+		SessionRecord record;
+		record.Kind = kind;
+		record.Timestamp = getTimestamp();
+
+		switch (kind) {
+
+		case SessionRecordKind::Show:
+		case SessionRecordKind::Resize:
+		{
+			auto data = e->getDataAs<const EventDataWindowSize>();
+			if (data) {
+				record.State = data->State;
+				record.Position = data->Position;
+				record.Size = data->Size;
+			}
+			break;
+		}
+
+		case SessionRecordKind::MouseMove:
+		case SessionRecordKind::MouseButtonDown:
+		case SessionRecordKind::MouseButtonUp:
+		{
+			auto data = e->getDataAs<const EventDataMouse>();
+			if (data) {
+				record.Position = data->Position;
+				record.Buttons = data->Buttons;
+				record.Modifiers = data->Modifiers;
+			}
+			break;
+		}
+
+		case SessionRecordKind::KeyDown:
+		case SessionRecordKind::KeyUp:
+		case SessionRecordKind::KeyStroke:
+		{
+			auto data = e->getDataAs<const EventDataKeyboard>();
+			if (data) {
+				record.Key = data->Key;
+				record.Modifiers = data->Modifiers;
+			}
+			break;
+		}
+
+		case SessionRecordKind::Timer:
+		{
+			auto data = e->getDataAs<const EventDataTimer>();
+			if (data)
+				record.TimerId = data->TimerId;
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		m_log->append(record);
+	}
+
+	uint64_t SessionRecorder::getTimestamp() {
+
+		if (!m_isStarted) {
+			m_startTime = std::chrono::steady_clock::now();
+			m_isStarted = true;
+		}
+
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - m_startTime).count();
+	}
+
+	/////////////////
+	// FrameTiming //
+	/////////////////
+
+	FrameTiming::FrameTiming() :
+		FrameIndex(0), Timestamp(0), RecordCount(0), InputTime(0), PaintTime(0) {}
+
+	FrameTiming::~FrameTiming() {}
+
+	/////////////////////
+	// SessionReplayer //
+	/////////////////////
+
+	SessionReplayer::SessionReplayer() {}
+
+	SessionReplayer::SessionReplayer(const SessionPayloadTypes & payloadTypes) :
+		m_payloadTypes(payloadTypes) {}
+
+	SessionReplayer::~SessionReplayer() {}
+
+	void SessionReplayer::setMessageTarget(const MessageCallback & target) {
+		m_messageTarget = target;
+	}
+
+	std::vector<FrameTiming> SessionReplayer::replay(const SessionLog & log, WindowHost::Shared host, ReplaySpeed speed) {
+
+		typedef std::chrono::steady_clock Clock;
+		typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+		if (!host)
+			throw Exception(L"SessionReplayer::replay(): The host is NULL!");
+
+		std::vector<FrameTiming> result;
+		FrameTiming frame;
+
+		const Clock::time_point startTime = Clock::now();
+
+		SessionLog::Reader reader(log);
+		SessionRecord record;
+		while (reader.next(record)) {
+
+			if (speed == ReplaySpeed::RealTime)
+				std::this_thread::sleep_until(startTime + std::chrono::microseconds(record.Timestamp));
+
+			const Clock::time_point t0 = Clock::now();
+			dispatch(record, host);
+			const double elapsed = Milliseconds(Clock::now() - t0).count();
+
+			++frame.RecordCount;
+			frame.Timestamp = record.Timestamp;
+
+			if (record.Kind == SessionRecordKind::Paint) {
+				frame.PaintTime += elapsed;
+				result.push_back(frame);
+
+				frame = FrameTiming();
+				frame.FrameIndex = result.size();
+			}
+			else frame.InputTime += elapsed;
+		}
+
+		// The records after the last paint form an incomplete frame.
+		if (frame.RecordCount > 0)
+			result.push_back(frame);
+
+		return result;
+	}
+
+	void SessionReplayer::dispatch(const SessionRecord & record, WindowHost::Shared host) {
+
+		switch (record.Kind) {
+
+		case SessionRecordKind::Show:
+			host->OnShow.notifyEvent(host, EventDataWindowSize::Shared(
+				new EventDataWindowSize(record.State, record.Position, record.Size)));
+			break;
+
+		case SessionRecordKind::Close:
+			host->OnClose.notifyEvent(host, Object::Shared());
+			break;
+
+		case SessionRecordKind::Resize:
+			host->OnResize.notifyEvent(host, EventDataWindowSize::Shared(
+				new EventDataWindowSize(record.State, record.Position, record.Size)));
+			break;
+
+		case SessionRecordKind::MouseMove:
+			host->OnMouseMove.notifyEvent(host, EventDataMouse::Shared(
+				new EventDataMouse(record.Position, record.Buttons, record.Modifiers)));
+			break;
+
+		case SessionRecordKind::MouseButtonDown:
+			host->OnMouseButtonDown.notifyEvent(host, EventDataMouse::Shared(
+				new EventDataMouse(record.Position, record.Buttons, record.Modifiers)));
+			break;
+
+		case SessionRecordKind::MouseButtonUp:
+			host->OnMouseButtonUp.notifyEvent(host, EventDataMouse::Shared(
+				new EventDataMouse(record.Position, record.Buttons, record.Modifiers)));
+			break;
+
+		case SessionRecordKind::KeyDown:
+			host->OnKeyDown.notifyEvent(host, EventDataKeyboard::Shared(
+				new EventDataKeyboard(record.Key, record.Modifiers)));
+			break;
+
+		case SessionRecordKind::KeyUp:
+			host->OnKeyUp.notifyEvent(host, EventDataKeyboard::Shared(
+				new EventDataKeyboard(record.Key, record.Modifiers)));
+			break;
+
+		case SessionRecordKind::KeyStroke:
+			host->OnKeyStroke.notifyEvent(host, EventDataKeyboard::Shared(
+				new EventDataKeyboard(record.Key, record.Modifiers)));
+			break;
+
+		case SessionRecordKind::Paint:
+			host->OnPaint.notifyEvent(host, Object::Shared());
+			break;
+
+		case SessionRecordKind::Timer:
+			host->OnTimer.notifyEvent(host, EventDataTimer::Shared(new EventDataTimer(record.TimerId)));
+			break;
+
+		case SessionRecordKind::Message:
+		{
+			if (!m_messageTarget)
+				break;
+
+			Message message(record.MessageId);
+			if (record.PayloadIndex >= 0)
+				message.setRawPayload(m_payloadTypes.getType(record.PayloadIndex),
+					record.Payload, m_payloadTypes.getSize(record.PayloadIndex));
+			m_messageTarget(message);
+			break;
+		}
+
+		default:
+			throw Exception(CHECKED_FORMAT(L"SessionReplayer::dispatch(): Unknown record kind (%d)!", (int)record.Kind));
+		}
+	}
+}
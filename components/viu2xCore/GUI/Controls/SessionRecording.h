@@ -0,0 +1,259 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+#include "Controls.h"
+#include "WindowHost.h"
+
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <ostream>
+
+namespace v2x {
+
+	/// The kind of a recorded session entry. Most of them correspond to an
+	/// event slot of WindowHost.
+	enum class SessionRecordKind : uint8_t {
+		Show,
+		Close,
+		Resize,
+		MouseMove,
+		MouseButtonDown,
+		MouseButtonUp,
+		KeyDown,
+		KeyUp,
+		KeyStroke,
+		Paint,
+		Timer,
+		Message,
+	};
+
+	/// A single entry of a recorded session.
+	///
+	/// Only the fields related to the Kind are meaningful.
+	///
+	class SessionRecord {
+	public:
+		SessionRecord();
+		~SessionRecord();
+
+		SessionRecordKind Kind;
+
+		/// Time since the start of the recording in microseconds
+		uint64_t Timestamp;
+
+		// Show/Resize
+		WindowState State;
+		Vector2D64F Position;
+		Size2D64F Size;
+
+		// Mouse/Keyboard (Position is shared with Show/Resize)
+		EnumSet<MouseButton> Buttons;
+		EnumSet<KeyModifier> Modifiers;
+		String Key;
+
+		// Timer
+		uint32_t TimerId;
+
+		// Message
+		Message::Id MessageId;
+		/// Index of the payload type in SessionPayloadTypes or -1
+		int32_t PayloadIndex;
+		uint8_t Payload[Message::PAYLOAD_CAPACITY];
+	};
+
+	/// Inline message payload types are identified by TypeId at runtime, which
+	/// cannot be stored in a file. Recorder and replayer must therefore agree
+	/// on a list of payload types which is used to translate TypeIds into
+	/// indices and back. Payloads of unregistered types are not recorded.
+	class SessionPayloadTypes {
+	public:
+		SessionPayloadTypes();
+		~SessionPayloadTypes();
+
+		/// Register a payload type. The order of registration matters!
+		template <typename T>
+		void add() {
+			static_assert(sizeof(T) <= Message::PAYLOAD_CAPACITY,
+				"Type of inline message payload is too large");
+			m_types.push_back(typeIdOf<T>());
+			m_sizes.push_back(sizeof(T));
+		}
+
+		/// Returns the index of the type or -1 if it is not registered.
+		int32_t indexOf(TypeId type) const;
+
+		TypeId getType(int32_t index) const;
+		size_t getSize(int32_t index) const;
+		size_t count() const;
+
+	private:
+		std::vector<TypeId> m_types;
+		std::vector<size_t> m_sizes;
+	};
+
+	/// A compact binary log of a recorded session.
+	///
+	/// Records are stored with variable-length integers and delta timestamps.
+	/// Mouse positions are stored with single precision.
+	///
+	class SessionLog : public Object {
+	public:
+		DEFINE_POINTERS(SessionLog);
+
+		SessionLog();
+		virtual ~SessionLog();
+
+		/// Remove all records
+		void clear();
+
+		/// Append a record to the end of the log. The timestamps of the
+		/// records must not decrease.
+		void append(const SessionRecord & record);
+
+		size_t getRecordCount() const;
+		size_t getSizeInBytes() const;
+
+		/// Returns the timestamp of the last record in microseconds
+		uint64_t getDuration() const;
+
+		/// Write the log to a binary stream
+		void save(std::ostream & stream) const;
+
+		/// Replace the content of the log by the data from a binary stream
+		///
+		/// @throw Exception if the stream does not contain a valid log.
+		void load(std::istream & stream);
+
+		/// A forward-only reader of the log records.
+		class Reader {
+		public:
+			Reader(const SessionLog & log);
+			~Reader();
+
+			/// Read the next record. Returns false at the end of the log.
+			bool next(SessionRecord & record);
+
+		private:
+			const SessionLog & m_log;
+			size_t m_offset;
+			uint64_t m_timestamp;
+
+			uint8_t readByte();
+			uint64_t readVarUInt();
+			float readFloat();
+		};
+
+	private:
+		std::vector<uint8_t> m_data;
+		size_t m_recordCount;
+		uint64_t m_lastTimestamp;
+
+		void writeByte(uint8_t value);
+		void writeVarUInt(uint64_t value);
+		void writeFloat(float value);
+	};
+
+	/// This class records all events of a WindowHost into a SessionLog.
+	///
+	/// Messages and application timer ticks which do not pass through the
+	/// window host can be recorded explicitly.
+	///
+	class SessionRecorder : public Object {
+	public:
+		DEFINE_POINTERS(SessionRecorder);
+
+		SessionRecorder();
+		SessionRecorder(const SessionPayloadTypes & payloadTypes);
+		virtual ~SessionRecorder();
+
+		/// Start recording the events of the specified host. The recording
+		/// clock starts with the first attach.
+		void attach(WindowHost::Shared host);
+
+		/// Stop recording the events of the attached host.
+		void detach();
+
+		/// Record a message.
+		void recordMessage(const Message & message);
+
+		/// Record a tick of a timer which is not managed by the window host.
+		void recordTimerTick(uint32_t timerId);
+
+		/// Returns the recorded log.
+		SessionLog::Shared getLog() const;
+
+	protected:
+		virtual void doOnHostEvent(SessionRecordKind kind, Event::Shared e);
+
+	private:
+		SessionPayloadTypes m_payloadTypes;
+		SessionLog::Shared m_log;
+		WindowHost::Weak m_host;
+
+		bool m_isStarted;
+		std::chrono::steady_clock::time_point m_startTime;
+
+		uint64_t getTimestamp();
+	};
+
+	/// The replaying pace of SessionReplayer.
+	enum class ReplaySpeed {
+		/// Records are dispatched without any delay
+		AsFastAsPossible,
+
+		/// Records are dispatched according to their timestamps
+		RealTime,
+	};
+
+	/// Timing of a replayed frame. A frame consists of all records up to and
+	/// including a paint record.
+	class FrameTiming {
+	public:
+		FrameTiming();
+		~FrameTiming();
+
+		size_t FrameIndex;
+
+		/// Recorded timestamp of the frame end in microseconds
+		uint64_t Timestamp;
+
+		/// Number of records dispatched in this frame
+		size_t RecordCount;
+
+		/// Time in ms spent on dispatching input and state change records,
+		/// including the layout triggered by them.
+		double InputTime;
+
+		/// Time in ms spent on painting.
+		double PaintTime;
+	};
+
+	/// This class feeds a recorded session into a window host, usually a
+	/// WindowHostHeadless, and measures the processing time per frame.
+	///
+	class SessionReplayer {
+	public:
+		typedef std::function<bool(const Message & message)> MessageCallback;
+
+		SessionReplayer();
+		SessionReplayer(const SessionPayloadTypes & payloadTypes);
+		virtual ~SessionReplayer();
+
+		/// Set the receiver of the recorded messages. Message records are
+		/// skipped if there is no receiver.
+		void setMessageTarget(const MessageCallback & target);
+
+		/// Replay the whole log and return the timing of each frame.
+		std::vector<FrameTiming> replay(const SessionLog & log, WindowHost::Shared host,
+			ReplaySpeed speed = ReplaySpeed::AsFastAsPossible);
+
+	private:
+		SessionPayloadTypes m_payloadTypes;
+		MessageCallback m_messageTarget;
+
+		void dispatch(const SessionRecord & record, WindowHost::Shared host);
+	};
+}
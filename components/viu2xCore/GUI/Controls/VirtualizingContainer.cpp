@@ -0,0 +1,201 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "VirtualizingContainer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace v2x {
+
+	namespace {
+
+		/// Items measured smaller than estimated may leave space for more
+		/// items, which are realized in another pass
+		const size_t REALIZE_PASSES = 3;
+	}
+
+	///////////////////////////
+	// VirtualizingContainer //
+	///////////////////////////
+
+	const size_t VirtualizingContainer::DEFAULT_OVERSCAN;
+
+	VirtualizingContainer::VirtualizingContainer(const ItemFactory & factory, const ItemBinder & binder) :
+		m_factory(factory), m_binder(binder), m_overscan(DEFAULT_OVERSCAN),
+		m_scrollOffset(0), m_viewportHeight(0), m_firstRealized(0) {}
+
+	VirtualizingContainer::~VirtualizingContainer() {}
+
+	void VirtualizingContainer::setItems(size_t count, const SizeEstimator & estimator) {
+
+		// The controls are kept for the new items
+		m_pool.insert(m_pool.end(), m_children.begin(), m_children.end());
+		Clear();
+		m_firstRealized = 0;
+
+		m_heights.assign(count, estimator);
+		m_scrollOffset = clampScrollOffset(m_scrollOffset, m_viewportHeight);
+		invalidateLayout();
+	}
+
+	size_t VirtualizingContainer::getItemCount() const { return m_heights.size(); }
+
+	void VirtualizingContainer::setOverscan(size_t count) {
+		if (count == m_overscan)
+			return;
+		m_overscan = count;
+		invalidateLayout();
+	}
+
+	size_t VirtualizingContainer::getOverscan() const { return m_overscan; }
+
+	void VirtualizingContainer::setScrollOffset(double offset) {
+		offset = clampScrollOffset(offset, m_viewportHeight);
+		if (offset == m_scrollOffset)
+			return;
+		m_scrollOffset = offset;
+
+		// Within the realized items only their positions change
+		if (isRealized(getRealizedRange(offset, m_viewportHeight)))
+			invalidate(Invalidations(Invalidation::Arrange) + Invalidation::Canvas);
+		else
+			invalidate(Invalidations(Invalidation::Measure) + Invalidation::Arrange + Invalidation::Canvas);
+	}
+
+	double VirtualizingContainer::getScrollOffset() const { return m_scrollOffset; }
+
+	double VirtualizingContainer::getScrollExtent() const { return m_heights.getTotal(); }
+
+	double VirtualizingContainer::getViewportHeight() const { return m_viewportHeight; }
+
+	double VirtualizingContainer::getItemOffset(size_t index) const { return m_heights.getPrefixSum(index); }
+
+	size_t VirtualizingContainer::getItemAt(double offset) const { return m_heights.findIndex(offset); }
+
+	size_t VirtualizingContainer::getFirstRealizedItem() const { return m_firstRealized; }
+
+	size_t VirtualizingContainer::getRealizedItemCount() const { return m_children.size(); }
+
+	Control::Shared VirtualizingContainer::getRealizedControl(size_t index) const {
+		if (index < m_firstRealized || index - m_firstRealized >= m_children.size())
+			return Control::Shared();
+		return m_children[index - m_firstRealized];
+	}
+
+	size_t VirtualizingContainer::getPoolSize() const { return m_pool.size(); }
+
+	bool VirtualizingContainer::hasSerialLayout() const { return true; }
+
+	Size2D64F VirtualizingContainer::doMeasure(const Size2D64F & availableSize) {
+		const ResolvedMargin padding = getLayoutUnits().resolve(ContentLayout->Padding, availableSize);
+		const Size2D64F content = padding.deflate(availableSize).size;
+
+		// Without a limit the viewport of the last arrange is filled
+		const double viewport = std::isfinite(content.height()) ? content.height() : m_viewportHeight;
+		double width = 0;
+		for (size_t i = 0; i < REALIZE_PASSES; ++i) {
+			const std::pair<size_t, size_t> range = getRealizedRange(m_scrollOffset, viewport);
+			if (i > 0 && isRealized(range))
+				break;
+			realize(range.first, range.second);
+			width = measureChildren(Size2D64F(content.width(), INFINITY));
+
+			// Measured items may have shrunk the extent below the offset
+			m_scrollOffset = clampScrollOffset(m_scrollOffset, viewport);
+		}
+		const double height = std::min(m_heights.getTotal(), content.height());
+		return Size2D64F(width + padding.Left + padding.Right, height + padding.Top + padding.Bottom);
+	}
+
+	void VirtualizingContainer::doArrange(const Size2D64F & finalSize) {
+		const LayoutUnits & units = getLayoutUnits();
+		const Rect64F content = units.resolve(ContentLayout->Padding, finalSize).deflate(finalSize);
+		m_viewportHeight = content.getHeight();
+
+		// The content size may have come from the cache, see ControlContainer
+		const Size2D64F & constraint = getContentConstraint();
+		measureChildren(Size2D64F(units.resolve(ContentLayout->Padding, constraint).deflate(constraint).getWidth(), INFINITY));
+		m_scrollOffset = clampScrollOffset(m_scrollOffset, m_viewportHeight);
+
+		// The children are stacked from the offset of the first one
+		std::vector<double> tops(m_children.size());
+		double top = content.getTop() + m_heights.getPrefixSum(m_firstRealized) - m_scrollOffset;
+		for (size_t i = 0; i < m_children.size(); ++i) {
+			tops[i] = top;
+			top += m_heights.get(m_firstRealized + i);
+		}
+
+		layoutChildren([this, &tops, &content](Control & child, size_t index) {
+			child.arrange(Rect64F(content.getLeft(), tops[index], content.getWidth(), m_heights.get(m_firstRealized + index)));
+		});
+	}
+
+	std::pair<size_t, size_t> VirtualizingContainer::getRealizedRange(double offset, double viewport) const {
+		const size_t count = m_heights.size();
+		if (count == 0)
+			return std::make_pair(0, 0);
+
+		const size_t first = std::min(m_heights.findIndex(offset), count - 1);
+		const size_t last = std::min(m_heights.findIndex(offset + viewport), count - 1);
+		return std::make_pair(first > m_overscan ? first - m_overscan : 0,
+			std::min(count, last + 1 + m_overscan));
+	}
+
+	double VirtualizingContainer::clampScrollOffset(double offset, double viewport) const {
+		return std::max(0.0, std::min(offset, m_heights.getTotal() - viewport));
+	}
+
+	bool VirtualizingContainer::isRealized(const std::pair<size_t, size_t> & range) const {
+		return range.first == m_firstRealized && range.second == m_firstRealized + m_children.size();
+	}
+
+	void VirtualizingContainer::realize(size_t first, size_t end) {
+		if (isRealized(std::make_pair(first, end)))
+			return;
+
+		// Keep the controls of the items which stay in the range
+		std::vector<Control::Shared> controls(end - first);
+		std::vector<Control::Shared> kept;
+		for (size_t i = 0; i < m_children.size(); ++i) {
+			const size_t item = m_firstRealized + i;
+			if (item >= first && item < end) {
+				controls[item - first] = m_children[i];
+				kept.push_back(m_children[i]);
+			}
+			else
+				m_pool.push_back(m_children[i]);
+		}
+		changeChildrenInLayout([&kept](Children & children) { children.assign(kept.begin(), kept.end()); });
+
+		// The others are bound while they have no parent, so that their
+		// invalidations stay with them
+		for (size_t i = 0; i < controls.size(); ++i) {
+			if (controls[i])
+				continue;
+
+			if (m_pool.empty())
+				controls[i] = m_factory();
+			else {
+				controls[i] = m_pool.back();
+				m_pool.pop_back();
+			}
+			m_binder(*controls[i], first + i);
+		}
+
+		changeChildrenInLayout([&controls](Children & children) { children.assign(controls.begin(), controls.end()); });
+		m_firstRealized = first;
+	}
+
+	double VirtualizingContainer::measureChildren(const Size2D64F & constraint) {
+		layoutChildren([&constraint](Control & child, size_t) { child.measure(constraint); });
+
+		double width = 0;
+		for (size_t i = 0; i < m_children.size(); ++i) {
+			const Size2D64F & size = m_children[i]->getDesiredSize();
+			width = std::max(width, size.width());
+			if (m_heights.get(m_firstRealized + i) != size.height())
+				m_heights.set(m_firstRealized + i, size.height());
+		}
+		return width;
+	}
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+#include "Controls.h"
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace v2x {
+
+	/// A vertical list of items which has controls only for the visible items
+	/// and a few around them, the overscan.
+	///
+	/// The items are given by their count and an estimate of their heights.
+	/// The controls of items leaving the visible range go to a pool and are
+	/// bound to the items coming into view. The measured heights replace the
+	/// estimates in a FenwickTree, so the scroll extent and the item at an
+	/// offset are found in O(log n) whatever the number of items.
+	///
+	/// The children are managed by the container and must not be changed.
+	/// The factory and the binder run within the measure, but always on the
+	/// thread which started the layout (see hasSerialLayout()), so they may
+	/// edit the specs of the controls.
+	///
+	class VirtualizingContainer : public ControlContainer {
+
+	public:
+		DEFINE_POINTERS(VirtualizingContainer);
+
+		/// Returns the estimated height of an item including its margin
+		typedef std::function<double(size_t index)> SizeEstimator;
+		/// Creates a control for items
+		typedef std::function<Control::Shared()> ItemFactory;
+		/// Shows an item by a new or recycled control. The control has no
+		/// parent meanwhile.
+		typedef std::function<void(Control & control, size_t index)> ItemBinder;
+
+		/// The default number of items realized before and after the visible
+		/// ones
+		static const size_t DEFAULT_OVERSCAN = 4;
+
+		VirtualizingContainer(const ItemFactory & factory, const ItemBinder & binder);
+
+		virtual ~VirtualizingContainer();
+
+		/// Replace the items. Their controls go back to the pool.
+		void setItems(size_t count, const SizeEstimator & estimator);
+		size_t getItemCount() const;
+
+		void setOverscan(size_t count);
+		size_t getOverscan() const;
+
+		/// Scroll the top of the viewport to an offset within the extent
+		void setScrollOffset(double offset);
+		double getScrollOffset() const;
+		/// Returns the height of all items. It is estimated for the items
+		/// which have not been measured yet.
+		double getScrollExtent() const;
+		/// Returns the height of the viewport from the last arrange
+		double getViewportHeight() const;
+
+		/// Returns the offset of the top of an item
+		double getItemOffset(size_t index) const;
+		/// Returns the item at an offset or the item count if the offset is
+		/// beyond the extent
+		size_t getItemAt(double offset) const;
+
+		/// Returns the first item with a control. The items with controls
+		/// follow it in the order of the children.
+		size_t getFirstRealizedItem() const;
+		size_t getRealizedItemCount() const;
+		/// Returns the control of an item or nullptr if it has none
+		Control::Shared getRealizedControl(size_t index) const;
+		/// Returns the number of controls waiting for reuse
+		size_t getPoolSize() const;
+
+		/// Returns true, as the items are realized during the layout
+		bool hasSerialLayout() const override;
+
+	protected:
+
+		/// Realize the items within the available height and stack them
+		Size2D64F doMeasure(const Size2D64F & availableSize) override;
+		void doArrange(const Size2D64F & finalSize) override;
+
+	private:
+		ItemFactory m_factory;
+		ItemBinder m_binder;
+		size_t m_overscan;
+
+		/// The height of each item, measured or estimated
+		FenwickTree<double> m_heights;
+		double m_scrollOffset;
+		double m_viewportHeight;
+
+		/// The item of the first child
+		size_t m_firstRealized;
+		std::vector<Control::Shared> m_pool;
+
+		/// Returns the first and the end of the items to be realized
+		std::pair<size_t, size_t> getRealizedRange(double offset, double viewport) const;
+		bool isRealized(const std::pair<size_t, size_t> & range) const;
+		double clampScrollOffset(double offset, double viewport) const;
+		/// Give the items of a range controls and recycle the others
+		void realize(size_t first, size_t end);
+		/// Measure the children and take their heights
+		double measureChildren(const Size2D64F & constraint);
+	};
+}
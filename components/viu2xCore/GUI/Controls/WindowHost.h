@@ -27,6 +27,11 @@ namespace v2x {
 		/// This function returns the default window size of the v2x system.
 		virtual Size2D64F getDefaultWindowSize() = 0;
 
+		/// Request an OnPaint event. It is triggered once after the pending
+		/// input has been processed. A request from within OnPaint triggers
+		/// another event.
+		virtual void requestPaint() = 0;
+
 		EventSlot OnShow;
 		EventSlot OnClose;
 		EventSlot OnResize;
@@ -40,6 +45,11 @@ namespace v2x {
 		EventSlot OnKeyStroke;
 
 		EventSlot OnPaint;
+		/// Triggered with EventDataDpiChange when the resolution of the
+		/// window changes
+		EventSlot OnDpiChange;
+
+		EventSlot OnTimer;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "../../common.h"
+
+#include "Controls.h"
+#include "WindowHostHeadless.h"
+
+namespace v2x {
+
+	WindowHostHeadless::Shared WindowHostHeadless::createNew() {
+		return createNew(Size2D64F(1024, 768));
+	}
+
+	WindowHostHeadless::Shared WindowHostHeadless::createNew(const Size2D64F & defaultSize) {
+		return WindowHostHeadless::Shared(new WindowHostHeadless(defaultSize));
+	}
+
+	WindowHostHeadless::WindowHostHeadless(const Size2D64F & defaultSize) :
+		m_defaultSize(defaultSize), m_position(0, 0, defaultSize.width(), defaultSize.height()),
+		m_isVisible(false), m_isPaintRequested(false) {}
+
+	WindowHostHeadless::~WindowHostHeadless() {}
+
+	void WindowHostHeadless::show() {
+
+		m_isVisible = true;
+
+		EventDataWindowSize::Shared data(new EventDataWindowSize(WindowState::Normal,
+			m_position.position, m_position.size));
+		OnShow.notifyEvent(Event::Shared(new Event(shared_from_this(), data)));
+	}
+
+	void WindowHostHeadless::close() {
+
+		if (!m_isVisible)
+			throw Exception(L"WindowHostHeadless::close(): The window host is not visible!");
+
+		OnClose.notifyEvent(Event::Shared(new Event(shared_from_this(), Object::Shared())));
+		m_isVisible = false;
+	}
+
+	void WindowHostHeadless::setPosition(const Rect64F & position) {
+
+		m_position = position;
+
+		EventDataWindowSize::Shared data(new EventDataWindowSize(WindowState::Normal,
+			m_position.position, m_position.size));
+		OnResize.notifyEvent(Event::Shared(new Event(shared_from_this(), data)));
+	}
+
+	Size2D64F WindowHostHeadless::getDefaultWindowSize() {
+		return m_defaultSize;
+	}
+
+	void WindowHostHeadless::requestPaint() {
+		m_isPaintRequested = true;
+	}
+
+	bool WindowHostHeadless::paint() {
+		if (!m_isPaintRequested)
+			return false;
+
+		m_isPaintRequested = false;
+		OnPaint.notifyEvent(Event::Shared(new Event(shared_from_this(), Object::Shared())));
+		return true;
+	}
+
+	bool WindowHostHeadless::isPaintRequested() const {
+		return m_isPaintRequested;
+	}
+
+	void WindowHostHeadless::setDpi(double dpi) {
+		EventDataDpiChange::Shared data(new EventDataDpiChange(dpi));
+		OnDpiChange.notifyEvent(Event::Shared(new Event(shared_from_this(), data)));
+	}
+
+	bool WindowHostHeadless::isVisible() const {
+		return m_isVisible;
+	}
+
+	const Rect64F & WindowHostHeadless::getPosition() const {
+		return m_position;
+	}
+}
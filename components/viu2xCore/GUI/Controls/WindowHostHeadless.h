@@ -0,0 +1,68 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+#include "WindowHost.h"
+
+namespace v2x {
+
+	/// A WindowHost implementation without any OS window behind it.
+	///
+	/// It triggers the same events as a native window host when it is shown,
+	/// closed or moved, but never paints anything. It can be used on any
+	/// thread and is intended for automated tests and for replaying recorded
+	/// sessions (see SessionReplayer).
+	///
+	class WindowHostHeadless : public WindowHost {
+	public:
+		DEFINE_POINTERS(WindowHostHeadless);
+
+		/// This function creates a new invisible headless window host.
+		static WindowHostHeadless::Shared createNew();
+
+		/// This function creates a new invisible headless window host with
+		/// the specified default window size.
+		static WindowHostHeadless::Shared createNew(const Size2D64F & defaultSize);
+
+		// We always need a virtual destructor
+		virtual ~WindowHostHeadless();
+
+		// Trigger the OnShow event
+		void show() override;
+		// Trigger the OnClose event
+		void close() override;
+		// Change the virtual window size and trigger the OnResize event
+		void setPosition(const Rect64F & position) override;
+		/// This function returns the default window size of the host.
+		Size2D64F getDefaultWindowSize() override;
+		/// Remember the request until paint() is called
+		void requestPaint() override;
+
+		/// Trigger the OnPaint event if it has been requested, like the
+		/// message loop of a native host. Returns false if not requested.
+		bool paint();
+		bool isPaintRequested() const;
+
+		/// Trigger the OnDpiChange event as if the window was moved to a
+		/// display with another resolution
+		void setDpi(double dpi);
+
+		/// Returns true if the host has been shown and not yet closed.
+		bool isVisible() const;
+
+		/// Returns the current virtual window position.
+		const Rect64F & getPosition() const;
+
+	protected:
+		/// The constructor should be called ONLY by the createNew() methods.
+		WindowHostHeadless(const Size2D64F & defaultSize);
+
+	private:
+		Size2D64F m_defaultSize;
+		Rect64F m_position;
+		bool m_isVisible;
+		bool m_isPaintRequested;
+	};
+
+}
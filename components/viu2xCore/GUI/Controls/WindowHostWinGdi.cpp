@@ -20,9 +20,9 @@ namespace v2x {
 	void WindowHostWinGdi::assertGuiThread(const String & caller) {
 		std::lock_guard<std::recursive_mutex> lock(g_ownerThreadIdMutex);
 		if (!g_initialized)
-			throw Exception(L"%s: The GUI system has not been initialized!", caller.c_str());
+			throw Exception(CHECKED_FORMAT(L"%s: The GUI system has not been initialized!", caller.c_str()));
 		if (g_ownerThreadId != std::this_thread::get_id())
-			throw Exception(L"%s: The App instance can be freed ONLY in the owner thread!", caller.c_str());
+			throw Exception(CHECKED_FORMAT(L"%s: The App instance can be freed ONLY in the owner thread!", caller.c_str()));
 	}
 
 	bool WindowHostWinGdi::sendMessage(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -102,7 +102,7 @@ namespace v2x {
 		}
 
 		g_hInstance = GetModuleHandle(NULL);
-		g_windowClassName = StrUtils::format(L"Viu2x_Common_Window_%d", g_hInstance);
+		g_windowClassName = StrUtils::format(CHECKED_FORMAT(L"Viu2x_Common_Window_%d", g_hInstance));
 
 		// Register class
 		WNDCLASSEXW wcex;
@@ -194,6 +194,11 @@ namespace v2x {
 		return result;
 	}
 
+	void WindowHostWinGdi::requestPaint() {
+		if (m_hwnd != NULL)
+			InvalidateRect(m_hwnd, NULL, FALSE);
+	}
+
 	bool WindowHostWinGdi::processWindowsMessage(UINT message, WPARAM wParam, LPARAM lParam) {
 
 		switch (message) {
@@ -242,6 +247,41 @@ namespace v2x {
 			return false;
 		}
 
+		case WM_PAINT:
+		{
+			// The window is validated before the event, so that its handlers
+			// may request another paint, e.g. to continue a time-sliced layout.
+			// DefWindowProc would validate it afterwards and drop the request.
+			PAINTSTRUCT paint;
+			BeginPaint(m_hwnd, &paint);
+			EndPaint(m_hwnd, &paint);
+
+			OnPaint.notifyEvent(Event::Shared(new Event(shared_from_this(), Object::Shared())));
+			return true;
+		}
+
+		case WM_TIMER:
+		{
+			EventDataTimer::Shared data(new EventDataTimer((uint32_t)wParam));
+			OnTimer.notifyEvent(Event::Shared(new Event(shared_from_this(), data)));
+			return true;
+		}
+
+#ifdef WM_DPICHANGED
+		case WM_DPICHANGED:
+		{
+			// Both words hold the same resolution
+			EventDataDpiChange::Shared data(new EventDataDpiChange(HIWORD(wParam)));
+			OnDpiChange.notifyEvent(Event::Shared(new Event(shared_from_this(), data)));
+
+			// Take the size suggested for the new resolution
+			const RECT * rect = (const RECT *)lParam;
+			SetWindowPos(m_hwnd, NULL, rect->left, rect->top, rect->right - rect->left, rect->bottom - rect->top,
+				SWP_NOZORDER | SWP_NOACTIVATE);
+			return true;
+		}
+#endif
+
 		default:
 			return false;
 		}
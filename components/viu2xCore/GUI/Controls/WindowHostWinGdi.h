@@ -53,6 +53,9 @@ namespace v2x {
 		void setPosition(const Rect64F & position) override;
 		/// This function returns the default window size of the v2x system.
 		Size2D64F getDefaultWindowSize() override;
+		/// Invalidate the native window. Windows sends WM_PAINT when no other
+		/// messages are pending.
+		void requestPaint() override;
 
 	protected:
 		/// The constructor creates a new native window and export the handle 
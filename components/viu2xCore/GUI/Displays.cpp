@@ -22,6 +22,9 @@ namespace v2x {
 		m_displayName(displayName), //
 		m_physicalSizeInMm(physicalSizeInMm), //
 		m_resolutionInDpi(resolutionInDpi), //
+		m_actualResolutionInDpi(screenAreaInPx.getWidth() * 25.4 / physicalSizeInMm.width(), //
+			screenAreaInPx.getHeight() * 25.4 / physicalSizeInMm.height()), //
+		m_layoutUnits(resolutionInDpi.x()), //
 		m_screenAreaInPx(screenAreaInPx), //
 		m_workAreaInPx(workAreaInPx), //
 		m_isPrimary(isPrimary) {
@@ -50,10 +53,14 @@ namespace v2x {
 		return m_resolutionInDpi;
 	}
 
-	/// Specified resolution, not the actual one.
-	Vector2D Display::getActualResolutionInDpi() const {
-		return Vector2D(m_screenAreaInPx.getWidth() * 25.4 / m_physicalSizeInMm.width(), //
-			m_screenAreaInPx.getHeight() * 25.4 / m_physicalSizeInMm.height());
+	/// Resolution computed from the screen area and the physical size.
+	const Vector2D & Display::getActualResolutionInDpi() const {
+		return m_actualResolutionInDpi;
+	}
+
+	/// The units of layouts on the display at the specified resolution.
+	const LayoutUnits & Display::getLayoutUnits() const {
+		return m_layoutUnits;
 	}
 
 	/// The region where the display is mapped to.
@@ -100,7 +107,7 @@ namespace v2x {
 	Display::ConstShared Displays::getDisplay(size_t index) const {
 
 		if (index >= m_displays.size())
-			throw Exception(L"Displays::getDisplay: Index %u out of range!", index);
+			throw Exception(CHECKED_FORMAT(L"Displays::getDisplay: Index %u out of range!", index));
 
 		return m_displays[index];
 	}
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "../common.h"
+#include "Graphics/Layout.h"
 
 #ifdef V2X_WINDOWS
 #include <windows.h>
@@ -39,8 +40,11 @@ namespace v2x {
 		/// Specified resolution, not the actual one.
 		const Vector2D & getResolutionInDpi() const;
 
-		/// Specified resolution, not the actual one.
-		Vector2D getActualResolutionInDpi() const;
+		/// Resolution computed from the screen area and the physical size.
+		const Vector2D & getActualResolutionInDpi() const;
+
+		/// The units of layouts on the display at the specified resolution.
+		const LayoutUnits & getLayoutUnits() const;
 
 		/// The region where the display is mapped to.
 		const Rect32I & getScreenAreaInPx() const;
@@ -64,6 +68,10 @@ namespace v2x {
 		/// Specified resolution, not the actual one.
 		Vector2D m_resolutionInDpi;
 
+		/// Computed once as the display does not change.
+		Vector2D m_actualResolutionInDpi;
+		LayoutUnits m_layoutUnits;
+
 		/// The region where the display is mapped to.
 		Rect32I m_screenAreaInPx;
 
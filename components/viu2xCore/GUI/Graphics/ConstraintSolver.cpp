@@ -0,0 +1,645 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "ConstraintSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace v2x {
+
+	namespace {
+
+		/// Coefficients and constants closer to 0 are taken as 0
+		const double EPSILON = 1.0e-8;
+
+		const uint32_t INVALID_ID = std::numeric_limits<uint32_t>::max();
+
+		bool isNearZero(double value) {
+			return std::abs(value) < EPSILON;
+		}
+
+		double clipStrength(double strength) {
+			return std::max(0.0, std::min(strength, ConstraintStrength::REQUIRED));
+		}
+	}
+
+	////////////////////////
+	// ConstraintVariable //
+	////////////////////////
+
+	ConstraintVariable::ConstraintVariable() : Id(INVALID_ID) {}
+
+	ConstraintVariable::ConstraintVariable(uint32_t id) : Id(id) {}
+
+	bool ConstraintVariable::isValid() const { return Id != INVALID_ID; }
+
+	bool ConstraintVariable::operator == (const ConstraintVariable & variable) const { return Id == variable.Id; }
+
+	bool ConstraintVariable::operator != (const ConstraintVariable & variable) const { return Id != variable.Id; }
+
+	bool ConstraintVariable::operator < (const ConstraintVariable & variable) const { return Id < variable.Id; }
+
+	//////////////////////
+	// LinearExpression //
+	//////////////////////
+
+	LinearExpression::LinearExpression(double constant) : Constant(constant) {}
+
+	LinearExpression::LinearExpression(const ConstraintVariable & variable, double coefficient) :
+		Terms(1, Term(variable, coefficient)), Constant(0) {}
+
+	LinearExpression & LinearExpression::operator += (const LinearExpression & expression) {
+		Terms.insert(Terms.end(), expression.Terms.begin(), expression.Terms.end());
+		Constant += expression.Constant;
+		return *this;
+	}
+
+	LinearExpression & LinearExpression::operator -= (const LinearExpression & expression) {
+		return *this += expression * -1;
+	}
+
+	LinearExpression & LinearExpression::operator *= (double factor) {
+		for (auto i = Terms.begin(); i != Terms.end(); ++i)
+			i->second *= factor;
+		Constant *= factor;
+		return *this;
+	}
+
+	LinearExpression operator + (LinearExpression left, const LinearExpression & right) { return left += right; }
+
+	LinearExpression operator - (LinearExpression left, const LinearExpression & right) { return left -= right; }
+
+	LinearExpression operator - (LinearExpression expression) { return expression *= -1; }
+
+	LinearExpression operator * (LinearExpression expression, double factor) { return expression *= factor; }
+
+	LinearExpression operator * (double factor, LinearExpression expression) { return expression *= factor; }
+
+	////////////////////////
+	// ConstraintStrength //
+	////////////////////////
+
+	// The same as create(1000, 1000, 1000), create(1, 0, 0) etc.
+	const double ConstraintStrength::REQUIRED = 1001001000.0;
+	const double ConstraintStrength::STRONG = 1000000.0;
+	const double ConstraintStrength::MEDIUM = 1000.0;
+	const double ConstraintStrength::WEAK = 1.0;
+
+	double ConstraintStrength::create(double strong, double medium, double weak) {
+		return std::max(0.0, std::min(1000.0, strong)) * 1000000 +
+			std::max(0.0, std::min(1000.0, medium)) * 1000 +
+			std::max(0.0, std::min(1000.0, weak));
+	}
+
+	//////////////////////
+	// LinearConstraint //
+	//////////////////////
+
+	LinearConstraint::LinearConstraint(const LinearExpression & left, ConstraintRelation relation,
+		const LinearExpression & right, double strength) :
+		Expression(left - right), Relation(relation), Strength(strength) {}
+
+	///////////////////////////
+	// ConstraintSolver::Row //
+	///////////////////////////
+
+	/// A basic symbol equals the constant plus the other symbols times their
+	/// coefficients. The cells are sorted by the symbols.
+	class ConstraintSolver::Row {
+	public:
+		typedef std::vector<std::pair<Symbol, double>> CellList;
+
+		explicit Row(double constant = 0) : Constant(constant) {}
+
+		CellList Cells;
+		double Constant;
+
+		/// Returns the new constant
+		double add(double value) { return Constant += value; }
+
+		double getCoefficient(const Symbol & symbol) const {
+			auto i = find(symbol);
+			return i != Cells.end() && i->first == symbol ? i->second : 0;
+		}
+
+		void insert(const Symbol & symbol, double coefficient = 1) {
+			auto i = find(symbol);
+			if (i != Cells.end() && i->first == symbol) {
+				if (isNearZero(i->second += coefficient))
+					Cells.erase(i);
+			}
+			else if (!isNearZero(coefficient))
+				Cells.insert(i, std::make_pair(symbol, coefficient));
+		}
+
+		/// Add a row times a coefficient by merging the sorted cells
+		void insert(const Row & row, double coefficient = 1) {
+			Constant += row.Constant * coefficient;
+
+			CellList cells;
+			cells.reserve(Cells.size() + row.Cells.size());
+			auto i = Cells.begin();
+			auto j = row.Cells.begin();
+			while (i != Cells.end() || j != row.Cells.end()) {
+				if (j == row.Cells.end() || (i != Cells.end() && i->first < j->first))
+					cells.push_back(*i++);
+				else {
+					double value = j->second * coefficient;
+					if (i != Cells.end() && i->first == j->first)
+						value += (i++)->second;
+					if (!isNearZero(value))
+						cells.push_back(std::make_pair(j->first, value));
+					++j;
+				}
+			}
+			Cells.swap(cells);
+		}
+
+		void remove(const Symbol & symbol) {
+			auto i = find(symbol);
+			if (i != Cells.end() && i->first == symbol)
+				Cells.erase(i);
+		}
+
+		void reverseSign() {
+			Constant = -Constant;
+			for (auto i = Cells.begin(); i != Cells.end(); ++i)
+				i->second = -i->second;
+		}
+
+		/// Solve the row, which equals 0, for a symbol in it
+		void solveFor(const Symbol & symbol) {
+			const double coefficient = -1.0 / getCoefficient(symbol);
+			remove(symbol);
+			Constant *= coefficient;
+			for (auto i = Cells.begin(); i != Cells.end(); ++i)
+				i->second *= coefficient;
+		}
+
+		/// Solve the row, which equals the basic symbol lhs, for rhs
+		void solveFor(const Symbol & lhs, const Symbol & rhs) {
+			insert(lhs, -1.0);
+			solveFor(rhs);
+		}
+
+		/// Replace a symbol by the row which defines it
+		void substitute(const Symbol & symbol, const Row & row) {
+			auto i = find(symbol);
+			if (i == Cells.end() || !(i->first == symbol))
+				return;
+			const double coefficient = i->second;
+			Cells.erase(i);
+			insert(row, coefficient);
+		}
+
+	private:
+		CellList::const_iterator find(const Symbol & symbol) const {
+			return std::lower_bound(Cells.begin(), Cells.end(), symbol,
+				[](const std::pair<Symbol, double> & cell, const Symbol & value) { return cell.first < value; });
+		}
+
+		CellList::iterator find(const Symbol & symbol) {
+			return std::lower_bound(Cells.begin(), Cells.end(), symbol,
+				[](const std::pair<Symbol, double> & cell, const Symbol & value) { return cell.first < value; });
+		}
+	};
+
+	//////////////////////////////
+	// ConstraintSolver::Symbol //
+	//////////////////////////////
+
+	ConstraintSolver::Symbol::Symbol() : Id(0), Kind(Type::Invalid) {}
+
+	ConstraintSolver::Symbol::Symbol(uint64_t id, Type type) : Id(id), Kind(type) {}
+
+	bool ConstraintSolver::Symbol::isValid() const { return Kind != Type::Invalid; }
+
+	bool ConstraintSolver::Symbol::operator == (const Symbol & symbol) const { return Id == symbol.Id; }
+
+	bool ConstraintSolver::Symbol::operator < (const Symbol & symbol) const { return Id < symbol.Id; }
+
+	ConstraintSolver::ConstraintInfo::ConstraintInfo(const LinearConstraint & constraint, const Tag & tag) :
+		Constraint(constraint), Markers(tag) {}
+
+	//////////////////////
+	// ConstraintSolver //
+	//////////////////////
+
+	ConstraintSolver::ConstraintSolver() :
+		m_objective(new Row()), m_lastSymbol(0), m_lastConstraint(0) {}
+
+	ConstraintSolver::~ConstraintSolver() {}
+
+	ConstraintVariable ConstraintSolver::createVariable() {
+		if (m_variables.size() >= INVALID_ID)
+			throw Exception(L"ConstraintSolver::createVariable(): Too many variables!");
+		m_variables.push_back(Symbol());
+		return ConstraintVariable((uint32_t)(m_variables.size() - 1));
+	}
+
+	size_t ConstraintSolver::getVariableCount() const { return m_variables.size(); }
+
+	ConstraintSolver::ConstraintId ConstraintSolver::addConstraint(const LinearConstraint & constraint) {
+		Tag tag;
+		std::unique_ptr<Row> row = createRow(constraint, tag);
+		Symbol subject = chooseSubject(*row, tag);
+
+		// A row of dummies only is either redundant or unsatisfiable
+		if (!subject.isValid() && std::all_of(row->Cells.begin(), row->Cells.end(),
+			[](const std::pair<Symbol, double> & cell) { return cell.first.Kind == Symbol::Type::Dummy; })) {
+			if (!isNearZero(row->Constant))
+				throw Exception(L"ConstraintSolver::addConstraint(): The required constraint cannot be satisfied!");
+			subject = tag.Marker;
+		}
+
+		if (subject.isValid()) {
+			row->solveFor(subject);
+			substitute(subject, *row);
+			m_rows[subject] = std::move(row);
+		}
+		else if (!addWithArtificialVariable(*row)) {
+			// Only required constraints fail here, which have not touched
+			// the objective. The tableau holds the other constraints in
+			// another basis, which may need to be optimized again.
+			m_infeasibleRows.clear();
+			optimize(*m_objective);
+			throw Exception(L"ConstraintSolver::addConstraint(): The required constraint cannot be satisfied!");
+		}
+
+		const ConstraintId id = ++m_lastConstraint;
+		LinearConstraint info(constraint);
+		info.Strength = clipStrength(constraint.Strength);
+		m_constraints.insert(std::make_pair(id, ConstraintInfo(info, tag)));
+
+		optimize(*m_objective);
+		m_infeasibleRows.clear();
+		return id;
+	}
+
+	void ConstraintSolver::removeConstraint(ConstraintId id) {
+		auto constraint = m_constraints.find(id);
+		if (constraint == m_constraints.end())
+			throw Exception(CHECKED_FORMAT(L"ConstraintSolver::removeConstraint(): Unknown constraint %d!", (int)id));
+		const Tag tag = constraint->second.Markers;
+		const double strength = constraint->second.Constraint.Strength;
+		m_constraints.erase(constraint);
+
+		if (tag.Marker.Kind == Symbol::Type::Error)
+			removeMarkerEffects(tag.Marker, strength);
+		if (tag.Other.Kind == Symbol::Type::Error)
+			removeMarkerEffects(tag.Other, strength);
+
+		// The marker is made basic, then its row is dropped
+		auto row = m_rows.find(tag.Marker);
+		if (row == m_rows.end()) {
+			auto leaving = getMarkerLeavingRow(tag.Marker);
+			if (leaving == m_rows.end())
+				throw Exception(CHECKED_FORMAT(L"ConstraintSolver::removeConstraint(): No row to remove constraint %d!", (int)id));
+			pivot(leaving, tag.Marker);
+			row = m_rows.find(tag.Marker);
+		}
+		m_rows.erase(row);
+
+		optimize(*m_objective);
+		m_infeasibleRows.clear();
+	}
+
+	bool ConstraintSolver::hasConstraint(ConstraintId id) const { return m_constraints.find(id) != m_constraints.end(); }
+
+	size_t ConstraintSolver::getConstraintCount() const { return m_constraints.size(); }
+
+	void ConstraintSolver::addEditVariable(const ConstraintVariable & variable, double strength) {
+		if (hasEditVariable(variable))
+			throw Exception(CHECKED_FORMAT(L"ConstraintSolver::addEditVariable(): The variable %d is edited already!", (int)variable.Id));
+		strength = clipStrength(strength);
+		if (strength >= ConstraintStrength::REQUIRED)
+			throw Exception(L"ConstraintSolver::addEditVariable(): An edit variable must not be required!");
+
+		EditInfo info;
+		info.Constraint = addConstraint(LinearConstraint(variable, ConstraintRelation::Equal, 0, strength));
+		info.Markers = m_constraints.find(info.Constraint)->second.Markers;
+		info.Constant = 0;
+		m_edits[variable] = info;
+	}
+
+	void ConstraintSolver::removeEditVariable(const ConstraintVariable & variable) {
+		auto edit = m_edits.find(variable);
+		if (edit == m_edits.end())
+			throw Exception(CHECKED_FORMAT(L"ConstraintSolver::removeEditVariable(): The variable %d is not edited!", (int)variable.Id));
+		removeConstraint(edit->second.Constraint);
+		m_edits.erase(edit);
+	}
+
+	bool ConstraintSolver::hasEditVariable(const ConstraintVariable & variable) const {
+		return m_edits.find(variable) != m_edits.end();
+	}
+
+	void ConstraintSolver::suggestValue(const ConstraintVariable & variable, double value) {
+		auto edit = m_edits.find(variable);
+		if (edit == m_edits.end())
+			throw Exception(CHECKED_FORMAT(L"ConstraintSolver::suggestValue(): The variable %d is not edited!", (int)variable.Id));
+
+		EditInfo & info = edit->second;
+		const double delta = value - info.Constant;
+		if (delta == 0)
+			return;
+		info.Constant = value;
+
+		// Only the constants of the rows with the edit constraint change
+		auto row = m_rows.find(info.Markers.Marker);
+		if (row != m_rows.end()) {
+			if (row->second->add(-delta) < 0)
+				m_infeasibleRows.push_back(row->first);
+		}
+		else if ((row = m_rows.find(info.Markers.Other)) != m_rows.end()) {
+			if (row->second->add(delta) < 0)
+				m_infeasibleRows.push_back(row->first);
+		}
+		else {
+			for (auto i = m_rows.begin(); i != m_rows.end(); ++i) {
+				const double coefficient = i->second->getCoefficient(info.Markers.Marker);
+				if (coefficient != 0 && i->second->add(delta * coefficient) < 0 && i->first.Kind != Symbol::Type::External)
+					m_infeasibleRows.push_back(i->first);
+			}
+		}
+		dualOptimize();
+	}
+
+	double ConstraintSolver::getValue(const ConstraintVariable & variable) const {
+		if (!variable.isValid() || variable.Id >= m_variables.size())
+			throw Exception(CHECKED_FORMAT(L"ConstraintSolver::getValue(): Unknown variable %d!", (int)variable.Id));
+
+		// Parametric variables are 0
+		auto row = m_rows.find(m_variables[variable.Id]);
+		return row != m_rows.end() ? row->second->Constant : 0;
+	}
+
+	void ConstraintSolver::reset() {
+		m_variables.clear();
+		m_constraints.clear();
+		m_edits.clear();
+		m_rows.clear();
+		m_infeasibleRows.clear();
+		m_objective.reset(new Row());
+		m_artificial.reset();
+		m_lastSymbol = 0;
+		m_lastConstraint = 0;
+	}
+
+	ConstraintSolver::Symbol ConstraintSolver::createSymbol(Symbol::Type type) {
+		return Symbol(++m_lastSymbol, type);
+	}
+
+	ConstraintSolver::Symbol ConstraintSolver::getVariableSymbol(const ConstraintVariable & variable, const Char * caller) {
+		if (!variable.isValid() || variable.Id >= m_variables.size())
+			throw Exception(CHECKED_FORMAT(L"%s: Unknown variable %d!", caller, (int)variable.Id));
+
+		Symbol & symbol = m_variables[variable.Id];
+		if (!symbol.isValid())
+			symbol = createSymbol(Symbol::Type::External);
+		return symbol;
+	}
+
+	std::unique_ptr<ConstraintSolver::Row> ConstraintSolver::createRow(const LinearConstraint & constraint, Tag & tag) {
+		const LinearExpression & expression = constraint.Expression;
+		std::unique_ptr<Row> row(new Row(expression.Constant));
+
+		// Basic variables are replaced by their rows
+		for (auto i = expression.Terms.begin(); i != expression.Terms.end(); ++i) {
+			if (isNearZero(i->second))
+				continue;
+			const Symbol symbol = getVariableSymbol(i->first, L"ConstraintSolver::addConstraint()");
+			auto basic = m_rows.find(symbol);
+			if (basic != m_rows.end())
+				row->insert(*basic->second, i->second);
+			else
+				row->insert(symbol, i->second);
+		}
+
+		// Slacks turn inequations into equations, the errors of optional
+		// constraints are minimized by the objective
+		const double strength = clipStrength(constraint.Strength);
+		const bool isRequired = strength >= ConstraintStrength::REQUIRED;
+		switch (constraint.Relation) {
+		case ConstraintRelation::LessOrEqual:
+		case ConstraintRelation::GreaterOrEqual: {
+			const double coefficient = constraint.Relation == ConstraintRelation::LessOrEqual ? 1.0 : -1.0;
+			tag.Marker = createSymbol(Symbol::Type::Slack);
+			row->insert(tag.Marker, coefficient);
+			if (!isRequired) {
+				tag.Other = createSymbol(Symbol::Type::Error);
+				row->insert(tag.Other, -coefficient);
+				m_objective->insert(tag.Other, strength);
+			}
+			break;
+		}
+		case ConstraintRelation::Equal:
+			if (!isRequired) {
+				tag.Marker = createSymbol(Symbol::Type::Error);
+				tag.Other = createSymbol(Symbol::Type::Error);
+				row->insert(tag.Marker, -1.0);
+				row->insert(tag.Other, 1.0);
+				m_objective->insert(tag.Marker, strength);
+				m_objective->insert(tag.Other, strength);
+			}
+			else {
+				tag.Marker = createSymbol(Symbol::Type::Dummy);
+				row->insert(tag.Marker);
+			}
+			break;
+		}
+
+		if (row->Constant < 0)
+			row->reverseSign();
+		return row;
+	}
+
+	ConstraintSolver::Symbol ConstraintSolver::chooseSubject(const Row & row, const Tag & tag) {
+		for (auto i = row.Cells.begin(); i != row.Cells.end(); ++i)
+			if (i->first.Kind == Symbol::Type::External)
+				return i->first;
+
+		const Symbol * markers[] = { &tag.Marker, &tag.Other };
+		for (const Symbol * marker : markers)
+			if ((marker->Kind == Symbol::Type::Slack || marker->Kind == Symbol::Type::Error) &&
+				row.getCoefficient(*marker) < 0)
+				return *marker;
+		return Symbol();
+	}
+
+	bool ConstraintSolver::addWithArtificialVariable(const Row & row) {
+		// The artificial variable is minimized to 0 if the row is feasible
+		const Symbol artificial = createSymbol(Symbol::Type::Slack);
+		m_rows[artificial].reset(new Row(row));
+		m_artificial.reset(new Row(row));
+		try {
+			optimize(*m_artificial);
+		}
+		catch (...) {
+			m_artificial.reset();
+			throw;
+		}
+		const bool isSatisfied = isNearZero(m_artificial->Constant);
+		m_artificial.reset();
+
+		// The artificial variable stays basic unless it reached 0. Dropping
+		// its row drops the constraint, the pivots before only changed the
+		// basis of the other rows.
+		auto basic = m_rows.find(artificial);
+		if (basic != m_rows.end()) {
+			if (!isSatisfied || basic->second->Cells.empty()) {
+				m_rows.erase(basic);
+				return isSatisfied;
+			}
+			const Symbol entering = getPivotableSymbol(*basic->second);
+			if (!entering.isValid()) {
+				m_rows.erase(basic);
+				return false;
+			}
+			pivot(basic, entering);
+		}
+
+		for (auto i = m_rows.begin(); i != m_rows.end(); ++i)
+			i->second->remove(artificial);
+		m_objective->remove(artificial);
+		return isSatisfied;
+	}
+
+	void ConstraintSolver::substitute(const Symbol & symbol, const Row & row) {
+		for (auto i = m_rows.begin(); i != m_rows.end(); ++i) {
+			i->second->substitute(symbol, row);
+			if (i->first.Kind != Symbol::Type::External && i->second->Constant < 0)
+				m_infeasibleRows.push_back(i->first);
+		}
+		m_objective->substitute(symbol, row);
+		if (m_artificial)
+			m_artificial->substitute(symbol, row);
+	}
+
+	void ConstraintSolver::pivot(Rows::iterator leaving, const Symbol & entering) {
+		const Symbol symbol = leaving->first;
+		std::unique_ptr<Row> row = std::move(leaving->second);
+		m_rows.erase(leaving);
+
+		row->solveFor(symbol, entering);
+		substitute(entering, *row);
+		m_rows[entering] = std::move(row);
+	}
+
+	void ConstraintSolver::optimize(Row & objective) {
+		for (;;) {
+			const Symbol entering = getEnteringSymbol(objective);
+			if (!entering.isValid())
+				return;
+
+			auto leaving = getLeavingRow(entering);
+			if (leaving == m_rows.end())
+				throw Exception(L"ConstraintSolver::optimize(): The objective is unbounded!");
+			pivot(leaving, entering);
+		}
+	}
+
+	void ConstraintSolver::dualOptimize() {
+		while (!m_infeasibleRows.empty()) {
+			const Symbol leaving = m_infeasibleRows.back();
+			m_infeasibleRows.pop_back();
+
+			// A row may have been listed again or pivoted meanwhile
+			auto row = m_rows.find(leaving);
+			if (row == m_rows.end() || isNearZero(row->second->Constant) || row->second->Constant >= 0)
+				continue;
+
+			const Symbol entering = getDualEnteringSymbol(*row->second);
+			if (!entering.isValid())
+				throw Exception(L"ConstraintSolver::dualOptimize(): The tableau is infeasible!");
+			pivot(row, entering);
+		}
+	}
+
+	ConstraintSolver::Symbol ConstraintSolver::getEnteringSymbol(const Row & objective) {
+		for (auto i = objective.Cells.begin(); i != objective.Cells.end(); ++i)
+			if (i->first.Kind != Symbol::Type::Dummy && i->second < 0)
+				return i->first;
+		return Symbol();
+	}
+
+	ConstraintSolver::Symbol ConstraintSolver::getDualEnteringSymbol(const Row & row) const {
+		Symbol entering;
+		double ratio = std::numeric_limits<double>::max();
+		for (auto i = row.Cells.begin(); i != row.Cells.end(); ++i) {
+			if (i->second > 0 && i->first.Kind != Symbol::Type::Dummy) {
+				const double value = m_objective->getCoefficient(i->first) / i->second;
+				if (value < ratio) {
+					ratio = value;
+					entering = i->first;
+				}
+			}
+		}
+		return entering;
+	}
+
+	ConstraintSolver::Symbol ConstraintSolver::getPivotableSymbol(const Row & row) {
+		for (auto i = row.Cells.begin(); i != row.Cells.end(); ++i)
+			if (i->first.Kind == Symbol::Type::Slack || i->first.Kind == Symbol::Type::Error)
+				return i->first;
+		return Symbol();
+	}
+
+	ConstraintSolver::Rows::iterator ConstraintSolver::getLeavingRow(const Symbol & entering) {
+		auto result = m_rows.end();
+		double ratio = std::numeric_limits<double>::max();
+		for (auto i = m_rows.begin(); i != m_rows.end(); ++i) {
+			if (i->first.Kind == Symbol::Type::External)
+				continue;
+			const double coefficient = i->second->getCoefficient(entering);
+			if (coefficient < 0) {
+				const double value = -i->second->Constant / coefficient;
+				if (value < ratio) {
+					ratio = value;
+					result = i;
+				}
+			}
+		}
+		return result;
+	}
+
+	ConstraintSolver::Rows::iterator ConstraintSolver::getMarkerLeavingRow(const Symbol & marker) {
+		// Restricted rows with negative coefficients are preferred, then
+		// those with positive ones, then unrestricted ones
+		auto first = m_rows.end(), second = m_rows.end(), third = m_rows.end();
+		double firstRatio = std::numeric_limits<double>::max();
+		double secondRatio = std::numeric_limits<double>::max();
+		for (auto i = m_rows.begin(); i != m_rows.end(); ++i) {
+			const double coefficient = i->second->getCoefficient(marker);
+			if (coefficient == 0)
+				continue;
+
+			if (i->first.Kind == Symbol::Type::External)
+				third = i;
+			else if (coefficient < 0) {
+				const double value = -i->second->Constant / coefficient;
+				if (value < firstRatio) {
+					firstRatio = value;
+					first = i;
+				}
+			}
+			else {
+				const double value = i->second->Constant / coefficient;
+				if (value < secondRatio) {
+					secondRatio = value;
+					second = i;
+				}
+			}
+		}
+		return first != m_rows.end() ? first : second != m_rows.end() ? second : third;
+	}
+
+	void ConstraintSolver::removeMarkerEffects(const Symbol & marker, double strength) {
+		auto row = m_rows.find(marker);
+		if (row != m_rows.end())
+			m_objective->insert(*row->second, -strength);
+		else
+			m_objective->insert(marker, -strength);
+	}
+}
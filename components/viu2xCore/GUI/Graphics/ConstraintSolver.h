@@ -0,0 +1,224 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace v2x {
+
+	/// A variable of a ConstraintSolver. It is a handle given by
+	/// ConstraintSolver::createVariable().
+	class ConstraintVariable {
+	public:
+		/// An invalid variable
+		ConstraintVariable();
+		explicit ConstraintVariable(uint32_t id);
+
+		uint32_t Id;
+
+		bool isValid() const;
+
+		bool operator == (const ConstraintVariable & variable) const;
+		bool operator != (const ConstraintVariable & variable) const;
+		bool operator < (const ConstraintVariable & variable) const;
+	};
+
+	/// A sum of variables times coefficients plus a constant
+	class LinearExpression {
+	public:
+		typedef std::pair<ConstraintVariable, double> Term;
+
+		LinearExpression(double constant = 0);
+		LinearExpression(const ConstraintVariable & variable, double coefficient = 1);
+
+		/// A variable may occur in several terms
+		std::vector<Term> Terms;
+		double Constant;
+
+		LinearExpression & operator += (const LinearExpression & expression);
+		LinearExpression & operator -= (const LinearExpression & expression);
+		LinearExpression & operator *= (double factor);
+	};
+
+	LinearExpression operator + (LinearExpression left, const LinearExpression & right);
+	LinearExpression operator - (LinearExpression left, const LinearExpression & right);
+	LinearExpression operator - (LinearExpression expression);
+	LinearExpression operator * (LinearExpression expression, double factor);
+	LinearExpression operator * (double factor, LinearExpression expression);
+
+	/// The relation of the sides of a LinearConstraint
+	enum class ConstraintRelation {
+		Equal,
+		LessOrEqual,
+		GreaterOrEqual,
+	};
+
+	DEFINE_ENUM_STRINGS(ConstraintRelation,
+		L"Equal",
+		L"LessOrEqual",
+		L"GreaterOrEqual");
+
+	/// The strengths of constraints. Required constraints must be satisfied.
+	/// The others are satisfied as far as possible, the stronger ones first.
+	class ConstraintStrength {
+	public:
+		static const double REQUIRED;
+		static const double STRONG;
+		static const double MEDIUM;
+		static const double WEAK;
+
+		/// A strength between the predefined ones. A strength of 1 in one
+		/// level outweighs any strength below 1000 in the levels below.
+		static double create(double strong, double medium, double weak);
+	};
+
+	/// A linear equation or inequation of two expressions
+	class LinearConstraint {
+	public:
+		LinearConstraint(const LinearExpression & left, ConstraintRelation relation,
+			const LinearExpression & right, double strength = ConstraintStrength::REQUIRED);
+
+		/// The left side minus the right one, which is compared with 0
+		LinearExpression Expression;
+		ConstraintRelation Relation;
+		double Strength;
+	};
+
+	/// This class solves linear constraints incrementally by the Cassowary
+	/// algorithm, a simplex method which keeps its tableau between changes.
+	///
+	/// Adding or removing a constraint pivots only until the tableau is
+	/// optimal again. Edit variables are meant to follow the user, e.g. the
+	/// position of a splitter: a suggested value changes the constants of
+	/// the rows which contain the edit constraint, and only the rows which
+	/// became infeasible are pivoted by the dual simplex method.
+	///
+	///     ConstraintSolver solver;
+	///     ConstraintVariable left = solver.createVariable();
+	///     ConstraintVariable width = solver.createVariable();
+	///     solver.addConstraint(LinearConstraint(left + width, ConstraintRelation::LessOrEqual, 800));
+	///     solver.addEditVariable(width, ConstraintStrength::STRONG);
+	///     solver.suggestValue(width, 300);
+	///     double value = solver.getValue(width);
+	///
+	/// An exception is thrown if a required constraint conflicts with the
+	/// other required ones. The solver keeps the other constraints and their
+	/// solution then. The other exceptions are internal errors, e.g. of
+	/// numerical problems, after which the solver must be reset().
+	///
+	class ConstraintSolver {
+	public:
+		typedef uint32_t ConstraintId;
+
+		ConstraintSolver();
+		~ConstraintSolver();
+
+		ConstraintVariable createVariable();
+		size_t getVariableCount() const;
+
+		ConstraintId addConstraint(const LinearConstraint & constraint);
+		void removeConstraint(ConstraintId id);
+		bool hasConstraint(ConstraintId id) const;
+		size_t getConstraintCount() const;
+
+		/// Make a variable follow the values suggested for it with a
+		/// strength below required. It starts with the value 0.
+		void addEditVariable(const ConstraintVariable & variable, double strength);
+		void removeEditVariable(const ConstraintVariable & variable);
+		bool hasEditVariable(const ConstraintVariable & variable) const;
+		void suggestValue(const ConstraintVariable & variable, double value);
+
+		/// Returns the value of a variable in the current solution
+		double getValue(const ConstraintVariable & variable) const;
+
+		/// Remove all variables and constraints
+		void reset();
+
+	private:
+		/// A column of the tableau
+		class Symbol {
+		public:
+			enum class Type : uint8_t { Invalid, External, Slack, Error, Dummy };
+
+			Symbol();
+			Symbol(uint64_t id, Type type);
+
+			uint64_t Id;
+			Type Kind;
+
+			bool isValid() const;
+			bool operator == (const Symbol & symbol) const;
+			bool operator < (const Symbol & symbol) const;
+		};
+
+		/// The symbols which a constraint brought into the tableau
+		class Tag {
+		public:
+			Symbol Marker;
+			Symbol Other;
+		};
+
+		class ConstraintInfo {
+		public:
+			ConstraintInfo(const LinearConstraint & constraint, const Tag & tag);
+
+			LinearConstraint Constraint;
+			Tag Markers;
+		};
+
+		class EditInfo {
+		public:
+			ConstraintId Constraint;
+			Tag Markers;
+			double Constant;
+		};
+
+		class Row;
+		typedef std::map<Symbol, std::unique_ptr<Row>> Rows;
+
+		/// The symbol of each variable or an invalid one if the variable has
+		/// not been used yet
+		std::vector<Symbol> m_variables;
+		std::map<ConstraintId, ConstraintInfo> m_constraints;
+		std::map<ConstraintVariable, EditInfo> m_edits;
+
+		/// The basic symbols and the rows which define them
+		Rows m_rows;
+		/// The rows whose constants may have become negative
+		std::vector<Symbol> m_infeasibleRows;
+		std::unique_ptr<Row> m_objective;
+		std::unique_ptr<Row> m_artificial;
+
+		uint64_t m_lastSymbol;
+		ConstraintId m_lastConstraint;
+
+		Symbol createSymbol(Symbol::Type type);
+		Symbol getVariableSymbol(const ConstraintVariable & variable, const Char * caller);
+
+		std::unique_ptr<Row> createRow(const LinearConstraint & constraint, Tag & tag);
+		static Symbol chooseSubject(const Row & row, const Tag & tag);
+		bool addWithArtificialVariable(const Row & row);
+		/// Replace a symbol by a row in the whole tableau
+		void substitute(const Symbol & symbol, const Row & row);
+		/// Make a row basic for a symbol
+		void pivot(Rows::iterator leaving, const Symbol & entering);
+
+		/// Minimize an objective by the primal simplex method
+		void optimize(Row & objective);
+		/// Restore the feasibility of the infeasible rows by the dual
+		/// simplex method
+		void dualOptimize();
+
+		static Symbol getEnteringSymbol(const Row & objective);
+		Symbol getDualEnteringSymbol(const Row & row) const;
+		static Symbol getPivotableSymbol(const Row & row);
+		Rows::iterator getLeavingRow(const Symbol & entering);
+		Rows::iterator getMarkerLeavingRow(const Symbol & marker);
+		void removeMarkerEffects(const Symbol & marker, double strength);
+	};
+}
@@ -0,0 +1,484 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#include "FlowLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace v2x {
+
+	namespace {
+
+		/// The tolerance of comparing positions which are sums of sizes
+		const double EPSILON = 1e-6;
+
+		bool isFloat(PositionMode mode) {
+			return mode == PositionMode::FloatSurround || mode == PositionMode::FloatRow;
+		}
+
+		/// Returns true if a float overlaps a band. Empty bands overlap the
+		/// floats around their position.
+		bool overlaps(const Rect64F & rect, double top, double bottom) {
+			return rect.getBottom() > top && (rect.getTop() < bottom || rect.getTop() <= top);
+		}
+	}
+
+	//////////////
+	// FlowItem //
+	//////////////
+
+	FlowItem::FlowItem() :
+		Size(0, 0), Mode(PositionMode::Inline), Side(HorizontalAlignment::Left) {}
+
+	FlowItem::FlowItem(const Size2D64F & size, PositionMode mode, HorizontalAlignment side) :
+		Size(size), Mode(mode), Side(side) {}
+
+	bool FlowItem::operator == (const FlowItem & item) const {
+		return Size == item.Size && Mode == item.Mode && Side == item.Side;
+	}
+
+	bool FlowItem::operator != (const FlowItem & item) const {
+		return !(*this == item);
+	}
+
+	////////////////
+	// FlowLayout //
+	////////////////
+
+	FlowLayout::FlowLayout() :
+		m_width(NAN), m_alignment(FlowAlignment::Left), m_isChanged(false), m_firstChange(0), m_contentSize(0, 0),
+		m_top(0), m_bandHeight(0), m_interval(0), m_cursor(0), m_lineOpen(false) {}
+
+	size_t FlowLayout::update(const std::vector<FlowItem> & items, double width, FlowAlignment alignment) {
+
+		// Find the first change
+		size_t first = 0;
+		const size_t count = std::min(items.size(), m_items.size());
+		while (first < count && items[first] == m_items[first])
+			++first;
+		if (first < items.size() || first < m_items.size()) {
+			m_items = items;
+			markChanged(first);
+		}
+		return update(width, alignment);
+	}
+
+	size_t FlowLayout::update(double width, FlowAlignment alignment) {
+		const std::vector<FlowItem> & items = m_items;
+
+		size_t first = 0;
+		if (width == m_width && alignment == m_alignment) {
+			if (!m_isChanged)
+				return items.size();
+			first = m_firstChange;
+		}
+		m_isChanged = false;
+
+		// The item before the change may end its line because of the change,
+		// so the line of that item is placed again
+		size_t start = 0;
+		auto line = std::upper_bound(m_lines.begin(), m_lines.end(), first > 0 ? first - 1 : 0,
+			[](size_t item, const Line & line) { return item < line.FirstItem; });
+		if (first > 0 && line != m_lines.begin()) {
+			--line;
+			start = line->FirstItem;
+			m_floats.resize(line->FloatCount);
+			m_top = line->Start;
+			m_lines.erase(line, m_lines.end());
+		}
+		else {
+			m_floats.clear();
+			m_lines.clear();
+			m_top = 0;
+		}
+
+		m_width = width;
+		m_alignment = alignment;
+		m_rects.resize(items.size());
+
+		m_activeFloats.clear();
+		for (size_t i = 0; i < m_floats.size(); ++i)
+			if (m_floats[i].getBottom() > m_top)
+				m_activeFloats.push_back(i);
+		m_lineOpen = false;
+		m_lineItems.clear();
+		m_pendingFloats.clear();
+
+		// The last line is aligned differently
+		size_t lastInline = items.size();
+		for (size_t i = items.size(); i > 0; --i)
+			if (items[i - 1].Mode == PositionMode::Inline) {
+				lastInline = i - 1;
+				break;
+			}
+
+		for (size_t i = start; i < items.size(); ++i) {
+			const PositionMode mode = items[i].Mode;
+			if (mode == PositionMode::Inline)
+				placeInline(i, lastInline);
+			else if (isFloat(mode)) {
+				if (!m_lineOpen)
+					openLine(i);
+				if (m_lineItems.empty())
+					placeFloat(i);
+				else
+					m_pendingFloats.push_back(i);
+			}
+			else
+				m_rects[i] = Rect64F();
+		}
+		if (m_lineOpen)
+			closeLine(lastInline);
+
+		// The content covers all lines and floats
+		double contentWidth = 0;
+		double contentHeight = m_top;
+		for (auto i = m_lines.begin(); i != m_lines.end(); ++i)
+			contentWidth = std::max(contentWidth, i->Extent);
+		for (auto i = m_floats.begin(); i != m_floats.end(); ++i) {
+			contentWidth = std::max(contentWidth, i->getRight());
+			contentHeight = std::max(contentHeight, i->getBottom());
+		}
+		m_contentSize = Size2D64F(contentWidth, contentHeight);
+
+		return start;
+	}
+
+	void FlowLayout::clear() {
+		m_items.clear();
+		m_isChanged = false;
+		m_rects.clear();
+		m_lines.clear();
+		m_floats.clear();
+		m_width = NAN;
+		m_top = 0;
+		m_contentSize = Size2D64F(0, 0);
+	}
+
+	void FlowLayout::setItem(size_t index, const FlowItem & item) {
+		if (m_items[index] == item)
+			return;
+		m_items[index] = item;
+		markChanged(index);
+	}
+
+	void FlowLayout::insertItems(size_t index, size_t count, const FlowItem & item) {
+		if (count == 0)
+			return;
+		m_items.insert(m_items.begin() + index, count, item);
+		markChanged(index);
+	}
+
+	void FlowLayout::removeItems(size_t index, size_t count) {
+		if (count == 0)
+			return;
+		m_items.erase(m_items.begin() + index, m_items.begin() + index + count);
+		markChanged(index);
+	}
+
+	void FlowLayout::moveItems(size_t index, size_t count, size_t newIndex) {
+		if (count == 0 || index == newIndex)
+			return;
+		auto begin = m_items.begin();
+		if (newIndex < index)
+			std::rotate(begin + newIndex, begin + index, begin + index + count);
+		else
+			std::rotate(begin + index, begin + index + count, begin + newIndex + count);
+		markChanged(std::min(index, newIndex));
+	}
+
+	size_t FlowLayout::getItemCount() const { return m_items.size(); }
+
+	const FlowItem & FlowLayout::getItem(size_t index) const { return m_items[index]; }
+
+	void FlowLayout::markChanged(size_t item) {
+		if (!m_isChanged || item < m_firstChange)
+			m_firstChange = item;
+		m_isChanged = true;
+	}
+
+	const Rect64F & FlowLayout::getItemRect(size_t index) const { return m_rects[index]; }
+
+	Rect64F FlowLayout::getItemRect(size_t index, const Size2D64F & size, FlowDirection direction) const {
+		const PositionMode mode = m_items[index].Mode;
+		if (mode == PositionMode::FloatBack || mode == PositionMode::FloatFront)
+			return Rect64F(0, 0, size.width(), size.height());
+
+		const Rect64F & rect = m_rects[index];
+		const bool mirrorX = direction == FlowDirection::TopRightToBottomLeft || direction == FlowDirection::BottomRightToTopLeft;
+		const bool mirrorY = direction == FlowDirection::BottomLeftToTopRight || direction == FlowDirection::BottomRightToTopLeft;
+		return Rect64F(
+			mirrorX ? size.width() - rect.getRight() : rect.getLeft(),
+			mirrorY ? size.height() - rect.getBottom() : rect.getTop(),
+			rect.getWidth(), rect.getHeight());
+	}
+
+	Size2D64F FlowLayout::getContentSize() const { return m_contentSize; }
+
+	size_t FlowLayout::getLineCount() const { return m_lines.size(); }
+
+	void FlowLayout::openLine(size_t item) {
+
+		// Floats above the line are never reached again
+		m_activeFloats.erase(std::remove_if(m_activeFloats.begin(), m_activeFloats.end(),
+			[this](size_t i) { return m_floats[i].getBottom() <= m_top; }), m_activeFloats.end());
+
+		Line line;
+		line.FirstItem = item;
+		line.FloatCount = m_floats.size();
+		line.Start = m_top;
+		line.Top = m_top;
+		line.Height = 0;
+		line.Extent = 0;
+		m_lines.push_back(line);
+
+		m_lineOpen = true;
+		m_lineItems.clear();
+		m_lineIntervals.clear();
+		m_bandHeight = 0;
+	}
+
+	void FlowLayout::closeLine(size_t lastInline) {
+		Line & line = m_lines.back();
+		line.Top = m_top;
+
+		double height = 0;
+		for (auto i = m_lineItems.begin(); i != m_lineItems.end(); ++i) {
+			height = std::max(height, m_items[*i].Size.height());
+			line.Extent = std::max(line.Extent, m_rects[*i].getRight());
+		}
+		line.Height = height;
+
+		// Align the items of each interval
+		const bool isLast = !m_lineItems.empty() && m_lineItems.back() == lastInline;
+		for (size_t first = 0; first < m_lineItems.size();) {
+			size_t last = first;
+			while (last + 1 < m_lineItems.size() && m_lineIntervals[last + 1] == m_lineIntervals[first])
+				++last;
+			alignSegment(first, last, m_intervals[m_lineIntervals[first]], isLast);
+			first = last + 1;
+		}
+
+		for (auto i = m_lineItems.begin(); i != m_lineItems.end(); ++i) {
+			const Rect64F & rect = m_rects[*i];
+			m_rects[*i] = Rect64F(rect.getLeft(), m_top, rect.getWidth(), height);
+		}
+
+		m_top += height;
+		m_lineOpen = false;
+		m_lineItems.clear();
+
+		// The floats met within the line go below it
+		std::vector<size_t> pending;
+		std::swap(pending, m_pendingFloats);
+		for (auto i = pending.begin(); i != pending.end(); ++i)
+			placeFloat(*i);
+	}
+
+	void FlowLayout::placeInline(size_t item, size_t lastInline) {
+		if (!m_lineOpen)
+			openLine(item);
+
+		const double width = m_items[item].Size.width();
+		const double height = m_items[item].Size.height();
+
+		if (m_lineItems.empty()) {
+
+			// Move down until an interval is wide enough or no float is left
+			for (;;) {
+				getIntervals(m_top, m_top + height, m_intervals);
+				m_interval = 0;
+				while (m_interval < m_intervals.size() &&
+					m_intervals[m_interval].second - m_intervals[m_interval].first + EPSILON < width)
+					++m_interval;
+				if (m_interval < m_intervals.size())
+					break;
+
+				const double next = getNextFloatBottom(m_top, m_top + height);
+				if (std::isnan(next)) {
+					// Too wide for any line
+					m_intervals.assign(1, Interval(0, m_width));
+					m_interval = 0;
+					break;
+				}
+				m_top = next;
+			}
+			m_bandHeight = height;
+			m_cursor = m_intervals[m_interval].first;
+		}
+		else {
+
+			// A higher item may reach floats below the band
+			if (height > m_bandHeight) {
+				std::vector<Interval> intervals;
+				getIntervals(m_top, m_top + height, intervals);
+
+				std::vector<size_t> indexes;
+				if (!locate(intervals, indexes)) {
+					closeLine(lastInline);
+					placeInline(item, lastInline);
+					return;
+				}
+
+				m_intervals.swap(intervals);
+				m_lineIntervals.swap(indexes);
+				m_interval = m_lineIntervals.back();
+				m_bandHeight = height;
+			}
+
+			if (m_cursor + width > m_intervals[m_interval].second + EPSILON) {
+				size_t next = m_interval + 1;
+				while (next < m_intervals.size() &&
+					m_intervals[next].second - m_intervals[next].first + EPSILON < width)
+					++next;
+
+				if (next == m_intervals.size()) {
+					closeLine(lastInline);
+					placeInline(item, lastInline);
+					return;
+				}
+				m_interval = next;
+				m_cursor = m_intervals[next].first;
+			}
+		}
+
+		m_rects[item] = Rect64F(m_cursor, m_top, width, height);
+		m_cursor += width;
+		m_lineItems.push_back(item);
+		m_lineIntervals.push_back(m_interval);
+	}
+
+	void FlowLayout::placeFloat(size_t item) {
+		const FlowItem & flowItem = m_items[item];
+		const double width = flowItem.Size.width();
+		const double height = flowItem.Size.height();
+		double top = m_top;
+		Rect64F rect;
+
+		if (flowItem.Mode == PositionMode::FloatRow) {
+
+			// Below all floats
+			for (auto i = m_activeFloats.begin(); i != m_activeFloats.end(); ++i)
+				top = std::max(top, m_floats[*i].getBottom());
+			rect = Rect64F(0, top, std::isfinite(m_width) ? std::max(m_width, width) : width, height);
+		}
+		else {
+			const bool finite = std::isfinite(m_width);
+			const HorizontalAlignment side = finite ? flowItem.Side : HorizontalAlignment::Left;
+			std::vector<Interval> intervals;
+			double left = NAN;
+
+			for (;;) {
+				getIntervals(top, top + height, intervals);
+
+				if (side == HorizontalAlignment::Right) {
+					for (size_t i = intervals.size(); i > 0 && std::isnan(left); --i)
+						if (intervals[i - 1].second - intervals[i - 1].first + EPSILON >= width)
+							left = intervals[i - 1].second - width;
+				}
+				else if (side == HorizontalAlignment::Center) {
+					const double center = (m_width - width) / 2;
+					for (auto i = intervals.begin(); i != intervals.end() && std::isnan(left); ++i)
+						if (center + EPSILON >= i->first && center + width <= i->second + EPSILON)
+							left = center;
+				}
+				else {
+					for (auto i = intervals.begin(); i != intervals.end() && std::isnan(left); ++i)
+						if (i->second - i->first + EPSILON >= width)
+							left = i->first;
+				}
+				if (!std::isnan(left))
+					break;
+
+				const double next = getNextFloatBottom(top, top + height);
+				if (std::isnan(next)) {
+					left = 0;
+					break;
+				}
+				top = next;
+			}
+			rect = Rect64F(left, top, width, height);
+		}
+
+		m_rects[item] = rect;
+		m_activeFloats.push_back(m_floats.size());
+		m_floats.push_back(rect);
+	}
+
+	void FlowLayout::alignSegment(size_t first, size_t last, const Interval & interval, bool isLast) {
+		const size_t count = last - first + 1;
+		double used = 0;
+		for (size_t i = first; i <= last; ++i)
+			used += m_items[m_lineItems[i]].Size.width();
+
+		const double space = interval.second - interval.first - used;
+		if (!std::isfinite(space) || space <= 0)
+			return;
+
+		const bool justify = m_alignment == FlowAlignment::JustifyBoth ||
+			(!isLast && (m_alignment == FlowAlignment::JustifyLeft ||
+				m_alignment == FlowAlignment::JustifyCenter || m_alignment == FlowAlignment::JustifyRight));
+
+		double offset = 0, gap = 0;
+		if (justify && count > 1)
+			gap = space / (count - 1);
+		else if (m_alignment == FlowAlignment::Center || m_alignment == FlowAlignment::JustifyCenter)
+			offset = space / 2;
+		else if (m_alignment == FlowAlignment::Right || m_alignment == FlowAlignment::JustifyRight)
+			offset = space;
+
+		for (size_t i = first; i <= last; ++i) {
+			Rect64F & rect = m_rects[m_lineItems[i]];
+			rect = Rect64F(rect.getLeft() + offset + gap * (i - first), rect.getTop(), rect.getWidth(), rect.getHeight());
+		}
+	}
+
+	void FlowLayout::getIntervals(double top, double bottom, std::vector<Interval> & intervals) const {
+		intervals.assign(1, Interval(0, m_width));
+
+		std::vector<Interval> rest;
+		for (auto i = m_activeFloats.begin(); i != m_activeFloats.end(); ++i) {
+			const Rect64F & rect = m_floats[*i];
+			if (!overlaps(rect, top, bottom))
+				continue;
+
+			// Cut the float out of the intervals
+			rest.clear();
+			for (auto j = intervals.begin(); j != intervals.end(); ++j) {
+				if (j->second <= rect.getLeft() || j->first >= rect.getRight()) {
+					rest.push_back(*j);
+					continue;
+				}
+				if (j->first < rect.getLeft())
+					rest.push_back(Interval(j->first, rect.getLeft()));
+				if (j->second > rect.getRight())
+					rest.push_back(Interval(rect.getRight(), j->second));
+			}
+			intervals.swap(rest);
+		}
+	}
+
+	double FlowLayout::getNextFloatBottom(double top, double bottom) const {
+		double result = NAN;
+		for (auto i = m_activeFloats.begin(); i != m_activeFloats.end(); ++i) {
+			const Rect64F & rect = m_floats[*i];
+			if (overlaps(rect, top, bottom) && !(rect.getBottom() >= result))
+				result = rect.getBottom();
+		}
+		return result;
+	}
+
+	bool FlowLayout::locate(const std::vector<Interval> & intervals, std::vector<size_t> & indexes) const {
+		indexes.clear();
+		size_t interval = 0;
+		for (auto i = m_lineItems.begin(); i != m_lineItems.end(); ++i) {
+			const Rect64F & rect = m_rects[*i];
+			while (interval < intervals.size() && intervals[interval].second + EPSILON < rect.getRight())
+				++interval;
+			if (interval == intervals.size() || intervals[interval].first > rect.getLeft() + EPSILON)
+				return false;
+			indexes.push_back(interval);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,148 @@
+/* Copyright (C) Hao Qin. All rights reserved. */
+
+#pragma once
+
+#include "../../common.h"
+#include "Layout.h"
+
+#include <utility>
+#include <vector>
+
+namespace v2x {
+
+	/// An item placed by FlowLayout
+	class FlowItem {
+	public:
+		FlowItem();
+		FlowItem(const Size2D64F & size, PositionMode mode = PositionMode::Inline,
+			HorizontalAlignment side = HorizontalAlignment::Left);
+
+		/// The size including the margins
+		Size2D64F Size;
+		PositionMode Mode;
+		/// The side of FloatSurround items. Stretch means left.
+		HorizontalAlignment Side;
+
+		bool operator == (const FlowItem & item) const;
+		bool operator != (const FlowItem & item) const;
+	};
+
+	/// This class places items into lines like text.
+	///
+	/// It works in logical coordinates: the lines run from the left (0) to the
+	/// right (the width) and follow each other downwards. getItemRect() maps
+	/// them to a FlowDirection.
+	///
+	/// - Inline items fill the lines. A line ends before the first item which
+	///   does not fit. Items wider than the width get a line of their own.
+	/// - FloatSurround items are placed on their side at the top of the line
+	///   in progress if it is still empty, otherwise below it. The lines make
+	///   way for them: the free intervals besides the floats are filled one
+	///   after another.
+	/// - FloatRow items take the whole width below the line in progress.
+	/// - FloatBack and FloatFront items are not part of the flow. They cover
+	///   the whole area.
+	///
+	/// The alignment applies to each free interval of a line separately.
+	/// Justified lines distribute the remaining space between their items.
+	/// In an infinite width all items are aligned left.
+	///
+	/// Each item is placed in constant time apart from the floats besides its
+	/// line. Placing changed items again starts at the line of the first
+	/// change; the lines before are kept. The items are either given as a
+	/// whole, which compares them to the previous ones, or changed one by
+	/// one, so that an unchanged flow costs nothing.
+	///
+	class FlowLayout {
+	public:
+		FlowLayout();
+
+		/// Place the items within a width. Returns the index of the first
+		/// item placed again, which is the number of items if nothing changed.
+		size_t update(const std::vector<FlowItem> & items, double width, FlowAlignment alignment);
+		/// Place the items changed since the last update within a width
+		size_t update(double width, FlowAlignment alignment);
+		void clear();
+
+		/// Change the items, which are placed by the next update()
+		void setItem(size_t index, const FlowItem & item);
+		void insertItems(size_t index, size_t count, const FlowItem & item = FlowItem());
+		void removeItems(size_t index, size_t count);
+		void moveItems(size_t index, size_t count, size_t newIndex);
+
+		size_t getItemCount() const;
+		const FlowItem & getItem(size_t index) const;
+		/// The logical rectangle of an item. Inline items get the height of
+		/// their line.
+		const Rect64F & getItemRect(size_t index) const;
+		/// The rectangle of an item within an area of a size
+		Rect64F getItemRect(size_t index, const Size2D64F & size, FlowDirection direction) const;
+
+		/// Returns the size of the content. The width is that of the lines
+		/// aligned left.
+		Size2D64F getContentSize() const;
+		size_t getLineCount() const;
+
+	private:
+		typedef std::pair<double, double> Interval;
+
+		/// A line and the state of the layout where it starts
+		class Line {
+		public:
+			size_t FirstItem;
+			/// The number of floats placed before the line
+			size_t FloatCount;
+			/// The position where the line has been started
+			double Start;
+			/// The final position, which may be below the start because of
+			/// floats
+			double Top;
+			double Height;
+			/// The width of the items when aligned left
+			double Extent;
+		};
+
+		std::vector<FlowItem> m_items;
+		double m_width;
+		FlowAlignment m_alignment;
+		/// The first item changed since the last update
+		bool m_isChanged;
+		size_t m_firstChange;
+
+		std::vector<Rect64F> m_rects;
+		std::vector<Line> m_lines;
+		/// The rectangles of the FloatSurround and FloatRow items
+		std::vector<Rect64F> m_floats;
+		/// The floats which may reach the line in progress or below
+		std::vector<size_t> m_activeFloats;
+		Size2D64F m_contentSize;
+
+		/// The state of the line in progress
+		double m_top;
+		double m_bandHeight;
+		std::vector<Interval> m_intervals;
+		size_t m_interval;
+		double m_cursor;
+		std::vector<size_t> m_lineItems;
+		/// The interval of each item of the line
+		std::vector<size_t> m_lineIntervals;
+		std::vector<size_t> m_pendingFloats;
+		bool m_lineOpen;
+
+		void markChanged(size_t item);
+
+		void openLine(size_t item);
+		void closeLine(size_t lastInline);
+		void placeInline(size_t item, size_t lastInline);
+		void placeFloat(size_t item);
+		void alignSegment(size_t first, size_t last, const Interval & interval, bool isLast);
+
+		/// Returns the free intervals within a band
+		void getIntervals(double top, double bottom, std::vector<Interval> & intervals) const;
+		/// Returns the next bottom of a float within a band or NAN
+		double getNextFloatBottom(double top, double bottom) const;
+		/// Find the interval of each item of the line. Returns false if an
+		/// item is not within the intervals.
+		bool locate(const std::vector<Interval> & intervals, std::vector<size_t> & indexes) const;
+	};
+}
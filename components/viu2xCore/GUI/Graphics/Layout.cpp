@@ -2,23 +2,33 @@
 
 #include "Layout.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace v2x {
 
+	namespace {
+
+		double orDefault(double value, double defaultValue) {
+			return std::isnan(value) ? defaultValue : value;
+		}
+	}
+
 	////////////////
 	// ScalarSpec //
 	////////////////
 
-	ScalarSpec::ScalarSpec(const Listener & listener) : //
-		Notifier<ScalarSpec>(listener), Size(m_memberChangeListener), Unit(m_memberChangeListener) {}
+	ScalarSpec::ScalarSpec(const SpecOwner & owner) : //
+		CompositeSpec(owner), Size(member(Field::Size)), Unit(member(Field::Unit)) {}
 
-	ScalarSpec::ScalarSpec(const ScalarSpec & sizeSpec, const Listener & listener) : //
-		Notifier<ScalarSpec>(listener), Size(sizeSpec.Size, m_memberChangeListener), Unit(sizeSpec.Unit, m_memberChangeListener) {}
+	ScalarSpec::ScalarSpec(const ScalarSpec & sizeSpec, const SpecOwner & owner) : //
+		CompositeSpec(sizeSpec, owner), Size(sizeSpec.Size, member(Field::Size)), Unit(sizeSpec.Unit, member(Field::Unit)) {}
 
-	ScalarSpec::ScalarSpec(const double & size, const Listener & listener) : //
-		Notifier<ScalarSpec>(listener), Size(size, m_memberChangeListener), Unit(ScalarUnit::Pixel, m_memberChangeListener) {}
+	ScalarSpec::ScalarSpec(const double & size, const SpecOwner & owner) : //
+		CompositeSpec(owner), Size(size, member(Field::Size)), Unit(ScalarUnit::Pixel, member(Field::Unit)) {}
 
-	ScalarSpec::ScalarSpec(const double & size, const ScalarUnit & unit, const Listener & listener) : //
-		Notifier<ScalarSpec>(listener), Size(size, m_memberChangeListener), Unit(unit, m_memberChangeListener) {}
+	ScalarSpec::ScalarSpec(const double & size, const ScalarUnit & unit, const SpecOwner & owner) : //
+		CompositeSpec(owner), Size(size, member(Field::Size)), Unit(unit, member(Field::Unit)) {}
 
 	ScalarSpec::~ScalarSpec() {}
 
@@ -32,19 +42,34 @@ namespace v2x {
 
 	bool ScalarSpec::operator == (const ScalarSpec & value) const { return Size == value.Size && Unit == value.Unit; }
 	bool ScalarSpec::operator != (const ScalarSpec & value) const { return Size != value.Size || Unit != value.Unit; }
+	size_t ScalarSpec::hash() const {
+		size_t result;
+		if (getCachedHash(result))
+			return result;
+
+		result = Size.hash();
+		result = hashCombine(result, Unit.hash());
+		return setCachedHash(result);
+	}
+	uint32_t ScalarSpec::diff(const ScalarSpec & value) const {
+		uint32_t result = 0;
+		if (Size != value.Size) result |= fieldBit(Field::Size);
+		if (Unit != value.Unit) result |= fieldBit(Field::Unit);
+		return result;
+	}
 
 	//////////////////
 	// Vector2DSpec //
 	//////////////////
 
-	Vector2DSpec::Vector2DSpec(const Listener & listener) : //
-		Notifier<Vector2DSpec>(listener), X(m_memberChangeListener), Y(m_memberChangeListener), Unit(m_memberChangeListener) {}
-	Vector2DSpec::Vector2DSpec(const Vector2DSpec & vector2DSpec, const Listener & listener) : //
-		Notifier<Vector2DSpec>(listener), X(vector2DSpec.X, m_memberChangeListener), Y(vector2DSpec.Y, m_memberChangeListener), Unit(vector2DSpec.Unit, m_memberChangeListener) {}
-	Vector2DSpec::Vector2DSpec(const double & x, const double & y, const Listener & listener) : //
-		Notifier<Vector2DSpec>(listener), X(x, m_memberChangeListener), Y(y, m_memberChangeListener), Unit(ScalarUnit::Pixel, m_memberChangeListener) {}
-	Vector2DSpec::Vector2DSpec(const double & x, const double & y, const ScalarUnit & unit, const Listener & listener) : //
-		Notifier<Vector2DSpec>(listener), X(x, m_memberChangeListener), Y(y, m_memberChangeListener), Unit(unit, m_memberChangeListener) {}
+	Vector2DSpec::Vector2DSpec(const SpecOwner & owner) : //
+		CompositeSpec(owner), X(member(Field::X)), Y(member(Field::Y)), Unit(member(Field::Unit)) {}
+	Vector2DSpec::Vector2DSpec(const Vector2DSpec & vector2DSpec, const SpecOwner & owner) : //
+		CompositeSpec(vector2DSpec, owner), X(vector2DSpec.X, member(Field::X)), Y(vector2DSpec.Y, member(Field::Y)), Unit(vector2DSpec.Unit, member(Field::Unit)) {}
+	Vector2DSpec::Vector2DSpec(const double & x, const double & y, const SpecOwner & owner) : //
+		CompositeSpec(owner), X(x, member(Field::X)), Y(y, member(Field::Y)), Unit(ScalarUnit::Pixel, member(Field::Unit)) {}
+	Vector2DSpec::Vector2DSpec(const double & x, const double & y, const ScalarUnit & unit, const SpecOwner & owner) : //
+		CompositeSpec(owner), X(x, member(Field::X)), Y(y, member(Field::Y)), Unit(unit, member(Field::Unit)) {}
 	Vector2DSpec::~Vector2DSpec() {}
 
 	Vector2DSpec & Vector2DSpec::operator = (const Vector2DSpec & value) {
@@ -61,19 +86,36 @@ namespace v2x {
 	bool Vector2DSpec::operator != (const Vector2DSpec & value) const {
 		return X != value.X || Y != value.Y || Unit != value.Unit;
 	}
+	size_t Vector2DSpec::hash() const {
+		size_t result;
+		if (getCachedHash(result))
+			return result;
+
+		result = X.hash();
+		result = hashCombine(result, Y.hash());
+		result = hashCombine(result, Unit.hash());
+		return setCachedHash(result);
+	}
+	uint32_t Vector2DSpec::diff(const Vector2DSpec & value) const {
+		uint32_t result = 0;
+		if (X != value.X) result |= fieldBit(Field::X);
+		if (Y != value.Y) result |= fieldBit(Field::Y);
+		if (Unit != value.Unit) result |= fieldBit(Field::Unit);
+		return result;
+	}
 
 	////////////////
 	// MarginSpec //
 	////////////////
 
-	MarginSpec::MarginSpec(const Listener & listener) :
-		Notifier<MarginSpec>(listener), Left(m_memberChangeListener), Top(m_memberChangeListener), Right(m_memberChangeListener), Bottom(m_memberChangeListener) {}
-	MarginSpec::MarginSpec(const MarginSpec & marginSpec, const Listener & listener) :
-		Notifier<MarginSpec>(listener), Left(marginSpec.Left, m_memberChangeListener), Top(marginSpec.Top, m_memberChangeListener), Right(marginSpec.Right, m_memberChangeListener), Bottom(marginSpec.Bottom, m_memberChangeListener) {}
-	MarginSpec::MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const Listener & listener) :
-		Notifier<MarginSpec>(listener), Left(left, m_memberChangeListener), Top(top, m_memberChangeListener), Right(right, m_memberChangeListener), Bottom(bottom, m_memberChangeListener){}
-	MarginSpec::MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const ScalarUnit & unit, const Listener & listener) :
-		Notifier<MarginSpec>(listener), Left(left, m_memberChangeListener), Top(top, m_memberChangeListener), Right(right, m_memberChangeListener), Bottom(bottom, m_memberChangeListener){}
+	MarginSpec::MarginSpec(const SpecOwner & owner) :
+		CompositeSpec(owner), Left(member(Field::Left)), Top(member(Field::Top)), Right(member(Field::Right)), Bottom(member(Field::Bottom)) {}
+	MarginSpec::MarginSpec(const MarginSpec & marginSpec, const SpecOwner & owner) :
+		CompositeSpec(marginSpec, owner), Left(marginSpec.Left, member(Field::Left)), Top(marginSpec.Top, member(Field::Top)), Right(marginSpec.Right, member(Field::Right)), Bottom(marginSpec.Bottom, member(Field::Bottom)) {}
+	MarginSpec::MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const SpecOwner & owner) :
+		CompositeSpec(owner), Left(left, member(Field::Left)), Top(top, member(Field::Top)), Right(right, member(Field::Right)), Bottom(bottom, member(Field::Bottom)){}
+	MarginSpec::MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const ScalarUnit & unit, const SpecOwner & owner) :
+		CompositeSpec(owner), Left(left, unit, member(Field::Left)), Top(top, unit, member(Field::Top)), Right(right, unit, member(Field::Right)), Bottom(bottom, unit, member(Field::Bottom)){}
 	MarginSpec::~MarginSpec() {}
 
 	MarginSpec & MarginSpec::operator = (const MarginSpec & value) {
@@ -97,25 +139,44 @@ namespace v2x {
 			Right != value.Right ||
 			Bottom != value.Bottom;
 	}
+	size_t MarginSpec::hash() const {
+		size_t result;
+		if (getCachedHash(result))
+			return result;
+
+		result = Left.hash();
+		result = hashCombine(result, Top.hash());
+		result = hashCombine(result, Right.hash());
+		result = hashCombine(result, Bottom.hash());
+		return setCachedHash(result);
+	}
+	uint32_t MarginSpec::diff(const MarginSpec & value) const {
+		uint32_t result = 0;
+		if (Left != value.Left) result |= fieldBit(Field::Left);
+		if (Top != value.Top) result |= fieldBit(Field::Top);
+		if (Right != value.Right) result |= fieldBit(Field::Right);
+		if (Bottom != value.Bottom) result |= fieldBit(Field::Bottom);
+		return result;
+	}
 
 	////////////////
 	// LayoutSpec //
 	////////////////
 
-	LayoutSpec::LayoutSpec(const Listener & listener) :
-		Notifier<LayoutSpec>(listener), //
-		Width(m_memberChangeListener), Height(m_memberChangeListener), //
-		MinWidth(m_memberChangeListener), MinHeight(m_memberChangeListener), //
-		MaxWidth(m_memberChangeListener), MaxHeight(m_memberChangeListener), //
-		Margin(m_memberChangeListener), PositionMode(m_memberChangeListener), //
-		HorizontalAlignment(m_memberChangeListener), VerticalAlignment(m_memberChangeListener) {}
-	LayoutSpec::LayoutSpec(const LayoutSpec & layoutSpec, const Listener & listener) :
-		Notifier<LayoutSpec>(listener), //
-		Width(layoutSpec.Width, m_memberChangeListener), Height(layoutSpec.Height, m_memberChangeListener), //
-		MinWidth(layoutSpec.MinWidth, m_memberChangeListener), MinHeight(layoutSpec.MinHeight, m_memberChangeListener), //
-		MaxWidth(layoutSpec.MaxWidth, m_memberChangeListener), MaxHeight(layoutSpec.MaxHeight, m_memberChangeListener), //
-		Margin(layoutSpec.Margin, m_memberChangeListener), PositionMode(layoutSpec.PositionMode, m_memberChangeListener), //
-		HorizontalAlignment(layoutSpec.HorizontalAlignment, m_memberChangeListener), VerticalAlignment(layoutSpec.VerticalAlignment, m_memberChangeListener) {}
+	LayoutSpec::LayoutSpec(const SpecOwner & owner) :
+		CompositeSpec(owner), //
+		Width(member(Field::Width)), Height(member(Field::Height)), //
+		MinWidth(member(Field::MinWidth)), MinHeight(member(Field::MinHeight)), //
+		MaxWidth(member(Field::MaxWidth)), MaxHeight(member(Field::MaxHeight)), //
+		Margin(member(Field::Margin)), PositionMode(member(Field::PositionMode)), //
+		HorizontalAlignment(member(Field::HorizontalAlignment)), VerticalAlignment(member(Field::VerticalAlignment)) {}
+	LayoutSpec::LayoutSpec(const LayoutSpec & layoutSpec, const SpecOwner & owner) :
+		CompositeSpec(layoutSpec, owner), //
+		Width(layoutSpec.Width, member(Field::Width)), Height(layoutSpec.Height, member(Field::Height)), //
+		MinWidth(layoutSpec.MinWidth, member(Field::MinWidth)), MinHeight(layoutSpec.MinHeight, member(Field::MinHeight)), //
+		MaxWidth(layoutSpec.MaxWidth, member(Field::MaxWidth)), MaxHeight(layoutSpec.MaxHeight, member(Field::MaxHeight)), //
+		Margin(layoutSpec.Margin, member(Field::Margin)), PositionMode(layoutSpec.PositionMode, member(Field::PositionMode)), //
+		HorizontalAlignment(layoutSpec.HorizontalAlignment, member(Field::HorizontalAlignment)), VerticalAlignment(layoutSpec.VerticalAlignment, member(Field::VerticalAlignment)) {}
 	LayoutSpec::~LayoutSpec() {}
 
 	LayoutSpec & LayoutSpec::operator = (const LayoutSpec & value) {
@@ -134,6 +195,9 @@ namespace v2x {
 		return *this;
 	}
 	bool LayoutSpec::operator == (const LayoutSpec & value) const {
+		// Different hashes reject most unequal values quickly
+		if (hash() != value.hash())
+			return false;
 		return Width == value.Width &&
 			Height == value.Height &&
 			MinWidth == value.MinWidth &&
@@ -157,16 +221,47 @@ namespace v2x {
 			HorizontalAlignment != value.HorizontalAlignment ||
 			VerticalAlignment != value.VerticalAlignment;
 	}
+	size_t LayoutSpec::hash() const {
+		size_t result;
+		if (getCachedHash(result))
+			return result;
+
+		result = Width.hash();
+		result = hashCombine(result, Height.hash());
+		result = hashCombine(result, MinWidth.hash());
+		result = hashCombine(result, MinHeight.hash());
+		result = hashCombine(result, MaxWidth.hash());
+		result = hashCombine(result, MaxHeight.hash());
+		result = hashCombine(result, Margin.hash());
+		result = hashCombine(result, PositionMode.hash());
+		result = hashCombine(result, HorizontalAlignment.hash());
+		result = hashCombine(result, VerticalAlignment.hash());
+		return setCachedHash(result);
+	}
+	uint32_t LayoutSpec::diff(const LayoutSpec & value) const {
+		uint32_t result = 0;
+		if (Width != value.Width) result |= fieldBit(Field::Width);
+		if (Height != value.Height) result |= fieldBit(Field::Height);
+		if (MinWidth != value.MinWidth) result |= fieldBit(Field::MinWidth);
+		if (MinHeight != value.MinHeight) result |= fieldBit(Field::MinHeight);
+		if (MaxWidth != value.MaxWidth) result |= fieldBit(Field::MaxWidth);
+		if (MaxHeight != value.MaxHeight) result |= fieldBit(Field::MaxHeight);
+		if (Margin != value.Margin) result |= fieldBit(Field::Margin);
+		if (PositionMode != value.PositionMode) result |= fieldBit(Field::PositionMode);
+		if (HorizontalAlignment != value.HorizontalAlignment) result |= fieldBit(Field::HorizontalAlignment);
+		if (VerticalAlignment != value.VerticalAlignment) result |= fieldBit(Field::VerticalAlignment);
+		return result;
+	}
 
 	///////////////////////
 	// ContentLayoutSpec //
 	///////////////////////
 
-	ContentLayoutSpec::ContentLayoutSpec(const Listener & listener) :
-		Notifier<ContentLayoutSpec>(listener), Padding(m_memberChangeListener), FlowAlignment(m_memberChangeListener), FlowDirection(m_memberChangeListener) {}
-	ContentLayoutSpec::ContentLayoutSpec(const ContentLayoutSpec & contentLayoutSpec, const Listener & listener) :
-		Notifier<ContentLayoutSpec>(listener), Padding(contentLayoutSpec.Padding, m_memberChangeListener), //
-		FlowAlignment(contentLayoutSpec.FlowAlignment, m_memberChangeListener), FlowDirection(contentLayoutSpec.FlowDirection, m_memberChangeListener){}
+	ContentLayoutSpec::ContentLayoutSpec(const SpecOwner & owner) :
+		CompositeSpec(owner), Padding(member(Field::Padding)), FlowAlignment(member(Field::FlowAlignment)), FlowDirection(member(Field::FlowDirection)) {}
+	ContentLayoutSpec::ContentLayoutSpec(const ContentLayoutSpec & contentLayoutSpec, const SpecOwner & owner) :
+		CompositeSpec(contentLayoutSpec, owner), Padding(contentLayoutSpec.Padding, member(Field::Padding)), //
+		FlowAlignment(contentLayoutSpec.FlowAlignment, member(Field::FlowAlignment)), FlowDirection(contentLayoutSpec.FlowDirection, member(Field::FlowDirection)){}
 	ContentLayoutSpec::~ContentLayoutSpec() {}
 
 	ContentLayoutSpec & ContentLayoutSpec::operator = (const ContentLayoutSpec & value) {
@@ -178,6 +273,9 @@ namespace v2x {
 		return *this;
 	}
 	bool ContentLayoutSpec::operator == (const ContentLayoutSpec & value) const {
+		// Different hashes reject most unequal values quickly
+		if (hash() != value.hash())
+			return false;
 		return Padding == value.Padding &&
 			FlowAlignment == value.FlowAlignment &&
 			FlowDirection == value.FlowDirection;
@@ -187,6 +285,107 @@ namespace v2x {
 			FlowAlignment != value.FlowAlignment ||
 			FlowDirection != value.FlowDirection;
 	}
+	size_t ContentLayoutSpec::hash() const {
+		size_t result;
+		if (getCachedHash(result))
+			return result;
+
+		result = Padding.hash();
+		result = hashCombine(result, FlowAlignment.hash());
+		result = hashCombine(result, FlowDirection.hash());
+		return setCachedHash(result);
+	}
+	uint32_t ContentLayoutSpec::diff(const ContentLayoutSpec & value) const {
+		uint32_t result = 0;
+		if (Padding != value.Padding) result |= fieldBit(Field::Padding);
+		if (FlowAlignment != value.FlowAlignment) result |= fieldBit(Field::FlowAlignment);
+		if (FlowDirection != value.FlowDirection) result |= fieldBit(Field::FlowDirection);
+		return result;
+	}
+
+	////////////////////
+	// ResolvedMargin //
+	////////////////////
+
+	Rect64F ResolvedMargin::deflate(const Size2D64F & size) const {
+		return Rect64F(Left, Top,
+			std::max(0.0, size.width() - Left - Right),
+			std::max(0.0, size.height() - Top - Bottom));
+	}
+
+	/////////////////
+	// LayoutUnits //
+	/////////////////
+
+	LayoutUnits::LayoutUnits(double dpi) : m_dpi(dpi) {
+		m_factors[(size_t)ScalarUnit::Pixel] = 1;
+		// A dot is a typographic point of 1/72 inch
+		m_factors[(size_t)ScalarUnit::Dot] = dpi / 72;
+		m_factors[(size_t)ScalarUnit::Millimeter] = dpi / 25.4;
+		m_factors[(size_t)ScalarUnit::Parent] = 0.01;
+		m_factors[(size_t)ScalarUnit::Relative] = 1;
+	}
+
+	double LayoutUnits::getDpi() const { return m_dpi; }
+
+	double LayoutUnits::toPixels(const ScalarSpec & size, double reference) const {
+		if (!size.Size.isSet())
+			return NAN;
+		return toPixels(size.Size.get(), size.Unit.isSet() ? size.Unit.get() : ScalarUnit::Pixel, reference);
+	}
+
+	double LayoutUnits::toPixels(double size, ScalarUnit unit, double reference) const {
+		if ((size_t)unit >= sizeof(m_factors) / sizeof(m_factors[0]))
+			return NAN;
+
+		const double pixels = size * m_factors[(size_t)unit];
+		if (unit == ScalarUnit::Parent || unit == ScalarUnit::Relative)
+			return std::isfinite(reference) ? pixels * reference : NAN;
+		return pixels;
+	}
+
+	ResolvedMargin LayoutUnits::resolve(const MarginSpec & margin, const Size2D64F & reference) const {
+		ResolvedMargin result;
+		result.Left = orDefault(toPixels(margin.Left, reference.width()), 0);
+		result.Top = orDefault(toPixels(margin.Top, reference.height()), 0);
+		result.Right = orDefault(toPixels(margin.Right, reference.width()), 0);
+		result.Bottom = orDefault(toPixels(margin.Bottom, reference.height()), 0);
+		return result;
+	}
+
+	ResolvedLayout LayoutUnits::resolve(const LayoutSpec & layout, const Size2D64F & reference) const {
+		ResolvedLayout result;
+		result.Margin = resolve(layout.Margin, reference);
+		result.Width = toPixels(layout.Width, reference.width());
+		result.Height = toPixels(layout.Height, reference.height());
+		result.MinWidth = orDefault(toPixels(layout.MinWidth, reference.width()), 0);
+		result.MinHeight = orDefault(toPixels(layout.MinHeight, reference.height()), 0);
+		result.MaxWidth = orDefault(toPixels(layout.MaxWidth, reference.width()), INFINITY);
+		result.MaxHeight = orDefault(toPixels(layout.MaxHeight, reference.height()), INFINITY);
+		return result;
+	}
+
+	bool LayoutUnits::dependsOnDpi(const ScalarSpec & size) {
+		if (!size.Size.isSet() || !size.Unit.isSet())
+			return false;
+		return size.Unit.get() == ScalarUnit::Dot || size.Unit.get() == ScalarUnit::Millimeter;
+	}
+
+	bool LayoutUnits::dependsOnDpi(const MarginSpec & margin) {
+		return dependsOnDpi(margin.Left) || dependsOnDpi(margin.Top) ||
+			dependsOnDpi(margin.Right) || dependsOnDpi(margin.Bottom);
+	}
+
+	bool LayoutUnits::dependsOnDpi(const LayoutSpec & layout) {
+		return dependsOnDpi(layout.Width) || dependsOnDpi(layout.Height) ||
+			dependsOnDpi(layout.MinWidth) || dependsOnDpi(layout.MinHeight) ||
+			dependsOnDpi(layout.MaxWidth) || dependsOnDpi(layout.MaxHeight) ||
+			dependsOnDpi(layout.Margin);
+	}
+
+	bool LayoutUnits::operator == (const LayoutUnits & units) const { return m_dpi == units.m_dpi; }
+
+	bool LayoutUnits::operator != (const LayoutUnits & units) const { return m_dpi != units.m_dpi; }
 
 	//////////////  
 	// FontSpec //
@@ -194,14 +393,14 @@ namespace v2x {
 
 
 
-	FontSpec::FontSpec(const Listener & listener) :
-		Notifier<FontSpec>(listener), Name(m_memberChangeListener), Size(m_memberChangeListener), Styles(m_memberChangeListener) {}
-	FontSpec::FontSpec(const FontSpec & fontSpec, const Listener & listener) :
-		Notifier<FontSpec>(listener), Name(fontSpec.Name.get(), m_memberChangeListener), Size(11, ScalarUnit::Dot, m_memberChangeListener), Styles(m_memberChangeListener) {}
-	FontSpec::FontSpec(const String & fontName, const double & size, const FontStyles & styles, const Listener & listener) :
-		Notifier<FontSpec>(listener), Name(fontName, m_memberChangeListener), Size(size, ScalarUnit::Dot, m_memberChangeListener), Styles(styles, m_memberChangeListener) {}
-	FontSpec::FontSpec(const String & fontName, const double & size, const ScalarUnit & unit, const FontStyles & styles, const Listener & listener) :
-		Notifier<FontSpec>(listener), Name(fontName, m_memberChangeListener), Size(size, unit, m_memberChangeListener), Styles(styles, m_memberChangeListener) {}
+	FontSpec::FontSpec(const SpecOwner & owner) :
+		CompositeSpec(owner), Name(member(Field::Name)), Size(member(Field::Size)), Styles(member(Field::Styles)) {}
+	FontSpec::FontSpec(const FontSpec & fontSpec, const SpecOwner & owner) :
+		CompositeSpec(fontSpec, owner), Name(fontSpec.Name, member(Field::Name)), Size(fontSpec.Size, member(Field::Size)), Styles(fontSpec.Styles, member(Field::Styles)) {}
+	FontSpec::FontSpec(const Atom & fontName, const double & size, const FontStyles & styles, const SpecOwner & owner) :
+		CompositeSpec(owner), Name(fontName, member(Field::Name)), Size(size, ScalarUnit::Dot, member(Field::Size)), Styles(styles, member(Field::Styles)) {}
+	FontSpec::FontSpec(const Atom & fontName, const double & size, const ScalarUnit & unit, const FontStyles & styles, const SpecOwner & owner) :
+		CompositeSpec(owner), Name(fontName, member(Field::Name)), Size(size, unit, member(Field::Size)), Styles(styles, member(Field::Styles)) {}
 	FontSpec::~FontSpec() {}
 
 	FontSpec & FontSpec::operator = (const FontSpec & value) {
@@ -213,6 +412,9 @@ namespace v2x {
 		return *this;
 	}
 	bool FontSpec::operator == (const FontSpec & value) const {
+		// Different hashes reject most unequal values quickly
+		if (hash() != value.hash())
+			return false;
 		return Name == value.Name &&
 			Size == value.Size &&
 			Styles == value.Styles;
@@ -222,4 +424,21 @@ namespace v2x {
 			Size != value.Size ||
 			Styles != value.Styles;
 	}
+	size_t FontSpec::hash() const {
+		size_t result;
+		if (getCachedHash(result))
+			return result;
+
+		result = Name.hash();
+		result = hashCombine(result, Size.hash());
+		result = hashCombine(result, Styles.hash());
+		return setCachedHash(result);
+	}
+	uint32_t FontSpec::diff(const FontSpec & value) const {
+		uint32_t result = 0;
+		if (Name != value.Name) result |= fieldBit(Field::Name);
+		if (Size != value.Size) result |= fieldBit(Field::Size);
+		if (Styles != value.Styles) result |= fieldBit(Field::Styles);
+		return result;
+	}
 }
\ No newline at end of file
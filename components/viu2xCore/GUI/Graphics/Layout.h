@@ -23,11 +23,11 @@ namespace v2x {
 		Right,
 	};
 
-	std::vector<const Char *> EnumString<HorizontalAlignment>::m_strings = {
+	DEFINE_ENUM_STRINGS(HorizontalAlignment,
 		L"Stretch",
 		L"Left",
 		L"Center",
-		L"Right" };
+		L"Right");
 
 	typedef SimpleSpec<HorizontalAlignment> HorizontalAlignmentSpec;
 
@@ -48,11 +48,11 @@ namespace v2x {
 		Bottom,
 	};
 
-	std::vector<const Char *> EnumString<VerticalAlignment>::m_strings = {
+	DEFINE_ENUM_STRINGS(VerticalAlignment,
 		L"Stretch",
 		L"Top",
 		L"Middle",
-		L"Bottom" };
+		L"Bottom");
 
 	typedef SimpleSpec<VerticalAlignment> VerticalAlignmentSpec;
 
@@ -84,14 +84,14 @@ namespace v2x {
 		JustifyBoth,
 	};
 
-	std::vector<const Char *> EnumString<FlowAlignment>::m_strings = {
+	DEFINE_ENUM_STRINGS(FlowAlignment,
 		L"Left",
 		L"Center",
 		L"Right",
 		L"JustifyLeft",
 		L"JustifyCenter",
 		L"JustifyRight",
-		L"JustifyBoth" };
+		L"JustifyBoth");
 
 	typedef SimpleSpec<FlowAlignment> FlowAlignmentSpec;
 
@@ -103,11 +103,11 @@ namespace v2x {
 		BottomRightToTopLeft,
 	};
 
-	std::vector<const Char *> EnumString<FlowDirection>::m_strings = {
+	DEFINE_ENUM_STRINGS(FlowDirection,
 		L"TopLeftToBottomRight",
 		L"TopRightToBottomLeft",
 		L"BottomLeftToTopRight",
-		L"BottomRightToTopLeft" };
+		L"BottomRightToTopLeft");
 
 	typedef SimpleSpec<FlowDirection> FlowDirectionSpec;
 
@@ -130,22 +130,25 @@ namespace v2x {
 		Relative,
 	};
 
-	std::vector<const Char *> EnumString<ScalarUnit>::m_strings = {
+	DEFINE_ENUM_STRINGS(ScalarUnit,
 		L"Pixel",
 		L"Dot",
 		L"Millimeter",
 		L"Parent",
-		L"Relative" };
+		L"Relative");
 
 	typedef SimpleSpec<ScalarUnit> ScalarUnitSpec;
 
-	class ScalarSpec : public Specification, public Notifier < ScalarSpec > {
+	class ScalarSpec : public CompositeSpec {
 	public:
-		ScalarSpec(const Listener & listener = nullptr);
-		ScalarSpec(const ScalarSpec & sizeSpec, const Listener & listener = nullptr);
-		ScalarSpec(const double & size, const Listener & listener = nullptr);
-		ScalarSpec(const double & size, const ScalarUnit & unit, const Listener & listener = nullptr);
-		virtual ~ScalarSpec();
+		/// The member fields of ScalarSpec
+		enum class Field : uint8_t { Size, Unit };
+
+		ScalarSpec(const SpecOwner & owner = SpecOwner());
+		ScalarSpec(const ScalarSpec & sizeSpec, const SpecOwner & owner = SpecOwner());
+		ScalarSpec(const double & size, const SpecOwner & owner = SpecOwner());
+		ScalarSpec(const double & size, const ScalarUnit & unit, const SpecOwner & owner = SpecOwner());
+		~ScalarSpec();
 
 		NumberSpec Size;
 		ScalarUnitSpec Unit;
@@ -153,6 +156,11 @@ namespace v2x {
 		ScalarSpec & operator = (const ScalarSpec & value);
 		bool operator == (const ScalarSpec & value) const;
 		bool operator != (const ScalarSpec & value) const;
+
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const;
+		/// Returns the mask of the fields which differ from value.
+		uint32_t diff(const ScalarSpec & value) const;
 	};
 
 	/// A specification of control sizes consisting of a value and a unit.
@@ -161,14 +169,17 @@ namespace v2x {
 	/// This class should be used as a value-type.
 	typedef ScalarSpec SizeSpec;
 
-	class Vector2DSpec : public Specification, public Notifier < Vector2DSpec > {
+	class Vector2DSpec : public CompositeSpec {
 
 	public:
-		Vector2DSpec(const Listener & listener = nullptr);
-		Vector2DSpec(const Vector2DSpec & vector2DSpec, const Listener & listener = nullptr);
-		Vector2DSpec(const double & x, const double & y, const Listener & listener = nullptr);
-		Vector2DSpec(const double & x, const double & y, const ScalarUnit & unit, const Listener & listener = nullptr);
-		virtual ~Vector2DSpec();
+		/// The member fields of Vector2DSpec
+		enum class Field : uint8_t { X, Y, Unit };
+
+		Vector2DSpec(const SpecOwner & owner = SpecOwner());
+		Vector2DSpec(const Vector2DSpec & vector2DSpec, const SpecOwner & owner = SpecOwner());
+		Vector2DSpec(const double & x, const double & y, const SpecOwner & owner = SpecOwner());
+		Vector2DSpec(const double & x, const double & y, const ScalarUnit & unit, const SpecOwner & owner = SpecOwner());
+		~Vector2DSpec();
 
 		NumberSpec X;
 		NumberSpec Y;
@@ -177,6 +188,11 @@ namespace v2x {
 		Vector2DSpec & operator = (const Vector2DSpec & value);
 		bool operator == (const Vector2DSpec & value) const;
 		bool operator != (const Vector2DSpec & value) const;
+
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const;
+		/// Returns the mask of the fields which differ from value.
+		uint32_t diff(const Vector2DSpec & value) const;
 	};
 
 	typedef Vector2DSpec PointSpec;
@@ -186,14 +202,17 @@ namespace v2x {
 	/// A NAN value by the size means to inherit the settings from the default 
 	/// settings.
 	/// This class should be used as a value-type.
-	class MarginSpec : public Specification, public Notifier < MarginSpec > {
+	class MarginSpec : public CompositeSpec {
 
 	public:
-		MarginSpec(const Listener & listener = nullptr);
-		MarginSpec(const MarginSpec & marginSpec, const Listener & listener = nullptr);
-		MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const Listener & listener = nullptr);
-		MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const ScalarUnit & unit, const Listener & listener = nullptr);
-		virtual ~MarginSpec();
+		/// The member fields of MarginSpec
+		enum class Field : uint8_t { Left, Top, Right, Bottom };
+
+		MarginSpec(const SpecOwner & owner = SpecOwner());
+		MarginSpec(const MarginSpec & marginSpec, const SpecOwner & owner = SpecOwner());
+		MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const SpecOwner & owner = SpecOwner());
+		MarginSpec(const double & left, const double & top, const double & right, const double & bottom, const ScalarUnit & unit, const SpecOwner & owner = SpecOwner());
+		~MarginSpec();
 
 		SizeSpec Left;
 		SizeSpec Top;
@@ -203,6 +222,11 @@ namespace v2x {
 		MarginSpec & operator = (const MarginSpec & value);
 		bool operator == (const MarginSpec & value) const;
 		bool operator != (const MarginSpec & value) const;
+
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const;
+		/// Returns the mask of the fields which differ from value.
+		uint32_t diff(const MarginSpec & value) const;
 	};
 
 	typedef MarginSpec PaddingSpec;
@@ -226,20 +250,34 @@ namespace v2x {
 		FloatFront,
 	};
 
-	std::vector<const Char *> EnumString<PositionMode>::m_strings = {
+	DEFINE_ENUM_STRINGS(PositionMode,
 		L"Inline",
 		L"FloatSurround",
 		L"FloatRow",
 		L"FloatBack",
-		L"FloatFront" };
+		L"FloatFront");
 
 	typedef SimpleSpec<PositionMode> PositionModeSpec;
 
-	class LayoutSpec : public Specification, public Notifier < LayoutSpec > {
+	class LayoutSpec : public CompositeSpec {
 	public:
-		LayoutSpec(const Listener & listener = nullptr);
-		LayoutSpec(const LayoutSpec & layoutSpec, const Listener & listener = nullptr);
-		virtual ~LayoutSpec();
+		/// The member fields of LayoutSpec
+		enum class Field : uint8_t {
+			Width,
+			Height,
+			MinWidth,
+			MinHeight,
+			MaxWidth,
+			MaxHeight,
+			Margin,
+			PositionMode,
+			HorizontalAlignment,
+			VerticalAlignment,
+		};
+
+		LayoutSpec(const SpecOwner & owner = SpecOwner());
+		LayoutSpec(const LayoutSpec & layoutSpec, const SpecOwner & owner = SpecOwner());
+		~LayoutSpec();
 
 		SizeSpec Width;
 		SizeSpec Height;
@@ -256,19 +294,27 @@ namespace v2x {
 		LayoutSpec & operator = (const LayoutSpec & value);
 		bool operator == (const LayoutSpec & value) const;
 		bool operator != (const LayoutSpec & value) const;
+
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const;
+		/// Returns the mask of the fields which differ from value.
+		uint32_t diff(const LayoutSpec & value) const;
 	};
 
-	class ContentLayoutSpec : public Specification, public Notifier < ContentLayoutSpec > {
+	class ContentLayoutSpec : public CompositeSpec {
 	public:
-		ContentLayoutSpec(const Listener & listener = nullptr);
-		ContentLayoutSpec(const ContentLayoutSpec & contentLayoutSpec, const Listener & listener = nullptr);
+		/// The member fields of ContentLayoutSpec
+		enum class Field : uint8_t { Padding, FlowAlignment, FlowDirection };
+
+		ContentLayoutSpec(const SpecOwner & owner = SpecOwner());
+		ContentLayoutSpec(const ContentLayoutSpec & contentLayoutSpec, const SpecOwner & owner = SpecOwner());
 		ContentLayoutSpec(const double & width, const double & height, //
 			const HorizontalAlignment & horzAlignment, const VerticalAlignment & vertAlignment, //
-			const Listener & listener = nullptr);
+			const SpecOwner & owner = SpecOwner());
 		ContentLayoutSpec(const double & margin, //
 			const HorizontalAlignment & horzAlignment, const VerticalAlignment & vertAlignment, //
-			const Listener & listener = nullptr);
-		virtual ~ContentLayoutSpec();
+			const SpecOwner & owner = SpecOwner());
+		~ContentLayoutSpec();
 
 		PaddingSpec Padding;
 		FlowAlignmentSpec FlowAlignment;
@@ -277,6 +323,80 @@ namespace v2x {
 		ContentLayoutSpec & operator = (const ContentLayoutSpec & value);
 		bool operator == (const ContentLayoutSpec & value) const;
 		bool operator != (const ContentLayoutSpec & value) const;
+
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const;
+		/// Returns the mask of the fields which differ from value.
+		uint32_t diff(const ContentLayoutSpec & value) const;
+	};
+
+	/// The sides of a margin or padding in pixels. Unset sides are 0.
+	class ResolvedMargin {
+	public:
+		double Left;
+		double Top;
+		double Right;
+		double Bottom;
+
+		/// Returns the area within the margin
+		Rect64F deflate(const Size2D64F & size) const;
+	};
+
+	/// The sizes of a layout specification in pixels
+	class ResolvedLayout {
+	public:
+		ResolvedMargin Margin;
+		/// NAN if automatic
+		double Width;
+		double Height;
+		/// 0 and INFINITY if unset
+		double MinWidth;
+		double MinHeight;
+		double MaxWidth;
+		double MaxHeight;
+	};
+
+	/// The conversion of the sizes of layout specifications to pixels.
+	///
+	/// The factors of the units are computed once per resolution, so that an
+	/// instance should be kept per display rather than per conversion.
+	class LayoutUnits {
+	public:
+		/// The resolution assumed without display
+		static const int DEFAULT_DPI = 96;
+
+		LayoutUnits(double dpi = DEFAULT_DPI);
+
+		double getDpi() const;
+
+		/// Returns a size in pixels or NAN if it is not set, i.e. automatic.
+		///
+		/// Sizes in the unit Parent are percentages of the reference, those
+		/// in the unit Relative are factors of it. They are NAN if the
+		/// reference is not finite. Sizes without unit are pixels.
+		double toPixels(const ScalarSpec & size, double reference) const;
+		double toPixels(double size, ScalarUnit unit, double reference) const;
+
+		/// Resolve all sizes of a specification at once. The horizontal
+		/// sizes refer to the width of the reference, the vertical ones to
+		/// its height.
+		ResolvedMargin resolve(const MarginSpec & margin, const Size2D64F & reference) const;
+		ResolvedLayout resolve(const LayoutSpec & layout, const Size2D64F & reference) const;
+
+		/// Returns true if a size depends on the resolution, i.e. it is given
+		/// in dots or millimeters
+		static bool dependsOnDpi(const ScalarSpec & size);
+		static bool dependsOnDpi(const MarginSpec & margin);
+		static bool dependsOnDpi(const LayoutSpec & layout);
+
+		bool operator == (const LayoutUnits & units) const;
+		bool operator != (const LayoutUnits & units) const;
+
+	private:
+		double m_dpi;
+		/// The pixels per unit of each ScalarUnit. Those relative to the
+		/// reference are factors of it.
+		double m_factors[5];
 	};
 
 	enum class FontStyle {
@@ -286,11 +406,11 @@ namespace v2x {
 		Stroke,
 	};
 
-	std::vector<const Char *> EnumString<FontStyle>::m_strings = {
+	DEFINE_ENUM_STRINGS(FontStyle,
 		L"Bold",
 		L"Italic",
 		L"Underline",
-		L"Stroke" };
+		L"Stroke");
 
 	typedef EnumSet<FontStyle> FontStyles;
 
@@ -298,21 +418,38 @@ namespace v2x {
 
 	/// Font specification which can be applied down to one single character.
 	/// This class should be used as a value-type.
-	class FontSpec : public Specification, public Notifier < FontSpec > {
+	class FontSpec : public CompositeSpec {
 
 	public:
-		FontSpec(const Listener & listener = nullptr);
-		FontSpec(const FontSpec & fontSpec, const Listener & listener = nullptr);
-		FontSpec(const String & fontName, const double & size, const FontStyles & styles, const Listener & listener = nullptr);
-		FontSpec(const String & fontName, const double & size, const ScalarUnit & unit, const FontStyles & styles, const Listener & listener = nullptr);
-		virtual ~FontSpec();
+		/// The member fields of FontSpec
+		enum class Field : uint8_t { Name, Size, Styles };
+
+		FontSpec(const SpecOwner & owner = SpecOwner());
+		FontSpec(const FontSpec & fontSpec, const SpecOwner & owner = SpecOwner());
+		FontSpec(const Atom & fontName, const double & size, const FontStyles & styles, const SpecOwner & owner = SpecOwner());
+		FontSpec(const Atom & fontName, const double & size, const ScalarUnit & unit, const FontStyles & styles, const SpecOwner & owner = SpecOwner());
+		~FontSpec();
 
-		StringSpec Name;
+		/// The font family. Being an atom, comparing fonts compares pointers.
+		AtomSpec Name;
 		SizeSpec Size;
 		FontStylesSpec Styles;
 
 		FontSpec & operator = (const FontSpec & value);
 		bool operator == (const FontSpec & value) const;
 		bool operator != (const FontSpec & value) const;
+
+		/// Returns a hash consistent with operator ==.
+		size_t hash() const;
+		/// Returns the mask of the fields which differ from value.
+		uint32_t diff(const FontSpec & value) const;
 	};
+
+	typedef EnumSet<LayoutSpec::Field> LayoutFields;
+	typedef EnumSet<ContentLayoutSpec::Field> ContentLayoutFields;
+	typedef EnumSet<FontSpec::Field> FontFields;
+
+	typedef SharedSpec<LayoutSpec> SharedLayoutSpec;
+	typedef SharedSpec<ContentLayoutSpec> SharedContentLayoutSpec;
+	typedef SharedSpec<FontSpec> SharedFontSpec;
 }
\ No newline at end of file
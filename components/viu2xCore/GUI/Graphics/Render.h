@@ -14,16 +14,26 @@ namespace v2x {
 		/// at runtime.
 		Default,
 
+		/// This engine renders nothing and has no OS window. It is used for 
+		/// automated tests and for replaying recorded sessions.
+		Headless,
+
 #ifdef V2X_WINDOWS
 		GDI,
 #endif
 	};
 	/// The strings for MouseButton
-	std::vector<const Char *> EnumString<RenderingEngineType>::m_strings = {
-		L"Default",
 #ifdef V2X_WINDOWS
-		L"GDI",
+	DEFINE_ENUM_STRINGS(RenderingEngineType,
+		L"Default",
+		L"Headless",
+		L"GDI"
+	);
+#else
+	DEFINE_ENUM_STRINGS(RenderingEngineType,
+		L"Default",
+		L"Headless"
+	);
 #endif
-	};
 
 }
\ No newline at end of file
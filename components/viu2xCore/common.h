@@ -4,10 +4,21 @@
 
 #include "Common/Config.h"
 #include "Common/String.h"
+#include "Common/Format.hpp"
+#include "Common/StringView.h"
+#include "Common/Atom.h"
+#include "Common/Unicode.h"
 #include "Common/Exceptions.h"
 #include "Common/EnumString.hpp"
+#include "Common/TypeId.hpp"
+#include "Common/Interning.hpp"
+#include "Common/Transaction.h"
+#include "Common/TaskPool.h"
+#include "Common/Reactive.h"
 #include "Common/Object.h"
 #include "Common/Ownership.hpp"
+#include "Common/ObservableVector.hpp"
+#include "Common/FenwickTree.hpp"
 #include "Common/Event.h"
 #include "Common/Messaging.h"
 
@@ -4,5 +4,11 @@
 
 #include "GUI/Displays.h"
 #include "GUI/Graphics/Layout.h"
+#include "GUI/Graphics/ConstraintSolver.h"
+#include "GUI/Controls/LayoutTree.h"
 #include "GUI/Controls/Controls.h"
-#include "GUI/Controls/App.h"
\ No newline at end of file
+#include "GUI/Controls/VirtualizingContainer.h"
+#include "GUI/Controls/ConstraintContainer.h"
+#include "GUI/Controls/App.h"
+#include "GUI/Controls/WindowHostHeadless.h"
+#include "GUI/Controls/SessionRecording.h"
\ No newline at end of file
@@ -0,0 +1,510 @@
+// viu2xBenchmarks.cpp : Measures the layout of synthetic control trees.
+//
+// Usage: viu2xBenchmarks [--shapes deep,wide,grid,flow,mixed]
+//                        [--nodes 1000,10000,100000,1000000]
+//                        [--resize-steps 10] [--parallel] [--output file.json]
+//
+// Each tree is laid out once in full, then after a single spec change and
+// then at a series of sizes. The time, the allocations and the peak memory
+// of each phase are written as JSON to the output file or the console. The
+// memory held by each tree is reported as its live bytes and the growth of
+// the working set, the peak working set once for the whole process.
+//
+
+#include "stdafx.h"
+#include "../components/viu2xCore/common.h"
+#include "../components/viu2xCore/gui.h"
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+
+using namespace v2x;
+
+namespace {
+
+	// Counters of the replaced operators new and delete below
+	std::atomic<uint64_t> g_allocations(0);
+	std::atomic<uint64_t> g_allocatedBytes(0);
+	std::atomic<int64_t> g_liveBytes(0);
+	std::atomic<int64_t> g_peakBytes(0);
+
+	/// Each block starts with its size. The header keeps the alignment of
+	/// malloc().
+	const size_t HEADER_SIZE = 16;
+
+	void * allocate(size_t size) {
+		char * block = (char *)malloc(size + HEADER_SIZE);
+		if (block == nullptr)
+			return nullptr;
+		*(size_t *)block = size;
+
+		++g_allocations;
+		g_allocatedBytes += size;
+		const int64_t live = g_liveBytes += (int64_t)size;
+		int64_t peak = g_peakBytes;
+		while (live > peak && !g_peakBytes.compare_exchange_weak(peak, live)) {}
+
+		return block + HEADER_SIZE;
+	}
+
+	void deallocate(void * pointer) {
+		if (pointer == nullptr)
+			return;
+		char * block = (char *)pointer - HEADER_SIZE;
+		g_liveBytes -= (int64_t)*(size_t *)block;
+		free(block);
+	}
+}
+
+void * operator new(size_t size) {
+	void * result = allocate(size);
+	if (result == nullptr)
+		throw std::bad_alloc();
+	return result;
+}
+
+void * operator new[](size_t size) {
+	void * result = allocate(size);
+	if (result == nullptr)
+		throw std::bad_alloc();
+	return result;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void * operator new[](size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void operator delete(void * pointer) noexcept { deallocate(pointer); }
+void operator delete[](void * pointer) noexcept { deallocate(pointer); }
+void operator delete(void * pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete[](void * pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete(void * pointer, const std::nothrow_t &) noexcept { deallocate(pointer); }
+void operator delete[](void * pointer, const std::nothrow_t &) noexcept { deallocate(pointer); }
+
+namespace {
+
+	/// The size of the full and the incremental layout
+	const Size2D64F SCREEN_SIZE(1920, 1080);
+	/// The smallest size of the resize sweep
+	const Size2D64F MIN_SIZE(800, 600);
+
+	/// Layout recurses once per level, so deep trees are made of chains of
+	/// this depth side by side
+	const size_t MAX_DEPTH = 1000;
+
+	/// The number of single spec changes of the incremental phase
+	const size_t INCREMENTAL_CHANGES = 10;
+
+	/// A container which is never shown
+	template <typename Base>
+	class Panel : public Base {
+	public:
+		typedef std::shared_ptr<Panel> Shared;
+		void show() override {}
+		void close() override {}
+	};
+
+	typedef Panel<ControlContainer> Box;
+	typedef Panel<FlowContainer> Flow;
+
+	/// A generated tree and the control whose spec is changed by the
+	/// incremental phase
+	class Tree {
+	public:
+		Tree() : Changed(nullptr), Nodes(0) {}
+
+		Control::Shared Root;
+		Control * Changed;
+		size_t Nodes;
+
+		template <typename T>
+		std::shared_ptr<T> create() {
+			++Nodes;
+			return std::shared_ptr<T>(new T());
+		}
+	};
+
+	void setFixedSize(Control & control, double width, double height, ScalarUnit unit = ScalarUnit::Pixel) {
+		control.Layout.edit([width, height, unit](LayoutSpec & layout) {
+			layout.Width = SizeSpec(width, unit);
+			layout.Height = SizeSpec(height, unit);
+			layout.HorizontalAlignment = HorizontalAlignment::Left;
+			layout.VerticalAlignment = VerticalAlignment::Top;
+		});
+	}
+
+	/// Chains of nested containers, each inset by a pixel
+	Tree createDeep(size_t nodes) {
+		Tree tree;
+		Box::Shared root = tree.create<Box>();
+		tree.Root = root;
+
+		while (tree.Nodes < nodes) {
+			ControlContainer * parent = root.get();
+			for (size_t depth = 0; depth < MAX_DEPTH && tree.Nodes < nodes; ++depth) {
+				Box::Shared child = tree.create<Box>();
+				child->Layout.edit([](LayoutSpec & layout) { layout.Margin = MarginSpec(1, 1, 0, 0); });
+				parent->Add(child);
+				parent = child.get();
+			}
+			if (tree.Nodes * 2 >= nodes && tree.Changed == nullptr)
+				tree.Changed = parent;
+		}
+		return tree;
+	}
+
+	/// A single container with fixed-size children all over it
+	Tree createWide(size_t nodes) {
+		Tree tree;
+		Box::Shared root = tree.create<Box>();
+		tree.Root = root;
+
+		for (size_t i = 0; tree.Nodes < nodes; ++i) {
+			Box::Shared child = tree.create<Box>();
+			setFixedSize(*child, 16, 16);
+			child->Layout.edit([i](LayoutSpec & layout) {
+				layout.Margin = MarginSpec((double)(i % 120 * 16), (double)(i / 120 % 67 * 16), 0, 0);
+			});
+			root->Add(child);
+			if (tree.Nodes * 2 >= nodes && tree.Changed == nullptr)
+				tree.Changed = child.get();
+		}
+		return tree;
+	}
+
+	/// Rows of cells sized in percent of the row
+	Tree createGrid(size_t nodes) {
+		Tree tree;
+		Box::Shared root = tree.create<Box>();
+		tree.Root = root;
+
+		const size_t columns = std::max((size_t)1, (size_t)std::sqrt((double)nodes));
+		for (size_t row = 0; tree.Nodes < nodes; ++row) {
+			Box::Shared line = tree.create<Box>();
+			line->Layout.edit([row](LayoutSpec & layout) {
+				layout.Height = SizeSpec(20);
+				layout.VerticalAlignment = VerticalAlignment::Top;
+				layout.Margin = MarginSpec(0, (double)row * 20, 0, 0);
+			});
+			root->Add(line);
+
+			for (size_t column = 0; column < columns && tree.Nodes < nodes; ++column) {
+				Box::Shared cell = tree.create<Box>();
+				cell->Layout.edit([column, columns](LayoutSpec & layout) {
+					layout.Width = SizeSpec(100.0 / columns, ScalarUnit::Parent);
+					layout.HorizontalAlignment = HorizontalAlignment::Left;
+					layout.Margin = MarginSpec(100.0 * column / columns, 0, 0, 0, ScalarUnit::Parent);
+				});
+				line->Add(cell);
+				if (tree.Nodes * 2 >= nodes && tree.Changed == nullptr)
+					tree.Changed = cell.get();
+			}
+		}
+		return tree;
+	}
+
+	/// Words of different widths in a justified flow with a few floats
+	Tree createFlow(size_t nodes) {
+		Tree tree;
+		Flow::Shared root = tree.create<Flow>();
+		root->ContentLayout.edit([](ContentLayoutSpec & layout) {
+			layout.Padding = PaddingSpec(8, 8, 8, 8);
+			layout.FlowAlignment = FlowAlignment::JustifyLeft;
+		});
+		tree.Root = root;
+
+		for (size_t i = 0; tree.Nodes < nodes; ++i) {
+			Box::Shared word = tree.create<Box>();
+			if (i % 1009 == 1008) {
+				setFixedSize(*word, 400, 120);
+				word->Layout.edit([](LayoutSpec & layout) { layout.PositionMode = PositionMode::FloatRow; });
+			}
+			else if (i % 97 == 96) {
+				setFixedSize(*word, 160, 90);
+				word->Layout.edit([i](LayoutSpec & layout) {
+					layout.PositionMode = PositionMode::FloatSurround;
+					layout.HorizontalAlignment = i % 2 ? HorizontalAlignment::Left : HorizontalAlignment::Right;
+				});
+			}
+			else
+				setFixedSize(*word, (double)(12 + i * 7919 % 61), 16);
+			root->Add(word);
+			if (tree.Nodes * 2 >= nodes && tree.Changed == nullptr)
+				tree.Changed = word.get();
+		}
+		return tree;
+	}
+
+	/// Add random subtrees of overlays and flows, sized in pixels,
+	/// millimeters and percent, as found in real windows
+	void addMixed(ControlContainer & parent, size_t nodes, size_t depth, std::mt19937 & random, Tree & tree) {
+		const size_t fanout = 2 + random() % 8;
+		for (size_t i = 0; i < fanout && tree.Nodes < nodes; ++i) {
+			const bool isContainer = depth < 10 && random() % 3 != 0;
+			Control::Shared child;
+
+			if (isContainer && random() % 2 == 0) {
+				Flow::Shared flow = tree.create<Flow>();
+				flow->ContentLayout.edit([](ContentLayoutSpec & layout) { layout.Padding = PaddingSpec(2, 2, 2, 2); });
+				child = flow;
+			}
+			else {
+				Box::Shared box = tree.create<Box>();
+				switch (random() % 4) {
+				case 0: setFixedSize(*box, (double)(20 + random() % 100), (double)(10 + random() % 30)); break;
+				case 1: setFixedSize(*box, (double)(5 + random() % 30), (double)(3 + random() % 10), ScalarUnit::Millimeter); break;
+				case 2: setFixedSize(*box, (double)(10 + random() % 40), (double)(5 + random() % 20), ScalarUnit::Parent); break;
+				default:
+					box->Layout.edit([](LayoutSpec & layout) { layout.Margin = MarginSpec(1, 1, 1, 1); });
+					break;
+				}
+				child = box;
+			}
+
+			parent.Add(child);
+			if (tree.Nodes * 2 >= nodes && tree.Changed == nullptr)
+				tree.Changed = child.get();
+			if (isContainer)
+				addMixed(*std::static_pointer_cast<ControlContainer>(child), nodes, depth + 1, random, tree);
+		}
+	}
+
+	Tree createMixed(size_t nodes) {
+		Tree tree;
+		Box::Shared root = tree.create<Box>();
+		tree.Root = root;
+
+		// The same tree in every run
+		std::mt19937 random(2016);
+		while (tree.Nodes < nodes)
+			addMixed(*root, nodes, 0, random, tree);
+		return tree;
+	}
+
+	typedef Tree(*TreeFactory)(size_t nodes);
+
+	class Shape {
+	public:
+		const char * Name;
+		TreeFactory Create;
+	};
+
+	const Shape SHAPES[] = {
+		{ "deep", createDeep },
+		{ "wide", createWide },
+		{ "grid", createGrid },
+		{ "flow", createFlow },
+		{ "mixed", createMixed },
+	};
+
+	/// The cost of a phase
+	class Sample {
+	public:
+		Sample() : Iterations(0), Milliseconds(0), Allocations(0), AllocatedBytes(0), PeakBytes(0) {}
+
+		size_t Iterations;
+		double Milliseconds;
+		uint64_t Allocations;
+		uint64_t AllocatedBytes;
+		/// The peak of the allocated bytes above those allocated before
+		int64_t PeakBytes;
+		LayoutStatistics Statistics;
+	};
+
+	template <typename F>
+	Sample measure(size_t iterations, const F & run) {
+		LayoutStatistics & statistics = Control::getLayoutStatistics();
+		statistics.reset();
+
+		const uint64_t allocations = g_allocations;
+		const uint64_t allocatedBytes = g_allocatedBytes;
+		const int64_t liveBytes = g_liveBytes;
+		g_peakBytes = liveBytes;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i)
+			run(i);
+		const auto end = std::chrono::steady_clock::now();
+
+		Sample result;
+		result.Iterations = iterations;
+		result.Milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+		result.Allocations = g_allocations - allocations;
+		result.AllocatedBytes = g_allocatedBytes - allocatedBytes;
+		result.PeakBytes = g_peakBytes - liveBytes;
+		result.Statistics = statistics;
+		return result;
+	}
+
+	PROCESS_MEMORY_COUNTERS getMemoryCounters() {
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters;
+	}
+
+	void writeSample(std::ostream & out, const char * name, const Sample & sample) {
+		out << "\t\t\t\"" << name << "\": { "
+			<< "\"iterations\": " << sample.Iterations
+			<< ", \"milliseconds\": " << sample.Milliseconds
+			<< ", \"allocations\": " << sample.Allocations
+			<< ", \"allocatedBytes\": " << sample.AllocatedBytes
+			<< ", \"peakBytes\": " << sample.PeakBytes
+			<< ", \"measures\": " << sample.Statistics.Measures
+			<< ", \"arranges\": " << sample.Statistics.Arranges
+			<< " }";
+	}
+
+	/// Lay out a tree in all phases and write the result
+	void run(std::ostream & out, const Shape & shape, size_t nodes, size_t resizeSteps) {
+		// The peak working set covers the whole process and never decreases,
+		// so the tree is measured by the growth of the current one
+		const int64_t workingSetBefore = (int64_t)getMemoryCounters().WorkingSetSize;
+		const int64_t liveBytesBefore = g_liveBytes;
+
+		Tree tree;
+		const Sample build = measure(1, [&tree, &shape, nodes](size_t) { tree = shape.Create(nodes); });
+
+		const Sample full = measure(1, [&tree](size_t) { tree.Root->updateLayout(SCREEN_SIZE); });
+
+		const Sample incremental = measure(INCREMENTAL_CHANGES, [&tree](size_t i) {
+			tree.Changed->Layout.edit([i](LayoutSpec & layout) { layout.Margin.Right = SizeSpec((double)(i % 2 + 1)); });
+			tree.Root->updateLayout(SCREEN_SIZE);
+		});
+
+		// From the screen size down to the smallest size
+		const Sample resize = measure(resizeSteps, [&tree, resizeSteps](size_t i) {
+			const double ratio = (double)(i + 1) / resizeSteps;
+			tree.Root->updateLayout(Size2D64F(
+				SCREEN_SIZE.width() + (MIN_SIZE.width() - SCREEN_SIZE.width()) * ratio,
+				SCREEN_SIZE.height() + (MIN_SIZE.height() - SCREEN_SIZE.height()) * ratio));
+		});
+
+		const int64_t liveBytes = g_liveBytes - liveBytesBefore;
+		const int64_t workingSetGrowth = (int64_t)getMemoryCounters().WorkingSetSize - workingSetBefore;
+
+		out << "\t\t{\n"
+			<< "\t\t\t\"shape\": \"" << shape.Name << "\",\n"
+			<< "\t\t\t\"nodes\": " << tree.Nodes << ",\n";
+		writeSample(out, "build", build);
+		out << ",\n";
+		writeSample(out, "full", full);
+		out << ",\n";
+		writeSample(out, "incremental", incremental);
+		out << ",\n";
+		writeSample(out, "resize", resize);
+		out << ",\n"
+			<< "\t\t\t\"liveBytes\": " << liveBytes << ",\n"
+			<< "\t\t\t\"workingSetGrowthBytes\": " << workingSetGrowth << "\n"
+			<< "\t\t}";
+	}
+
+	std::vector<String> split(const String & text) {
+		std::vector<String> result;
+		std::wistringstream in(text);
+		String item;
+		while (std::getline(in, item, L','))
+			if (!item.empty())
+				result.push_back(item);
+		return result;
+	}
+
+	const Shape * findShape(const String & name) {
+		for (size_t i = 0; i < sizeof(SHAPES) / sizeof(SHAPES[0]); ++i)
+			if (name == String(SHAPES[i].Name, SHAPES[i].Name + strlen(SHAPES[i].Name)))
+				return &SHAPES[i];
+		throw Exception(CHECKED_FORMAT(L"Unknown shape %s!", name.c_str()));
+	}
+}
+
+int _tmain(int argc, _TCHAR * argv[]) {
+	std::vector<const Shape *> shapes;
+	for (size_t i = 0; i < sizeof(SHAPES) / sizeof(SHAPES[0]); ++i)
+		shapes.push_back(&SHAPES[i]);
+	std::vector<size_t> nodeCounts = { 1000, 10000, 100000, 1000000 };
+	size_t resizeSteps = 10;
+	bool isParallel = false;
+	String output;
+
+	try {
+		for (int i = 1; i < argc; ++i) {
+			const String option = argv[i];
+			if (option == L"--parallel") {
+				isParallel = true;
+				continue;
+			}
+			if (i + 1 >= argc)
+				throw Exception(CHECKED_FORMAT(L"Missing the value of %s!", option.c_str()));
+
+			const String value = argv[++i];
+			if (option == L"--shapes") {
+				shapes.clear();
+				for (const String & name : split(value))
+					shapes.push_back(findShape(name));
+			}
+			else if (option == L"--nodes") {
+				nodeCounts.clear();
+				for (const String & count : split(value))
+					nodeCounts.push_back((size_t)std::stoull(count));
+			}
+			else if (option == L"--resize-steps")
+				resizeSteps = std::max((size_t)1, (size_t)std::stoull(value));
+			else if (option == L"--output")
+				output = value;
+			else
+				throw Exception(CHECKED_FORMAT(L"Unknown option %s!", option.c_str()));
+		}
+	}
+	catch (const Exception & e) {
+		std::wcerr << e.getMessage() << std::endl;
+		return 1;
+	}
+	catch (const std::exception &) {
+		std::cerr << "Usage: viu2xBenchmarks [--shapes deep,wide,grid,flow,mixed] [--nodes 1000,10000]"
+			" [--resize-steps 10] [--parallel] [--output file.json]" << std::endl;
+		return 1;
+	}
+
+	// Layout is serial unless asked otherwise
+	std::unique_ptr<TaskPool> pool;
+	if (isParallel)
+		pool.reset(new TaskPool());
+	Control::setParallelLayout(pool.get());
+
+	std::ofstream file;
+	if (!output.empty()) {
+		file.open(output.c_str());
+		if (!file) {
+			std::wcerr << L"Cannot write " << output << std::endl;
+			return 1;
+		}
+	}
+	std::ostream & out = output.empty() ? std::cout : file;
+
+	out << "{\n"
+		<< "\t\"parallel\": " << (isParallel ? "true" : "false") << ",\n"
+		<< "\t\"results\": [\n";
+	bool isFirst = true;
+	for (const Shape * shape : shapes) {
+		for (size_t nodes : nodeCounts) {
+			if (!isFirst)
+				out << ",\n";
+			isFirst = false;
+			run(out, *shape, nodes, resizeSteps);
+			out.flush();
+		}
+	}
+	out << "\n\t],\n"
+		<< "\t\"peakWorkingSetBytes\": " << getMemoryCounters().PeakWorkingSetSize << "\n"
+		<< "}\n";
+
+	Control::setParallelLayout(nullptr);
+	return 0;
+}
@@ -2,7 +2,11 @@
 #include <iostream>
 #include "CppUnitTest.h"
 
+#include <chrono>
 #include <cmath>
+#include <stdarg.h>
+#include <set>
+#include <thread>
 #include <viu2xCore/common.h>
 #include <viu2xCore/gui.h>
 
@@ -488,5 +492,502 @@ namespace viu2xTests
 			MessageData3::Shared m3 = msg->getDataAs<MessageData3>();
 			Assert::AreEqual(false, m3 != nullptr);
 		}
+
+		TEST_METHOD(TestMessagePayload) {
+
+			/////////////////////////////
+			// Inline Message Payloads //
+			/////////////////////////////
+
+			struct MessagePayload1 {
+				int32_t x;
+				int32_t y;
+			};
+
+			const Message::Id MSGID_FOR_TEST = 12345;
+			Message msg(MSGID_FOR_TEST, MessagePayload1{ 10, 20 });
+
+			Assert::AreEqual(MSGID_FOR_TEST, msg.getId());
+			Assert::AreEqual(true, msg.hasPayload());
+			Assert::AreEqual(true, msg.hasPayload<MessagePayload1>());
+			Assert::AreEqual(false, msg.hasPayload<int32_t>());
+			Assert::AreEqual(20, msg.getPayload<MessagePayload1>().y);
+			Assert::AreEqual(true, msg.tryGetPayload<double>() == nullptr);
+			Assert::AreEqual(true, msg.getData() == nullptr);
+
+			bool thrown = false;
+			try { msg.getPayload<double>(); }
+			catch (const Exception &) { thrown = true; }
+			Assert::AreEqual(true, thrown);
+
+			// Messages are values and can be copied
+			Message copy(msg);
+			Assert::AreEqual(MSGID_FOR_TEST, copy.getId());
+			Assert::AreEqual(10, copy.tryGetPayload<MessagePayload1>()->x);
+
+			Message assigned;
+			Assert::AreEqual(false, assigned.hasPayload());
+			assigned = msg;
+			Assert::AreEqual(20, assigned.getPayload<MessagePayload1>().y);
+		}
+
+		TEST_METHOD(TestReactive) {
+
+			Signal<int32_t> a(1);
+			Signal<int32_t> b(2);
+
+			// Computed values are lazy and cached
+			int32_t sumCount = 0;
+			Computed<int32_t> sum([&]() { ++sumCount; return a.get() + b.get(); });
+			Assert::AreEqual(0, sumCount);
+			Assert::AreEqual(3, sum.get());
+			Assert::AreEqual(3, sum.get());
+			Assert::AreEqual(1, sumCount);
+
+			a.set(2);
+			Assert::AreEqual(1, sumCount);
+			Assert::AreEqual(4, sum.get());
+			Assert::AreEqual(2, sumCount);
+
+			// A diamond is evaluated once per change without glitches
+			Computed<int32_t> twice([&]() { return a.get() * 2; });
+			Computed<int32_t> thrice([&]() { return a.get() * 3; });
+			std::vector<int32_t> seen;
+			Effect diamond([&]() { seen.push_back(twice.get() + thrice.get()); });
+			Assert::AreEqual((size_t)1, seen.size());
+			Assert::AreEqual(10, seen.back());
+
+			a.set(3);
+			Assert::AreEqual((size_t)2, seen.size());
+			Assert::AreEqual(15, seen.back());
+
+			// An unchanged computed value stops the propagation
+			int32_t parityRuns = 0;
+			Computed<int32_t> parity([&]() { return a.get() % 2; });
+			Effect parityEffect([&]() { parity.get(); ++parityRuns; });
+			a.set(5);
+			Assert::AreEqual(1, parityRuns);
+			a.set(6);
+			Assert::AreEqual(2, parityRuns);
+
+			// Effects are flushed once on commit of a transaction
+			int32_t sumRuns = 0;
+			Effect sumEffect([&]() { sum.get(); ++sumRuns; });
+			{
+				UpdateTransaction transaction;
+				a.set(10);
+				b.set(20);
+				Assert::AreEqual(1, sumRuns);
+			}
+			Assert::AreEqual(2, sumRuns);
+			Assert::AreEqual(30, sum.get());
+
+			// Dependencies are tracked dynamically
+			Signal<bool> useA(true);
+			int32_t pickRuns = 0;
+			Computed<int32_t> pick([&]() { ++pickRuns; return useA.get() ? a.get() : b.get(); });
+			Assert::AreEqual(10, pick.get());
+			useA.set(false);
+			Assert::AreEqual(20, pick.get());
+			a.set(11);
+			Assert::AreEqual(20, pick.get());
+			Assert::AreEqual(2, pickRuns);
+
+			// Destroyed effects are stopped
+			int32_t scopedRuns = 0;
+			{
+				Effect scoped([&]() { b.get(); ++scopedRuns; });
+			}
+			b.set(21);
+			Assert::AreEqual(1, scopedRuns);
+
+			// Specs can be bound to reactive values, e.g. a resolved pixel size
+			Signal<double> dpi(96.0);
+			Signal<double> points(12.0);
+			int32_t resolveCount = 0;
+			Computed<double> pixels([&]() { ++resolveCount; return points.get() * dpi.get() / 72.0; });
+
+			int32_t notifications = 0;
+			NumberSpec spec([&](const void *, const void *) { ++notifications; });
+			auto binding = spec.bind(pixels);
+			Assert::AreEqual(16.0, spec.get());
+			Assert::AreEqual(1, notifications);
+
+			dpi.set(144.0);
+			Assert::AreEqual(24.0, spec.get());
+			Assert::AreEqual(2, resolveCount);
+			Assert::AreEqual(2, notifications);
+
+			dpi.set(144.0);
+			Assert::AreEqual(2, resolveCount);
+
+			binding.reset();
+			dpi.set(72.0);
+			Assert::AreEqual(24.0, spec.get());
+		}
+
+		TEST_METHOD(TestFormatter) {
+
+			// Numbers follow printf
+			Assert::IsTrue(Formatter::format(L"%d|%5d|%-5d|%05d|%+d", 42, 42, 42, -42, 42) == L"42|   42|42   |-0042|+42");
+			Assert::IsTrue(Formatter::format(L"%x %X %#x %o", 255, 255u, 255, 8) == L"ff FF 0xff 10");
+			Assert::IsTrue(Formatter::format(L"%.3f|%8.2f|%g|%e", 3.14159, 2.5, 0.5, 1000.0) == L"3.142|    2.50|0.5|1.000000e+03");
+
+			// The argument type decides, not the length modifier
+			Assert::IsTrue(Formatter::format(L"%d %u", 0xFFFFFFFFu, -1) == L"-1 4294967295");
+			Assert::IsTrue(Formatter::format(L"%lld %d", (int64_t)-5, (uint8_t)200) == L"-5 -56");
+			Assert::IsTrue(Formatter::format(L"%d %s", 2.6, 7) == L"3 7");
+
+			// Strings, characters and booleans
+			Assert::IsTrue(Formatter::format(L"%s/%s/%s/%.3s", L"wide", "narrow", String(L"string"), L"truncated") == L"wide/narrow/string/tru");
+			Assert::IsTrue(Formatter::format(L"%c%c %s %d", L'o', 'k', true, false) == L"ok true 0");
+
+			// Enums, matrices and rectangles
+			Assert::IsTrue(Formatter::format(L"%s %d", FlowDirection::BottomLeftToTopRight, FlowDirection::BottomLeftToTopRight) == L"BottomLeftToTopRight 2");
+			Assert::IsTrue(Formatter::format(L"%s", Vector2D32I(3, 4)) == L"{{3}, {4}}");
+			Assert::IsTrue(Formatter::format(L"%.1f", Rect64F(0, 1, 10, 20)) == L"Rect_T (0.0, 1.0, 10.0, 20.0)");
+
+			// Missing arguments stay visible, surplus ones are ignored
+			Assert::IsTrue(Formatter::format(L"100%% %d %s", 1) == L"100% 1 %s");
+			Assert::IsTrue(Formatter::format(L"none", 1, 2) == L"none");
+
+			// The argument count is known at compile time. CHECKED_FORMAT
+			// fails to compile if it does not match.
+			static_assert(Formatter::countArguments(L"%d of %5.2f%%") == 2, "Two arguments");
+			Assert::IsTrue(Formatter::format(CHECKED_FORMAT(L"%d of %5.2f%%", 1, 2.5)) == L"1 of  2.50%");
+
+			// Long results leave the inline storage
+			const String long1(FormatBuffer::INLINE_SIZE, L'a');
+			Assert::IsTrue(Formatter::format(L"%s-%s", long1, long1) == long1 + L"-" + long1);
+
+			// Exceptions format their messages with it
+			Exception e(CHECKED_FORMAT(L"Index %d of %s is out of range!", (size_t)7, String(L"list")));
+			Assert::IsTrue(e.getMessage() == L"Index 7 of list is out of range!");
+		}
+
+		TEST_METHOD(TestFormatterVarargs) {
+
+			// The varargs path which the formatter replaces
+			class Varargs {
+			public:
+				static String format(const Char * format, ...) {
+					va_list params;
+					va_start(params, format);
+					String result = StrUtils::vformat(format, params);
+					va_end(params);
+					return result;
+				}
+			};
+
+			// Both produce the same text, with and without the C runtime
+			for (int i = -1000; i < 1000; i += 7) {
+				Assert::IsTrue(Formatter::format(L"Control %d at (%.2f, %.2f) is %s", i, 1.5 * i, 2.5, L"visible") ==
+					Varargs::format(L"Control %d at (%.2f, %.2f) is %s", i, 1.5 * i, 2.5, L"visible"));
+				Assert::IsTrue(Formatter::format(L"Index %d out of range %u!", i, (unsigned int)i) ==
+					Varargs::format(L"Index %d out of range %u!", i, (unsigned int)i));
+			}
+		}
+
+		TEST_METHOD(TestUnicode) {
+
+			// ASCII longer than a vector register, then 2, 3 and 4 byte sequences
+			const std::string utf8 = "The quick brown fox jumps \xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80!";
+			const std::u16string utf16 = u"The quick brown fox jumps é€\U0001F600!";
+			const std::u32string utf32 = U"The quick brown fox jumps é€\U0001F600!";
+
+			Assert::AreEqual((size_t)26, Unicode::getAsciiLength(utf8.data(), utf8.size()));
+			Assert::AreEqual(utf16.size(), Unicode::getUtf16Length(utf8.data(), utf8.size()));
+			Assert::AreEqual(utf32.size(), Unicode::getUtf32Length(utf8.data(), utf8.size()));
+			Assert::AreEqual(utf8.size(), Unicode::getUtf8Length(utf16.data(), utf16.size()));
+			Assert::AreEqual(utf8.size(), Unicode::getUtf8Length(utf32.data(), utf32.size()));
+
+			// Round trips through destinations of the computed length
+			std::u16string to16(utf16.size(), 0);
+			Assert::AreEqual(utf16.size(), Unicode::convert(utf8.data(), utf8.size(), &to16[0]));
+			Assert::IsTrue(to16 == utf16);
+			std::u32string to32(utf32.size(), 0);
+			Assert::AreEqual(utf32.size(), Unicode::convert(utf8.data(), utf8.size(), &to32[0]));
+			Assert::IsTrue(to32 == utf32);
+			std::string from16(utf8.size(), 0);
+			Assert::AreEqual(utf8.size(), Unicode::convert(to16.data(), to16.size(), &from16[0]));
+			Assert::IsTrue(from16 == utf8);
+			std::string from32(utf8.size(), 0);
+			Assert::AreEqual(utf8.size(), Unicode::convert(to32.data(), to32.size(), &from32[0]));
+			Assert::IsTrue(from32 == utf8);
+
+			Assert::IsTrue(Unicode::toUtf8(Unicode::toWide(utf8)) == utf8);
+			const std::string ascii(100, 'x');
+			Assert::IsTrue(Unicode::toWide(ascii) == String(100, L'x'));
+			Assert::IsTrue(StrUtils::toStr(ascii) == String(100, L'x'));
+
+			// Overlong, lone continuation, truncated, surrogate and out of range
+			const char * invalid[] = { "\xC0\x80", "\x80", "ab\xE2\x82", "\xF0\x9F\x98", "\xED\xA0\x80", "\xF4\x90\x80\x80" };
+			for (const char * s : invalid)
+				Assert::IsFalse(Unicode::isValidUtf8(s, strlen(s)));
+			Assert::IsTrue(Unicode::isValidUtf8("\xF4\x8F\xBF\xBF", 4));
+
+			const char16_t loneSurrogate[] = { u'a', 0xD83D, u'b' };
+			Assert::AreEqual(Unicode::INVALID, Unicode::getUtf8Length(loneSurrogate, 3));
+			const char32_t outOfRange[] = { 0x110000 };
+			Assert::AreEqual(Unicode::INVALID, Unicode::getUtf8Length(outOfRange, 1));
+
+			bool thrown = false;
+			try {
+				Unicode::toWide("\xC0\x80", 2);
+			}
+			catch (Exception &) {
+				thrown = true;
+			}
+			Assert::IsTrue(thrown);
+		}
+
+		TEST_METHOD(TestStringView) {
+
+			// Tokens are views into the source, empty ones are skipped
+			const String path = L"\\\\first\\second//third fourth/";
+			std::vector<StringView> tokens;
+			StrUtils::split(path, L"\\/", tokens);
+			Assert::AreEqual((size_t)3, tokens.size());
+			Assert::IsTrue(tokens[0] == L"first");
+			Assert::IsTrue(tokens[1] == L"second");
+			Assert::IsTrue(tokens[2] == L"third fourth");
+			Assert::IsTrue(tokens[1].data() == path.data() + 8);
+
+			// The iterator is lazy; long inputs take the vector scan, large
+			// delimiter sets the scalar one
+			const String line = L"alpha, beta;gamma delta,,epsilon;zeta eta theta";
+			const Char * expected[] = { L"alpha", L"beta", L"gamma", L"delta", L"epsilon", L"zeta", L"eta", L"theta" };
+			for (StringView delimiters : { StringView(L",; "), StringView(L",; \t\r\n") }) {
+				size_t count = 0;
+				for (StringView token : StrUtils::tokenize(line, delimiters))
+					Assert::IsTrue(token == expected[count++]);
+				Assert::AreEqual((size_t)8, count);
+			}
+			Assert::IsTrue(StrUtils::tokenize(L"", L",").begin() == StrUtils::tokenize(L"", L",").end());
+			Assert::IsTrue(StrUtils::tokenize(L",,,", L",").begin() == StrUtils::tokenize(L",,,", L",").end());
+
+			// Searching
+			const StringView view(line);
+			Assert::AreEqual((size_t)35, view.findFirstOf(L"ht", 30));
+			Assert::AreEqual(StringView::npos, view.findFirstOf(L"XYZ"));
+			Assert::AreEqual((size_t)5, view.find(L','));
+			Assert::IsTrue(view.substr(7, 4) == L"beta");
+			Assert::IsTrue(view.substr(100).empty());
+			Assert::IsTrue(view.startsWith(L"alpha"));
+			Assert::IsTrue(StringView(L"abc") < StringView(L"abd"));
+			Assert::IsTrue(StringView(L"ab") < StringView(L"abc"));
+
+			// Trimming
+			const String padded = L"\t\n Trim me \r\n";
+			const StringView trimmed = StrUtils::trimView(padded);
+			Assert::IsTrue(trimmed == L"Trim me");
+			Assert::IsTrue(trimmed.data() == padded.data() + 3);
+			Assert::IsTrue(StrUtils::trimView(L" \t ").empty());
+			Assert::IsTrue(StrUtils::trim(L"x") == L"x");
+
+			Assert::IsTrue(StrUtils::format(L"[%s]", tokens[2]) == L"[third fourth]");
+		}
+
+		TEST_METHOD(TestAtom) {
+
+			// Equal strings share one atom, however they are given
+			const String name = L"Segoe UI";
+			const Atom a(L"Segoe UI");
+			const Atom b(name);
+			const Atom c(StringView(L"Segoe UI Light", 8));
+			Assert::IsTrue(a == b && b == c);
+			Assert::IsTrue(a.c_str() == c.c_str());
+			Assert::IsTrue(a != Atom(L"Arial"));
+			Assert::IsTrue(a == L"Segoe UI" && a == name && a != L"Segoe");
+			Assert::AreEqual(Atom::hashString(name.data(), name.size()), a.hash());
+			Assert::IsTrue(Atom() == Atom(L"") && Atom().empty());
+			Assert::IsTrue(StrUtils::format(L"<%s>", a) == L"<Segoe UI>");
+
+			// Looking up does not create atoms
+			Atom found;
+			Assert::IsTrue(Atom::find(L"Segoe UI", found) && found == a);
+			Assert::IsFalse(Atom::find(L"Never interned", found));
+
+			// Interning from several threads yields the same atoms, also
+			// while the table grows
+			const size_t COUNT = 3000;
+			std::vector<std::vector<const Char *>> results(4);
+			std::vector<std::thread> threads;
+			for (size_t t = 0; t < results.size(); ++t)
+				threads.push_back(std::thread([&results, t, COUNT]() {
+					for (size_t i = 0; i < COUNT; ++i)
+						results[t].push_back(Atom(StrUtils::format(L"Atom%d", (int)i)).c_str());
+				}));
+			for (auto & thread : threads)
+				thread.join();
+			for (size_t i = 0; i < COUNT; ++i) {
+				Assert::IsTrue(results[0][i] == results[1][i] && results[0][i] == results[2][i] && results[0][i] == results[3][i]);
+				Assert::IsTrue(StrUtils::format(L"Atom%d", (int)i) == results[0][i]);
+			}
+			Assert::IsTrue(Atom::getCount() >= COUNT + 2);
+
+			// Fonts and keys hold atoms
+			FontSpec font(L"Segoe UI", 12, FontStyles());
+			Assert::IsTrue(font.Name.get() == a);
+			EventDataKeyboard key(KeyModifier::Shift);
+			Assert::IsTrue(key.Key == L"Shift");
+		}
+
+		TEST_METHOD(TestLazyException) {
+
+			// The arguments are copied, so the message can be formatted after
+			// the sources are gone
+			std::unique_ptr<Exception> e;
+			{
+				String name = L"temporary";
+				e.reset(new Exception(L"%s at %d: %.1f%%", name.c_str(), 42, 99.5));
+				name = L"changed";
+			}
+			Assert::IsTrue(e->getMessage() == L"temporary at 42: 99.5%");
+			Assert::IsTrue(&e->getMessage() == &e->getMessage());
+
+			// Internal messages are kept unformatted until they are read
+			Exception outer(*e, L"Outer %s", String(L"failure"));
+			Exception copy(outer);
+			Assert::AreEqual((size_t)2, copy.getMessages().size());
+			Assert::IsTrue(copy.getMessages()[0] == L"Outer failure");
+			Assert::IsTrue(copy.getMessages()[1] == L"temporary at 42: 99.5%");
+			Assert::IsTrue(Exception(L"100%%").getMessage() == L"100%");
+
+			const Char * null = nullptr;
+			Assert::IsTrue(Exception(L"[%s]", null).getMessage() == L"[(null)]");
+
+			// Singular matrices can be probed without exceptions
+			Matrix_T<double, 2, 2> singular;
+			singular[0][0] = 1; singular[0][1] = 2;
+			singular[1][0] = 2; singular[1][1] = 4;
+			Assert::IsFalse(singular.tryEliminate(0, 0, 1, 1));
+			Assert::IsFalse(singular.tryEliminate(0, 0, 2, 2));
+
+			Matrix_T<double, 2, 2> regular;
+			regular[0][0] = 2; regular[0][1] = 0;
+			regular[1][0] = 0; regular[1][1] = 4;
+			Assert::IsTrue(regular.tryEliminate(0, 0, 1, 1));
+			Assert::AreEqual(1.0, regular[1][1]);
+
+			bool thrown = false;
+			try {
+				singular.eliminate(0, 0, 1, 1);
+			}
+			catch (const Exception & x) {
+				thrown = x.getMessage() == L"Matrix_T::eliminate: The specified zone cannot be eliminated!";
+			}
+			Assert::IsTrue(thrown);
+		}
+
+		TEST_METHOD(TestTaskPool) {
+
+			// Nested groups sum up the same on any number of threads
+			std::function<uint64_t(TaskPool &, uint64_t, uint64_t)> sum =
+				[&sum](TaskPool & pool, uint64_t first, uint64_t last) -> uint64_t {
+				if (last - first <= 1000) {
+					uint64_t result = 0;
+					for (uint64_t i = first; i < last; ++i)
+						result += i;
+					return result;
+				}
+
+				const uint64_t middle = (first + last) / 2;
+				uint64_t left = 0;
+				TaskGroup group(pool);
+				group.run([&]() { left = sum(pool, first, middle); });
+				const uint64_t right = sum(pool, middle, last);
+				group.wait();
+				return left + right;
+			};
+
+			const uint64_t expected = 999999ull * 1000000ull / 2;
+			for (size_t threads = 0; threads <= 4; threads += 2) {
+				TaskPool pool(threads);
+				Assert::AreEqual(threads, pool.getThreadCount());
+				Assert::AreEqual(expected, sum(pool, 0, 1000000));
+			}
+
+			// The tasks run on the workers as well
+			TaskPool pool(3);
+			std::mutex mutex;
+			std::set<std::thread::id> threads;
+			{
+				TaskGroup group(pool);
+				for (int i = 0; i < 200; ++i)
+					group.run([&]() {
+						std::this_thread::sleep_for(std::chrono::microseconds(200));
+						std::lock_guard<std::mutex> lock(mutex);
+						threads.insert(std::this_thread::get_id());
+					});
+				group.wait();
+			}
+			Assert::IsTrue(threads.size() > 1);
+
+			// The first exception is thrown by wait() after all tasks finished
+			std::atomic<int> finished(0);
+			TaskGroup group(pool);
+			for (int i = 0; i < 10; ++i)
+				group.run([&finished, i]() {
+					++finished;
+					if (i == 5)
+						throw Exception(L"Task %d failed", i);
+				});
+
+			bool thrown = false;
+			try { group.wait(); }
+			catch (const Exception & e) { thrown = e.getMessage() == L"Task 5 failed"; }
+			Assert::IsTrue(thrown);
+			Assert::AreEqual(10, finished.load());
+		}
+
+		TEST_METHOD(TestFenwickTree) {
+
+			FenwickTree<double> heights(10, 1.0);
+			Assert::AreEqual(10.0, heights.getTotal());
+			Assert::AreEqual(4.0, heights.getPrefixSum(4));
+
+			heights.set(3, 5);
+			Assert::AreEqual(8.0, heights.getPrefixSum(4));
+			Assert::AreEqual(14.0, heights.getTotal());
+
+			// The index covering a position
+			Assert::AreEqual((size_t)0, heights.findIndex(0));
+			Assert::AreEqual((size_t)2, heights.findIndex(2.5));
+			Assert::AreEqual((size_t)3, heights.findIndex(3));
+			Assert::AreEqual((size_t)3, heights.findIndex(7.9));
+			Assert::AreEqual((size_t)4, heights.findIndex(8));
+			Assert::AreEqual((size_t)10, heights.findIndex(14));
+
+			// Compared with plain sums
+			FenwickTree<int> tree;
+			std::vector<int> values(1000);
+			for (size_t i = 0; i < values.size(); ++i)
+				values[i] = (int)(i % 7);
+			tree.assign(values.size(), [&values](size_t i) { return values[i]; });
+
+			for (size_t i = 0; i < values.size(); i += 13) {
+				values[i] = (int)(i % 5) + 1;
+				tree.set(i, values[i]);
+			}
+
+			int sum = 0;
+			for (size_t i = 0; i < values.size(); ++i) {
+				Assert::AreEqual(sum, tree.getPrefixSum(i));
+				if (values[i] > 0)
+					Assert::AreEqual(i, tree.findIndex(sum));
+				sum += values[i];
+			}
+			Assert::AreEqual(sum, tree.getTotal());
+
+			bool thrown = false;
+			try {
+				tree.get(values.size());
+			}
+			catch (Exception &) {
+				thrown = true;
+			}
+			Assert::IsTrue(thrown);
+		}
 	};
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "CppUnitTest.h"
 
 #include <iostream>
+#include <sstream>
+#include <thread>
 
 #include <viu2xCore/common.h>
 #include <viu2xCore/gui.h>
@@ -11,6 +13,22 @@ using namespace v2x;
 
 namespace viu2xTests
 {
+	namespace {
+
+		/// A control of a base class which runs without window host, e.g. to
+		/// test the layout
+		template <class Base>
+		class TestPanel : public Base {
+		public:
+			DEFINE_POINTERS(TestPanel);
+			using Base::Base;
+			void show() override {}
+			void close() override {}
+		};
+
+		typedef TestPanel<ControlContainer> TestContainer;
+	}
+
 	TEST_CLASS(TestGui)
 	{
 	public:
@@ -47,5 +65,1456 @@ namespace viu2xTests
 			Assert::IsTrue(EnumString<FontStyle>::toString(FontStyle::Underline) == L"Underline");
 		}
 
+
+		TEST_METHOD(TestSessionReplay) {
+
+			struct MessagePayload1 {
+				int32_t value;
+			};
+
+			class EventCounter : public Object {
+			public:
+				DEFINE_POINTERS(EventCounter);
+				EventCounter() : Resizes(0), MouseMoves(0), KeyDowns(0), Paints(0), Timers(0) {}
+				virtual ~EventCounter() {}
+
+				int Resizes;
+				int MouseMoves;
+				int KeyDowns;
+				int Paints;
+				int Timers;
+				String LastKey;
+				Size2D64F LastSize;
+
+				void doOnResize(Event::Shared e) { ++Resizes; LastSize = e->getDataAs<EventDataWindowSize>()->Size; }
+				void doOnMouseMove(Event::Shared e) { ++MouseMoves; }
+				void doOnKeyDown(Event::Shared e) { ++KeyDowns; LastKey = e->getDataAs<EventDataKeyboard>()->Key; }
+				void doOnPaint(Event::Shared e) { ++Paints; }
+				void doOnTimer(Event::Shared e) { ++Timers; }
+			};
+
+			SessionPayloadTypes payloadTypes;
+			payloadTypes.add<MessagePayload1>();
+
+			// Record a session on a headless host
+			WindowHostHeadless::Shared host = WindowHostHeadless::createNew(Size2D64F(640, 480));
+			SessionRecorder::Shared recorder(new SessionRecorder(payloadTypes));
+			recorder->attach(host);
+
+			host->show();
+			host->setPosition(Rect64F(10, 20, 800, 600));
+			for (int i = 0; i < 10; ++i)
+				host->OnMouseMove.notifyEvent(host, EventDataMouse::Shared(
+					new EventDataMouse(Vector2D64F(i, i * 2), MouseButton::Left, EnumSet<KeyModifier>(KeyModifier::Shift))));
+			host->OnPaint.notifyEvent(host, Object::Shared());
+			host->OnKeyDown.notifyEvent(host, EventDataKeyboard::Shared(
+				new EventDataKeyboard(L"F10", EnumSet<KeyModifier>())));
+			recorder->recordTimerTick(7);
+			recorder->recordMessage(Message(123, MessagePayload1{ 456 }));
+			host->OnPaint.notifyEvent(host, Object::Shared());
+			recorder->detach();
+
+			// Events after detaching are not recorded
+			host->OnPaint.notifyEvent(host, Object::Shared());
+
+			SessionLog::Shared log = recorder->getLog();
+			Assert::AreEqual(17u, log->getRecordCount());
+
+			// Save and reload
+			std::stringstream stream;
+			log->save(stream);
+			SessionLog::Shared loaded(new SessionLog());
+			loaded->load(stream);
+			Assert::AreEqual(log->getRecordCount(), loaded->getRecordCount());
+			Assert::AreEqual(log->getDuration(), loaded->getDuration());
+
+			// A truncated log is rejected and the loaded one is kept
+			std::string truncated = stream.str();
+			truncated.resize(truncated.size() - 1);
+			uint32_t dataSize;
+			memcpy(&dataSize, &truncated[12], sizeof(dataSize));
+			--dataSize;
+			memcpy(&truncated[12], &dataSize, sizeof(dataSize));
+			std::stringstream truncatedStream(truncated);
+			bool thrown = false;
+			try { loaded->load(truncatedStream); }
+			catch (const Exception &) { thrown = true; }
+			Assert::IsTrue(thrown);
+			Assert::AreEqual(log->getRecordCount(), loaded->getRecordCount());
+			Assert::AreEqual(log->getDuration(), loaded->getDuration());
+
+			// Replay into another headless host
+			WindowHostHeadless::Shared replayHost = WindowHostHeadless::createNew();
+			EventCounter::Shared counter(new EventCounter());
+			replayHost->OnResize += EVENTHANDLER(counter, EventCounter::doOnResize);
+			replayHost->OnMouseMove += EVENTHANDLER(counter, EventCounter::doOnMouseMove);
+			replayHost->OnKeyDown += EVENTHANDLER(counter, EventCounter::doOnKeyDown);
+			replayHost->OnPaint += EVENTHANDLER(counter, EventCounter::doOnPaint);
+			replayHost->OnTimer += EVENTHANDLER(counter, EventCounter::doOnTimer);
+
+			int receivedPayload = 0;
+			SessionReplayer replayer(payloadTypes);
+			replayer.setMessageTarget([&receivedPayload](const Message & message) {
+				receivedPayload = message.getPayload<MessagePayload1>().value;
+				return true;
+			});
+
+			std::vector<FrameTiming> frames = replayer.replay(*loaded, replayHost);
+
+			Assert::AreEqual(2u, frames.size());
+			Assert::AreEqual(13u, frames[0].RecordCount);
+			Assert::AreEqual(4u, frames[1].RecordCount);
+			Assert::AreEqual(1, counter->Resizes);
+			Assert::AreEqual(800.0, counter->LastSize.width());
+			Assert::AreEqual(10, counter->MouseMoves);
+			Assert::AreEqual(1, counter->KeyDowns);
+			Assert::AreEqual(L"F10", counter->LastKey.c_str());
+			Assert::AreEqual(2, counter->Paints);
+			Assert::AreEqual(1, counter->Timers);
+			Assert::AreEqual(456, receivedPayload);
+		}
+
+		TEST_METHOD(TestSpecStorage) {
+
+			// Members store only a back-pointer to the parent and their set-flag
+			// lives in the set-mask of the parent. Composites add a small header
+			// with change mask, version and cached hash.
+			Assert::IsTrue(sizeof(NumberSpec) <= sizeof(double) + 2 * sizeof(void *));
+			Assert::IsTrue(sizeof(ScalarSpec) - 2 * sizeof(NumberSpec) <= 48);
+			// A layout spec holds ten scalars, three enums and two headers. A
+			// control holds about 44 doubles of geometry, measure cache and
+			// resolved layout besides its pointers.
+			Assert::IsTrue(sizeof(LayoutSpec) <= 10 * sizeof(ScalarSpec) + 6 * sizeof(NumberSpec));
+			Assert::IsTrue(sizeof(Control) <= 44 * sizeof(double) + 32 * sizeof(void *));
+
+			int changes = 0;
+			Listener listener = [&changes](const void * sender, const void * data) { ++changes; };
+
+			LayoutSpec layout(listener);
+			Assert::IsFalse(layout.isSet());
+			Assert::IsFalse(layout.Margin.isSet());
+
+			layout.Margin.Left.Size = 5;
+			Assert::IsTrue(layout.Margin.Left.Size.isSet());
+			Assert::IsTrue(layout.Margin.Left.isSet());
+			Assert::IsTrue(layout.Margin.isSet());
+			Assert::IsTrue(layout.isSet());
+			Assert::IsFalse(layout.Margin.Top.isSet());
+			Assert::AreEqual(1, changes);
+
+			layout.Margin.Left.Size.unset();
+			Assert::IsFalse(layout.Margin.isSet());
+			Assert::IsFalse(layout.isSet());
+			Assert::AreEqual(2, changes);
+
+			// Batched changes are notified only once
+			layout.beginUpdate();
+			layout.Width = ScalarSpec(100);
+			layout.Height = ScalarSpec(50, ScalarUnit::Parent);
+			layout.HorizontalAlignment = HorizontalAlignment::Center;
+			layout.endUpdate();
+			Assert::AreEqual(3, changes);
+
+			// Copies do not notify the listener of the original
+			LayoutSpec copy(layout);
+			Assert::IsTrue(copy == layout);
+			copy.Width.Size = 200;
+			Assert::IsTrue(copy != layout);
+			Assert::AreEqual(3, changes);
+
+			FontSpec font(L"Arial", 12, FontStyles(FontStyle::Bold));
+			FontSpec fontCopy(font);
+			Assert::IsTrue(fontCopy == font);
+		}
+
+		TEST_METHOD(TestSharedSpecs) {
+
+			InternPool<LayoutSpec> & pool = InternPool<LayoutSpec>::getDefault();
+			pool.getEmpty();
+			pool.purge();
+			const size_t uniqueBefore = pool.getUniqueCount();
+			const size_t totalBefore = pool.getTotalCount();
+
+			int changes = 0;
+			Listener listener = [&changes](const void * sender, const void * data) { ++changes; };
+
+			// Copies do not take over the listener, so each spec is constructed
+			// in place
+			std::vector<SharedLayoutSpec> layouts;
+			layouts.reserve(1000);
+			for (size_t i = 0; i < 1000; ++i)
+				layouts.emplace_back(listener);
+			for (size_t i = 0; i < layouts.size(); i += 2)
+				layouts[i].edit([](LayoutSpec & layout) { layout.Width.Size = 100; });
+			Assert::AreEqual(500, changes);
+
+			// Equal values share one instance
+			Assert::IsTrue(layouts[0] == layouts[2]);
+			Assert::IsTrue(layouts[0].getInstance() == layouts[998].getInstance());
+			Assert::IsTrue(layouts[0] != layouts[1]);
+			Assert::IsTrue(layouts[0].isSet());
+			Assert::IsFalse(layouts[1].isSet());
+			Assert::AreEqual(100.0, layouts[0]->Width.Size.get());
+
+			Assert::IsTrue(pool.getUniqueCount() <= uniqueBefore + 2);
+			Assert::AreEqual(totalBefore + 1000, pool.getTotalCount());
+
+			// Copy-on-write leaves the other references untouched
+			layouts[0].edit([](LayoutSpec & layout) { layout.Height.Size = 50; });
+			Assert::AreEqual(501, changes);
+			Assert::IsTrue(layouts[0] != layouts[2]);
+			Assert::IsFalse(layouts[2]->Height.isSet());
+
+			// Writing an equal value is not a change
+			const int changesBefore = changes;
+			layouts[2] = layouts[4].get();
+			Assert::AreEqual(changesBefore, changes);
+
+			layouts.clear();
+			pool.purge();
+			Assert::AreEqual(uniqueBefore, pool.getUniqueCount());
+		}
+
+		TEST_METHOD(TestUpdateTransaction) {
+
+			class CountingContainer : public TestContainer {
+			public:
+				DEFINE_POINTERS(CountingContainer);
+
+				CountingContainer() : InvalidatedCount(0), DirtyCount(0), LayoutChangeCount(0) {}
+
+				size_t InvalidatedCount;
+				size_t DirtyCount;
+				size_t LayoutChangeCount;
+
+			protected:
+				void doOnInvalidated(const DirtySet & dirtySet) override {
+					++InvalidatedCount;
+					DirtyCount = dirtySet.count();
+				}
+				void doOnLayoutChange(const void * sender, const void * data) override {
+					++LayoutChangeCount;
+					ControlContainer::doOnLayoutChange(sender, data);
+				}
+			};
+
+			CountingContainer::Shared root(new CountingContainer());
+			std::vector<CountingContainer::Shared> children;
+			for (size_t i = 0; i < 500; ++i) {
+				children.push_back(CountingContainer::Shared(new CountingContainer()));
+				root->Add(children.back());
+			}
+			Assert::IsTrue(children[0]->getParent() == root.get());
+
+			// Without transaction every change is handed over at once
+			root->InvalidatedCount = 0;
+			children[0]->Layout.edit([](LayoutSpec & layout) { layout.Width.Size = 10; });
+			Assert::AreEqual((size_t)1, root->InvalidatedCount);
+			Assert::AreEqual((size_t)1, children[0]->LayoutChangeCount);
+
+			root->InvalidatedCount = 0;
+			children[0]->LayoutChangeCount = 0;
+			{
+				UpdateTransaction transaction;
+				for (size_t i = 0; i < children.size(); ++i) {
+					children[i]->Layout.edit([i](LayoutSpec & layout) { layout.Width.Size = (double)i; });
+					children[i]->Layout.edit([](LayoutSpec & layout) { layout.Height.Size = 20; });
+					children[i]->Font.edit([](FontSpec & font) { font.Size.Size = 12; });
+				}
+				{
+					// Nested transactions commit with the outermost one
+					UpdateTransaction nested;
+					root->ContentLayout.edit([](ContentLayoutSpec & layout) { layout.Padding.Left.Size = 5; });
+				}
+
+				Assert::AreEqual((size_t)0, root->InvalidatedCount);
+				Assert::AreEqual((size_t)0, children[0]->LayoutChangeCount);
+			}
+
+			// One consolidated dirty set and one notification per control
+			Assert::AreEqual((size_t)1, root->InvalidatedCount);
+			Assert::AreEqual((size_t)501, root->DirtyCount);
+			for (size_t i = 0; i < children.size(); ++i)
+				Assert::AreEqual((size_t)1, children[i]->LayoutChangeCount);
+
+			// A throwing handler neither stops the commit nor leaves the
+			// transaction open
+			int handled = 0;
+			{
+				UpdateTransaction transaction;
+				UpdateTransaction::addCommitHandler(&handled, []() { throw Exception(L"Commit failed"); });
+				UpdateTransaction::addCommitHandler(&root, [&handled]() { ++handled; });
+				bool thrown = false;
+				try { transaction.commit(); }
+				catch (const Exception &) { thrown = true; }
+				Assert::IsTrue(thrown);
+				Assert::AreEqual(1, handled);
+
+				// The destructor drops the error
+				UpdateTransaction::addCommitHandler(&handled, []() { throw Exception(L"Commit failed"); });
+			}
+			Assert::IsFalse(UpdateTransaction::isActive());
+
+			root->InvalidatedCount = 0;
+			{
+				UpdateTransaction transaction;
+				children[0]->Layout.edit([](LayoutSpec & layout) { layout.Width.Size = 30; });
+			}
+			Assert::AreEqual((size_t)1, root->InvalidatedCount);
+		}
+
+		TEST_METHOD(TestSpecChangeFields) {
+
+			uint32_t changedFields = 0;
+			int changes = 0;
+			Listener listener = [&](const void * sender, const void * data) {
+				changedFields = static_cast<const SpecChange *>(data)->ChangedFields;
+				++changes;
+			};
+
+			LayoutSpec layout(listener);
+
+			layout.Margin.Left.Size = 5;
+			Assert::IsTrue(LayoutFields::fromBits(changedFields) == LayoutSpec::Field::Margin);
+
+			// Batched changes are merged
+			layout.beginUpdate();
+			layout.Width.Size = 100;
+			layout.HorizontalAlignment = HorizontalAlignment::Center;
+			layout.endUpdate();
+			Assert::IsTrue(LayoutFields::fromBits(changedFields) ==
+				LayoutFields(LayoutSpec::Field::Width) + LayoutSpec::Field::HorizontalAlignment);
+
+			// Equal values are no changes
+			changes = 0;
+			layout.Width.Size = 100;
+			layout = LayoutSpec(layout);
+			Assert::AreEqual(0, changes);
+
+			// Shared specs report the fields which differ
+			SharedFontSpec font(FontSpec(L"Arial", 12, FontStyles()), listener);
+			font.edit([](FontSpec & value) { value.Styles = FontStyles(FontStyle::Bold); });
+			Assert::IsTrue(FontFields::fromBits(changedFields) == FontSpec::Field::Styles);
+
+			// Controls choose the invalidation by the changed fields
+			class RecordingContainer : public TestContainer {
+			public:
+				DEFINE_POINTERS(RecordingContainer);
+
+				DirtySet LastDirtySet;
+
+			protected:
+				void doOnInvalidated(const DirtySet & dirtySet) override {
+					LastDirtySet = dirtySet;
+				}
+			};
+
+			RecordingContainer::Shared root(new RecordingContainer());
+			RecordingContainer::Shared child(new RecordingContainer());
+			root->Add(child);
+
+			child->Layout.edit([](LayoutSpec & value) { value.VerticalAlignment = VerticalAlignment::Bottom; });
+			Assert::IsFalse(root->LastDirtySet.getInvalidations(child.get()).contains(Invalidation::Measure));
+			Assert::IsTrue(root->LastDirtySet.getInvalidations(child.get()).contains(Invalidation::Arrange));
+
+			child->Layout.edit([](LayoutSpec & value) { value.Margin.Top.Size = 3; });
+			Assert::IsTrue(root->LastDirtySet.getInvalidations(child.get()).contains(Invalidation::Measure));
+		}
+
+		TEST_METHOD(TestSpecVersions) {
+
+			LayoutSpec layout;
+			const uint64_t version = layout.getVersion();
+			const size_t hash = layout.hash();
+
+			// A member change renews the versions and hashes of all parents
+			layout.Margin.Left.Size = 5;
+			Assert::IsTrue(layout.getVersion() > version);
+			Assert::IsTrue(layout.Margin.getVersion() > version);
+			Assert::IsTrue(layout.hash() != hash);
+
+			// Even within a batch
+			const uint64_t version2 = layout.getVersion();
+			const size_t hash2 = layout.hash();
+			layout.beginUpdate();
+			layout.Width.Size = 100;
+			Assert::IsTrue(layout.getVersion() > version2);
+			Assert::IsTrue(layout.hash() != hash2);
+			layout.endUpdate();
+
+			// Reading does not change the version
+			const uint64_t version3 = layout.getVersion();
+			layout.hash();
+			Assert::IsTrue(layout == LayoutSpec(layout));
+			Assert::AreEqual(version3, layout.getVersion());
+
+			// Equal values have equal hashes
+			LayoutSpec other;
+			other.Width.Size = 100;
+			other.Margin.Left.Size = 5;
+			Assert::AreEqual(layout.hash(), other.hash());
+			Assert::IsTrue(layout == other);
+			other.Margin.Left.Size = 6;
+			Assert::IsFalse(layout == other);
+
+			// The combined version of a control
+			TestContainer::Shared root(new TestContainer());
+			uint64_t inputs = root->getLayoutInputsVersion();
+
+			root->Font.edit([](FontSpec & font) { font.Size.Size = 20; });
+			Assert::IsTrue(root->getLayoutInputsVersion() > inputs);
+			inputs = root->getLayoutInputsVersion();
+
+			root->ContentLayout.edit([](ContentLayoutSpec & content) { content.FlowDirection = FlowDirection::BottomLeftToTopRight; });
+			Assert::IsTrue(root->getLayoutInputsVersion() > inputs);
+			inputs = root->getLayoutInputsVersion();
+
+			root->Add(TestContainer::Shared(new TestContainer()));
+			Assert::IsTrue(root->getLayoutInputsVersion() > inputs);
+			inputs = root->getLayoutInputsVersion();
+
+			root->Cursor = Cursor::Busy;
+			Assert::AreEqual(inputs, root->getLayoutInputsVersion());
+		}
+
+		TEST_METHOD(TestObservableChildren) {
+
+			// Range operations notify once
+			std::vector<CollectionAction> actions;
+			std::vector<size_t> counts;
+			ObservableVector<int32_t> numbers([&](const void *, const void * data) {
+				auto change = static_cast<const ObservableVector<int32_t>::Change *>(data);
+				actions.push_back(change->Action);
+				counts.push_back(change->Count + change->OldItems.size());
+			});
+
+			std::vector<int32_t> range;
+			for (int32_t i = 0; i < 10; ++i)
+				range.push_back(i);
+			numbers.append(range.begin(), range.end());
+			Assert::AreEqual((size_t)1, actions.size());
+			Assert::AreEqual((size_t)10, counts.back());
+			Assert::AreEqual((size_t)7, numbers.indexOf(7));
+			Assert::IsTrue(numbers.indexOf(10) == ObservableVector<int32_t>::NotFound);
+
+			numbers.remove(2, 3);
+			Assert::IsTrue(actions.back() == CollectionAction::Remove);
+			Assert::AreEqual((size_t)3, counts.back());
+			Assert::AreEqual((size_t)2, numbers.indexOf(5));
+			Assert::IsFalse(numbers.contains(3));
+
+			// 0 1 5 6 7 8 9 -> 0 7 8 1 5 6 9
+			numbers.move(4, 2, 1);
+			Assert::IsTrue(actions.back() == CollectionAction::Move);
+			Assert::AreEqual(7, numbers[1]);
+			Assert::AreEqual(1, numbers[3]);
+			Assert::AreEqual((size_t)3, numbers.indexOf(1));
+			Assert::AreEqual((size_t)6, numbers.indexOf(9));
+
+			// 0 7 8 1 5 6 9 -> 0 7 20 21 6 9
+			std::vector<int32_t> replacement = { 20, 21 };
+			numbers.replace(2, 3, replacement.begin(), replacement.end());
+			Assert::IsTrue(actions.back() == CollectionAction::Replace);
+			Assert::AreEqual((size_t)6, numbers.size());
+			Assert::AreEqual((size_t)3, numbers.indexOf(21));
+			Assert::AreEqual((size_t)4, numbers.indexOf(6));
+
+			// Elements are unique
+			const size_t notifications = actions.size();
+			bool thrown = false;
+			try { numbers.push_back(6); }
+			catch (const Exception &) { thrown = true; }
+			Assert::IsTrue(thrown);
+			Assert::AreEqual(notifications, actions.size());
+
+			numbers.clear();
+			Assert::IsTrue(actions.back() == CollectionAction::Reset);
+			Assert::IsTrue(numbers.empty());
+
+			// Children of containers
+			TestContainer::Shared root(new TestContainer());
+			TestContainer::Shared other(new TestContainer());
+			ControlContainer::SubControls controls;
+			for (int32_t i = 0; i < 100; ++i)
+				controls.push_back(TestContainer::Shared(new TestContainer()));
+			controls.push_back(controls.front());
+
+			const uint64_t version = root->getLayoutInputsVersion();
+			other->Add(controls[5]);
+			root->AddRange(controls);
+			Assert::AreEqual((size_t)100, root->getChildren().size());
+			Assert::IsTrue(root->getLayoutInputsVersion() > version);
+			Assert::IsTrue(root->hasChild(controls[5]));
+			Assert::IsFalse(other->hasChild(controls[5]));
+			Assert::IsTrue(controls[99]->getParent() == root.get());
+
+			root->Insert(0, controls[50]);
+			Assert::IsTrue(root->getChildren()[0] == controls[50]);
+			Assert::AreEqual((size_t)100, root->getChildren().size());
+
+			// A failed insert leaves the control with its parent
+			TestContainer::Shared child(new TestContainer());
+			other->Add(child);
+			thrown = false;
+			try { root->Insert(101, child); }
+			catch (const Exception &) { thrown = true; }
+			Assert::IsTrue(thrown);
+			Assert::IsTrue(other->hasChild(child));
+			Assert::AreEqual((size_t)100, root->getChildren().size());
+
+			root->RemoveRange(10, 40);
+			Assert::AreEqual((size_t)60, root->getChildren().size());
+			Assert::IsTrue(controls[20]->getParent() == nullptr);
+			Assert::IsFalse(root->hasChild(controls[20]));
+
+			root->Remove(controls[99]);
+			Assert::IsFalse(root->hasChild(controls[99]));
+
+			root->Clear();
+			Assert::IsTrue(root->getChildren().empty());
+			Assert::IsTrue(controls[0]->getParent() == nullptr);
+		}
+
+		TEST_METHOD(TestEnumReflection) {
+
+			// The counts are known at compile time
+			static_assert(EnumString<ScalarUnit>::getCount() == 5, "ScalarUnit has 5 values");
+			Assert::AreEqual((size_t)7, EnumString<FlowAlignment>::getCount());
+
+			// Every name is parsed back to its value
+			for (size_t i = 0; i < EnumString<FlowAlignment>::getCount(); ++i) {
+				const FlowAlignment value = static_cast<FlowAlignment>(i);
+				Assert::IsTrue(EnumString<FlowAlignment>::fromString(EnumString<FlowAlignment>::toString(value)) == value);
+			}
+			Assert::IsTrue(EnumString<Cursor>::fromString(L"Busy") == Cursor::Busy);
+
+			FlowDirection direction = FlowDirection::TopLeftToBottomRight;
+			Assert::IsFalse(EnumString<FlowDirection>::tryParse(L"TopLeft", direction));
+			Assert::IsFalse(EnumString<FlowDirection>::tryParse(L"", direction));
+			Assert::IsTrue(direction == FlowDirection::TopLeftToBottomRight);
+
+			// Names can be parsed from within a document
+			const Char * document = L"<Control Unit=\"Millimeter\"/>";
+			ScalarUnit unit = ScalarUnit::Pixel;
+			Assert::IsTrue(EnumString<ScalarUnit>::tryParse(document + 15, 10, unit));
+			Assert::IsTrue(unit == ScalarUnit::Millimeter);
+
+			bool thrown = false;
+			try { EnumString<ScalarUnit>::fromString(L"Inch"); }
+			catch (const Exception &) { thrown = true; }
+			Assert::IsTrue(thrown);
+
+			// Enum sets are sized by the count
+			Assert::AreEqual((size_t)1, sizeof(Invalidations));
+			Invalidations all = Invalidations().getComplement();
+			Assert::IsTrue(all == Invalidations(Invalidation::Measure) + Invalidation::Arrange + Invalidation::Canvas);
+		}
+
+		TEST_METHOD(TestLayoutEngine) {
+
+			// A leaf which wants a size
+			class TestControl : public TestContainer {
+			public:
+				DEFINE_POINTERS(TestControl);
+				Size2D64F Content = Size2D64F(40, 20);
+			protected:
+				Size2D64F doMeasure(const Size2D64F & availableSize) override { return Content; }
+			};
+
+			TestContainer::Shared root(new TestContainer());
+			root->ContentLayout.edit([](ContentLayoutSpec & layout) {
+				layout.Padding = PaddingSpec(10, 10, 10, 10);
+			});
+
+			// Margins, alignments and limits
+			TestControl::Shared a(new TestControl());
+			a->Layout.edit([](LayoutSpec & layout) {
+				layout.Margin = MarginSpec(5, 5, 5, 5);
+				layout.HorizontalAlignment = HorizontalAlignment::Right;
+				layout.VerticalAlignment = VerticalAlignment::Top;
+			});
+			TestControl::Shared b(new TestControl());
+			b->Layout.edit([](LayoutSpec & layout) {
+				layout.Width.Size = 50;
+				layout.Width.Unit = ScalarUnit::Parent;
+				layout.MaxHeight.Size = 30;
+			});
+			root->AddRange({ a, b });
+
+			root->updateLayout(Size2D64F(220, 120));
+			Assert::IsTrue(root->isLayoutValid());
+			Assert::AreEqual(50.0, a->getDesiredSize().width());
+			Assert::AreEqual(30.0, a->getDesiredSize().height());
+			Assert::AreEqual(165.0, a->getLayoutRect().getLeft());
+			Assert::AreEqual(15.0, a->getLayoutRect().getTop());
+			Assert::AreEqual(40.0, a->getLayoutRect().getWidth());
+
+			// Half of the content width, centered since the height is limited
+			Assert::AreEqual(100.0, b->getLayoutRect().getWidth());
+			Assert::AreEqual(60.0, b->getLayoutRect().getLeft());
+			Assert::AreEqual(30.0, b->getLayoutRect().getHeight());
+			Assert::AreEqual(45.0, b->getLayoutRect().getTop());
+
+			// Without limits the root wants its content
+			root->updateLayout(Size2D64F(INFINITY, INFINITY));
+			Assert::AreEqual(70.0, root->getDesiredSize().width());
+			Assert::AreEqual(50.0, root->getDesiredSize().height());
+			root->updateLayout(Size2D64F(220, 120));
+
+			// Nothing is laid out again without changes
+			LayoutStatistics & statistics = Control::getLayoutStatistics();
+			statistics.reset();
+			root->updateLayout(Size2D64F(220, 120));
+			Assert::AreEqual((uint64_t)0, statistics.Measures + statistics.Arranges);
+
+			// A change inside a fixed-size panel stays inside
+			TestContainer::Shared panel(new TestContainer());
+			panel->Layout.edit([](LayoutSpec & layout) {
+				layout.Width.Size = 80;
+				layout.Height.Size = 60;
+			});
+			TestControl::Shared c(new TestControl());
+			panel->Add(c);
+			root->Add(panel);
+			root->updateLayout(Size2D64F(220, 120));
+			Assert::IsTrue(panel->isLayoutBoundary());
+
+			statistics.reset();
+			c->Content = Size2D64F(10, 10);
+			c->Layout.edit([](LayoutSpec & layout) {
+				layout.HorizontalAlignment = HorizontalAlignment::Left;
+				layout.MinWidth.Size = 15;
+			});
+			Assert::IsFalse(root->isLayoutValid());
+			root->updateLayout(Size2D64F(220, 120));
+			Assert::AreEqual((uint64_t)2, statistics.Measures);
+			Assert::AreEqual((uint64_t)2, statistics.Arranges);
+			Assert::AreEqual(15.0, c->getLayoutRect().getWidth());
+			Assert::AreEqual(70.0, panel->getLayoutRect().getLeft());
+
+			// Resizing the panel lays out its parent
+			statistics.reset();
+			panel->Layout.edit([](LayoutSpec & layout) {
+				layout.Width.Size = 100;
+			});
+			root->updateLayout(Size2D64F(220, 120));
+			Assert::AreEqual(60.0, panel->getLayoutRect().getLeft());
+			Assert::IsTrue(statistics.Measures >= 2);
+		}
+
+		TEST_METHOD(TestIncrementalLayout) {
+
+			LayoutStatistics & statistics = Control::getLayoutStatistics();
+			const Size2D64F size(1920, 1080);
+			const int depth = 1000;
+
+			// A deep chain and a wide tree of fixed-size panels
+			TestContainer::Shared deep(new TestContainer());
+			ControlContainer * leaf = deep.get();
+			for (int i = 0; i < depth; ++i) {
+				TestContainer::Shared child(new TestContainer());
+				child->Layout.edit([](LayoutSpec & layout) { layout.Margin = MarginSpec(1, 1, 0, 0); });
+				leaf->Add(child);
+				leaf = child.get();
+			}
+
+			TestContainer::Shared wide(new TestContainer());
+			ControlContainer * panel = nullptr;
+			for (int i = 0; i < 100; ++i) {
+				TestContainer::Shared child(new TestContainer());
+				child->Layout.edit([](LayoutSpec & layout) {
+					layout.Width.Size = 100;
+					layout.Height.Size = 100;
+				});
+				for (int j = 0; j < 100; ++j)
+					child->Add(TestContainer::Shared(new TestContainer()));
+				wide->Add(child);
+				panel = child.get();
+			}
+
+			// A change of a single control measures only the controls up to the
+			// nearest boundary: all ancestors in the chain, the fixed-size panel
+			// and its children in the wide tree.
+			const Control::Shared roots[] = { deep, wide };
+			ControlContainer * const changed[] = { leaf, panel };
+			const uint64_t maxMeasures[] = { depth + 1, 101 };
+			for (int i = 0; i < 2; ++i) {
+				roots[i]->updateLayout(size);
+				Assert::IsTrue(roots[i]->isLayoutValid());
+
+				statistics.reset();
+				changed[i]->ContentLayout.edit([](ContentLayoutSpec & layout) { layout.Padding = PaddingSpec(1, 1, 1, 1); });
+				roots[i]->updateLayout(size);
+				Assert::IsTrue(roots[i]->isLayoutValid());
+				Assert::IsTrue(statistics.Measures <= maxMeasures[i]);
+				statistics.reset();
+			}
+		}
+
+		TEST_METHOD(TestMeasureCache) {
+
+			// A leaf which counts its measures
+			class TestControl : public TestContainer {
+			public:
+				DEFINE_POINTERS(TestControl);
+				int Measures = 0;
+			protected:
+				Size2D64F doMeasure(const Size2D64F & availableSize) override {
+					++Measures;
+					return Size2D64F(std::min(availableSize.width(), 300.0), 20);
+				}
+			};
+
+			TestContainer::Shared root(new TestContainer());
+			TestContainer::Shared panel(new TestContainer());
+			panel->Layout.edit([](LayoutSpec & layout) {
+				layout.Width.Size = 200;
+				layout.Height.Size = 100;
+				layout.HorizontalAlignment = HorizontalAlignment::Left;
+			});
+			TestControl::Shared fixed(new TestControl());
+			TestControl::Shared stretched(new TestControl());
+			stretched->Layout.edit([](LayoutSpec & layout) {
+				layout.HorizontalAlignment = HorizontalAlignment::Left;
+			});
+			panel->Add(fixed);
+			root->AddRange({ panel, stretched });
+
+			// Live resize: the panel content always gets the same constraint
+			LayoutStatistics & statistics = Control::getLayoutStatistics();
+			statistics.reset();
+			for (int i = 0; i < 10; ++i)
+				root->updateLayout(Size2D64F(400 + i * 10, 300));
+			Assert::AreEqual(1, fixed->Measures);
+			Assert::AreEqual(10, stretched->Measures);
+			Assert::AreEqual((uint64_t)9, statistics.MeasureCacheHits);
+
+			// Resizing back takes the sizes from the cache
+			stretched->Measures = 0;
+			root->updateLayout(Size2D64F(480, 300));
+			root->updateLayout(Size2D64F(490, 300));
+			Assert::AreEqual(0, stretched->Measures);
+			Assert::AreEqual(300.0, stretched->getLayoutRect().getWidth());
+			root->updateLayout(Size2D64F(250, 300));
+			Assert::AreEqual(1, stretched->Measures);
+			Assert::AreEqual(250.0, stretched->getLayoutRect().getWidth());
+			Assert::IsTrue(stretched->getMeasureCache().count() <= MeasureCache::CAPACITY);
+
+			// Changes evict the entries up to the boundary
+			fixed->Layout.edit([](LayoutSpec & layout) {
+				layout.MaxHeight.Size = 10;
+			});
+			Assert::AreEqual((size_t)0, fixed->getMeasureCache().count());
+			Assert::AreEqual((size_t)0, panel->getMeasureCache().count());
+			Assert::IsTrue(root->getMeasureCache().count() > 0);
+			root->updateLayout(Size2D64F(250, 300));
+			Assert::AreEqual(2, fixed->Measures);
+			Assert::AreEqual(10.0, fixed->getLayoutRect().getHeight());
+
+			// Outdated entries are never returned
+			MeasureCache cache;
+			Size2D64F size;
+			cache.add(Size2D64F(10, 10), 1, Size2D64F(5, 5));
+			Assert::IsTrue(cache.find(Size2D64F(10, 10), 1, size));
+			Assert::IsFalse(cache.find(Size2D64F(10, 10), 2, size));
+			for (int i = 0; i < 10; ++i)
+				cache.add(Size2D64F(i, i), 3, Size2D64F(i, i));
+			Assert::AreEqual(MeasureCache::CAPACITY, cache.count());
+			Assert::IsTrue(cache.find(Size2D64F(9, 9), 3, size));
+			Assert::IsFalse(cache.find(Size2D64F(0, 0), 3, size));
+		}
+
+		TEST_METHOD(TestParallelLayout) {
+
+			// A dashboard of independent panels with content of varying size
+			auto createDashboard = []() {
+				TestContainer::Shared root(new TestContainer());
+				for (int i = 0; i < 200; ++i) {
+					TestContainer::Shared panel(new TestContainer());
+					panel->Layout.edit([i](LayoutSpec & layout) {
+						layout.Width.Size = 100 + i;
+						layout.Height.Size = 50;
+						layout.HorizontalAlignment = HorizontalAlignment::Left;
+						layout.VerticalAlignment = VerticalAlignment::Top;
+					});
+					for (int j = 0; j < 20; ++j) {
+						TestContainer::Shared item(new TestContainer());
+						item->Layout.edit([i, j](LayoutSpec & layout) {
+							layout.Margin = MarginSpec(i % 7, j, 0, 0);
+							layout.MaxWidth.Size = 10 + j * 5;
+							layout.HorizontalAlignment = j % 2 ? HorizontalAlignment::Right : HorizontalAlignment::Center;
+						});
+						panel->Add(item);
+					}
+					root->Add(panel);
+				}
+				return root;
+			};
+
+			auto collectRects = [](const ControlContainer & root, std::vector<Rect64F> & rects) {
+				for (auto i = root.getChildren().begin(); i != root.getChildren().end(); ++i) {
+					rects.push_back((*i)->getLayoutRect());
+					auto panel = std::dynamic_pointer_cast<ControlContainer>(*i);
+					for (auto j = panel->getChildren().begin(); j != panel->getChildren().end(); ++j)
+						rects.push_back((*j)->getLayoutRect());
+				}
+			};
+
+			LayoutStatistics & statistics = Control::getLayoutStatistics();
+
+			// Serial, which is the default
+			Assert::IsTrue(Control::getParallelLayoutPool() == nullptr);
+			auto serial = createDashboard();
+			statistics.reset();
+			serial->updateLayout(Size2D64F(1920, 1080));
+			const LayoutStatistics serialStatistics = statistics;
+			std::vector<Rect64F> serialRects;
+			collectRects(*serial, serialRects);
+
+			// Parallel, with a threshold below the size of a panel
+			TaskPool pool(4);
+			Control::setParallelLayout(&pool, 16);
+			Assert::AreEqual((size_t)4201, serial->getSubtreeSize());
+			auto parallel = createDashboard();
+			statistics.reset();
+			parallel->updateLayout(Size2D64F(1920, 1080));
+			Assert::AreEqual(serialStatistics.Measures, statistics.Measures);
+			Assert::AreEqual(serialStatistics.Arranges, statistics.Arranges);
+			std::vector<Rect64F> parallelRects;
+			collectRects(*parallel, parallelRects);
+
+			Assert::AreEqual(serialRects.size(), parallelRects.size());
+			for (size_t i = 0; i < serialRects.size(); ++i) {
+				Assert::IsTrue(serialRects[i].position == parallelRects[i].position);
+				Assert::IsTrue(serialRects[i].size == parallelRects[i].size);
+			}
+
+			// Invalid children are found in parallel as well
+			auto panel = std::dynamic_pointer_cast<ControlContainer>(parallel->getChildren()[150]);
+			panel->getChildren()[3]->Layout.edit([](LayoutSpec & layout) { layout.MinWidth.Size = 7; });
+			statistics.reset();
+			parallel->updateLayout(Size2D64F(1920, 1080));
+			Assert::AreEqual((uint64_t)2, statistics.Arranges);
+			Assert::AreEqual(7.0, panel->getChildren()[3]->getLayoutRect().getWidth());
+
+			// The subtree sizes follow the changes of the children
+			panel->RemoveRange(0, 10);
+			Assert::AreEqual((size_t)4191, parallel->getSubtreeSize());
+
+			Control::setParallelLayout(nullptr);
+		}
+
+		TEST_METHOD(TestTimeSlicedLayout) {
+
+			auto createPanels = []() {
+				TestContainer::Shared root(new TestContainer());
+				for (int i = 0; i < 200; ++i) {
+					TestContainer::Shared panel(new TestContainer());
+					panel->Layout.edit([i](LayoutSpec & layout) {
+						layout.Margin = MarginSpec(i, 0, 0, 0);
+						layout.HorizontalAlignment = HorizontalAlignment::Left;
+					});
+					for (int j = 0; j < 100; ++j) {
+						TestContainer::Shared item(new TestContainer());
+						item->Layout.edit([j](LayoutSpec & layout) {
+							layout.Width.Size = 10 + j;
+							layout.Width.Unit = ScalarUnit::Parent;
+							layout.HorizontalAlignment = HorizontalAlignment::Right;
+						});
+						panel->Add(item);
+					}
+					root->Add(panel);
+				}
+				return root;
+			};
+
+			TaskPool * defaultPool = Control::getParallelLayoutPool();
+			const size_t defaultThreshold = Control::getParallelLayoutThreshold();
+			Control::setParallelLayout(nullptr);
+
+			auto reference = createPanels();
+			reference->updateLayout(Size2D64F(1000, 800));
+			auto sliced = createPanels();
+			LayoutBudget unlimited;
+			Assert::IsTrue(sliced->updateLayout(Size2D64F(1000, 800), unlimited));
+
+			// Without time nothing changes
+			const ControlContainer & panel = *std::dynamic_pointer_cast<ControlContainer>(sliced->getChildren()[100]);
+			const Rect64F before = panel.getChildren()[50]->getLayoutRect();
+			LayoutBudget none(0);
+			Assert::IsFalse(sliced->updateLayout(Size2D64F(2000, 600), none));
+			Assert::IsTrue(none.isInterrupted());
+			Assert::IsTrue(panel.getChildren()[50]->getLayoutRect().size == before.size);
+			Assert::IsFalse(sliced->isLayoutValid());
+
+			// Slices continue where the previous one stopped
+			reference->updateLayout(Size2D64F(2000, 600));
+			int slices = 0;
+			for (;;) {
+				++slices;
+				LayoutBudget budget(0.5);
+				if (sliced->updateLayout(Size2D64F(2000, 600), budget))
+					break;
+				Assert::IsTrue(slices < 100000);
+			}
+			Assert::IsTrue(sliced->isLayoutValid());
+
+			for (size_t i = 0; i < sliced->getChildren().size(); i += 17) {
+				auto a = std::dynamic_pointer_cast<ControlContainer>(reference->getChildren()[i]);
+				auto b = std::dynamic_pointer_cast<ControlContainer>(sliced->getChildren()[i]);
+				Assert::IsTrue(a->getLayoutRect().position == b->getLayoutRect().position);
+				for (size_t j = 0; j < b->getChildren().size(); j += 7) {
+					Assert::IsTrue(a->getChildren()[j]->getLayoutRect().position == b->getChildren()[j]->getLayoutRect().position);
+					Assert::IsTrue(a->getChildren()[j]->getLayoutRect().size == b->getChildren()[j]->getLayoutRect().size);
+				}
+			}
+			// Hosts paint once per request
+			class PaintCounter : public Object {
+			public:
+				DEFINE_POINTERS(PaintCounter);
+				int Paints = 0;
+				int Continuations = 0;
+				void doOnPaint(Event::Shared e) {
+					++Paints;
+					if (Continuations > 0) {
+						--Continuations;
+						std::dynamic_pointer_cast<WindowHost>(e->Sender.lock())->requestPaint();
+					}
+				}
+			};
+
+			WindowHostHeadless::Shared host = WindowHostHeadless::createNew();
+			PaintCounter::Shared counter(new PaintCounter());
+			host->OnPaint += EVENTHANDLER(counter, PaintCounter::doOnPaint);
+			Assert::IsFalse(host->paint());
+			host->requestPaint();
+			host->requestPaint();
+			Assert::IsTrue(host->paint());
+			Assert::IsFalse(host->paint());
+			Assert::AreEqual(1, counter->Paints);
+
+			// A paint may request the next one, e.g. to continue a layout
+			counter->Continuations = 1;
+			host->requestPaint();
+			Assert::IsTrue(host->paint());
+			Assert::IsTrue(host->paint());
+			Assert::IsFalse(host->paint());
+			Assert::AreEqual(3, counter->Paints);
+
+			Control::setParallelLayout(defaultPool, defaultThreshold);
+		}
+
+		TEST_METHOD(TestFlowLayout) {
+
+			auto inlines = [](size_t count) {
+				return std::vector<FlowItem>(count, FlowItem(Size2D64F(30, 10)));
+			};
+			auto equals = [](const Rect64F & rect, double left, double top, double width, double height) {
+				return rect.getLeft() == left && rect.getTop() == top && rect.getWidth() == width && rect.getHeight() == height;
+			};
+
+			// Lines end before the first item which does not fit
+			FlowLayout flow;
+			Assert::AreEqual((size_t)0, flow.update(inlines(7), 100, FlowAlignment::Left));
+			Assert::AreEqual((size_t)3, flow.getLineCount());
+			Assert::IsTrue(equals(flow.getItemRect(3), 0, 10, 30, 10));
+			Assert::IsTrue(flow.getContentSize() == Size2D64F(90, 30));
+
+			// Directions mirror the lines
+			Assert::IsTrue(equals(flow.getItemRect(0, Size2D64F(100, 30), FlowDirection::TopRightToBottomLeft), 70, 0, 30, 10));
+			Assert::IsTrue(equals(flow.getItemRect(0, Size2D64F(100, 30), FlowDirection::BottomLeftToTopRight), 0, 20, 30, 10));
+
+			// The last line of a justified flow is aligned left
+			flow.update(inlines(7), 100, FlowAlignment::JustifyLeft);
+			Assert::IsTrue(equals(flow.getItemRect(1), 35, 0, 30, 10));
+			Assert::IsTrue(equals(flow.getItemRect(2), 70, 0, 30, 10));
+			Assert::IsTrue(equals(flow.getItemRect(6), 0, 20, 30, 10));
+
+			// The lines make way for a float
+			std::vector<FlowItem> items = inlines(8);
+			items[0] = FlowItem(Size2D64F(40, 25), PositionMode::FloatSurround, HorizontalAlignment::Left);
+			flow.update(items, 100, FlowAlignment::Left);
+			Assert::IsTrue(equals(flow.getItemRect(0), 0, 0, 40, 25));
+			Assert::IsTrue(equals(flow.getItemRect(2), 70, 0, 30, 10));
+			Assert::IsTrue(equals(flow.getItemRect(3), 40, 10, 30, 10));
+			Assert::IsTrue(equals(flow.getItemRect(6), 70, 20, 30, 10));
+			Assert::IsTrue(equals(flow.getItemRect(7), 0, 30, 30, 10));
+
+			items[0].Side = HorizontalAlignment::Right;
+			flow.update(items, 100, FlowAlignment::Left);
+			Assert::IsTrue(equals(flow.getItemRect(0), 60, 0, 40, 25));
+			Assert::IsTrue(equals(flow.getItemRect(2), 30, 0, 30, 10));
+
+			// A row float met within a line goes below it
+			items = inlines(3);
+			items[1] = FlowItem(Size2D64F(50, 20), PositionMode::FloatRow);
+			flow.update(items, 100, FlowAlignment::Left);
+			Assert::IsTrue(equals(flow.getItemRect(1), 0, 10, 100, 20));
+			Assert::IsTrue(equals(flow.getItemRect(2), 30, 0, 30, 10));
+			Assert::IsTrue(flow.getContentSize() == Size2D64F(100, 30));
+
+			// A change places the items again from the line before it
+			items = inlines(30);
+			flow.update(items, 100, FlowAlignment::JustifyLeft);
+			Assert::AreEqual(items.size(), flow.update(items, 100, FlowAlignment::JustifyLeft));
+			items[16].Size = Size2D64F(50, 10);
+			Assert::AreEqual((size_t)15, flow.update(items, 100, FlowAlignment::JustifyLeft));
+
+			FlowLayout fresh;
+			fresh.update(items, 100, FlowAlignment::JustifyLeft);
+			Assert::AreEqual(fresh.getLineCount(), flow.getLineCount());
+			for (size_t i = 0; i < items.size(); ++i)
+				Assert::IsTrue(fresh.getItemRect(i) == flow.getItemRect(i));
+
+			// Removing the last line turns the line before into the last one
+			items.resize(6);
+			flow.update(items, 100, FlowAlignment::JustifyLeft);
+			Assert::IsTrue(equals(flow.getItemRect(4), 30, 10, 30, 10));
+
+			// Items changed one by one are placed again from the line before
+			// the first change
+			Assert::AreEqual(items.size(), flow.update(100, FlowAlignment::JustifyLeft));
+			flow.setItem(4, FlowItem(Size2D64F(50, 10)));
+			Assert::AreEqual((size_t)3, flow.update(100, FlowAlignment::JustifyLeft));
+			flow.removeItems(5, 1);
+			flow.insertItems(1, 1, FlowItem(Size2D64F(20, 10)));
+			flow.moveItems(0, 1, 2);
+			flow.update(100, FlowAlignment::JustifyLeft);
+
+			items[4].Size = Size2D64F(50, 10);
+			items.erase(items.begin() + 5);
+			items.insert(items.begin() + 1, FlowItem(Size2D64F(20, 10)));
+			std::rotate(items.begin(), items.begin() + 1, items.begin() + 3);
+			fresh.update(items, 100, FlowAlignment::JustifyLeft);
+			Assert::AreEqual(items.size(), flow.getItemCount());
+			for (size_t i = 0; i < items.size(); ++i) {
+				Assert::IsTrue(flow.getItem(i) == items[i]);
+				Assert::IsTrue(fresh.getItemRect(i) == flow.getItemRect(i));
+			}
+
+			// The container flows its children
+			typedef TestPanel<FlowContainer> TestFlowContainer;
+
+			TestFlowContainer::Shared root(new TestFlowContainer());
+			for (int i = 0; i < 5; ++i) {
+				TestFlowContainer::Shared child(new TestFlowContainer());
+				child->Layout.edit([](LayoutSpec & layout) {
+					layout.Width.Size = 30;
+					layout.Width.Unit = ScalarUnit::Pixel;
+					layout.Height.Size = 10;
+					layout.Height.Unit = ScalarUnit::Pixel;
+				});
+				root->Add(child);
+			}
+
+			root->updateLayout(Size2D64F(100, 100));
+			Assert::IsTrue(equals(root->getChildren()[3]->getLayoutRect(), 0, 10, 30, 10));
+
+			root->ContentLayout.edit([](ContentLayoutSpec & layout) { layout.FlowAlignment = FlowAlignment::Right; });
+			root->updateLayout(Size2D64F(100, 100));
+			Assert::IsTrue(equals(root->getChildren()[0]->getLayoutRect(), 10, 0, 30, 10));
+			Assert::IsTrue(equals(root->getChildren()[4]->getLayoutRect(), 70, 10, 30, 10));
+
+			// The items follow the list and the specs of the children
+			root->Move(0, 1, 4);
+			root->getChildren()[1]->Layout.edit([](LayoutSpec & layout) { layout.Width.Size = 60; });
+			root->updateLayout(Size2D64F(100, 100));
+			Assert::IsTrue(equals(root->getChildren()[1]->getLayoutRect(), 40, 0, 60, 10));
+			Assert::IsTrue(equals(root->getChildren()[4]->getLayoutRect(), 70, 10, 30, 10));
+			Assert::IsTrue(root->getFlow().getItem(1).Size == Size2D64F(60, 10));
+
+			root->getChildren()[4]->Layout.edit([](LayoutSpec & layout) { layout.PositionMode = PositionMode::FloatRow; });
+			Assert::IsTrue(root->getFlow().getItem(4).Mode == PositionMode::FloatRow);
+			root->Remove(root->getChildren()[0]);
+			Assert::AreEqual((size_t)4, root->getFlow().getItemCount());
+		}
+
+		TEST_METHOD(TestLayoutUnits) {
+
+			// The factors depend on the resolution only
+			LayoutUnits units(144);
+			Assert::AreEqual(144.0, units.toPixels(72, ScalarUnit::Dot, NAN));
+			Assert::AreEqual(144.0, units.toPixels(25.4, ScalarUnit::Millimeter, NAN));
+			Assert::AreEqual(100.0, units.toPixels(50, ScalarUnit::Parent, 200));
+			Assert::IsTrue(std::isnan(units.toPixels(50, ScalarUnit::Parent, INFINITY)));
+
+			// A whole spec is resolved at once
+			LayoutSpec spec;
+			spec.Margin = MarginSpec(10, 20, 0, 0, ScalarUnit::Parent);
+			spec.Width = SizeSpec(72, ScalarUnit::Dot);
+			spec.MaxHeight = SizeSpec(50);
+			const ResolvedLayout resolved = units.resolve(spec, Size2D64F(300, 400));
+			Assert::AreEqual(30.0, resolved.Margin.Left);
+			Assert::AreEqual(80.0, resolved.Margin.Top);
+			Assert::AreEqual(144.0, resolved.Width);
+			Assert::IsTrue(std::isnan(resolved.Height));
+			Assert::AreEqual(0.0, resolved.MinHeight);
+			Assert::AreEqual(50.0, resolved.MaxHeight);
+			Assert::IsTrue(LayoutUnits::dependsOnDpi(spec));
+			Assert::IsFalse(LayoutUnits::dependsOnDpi(spec.Margin));
+
+			// A new resolution only invalidates the controls depending on it
+			// Like a window on a display
+			class TestRoot : public TestContainer {
+			public:
+				DEFINE_POINTERS(TestRoot);
+				LayoutUnits Units;
+
+				const LayoutUnits & getLayoutUnits() const override { return Units; }
+				void setLayoutUnits(const LayoutUnits & units) {
+					if (units == Units)
+						return;
+					Units = units;
+					doOnLayoutUnitsChange();
+				}
+			};
+
+			TestRoot::Shared window(new TestRoot());
+			TestContainer::Shared physical(new TestContainer());
+			physical->Layout.edit([](LayoutSpec & layout) {
+				layout.Width = SizeSpec(25.4, ScalarUnit::Millimeter);
+				layout.HorizontalAlignment = HorizontalAlignment::Left;
+			});
+			TestContainer::Shared pixels(new TestContainer());
+			pixels->Layout.edit([](LayoutSpec & layout) {
+				layout.Width = SizeSpec(100);
+				layout.Height = SizeSpec(100);
+			});
+			window->Add(physical);
+			window->Add(pixels);
+
+			window->updateLayout(Size2D64F(800, 600));
+			Assert::AreEqual(96.0, physical->getLayoutRect().getWidth());
+
+			window->setLayoutUnits(LayoutUnits(96));
+			Assert::IsTrue(physical->isLayoutValid());
+			window->setLayoutUnits(LayoutUnits(192));
+			Assert::IsFalse(physical->isLayoutValid());
+			Assert::IsTrue(pixels->isLayoutValid());
+
+			window->updateLayout(Size2D64F(800, 600));
+			Assert::AreEqual(192.0, physical->getLayoutRect().getWidth());
+			Assert::AreEqual(100.0, pixels->getLayoutRect().getWidth());
+		}
+
+		TEST_METHOD(TestVirtualizingContainer) {
+
+			typedef TestPanel<VirtualizingContainer> TestList;
+
+			// The items are half as high as estimated
+			size_t created = 0, bound = 0;
+			TestList::Shared list(new TestList(
+				[&created]() { ++created; return Control::Shared(new TestContainer()); },
+				[&bound](Control & control, size_t index) {
+					++bound;
+					control.Layout.edit([](LayoutSpec & layout) { layout.Height = SizeSpec(10); });
+				}));
+
+			const size_t count = 1000000;
+			list->setItems(count, [](size_t) { return 20.0; });
+			Assert::AreEqual(20.0 * count, list->getScrollExtent());
+
+			list->updateLayout(Size2D64F(200, 100));
+			Assert::AreEqual((size_t)0, list->getFirstRealizedItem());
+			Assert::IsTrue(list->getRealizedItemCount() >= 10 && list->getRealizedItemCount() <= 20);
+			Assert::AreEqual(list->getRealizedItemCount(), created);
+			Assert::AreEqual(30.0, list->getRealizedControl(3)->getLayoutRect().getTop());
+			Assert::AreEqual(20.0 * count - 10.0 * created, list->getScrollExtent());
+			Assert::IsTrue(list->getRealizedControl(100) == nullptr);
+
+			// Scrolling recycles the controls
+			list->setScrollOffset(1000);
+			list->updateLayout(Size2D64F(200, 100));
+			const size_t item = list->getItemAt(1000);
+			Assert::IsTrue(list->getFirstRealizedItem() <= item);
+			Assert::AreEqual(list->getItemOffset(item) - 1000, list->getRealizedControl(item)->getLayoutRect().getTop());
+			Assert::IsTrue(created <= 20);
+			Assert::IsTrue(bound > created);
+			Assert::AreEqual(created, list->getRealizedItemCount() + list->getPoolSize());
+
+			// Within the realized items only the positions change
+			Control::getLayoutStatistics().reset();
+			list->setScrollOffset(1005);
+			list->updateLayout(Size2D64F(200, 100));
+			Assert::AreEqual((uint64_t)0, Control::getLayoutStatistics().Measures);
+			Assert::AreEqual(list->getItemOffset(item) - 1005, list->getRealizedControl(item)->getLayoutRect().getTop());
+
+			// The end of the list
+			list->setScrollOffset(INFINITY);
+			list->updateLayout(Size2D64F(200, 100));
+			Assert::AreEqual(list->getScrollExtent() - 100, list->getScrollOffset());
+			Assert::IsTrue(list->getRealizedControl(count - 1) != nullptr);
+		}
+
+		TEST_METHOD(TestParallelVirtualizingContainer) {
+
+			typedef TestPanel<VirtualizingContainer> TestList;
+
+			// Lists besides panels which are forked. The binders edit specs,
+			// so they must run on the thread which started the layout.
+			const std::thread::id thread = std::this_thread::get_id();
+			std::atomic<int> foreignBinds(0);
+			auto createLists = [thread, &foreignBinds]() {
+				TestContainer::Shared root(new TestContainer());
+				for (int i = 0; i < 16; ++i) {
+					ControlContainer::Shared child;
+					if (i % 2) {
+						TestList::Shared list(new TestList(
+							[]() { return Control::Shared(new TestContainer()); },
+							[thread, &foreignBinds](Control & control, size_t index) {
+								if (std::this_thread::get_id() != thread)
+									++foreignBinds;
+								control.Layout.edit([index](LayoutSpec & layout) { layout.Height = SizeSpec(10 + index % 3); });
+							}));
+						list->setItems(10000, [](size_t) { return 20.0; });
+						child = list;
+					}
+					else {
+						child.reset(new TestContainer());
+						for (int j = 0; j < 20; ++j)
+							child->Add(TestContainer::Shared(new TestContainer()));
+					}
+					child->Layout.edit([i](LayoutSpec & layout) {
+						layout.Margin = MarginSpec(i * 50, 0, 0, 0);
+						layout.Width.Size = 50;
+						layout.HorizontalAlignment = HorizontalAlignment::Left;
+					});
+					root->Add(child);
+				}
+				return root;
+			};
+
+			auto serial = createLists();
+			serial->updateLayout(Size2D64F(800, 300));
+
+			TaskPool pool(4);
+			Control::setParallelLayout(&pool, 4);
+			auto parallel = createLists();
+			Assert::IsTrue(parallel->hasSerialLayout());
+			parallel->updateLayout(Size2D64F(800, 300));
+			std::dynamic_pointer_cast<TestList>(parallel->getChildren()[1])->setScrollOffset(5000);
+			std::dynamic_pointer_cast<TestList>(serial->getChildren()[1])->setScrollOffset(5000);
+			parallel->updateLayout(Size2D64F(800, 300));
+			serial->updateLayout(Size2D64F(800, 300));
+			Control::setParallelLayout(nullptr);
+
+			Assert::AreEqual(0, foreignBinds.load());
+			for (size_t i = 1; i < 16; i += 2) {
+				auto a = std::dynamic_pointer_cast<TestList>(serial->getChildren()[i]);
+				auto b = std::dynamic_pointer_cast<TestList>(parallel->getChildren()[i]);
+				Assert::AreEqual(a->getFirstRealizedItem(), b->getFirstRealizedItem());
+				Assert::AreEqual(a->getRealizedItemCount(), b->getRealizedItemCount());
+				Assert::AreEqual(a->getScrollExtent(), b->getScrollExtent());
+				for (size_t j = 0; j < b->getRealizedItemCount(); ++j) {
+					const size_t item = b->getFirstRealizedItem() + j;
+					Assert::IsTrue(a->getRealizedControl(item)->getLayoutRect().position == b->getRealizedControl(item)->getLayoutRect().position);
+				}
+			}
+		}
+
+		TEST_METHOD(TestConstraintSolver) {
+
+			auto isNear = [](double expected, double actual) { return std::abs(expected - actual) < 1e-6; };
+
+			ConstraintSolver solver;
+			ConstraintVariable left = solver.createVariable();
+			ConstraintVariable width = solver.createVariable();
+			ConstraintVariable right = solver.createVariable();
+
+			// A column of at least 100 which prefers 300
+			solver.addConstraint(LinearConstraint(left, ConstraintRelation::Equal, 0));
+			solver.addConstraint(LinearConstraint(right, ConstraintRelation::Equal, left + width));
+			solver.addConstraint(LinearConstraint(width, ConstraintRelation::GreaterOrEqual, 100));
+			solver.addConstraint(LinearConstraint(width, ConstraintRelation::Equal, 300, ConstraintStrength::WEAK));
+			Assert::IsTrue(isNear(300, solver.getValue(right)));
+
+			// A strong edit overrides the preference but not the minimum
+			solver.addEditVariable(width, ConstraintStrength::STRONG);
+			solver.suggestValue(width, 200);
+			Assert::IsTrue(isNear(200, solver.getValue(right)));
+			solver.suggestValue(width, 50);
+			Assert::IsTrue(isNear(100, solver.getValue(width)));
+			solver.removeEditVariable(width);
+			Assert::IsTrue(isNear(300, solver.getValue(width)));
+
+			// Conflicting required constraints are rejected without changes
+			const ConstraintSolver::ConstraintId limit =
+				solver.addConstraint(LinearConstraint(right, ConstraintRelation::LessOrEqual, 250));
+			Assert::IsTrue(isNear(250, solver.getValue(width)));
+			bool isThrown = false;
+			try {
+				solver.addConstraint(LinearConstraint(width, ConstraintRelation::GreaterOrEqual, 260));
+			}
+			catch (const Exception &) {
+				isThrown = true;
+			}
+			Assert::IsTrue(isThrown);
+			Assert::IsTrue(isNear(250, solver.getValue(width)));
+			Assert::AreEqual((size_t)5, solver.getConstraintCount());
+			solver.removeConstraint(limit);
+			Assert::IsTrue(isNear(300, solver.getValue(width)));
+			Assert::AreEqual((size_t)4, solver.getConstraintCount());
+
+			// Resizing a row of columns which share the space beyond their
+			// minimum moves all of them
+			const size_t count = 100;
+			ConstraintSolver row;
+			ConstraintVariable total = row.createVariable();
+			LinearExpression end = 0;
+			std::vector<ConstraintVariable> widths;
+			for (size_t i = 0; i < count; ++i) {
+				widths.push_back(row.createVariable());
+				row.addConstraint(LinearConstraint(widths[i], ConstraintRelation::GreaterOrEqual, 10));
+				if (i > 0)
+					row.addConstraint(LinearConstraint(widths[i], ConstraintRelation::Equal, widths[0], ConstraintStrength::MEDIUM));
+				end += widths[i];
+			}
+			row.addConstraint(LinearConstraint(end, ConstraintRelation::Equal, total));
+			row.addEditVariable(total, ConstraintStrength::STRONG);
+
+			for (int size = 1000; size <= 3000; size += 20) {
+				row.suggestValue(total, size);
+				Assert::IsTrue(isNear(size / (double)count, row.getValue(widths[count / 2])));
+			}
+
+			// The minimum holds when the total is too small
+			row.suggestValue(total, 500);
+			Assert::IsTrue(isNear(10, row.getValue(widths[count - 1])));
+		}
+
+		TEST_METHOD(TestConstraintContainer) {
+
+			typedef TestPanel<ConstraintContainer> TestConstraints;
+
+			auto equals = [](const Rect64F & rect, double left, double top, double width, double height) {
+				return std::abs(rect.getLeft() - left) < 1e-6 && std::abs(rect.getTop() - top) < 1e-6 &&
+					std::abs(rect.getWidth() - width) < 1e-6 && std::abs(rect.getHeight() - height) < 1e-6;
+			};
+
+			TestConstraints::Shared container(new TestConstraints());
+			TestContainer::Shared left(new TestContainer()), right(new TestContainer()), background(new TestContainer());
+			container->Add(background);
+			container->Add(left);
+			container->Add(right);
+
+			// Two panes besides a splitter of 4 pixels
+			const ConstraintContainer::Anchors & content = container->getContentAnchors();
+			const ConstraintContainer::Anchors & l = container->getAnchors(left);
+			const ConstraintContainer::Anchors & r = container->getAnchors(right);
+			ConstraintVariable splitter = container->createVariable();
+			container->addConstraint(LinearConstraint(l.Left, ConstraintRelation::Equal, content.Left));
+			container->addConstraint(LinearConstraint(l.Top, ConstraintRelation::Equal, content.Top));
+			container->addConstraint(LinearConstraint(l.getBottom(), ConstraintRelation::Equal, content.getBottom()));
+			container->addConstraint(LinearConstraint(l.Width, ConstraintRelation::Equal, splitter));
+			container->addConstraint(LinearConstraint(r.Left, ConstraintRelation::Equal, l.getRight() + 4));
+			container->addConstraint(LinearConstraint(r.getRight(), ConstraintRelation::Equal, content.getRight()));
+			container->addConstraint(LinearConstraint(r.Top, ConstraintRelation::Equal, content.Top));
+			container->addConstraint(LinearConstraint(r.Height, ConstraintRelation::Equal, 30));
+			container->addEditVariable(splitter);
+			container->suggestValue(splitter, 200);
+
+			container->updateLayout(Size2D64F(800, 600));
+			Assert::IsTrue(equals(left->getLayoutRect(), 0, 0, 200, 600));
+			Assert::IsTrue(equals(right->getLayoutRect(), 204, 0, 596, 30));
+			Assert::IsTrue(equals(background->getLayoutRect(), 0, 0, 800, 600));
+
+			// Resizing keeps the splitter
+			container->updateLayout(Size2D64F(1000, 500));
+			Assert::IsTrue(equals(left->getLayoutRect(), 0, 0, 200, 500));
+			Assert::IsTrue(equals(right->getLayoutRect(), 204, 0, 796, 30));
+
+			// Dragging the splitter
+			container->suggestValue(splitter, 300);
+			Assert::IsFalse(container->isLayoutValid());
+			container->updateLayout(Size2D64F(1000, 500));
+			Assert::IsTrue(equals(right->getLayoutRect(), 304, 0, 696, 30));
+
+			// Removed children lose their anchors
+			const size_t count = container->getSolver().getConstraintCount();
+			container->Remove(right);
+			Assert::IsFalse(container->hasAnchors(right));
+			Assert::AreEqual(count - 4, container->getSolver().getConstraintCount());
+			container->updateLayout(Size2D64F(1000, 500));
+			Assert::IsTrue(equals(left->getLayoutRect(), 0, 0, 300, 500));
+		}
+
+		TEST_METHOD(TestLayoutTree) {
+
+			TestContainer::Shared root(new TestContainer()), a(new TestContainer()), a1(new TestContainer()), b(new TestContainer());
+			root->Add(a);
+			a->Add(a1);
+			root->Add(b);
+			a->Layout.edit([](LayoutSpec & layout) { layout.Margin = MarginSpec(10, 10, 10, 10); });
+			a1->Layout.edit([](LayoutSpec & layout) {
+				layout.Margin = MarginSpec(5, 5, 5, 5);
+				layout.Width.Size = 50;
+				layout.Height.Size = 50;
+				layout.HorizontalAlignment = HorizontalAlignment::Left;
+				layout.VerticalAlignment = VerticalAlignment::Top;
+			});
+			b->Layout.edit([](LayoutSpec & layout) {
+				layout.Width.Size = 100;
+				layout.Height.Size = 100;
+				layout.HorizontalAlignment = HorizontalAlignment::Right;
+				layout.VerticalAlignment = VerticalAlignment::Bottom;
+			});
+			root->updateLayout(Size2D64F(800, 600));
+
+			// The controls in tree order
+			LayoutTree tree;
+			tree.build(*root);
+			Assert::IsFalse(tree.isStale());
+			Assert::IsFalse(tree.areBoundsStale());
+			Assert::AreEqual((size_t)4, tree.size());
+			Assert::IsTrue(tree.getControl(2) == a1.get());
+			Assert::AreEqual((uint32_t)2, a1->getLayoutIndex());
+			Assert::AreEqual(LayoutTree::NONE, tree.getParent(0));
+			Assert::AreEqual((uint32_t)1, tree.getParent(2));
+			Assert::AreEqual((uint32_t)1, tree.getFirstChild(0));
+			Assert::AreEqual((uint32_t)3, tree.getNextSibling(1));
+			Assert::AreEqual((uint32_t)3, tree.getSubtreeEnd(1));
+			Assert::AreEqual((uint32_t)4, tree.getSubtreeEnd(3));
+			Assert::IsTrue(tree.isLayoutValid());
+
+			// The bounds in the coordinates of the root
+			Assert::IsTrue(tree.getBounds(2) == Rect64F(15, 15, 50, 50));
+			Assert::IsTrue(tree.getBounds(3) == Rect64F(700, 500, 100, 100));
+			Assert::AreEqual(5.0, tree.getResolvedLayout(2).Margin.Left);
+
+			Assert::AreEqual((uint32_t)2, tree.hitTest(Vector2D64F(20, 20)));
+			Assert::AreEqual((uint32_t)1, tree.hitTest(Vector2D64F(12, 12)));
+			Assert::AreEqual((uint32_t)3, tree.hitTest(Vector2D64F(750, 550)));
+			Assert::AreEqual((uint32_t)0, tree.hitTest(Vector2D64F(5, 5)));
+			Assert::AreEqual(LayoutTree::NONE, tree.hitTest(Vector2D64F(900, 900)));
+
+			// Invalidations and layouts are written through
+			a1->Layout.edit([](LayoutSpec & layout) { layout.Margin.Left.Size = 20; });
+			Assert::AreEqual((int)(LayoutTree::MEASURE_INVALID | LayoutTree::ARRANGE_INVALID), (int)tree.getDirtyBits(2));
+			Assert::IsTrue((tree.getDirtyBits(0) & LayoutTree::DESCENDANT_INVALID) != 0);
+			Assert::IsFalse(tree.isLayoutValid());
+			root->updateLayout(Size2D64F(800, 600));
+			Assert::IsTrue(tree.isLayoutValid());
+			Assert::IsTrue(tree.areBoundsStale());
+			tree.updateBounds();
+			Assert::IsFalse(tree.areBoundsStale());
+			Assert::IsTrue(tree.getBounds(2) == Rect64F(30, 15, 50, 50));
+
+			// A layout which moves nothing keeps the bounds
+			a1->Layout.edit([](LayoutSpec & layout) { layout.MinWidth.Size = 10; });
+			root->updateLayout(Size2D64F(800, 600));
+			Assert::IsFalse(tree.areBoundsStale());
+
+			// Changed children and destroyed controls make it stale
+			root->Remove(b);
+			Assert::IsTrue(tree.isStale());
+			b.reset();
+			Assert::IsTrue(tree.getControl(3) == nullptr);
+			Assert::AreEqual((uint32_t)1, tree.hitTest(Vector2D64F(750, 550)));
+
+			tree.build(*root);
+			Assert::AreEqual((size_t)3, tree.size());
+			tree.clear();
+			Assert::AreEqual(LayoutTree::NONE, a1->getLayoutIndex());
+		}
 	};
 }
\ No newline at end of file